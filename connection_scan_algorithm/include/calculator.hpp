@@ -8,6 +8,7 @@
 #include <memory>
 #include <deque>
 #include <tuple>
+#include <functional>
 
 #include <boost/uuid/uuid.hpp>
 
@@ -17,6 +18,7 @@
 #include "node.hpp"
 #include "trip.hpp"
 #include "journey_step.hpp"
+#include "epoch_vector.hpp"
 
 namespace TrRouting
 {
@@ -38,10 +40,43 @@ namespace TrRouting
   class SingleCalculationResult;
   class AllNodesResult;
   class AlternativesResult;
+  class ProfileResult;
+  class PlaceAllNodesResult;
+  class AllNodesRangeResult;
   class TransitData;
   class ConnectionSet;
   class Point;
   class GeoFilter;
+  class CalculatorPool;
+  class WorkerPool;
+  class OdTripRoutingResult;
+  class OdTripsWriter;
+
+  /**
+   * Entry of the profile of a node: boarding the connection at boardIndex, when
+   * ready to board at readyTime at the node, arrives at destination at
+   * arrivalTime. The exit connection is the one where the first leg ends.
+   */
+  class ProfileEntry {
+  public:
+    int readyTime;
+    int arrivalTime;
+    size_t boardIndex;
+    size_t exitIndex;
+    bool exitToEgress; // true if the journey ends with an egress after the exit connection, false if there is a transfer
+  };
+
+  // Earliest arrival at destination when on a trip, with the connection where to get off
+  class TripProfileData {
+  public:
+    TripProfileData() : arrivalTime(MAX_INT), exitIndex(0), exitToEgress(false) {}
+    int arrivalTime;
+    size_t exitIndex;
+    bool exitToEgress;
+  };
+
+  // Number of places calculated together by the batch accessibility calculation, the lanes fit in a 32 bits mask
+  static const size_t ACCESSIBILITY_BATCH_LANES = 16;
 
   class Calculator {
 
@@ -57,6 +92,12 @@ namespace TrRouting
     // TODO Once the split is done, we can get rid of the unique_ptr return and have the right concret type returned directly
     std::unique_ptr<SingleCalculationResult> calculateSingle(RouteParameters &parameters, bool resetAccessPaths = true, bool resetFilters = true);
     std::unique_ptr<AllNodesResult> calculateAllNodes(AccessibilityParameters &parameters);
+    // Calculate the accessible nodes of all places, in a single connection scan per batch of ACCESSIBILITY_BATCH_LANES places. Results are in the order of the places
+    std::vector<PlaceAllNodesResult> calculateAllNodesBatch(AccessibilityBatchParameters &parameters);
+    // Calculate the travel time to all nodes for each departure time of the time window, with one connection scan per ACCESSIBILITY_BATCH_LANES departure times
+    std::unique_ptr<AllNodesRangeResult> calculateAllNodesRange(AccessibilityParameters &parameters);
+    // Calculate all the Pareto-optimal (departure, arrival) journeys in the time window of the parameters, in a single descending scan of the connections
+    std::unique_ptr<ProfileResult> calculateProfile(ProfileParameters &parameters);
 
     // Forward and and reverse calculation, in addition to their return values will fill up their JourneysSteps map
     std::optional<std::tuple<int, std::reference_wrapper<const Node>>> forwardCalculation(RouteParameters &parameters, std::unordered_map<Node::uid_t, JourneyStep> & forwardEgressJourneysSteps); // best arrival time,   best egress node
@@ -74,18 +115,44 @@ namespace TrRouting
     std::unique_ptr<AllNodesResult> reverseJourneyStepAllNodes(AccessibilityParameters &parameters, const std::unordered_map<Node::uid_t, JourneyStep> & reverseAccessJourneysSteps);
 
     AlternativesResult alternativesRouting(RouteParameters &parameters);
+    // Calculate the arrival time/number of transfers Pareto front in a single forward scan, with at most parameters.getMaxTransfers() transfers
+    AlternativesResult multiCriteriaRouting(RouteParameters &parameters);
     std::string             odTripsRouting(RouteParameters &parameters);
+    // Route the od trips, each result is passed to the writer as soon as it is calculated, then the summary with the profiles
+    void                    odTripsRouting(RouteParameters &parameters, OdTripsWriter &writer, const OdTripLegacyParameters &odTripParameters = OdTripLegacyParameters());
+    // Same as odTripsRouting, with chunks of od trips taken on demand by the worker threads, each with its calculator from the pool. The result is identical to the sequential one
+    static std::string      odTripsRouting(RouteParameters &parameters, const TransitData &transitData, CalculatorPool &calculatorPool, WorkerPool &workerPool);
+    static void             odTripsRouting(RouteParameters &parameters, const TransitData &transitData, CalculatorPool &calculatorPool, WorkerPool &workerPool, OdTripsWriter &writer, const OdTripLegacyParameters &odTripParameters = OdTripLegacyParameters());
 
     std::vector<int>        optimizeJourney(std::deque<JourneyStep> &journey);
 
   private:
     void initializeCalculationData();
-    bool resetAccessFootpaths(const CommonParameters &parameters, const Point& origin);
-    bool resetEgressFootpaths(const CommonParameters &parameters, const Point& destination);
+    // The precomputed nodes are used instead of the geofilter, those further than the max access or egress time are ignored
+    bool resetAccessFootpaths(const CommonParameters &parameters, const Point& origin, PrecomputedNodes precomputedNodes = std::nullopt);
+    bool resetEgressFootpaths(const CommonParameters &parameters, const Point& destination, PrecomputedNodes precomputedNodes = std::nullopt);
     void resetFilters(const CommonParameters &parameters);
     // Convert the optimization case ID returned by optimizeJourney to a string
     std::string optimizeCasesToString(const std::vector<int> optimizeCases);
     std::unique_ptr<SingleCalculationResult> calculateSingleReverse(RouteParameters &parameters);
+    // Get the best profile entry reachable from a node arrived at at arrivalTime, by walking to one of its transferable nodes
+    std::optional<std::tuple<std::reference_wrapper<const ProfileEntry>, std::reference_wrapper<const NodeTimeDistance>>> getBestTransferProfileEntry(const CommonParameters &parameters, const Node &node, int arrivalTime);
+    std::unique_ptr<SingleCalculationResult> profileJourney(ProfileParameters &parameters, int departureTime, const Node &accessNode, const ProfileEntry &entry);
+    // Forward all nodes calculation of up to ACCESSIBILITY_BATCH_LANES places, each at the departure time of its lane, appends one result per lane
+    void forwardCalculationAllNodesBatch(CommonParameters &parameters, const std::vector<std::reference_wrapper<const Point>> &lanesPlaces, const std::vector<PrecomputedNodes> &lanesNodes, const std::vector<int> &lanesDepartureTimes, std::vector<PlaceAllNodesResult> &results);
+    // Run the task with each chunk index from 0 to the chunks count, and the calculator to use for this chunk
+    typedef std::function<void(size_t, const std::function<void(size_t, Calculator &)> &)> OdTripsChunksRunner;
+    // Common part of the od trips routing: select the od trips, route them by chunks with runChunks, then add up their demand and write them in the order of the od trips, or of their groups when grouped
+    static void odTripsRoutingByChunks(RouteParameters &parameters, const TransitData &transitData, const OdTripsChunksRunner &runChunks, OdTripsWriter &writer, const OdTripLegacyParameters &params);
+    // Route a single od trip. The filters are reset if resetFilters is true, which is then set to false once they are
+    OdTripRoutingResult odTripRouting(RouteParameters &parameters, const OdTrip &odTrip, float sampleRatio, bool &resetFilters);
+    // Route od trips with the same access nodes and departure time with a single forward calculation, then a reverse calculation for each destination. Results are in the order of the od trips
+    std::vector<OdTripRoutingResult> odTripsGroupRouting(RouteParameters &parameters, const std::vector<std::reference_wrapper<const OdTrip>> &odTrips, float sampleRatio, bool &resetFilters);
+    // Reset the egress data for a new destination, returns false if there is no egress footpath
+    bool resetDestination(CommonParameters &parameters, const Point& destination, bool resetAccessPaths);
+    // Find the best egress node and arrival time at destination from the forward calculation egress journey steps
+    std::optional<std::tuple<int, std::reference_wrapper<const Node>>> getBestEgressNode(RouteParameters &parameters, const std::unordered_map<Node::uid_t, JourneyStep> & forwardEgressJourneysSteps);
+    std::unique_ptr<SingleCalculationResult> multiCriteriaJourney(RouteParameters &parameters, size_t legsCount, const Node &egressNode, const JourneyStep &egressJourneyStep);
 
     CalculationTime algorithmCalculationTime;
     //TODO set it mutable so it can be changed/reset?
@@ -104,23 +171,44 @@ namespace TrRouting
     // TODO Added Glob suffix to easily track which one was local and which was global
     std::optional<std::reference_wrapper<const OdTrip>> odTripGlob; //Used to tell the reset function that we are doing an OdTrip calculations
 
-    std::vector<int> nodesTentativeTime; // arrival time at node, using the Node::id as index
-    std::vector<int> nodesReverseTentativeTime; // departure time at node
+    // The per query scratch vectors are epoch stamped, so resetting them between queries does not depend on the network size
+    EpochVector<int> nodesTentativeTime; // arrival time at node, using the Node::id as index
+    EpochVector<int> nodesReverseTentativeTime; // departure time at node
     std::unordered_map<Node::uid_t, NodeTimeDistance> nodesAccess; // travel time/distance from origin to accessible nodes
     std::unordered_map<Node::uid_t, NodeTimeDistance> nodesEgress; // travel time/distance to reach destination;
 
-    // Field used at the time of the query, mostly for alternatives, which deactivate some of the scenario trips. Typically, there are less disabled trips and enabled ones, so we keep only those
-    // Since the number of disabled trip is more commonly low, the map query is fast
-    std::unordered_map<Trip::uid_t, bool> tripsDisabled;
-    bool isTripDisabled(Trip::uid_t uid) const { return tripsDisabled.find(uid) != tripsDisabled.end(); }
-    std::vector<TripQueryData> tripsQueryOverlay; // Store additionnal trip info during a query processing, indexed by Trip::uid
+    // Field used at the time of the query, mostly for alternatives, which deactivate some of the scenario trips.
+    // Bitset indexed by Trip::uid, so the calculation loops only need a bit lookup per connection
+    std::vector<bool> tripsDisabled;
+    bool isTripDisabled(Trip::uid_t uid) const { return tripsDisabled[uid]; }
+    EpochVector<TripQueryData> tripsQueryOverlay; // Store additionnal trip info during a query processing, indexed by Trip::uid
     // A subset of the connections that are used for the current query.
     std::shared_ptr<ConnectionSet> connectionSet;
 
     std::vector<NodeTimeDistance> accessFootpaths; // pair: accessNodeIndex, walkingTravelTimeSeconds, walkingDistanceMeters
     std::vector<NodeTimeDistance> egressFootpaths; // pair: egressNodeIndex, walkingTravelTimeSeconds, walkingDistanceMeters
-    std::vector<JourneyStep> forwardJourneysSteps; // indexed by Node::uid
-    std::vector<JourneyStep> reverseJourneysSteps; // indexed by Node::uid
+    EpochVector<JourneyStep> forwardJourneysSteps; // indexed by Node::uid
+    EpochVector<JourneyStep> reverseJourneysSteps; // indexed by Node::uid
+    // Profile calculation data, the entries of each node are sorted by decreasing ready and arrival times
+    std::vector<std::vector<ProfileEntry>> nodesProfiles; // indexed by Node::uid
+    std::vector<TripProfileData> tripsProfiles; // indexed by Trip::uid
+    // Multi-criteria calculation data, the first index is the maximum number of vehicle legs (transfers + 1) to reach the node or board the trip
+    std::vector<EpochVector<int>> nodesTentativeTimeByLegs; // indexed by Node::uid
+    std::vector<EpochVector<JourneyStep>> forwardJourneysStepsByLegs; // indexed by Node::uid
+    std::vector<EpochVector<std::optional<std::reference_wrapper<const Connection>>>> tripsEnterConnectionByLegs; // indexed by Trip::uid
+    // Batch accessibility calculation data, with ACCESSIBILITY_BATCH_LANES consecutive values per node or trip, one for each place
+    std::vector<int> nodesBatchTentativeTime; // indexed by Node::uid * lanes + lane
+    std::vector<short> nodesBatchBoardings; // number of boardings to get the tentative time
+    std::vector<char> nodesBatchAccessedFromOrigin; // whether the tentative time is the access from origin
+    std::vector<int> nodesBatchArrivalTime; // earliest arrival at node by unboarding there, like the egress journey steps of the single calculation
+    std::vector<short> nodesBatchArrivalBoardings;
+    std::vector<uint32_t> tripsBatchEnteredLanes; // mask of the lanes which entered the trip, indexed by Trip::uid
+    std::vector<short> tripsBatchBoardings; // number of boardings when on the trip, indexed by Trip::uid * lanes + lane
+    // Forward calculation data recorded for the grouped od trips routing, so each destination can be answered as if the forward calculation had stopped for it
+    bool recordForwardBoardings;
+    std::vector<Trip::uid_t> forwardBoardedTrips; // in the order they were boarded, so by increasing enter connection departure time
+    EpochVector<int> nodesFirstUnboardingIndex; // index of the first forward connection unboarding at the node, indexed by Node::uid
+    int lastForwardScannedConnectionsCount; // number of connections scanned by the last forward calculation
 
   };
 
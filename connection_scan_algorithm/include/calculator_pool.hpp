@@ -0,0 +1,87 @@
+#ifndef TR_CALCULATOR_POOL
+#define TR_CALCULATOR_POOL
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace TrRouting
+{
+  class Calculator;
+  class TransitData;
+  class GeoFilter;
+
+  /**
+   * @brief Keeps one long-lived Calculator per thread, so that the calculation
+   * scratch data is reused from one request to the next instead of being
+   * reallocated for each request.
+   *
+   * A thread's calculator is re-created when it is requested for another
+   * transit data, or when the data version of the transit data has changed
+   * since it was created. Once a new transit data is published, the
+   * calculators of the previous data are deleted as soon as they are
+   * released, so they do not keep the memory of the previous data.
+   */
+  class CalculatorPool {
+
+  public:
+    CalculatorPool(GeoFilter &_geoFilter);
+    virtual ~CalculatorPool();
+
+    /**
+     * Get the calculator for the calling thread, for this transit data. The
+     * returned calculator must not be shared with other threads, and must
+     * not be used after the transit data is deleted.
+     */
+    Calculator & getCalculator(const TransitData &transitData);
+    /**
+     * Release the calculator of the calling thread, after the last use of the
+     * calculator it got. It is deleted if it is for a previous transit data.
+     */
+    void releaseCalculator();
+    /**
+     * Set the currently published transit data, the unused calculators of the
+     * other data are deleted, the ones in use are deleted when released.
+     */
+    void releaseStaleCalculators(unsigned int currentDataInstanceId);
+    // Number of calculators created since the pool was constructed
+    unsigned int getCreatedCount() const {return createdCount;}
+    // Number of calculators currently kept by the pool
+    size_t getCalculatorsCount();
+
+  private:
+    class PooledCalculator {
+    public:
+      unsigned int dataInstanceId;
+      unsigned int dataVersion;
+      // Number of getCalculator calls of the thread not yet released
+      unsigned int users {0};
+      std::unique_ptr<Calculator> calculator;
+    };
+
+    GeoFilter &geoFilter;
+    std::mutex mutex; // Protects the calculators map, each entry is only used by its own thread
+    std::unordered_map<std::thread::id, PooledCalculator> calculators;
+    unsigned int createdCount;
+    // Instance id of the published transit data, 0 until it is set
+    unsigned int currentDataInstanceId {0};
+  };
+
+  /**
+   * @brief Releases the calling thread's calculator at the end of the scope,
+   * even when the calculation throws
+   */
+  class CalculatorRelease {
+
+  public:
+    CalculatorRelease(CalculatorPool &_calculatorPool) : calculatorPool(_calculatorPool) {}
+    ~CalculatorRelease() { calculatorPool.releaseCalculator(); }
+
+  private:
+    CalculatorPool &calculatorPool;
+  };
+
+}
+
+#endif // TR_CALCULATOR_POOL
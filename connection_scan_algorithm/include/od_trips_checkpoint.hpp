@@ -0,0 +1,54 @@
+#ifndef TR_OD_TRIPS_CHECKPOINT
+#define TR_OD_TRIPS_CHECKPOINT
+
+#include <string>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace TrRouting
+{
+
+  /**
+   * @brief Progress of an od trips routing run, saved to disk to resume it
+   *
+   * The state, with the number of od trips processed and the partial
+   * aggregates, is saved to the checkpoint file. The results of the
+   * processed od trips are appended to a results file next to it, so they
+   * can be written again to the output when resuming. The checkpoint file
+   * is replaced atomically, the results written after the last checkpoint
+   * are dropped on resume.
+   */
+  class OdTripsCheckpoint {
+  public:
+    OdTripsCheckpoint(const std::string &_filePath);
+
+    // Read the state of the last checkpoint, if there is one
+    std::optional<nlohmann::json> load() const;
+    /**
+     * Open the results file to continue after the state of the checkpoint,
+     * passing its results to onOdTrip. Without state, the run starts from
+     * the beginning.
+     */
+    void resume(const std::optional<nlohmann::json> &state, const std::function<void(const nlohmann::json &)> &onOdTrip);
+    // Keep the result of a processed od trip until the next checkpoint
+    void writeOdTrip(const nlohmann::json &odTripJson);
+    // Save the state, the od trips written since the last checkpoint are part of it. Returns false on error
+    bool save(nlohmann::json state);
+    // Remove the checkpoint files once the run is complete
+    void remove();
+
+  private:
+    std::string filePath;
+    std::string resultsFilePath;
+    std::ofstream resultsFile;
+    size_t savedOdTripsCount;
+    size_t writtenOdTripsCount;
+    uintmax_t resultsFileSize; // size of the results file with the written od trips
+  };
+
+}
+
+#endif // TR_OD_TRIPS_CHECKPOINT
@@ -0,0 +1,59 @@
+#ifndef TR_OD_TRIPS_WRITER
+#define TR_OD_TRIPS_WRITER
+
+#include <string>
+#include <ostream>
+#include <nlohmann/json.hpp>
+
+namespace TrRouting
+{
+
+  /**
+   * @brief Output of the od trips routing
+   *
+   * The result of each od trip is written as soon as it and all the od trips
+   * before it are routed, then the summary with the profiles is written at
+   * the end. The calls are never concurrent.
+   */
+  class OdTripsWriter {
+  public:
+    virtual ~OdTripsWriter() {}
+    virtual void writeOdTrip(const nlohmann::json &odTripJson) = 0;
+    // Aggregated demand, travel time and line and path profiles of all the od trips
+    virtual void writeSummary(const nlohmann::json &summaryJson) = 0;
+  };
+
+  /**
+   * Keeps the whole result in a single json object, with the od trips in the
+   * odTrips array and the summary fields, as returned by odTripsRouting.
+   */
+  class OdTripsJsonWriter : public OdTripsWriter {
+  public:
+    OdTripsJsonWriter();
+    void writeOdTrip(const nlohmann::json &odTripJson) override;
+    void writeSummary(const nlohmann::json &summaryJson) override;
+    std::string getJsonString() const { return json.dump(2); }
+
+  private:
+    nlohmann::json json;
+  };
+
+  /**
+   * Writes one compact json object per line to the stream, which can be a
+   * file or the response to a request: one line for each od trip, then a
+   * last line for the summary. The memory used does not depend on the
+   * number of od trips.
+   */
+  class OdTripsNdjsonWriter : public OdTripsWriter {
+  public:
+    OdTripsNdjsonWriter(std::ostream &_output);
+    void writeOdTrip(const nlohmann::json &odTripJson) override;
+    void writeSummary(const nlohmann::json &summaryJson) override;
+
+  private:
+    std::ostream &output;
+  };
+
+}
+
+#endif // TR_OD_TRIPS_WRITER
@@ -17,6 +17,7 @@ namespace TrRouting
     int         port;
     bool        debug;
     bool        cacheAllConnectionSets;
+    int         connectionCacheSizeMb;
     bool        useEuclideanDistance;
     int         numberOfThreads;
     std::string algorithm;
@@ -27,6 +28,10 @@ namespace TrRouting
     std::string osrmWalkingHost;
     std::string osrmCyclingHost;
     std::string osrmDrivingHost;
+    int         osrmCacheSize;
+    int         maxBatchQueries;
+    std::string snapshotPath;
+    std::string compileSnapshotPath;
 
     ProgramOptions();
     void parseOptions(int argc, char** argv);
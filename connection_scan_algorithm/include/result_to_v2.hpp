@@ -3,12 +3,11 @@
 
 #include <nlohmann/json.hpp>
 #include "routing_result.hpp"
+#include "parameters.hpp"
 
 namespace TrRouting
 {
 
-  class RouteParameters;
-
   /**
    * @brief Convert a result object to a json object for the version 2 trRouting API, as described in docs/APIv2/API.yml
    */
@@ -16,7 +15,11 @@ namespace TrRouting
   public:
     static nlohmann::json resultToJsonString(AlternativesResult& result, RouteParameters& params);
     static nlohmann::json resultToJsonString(SingleCalculationResult& result, RouteParameters& params);
+    static nlohmann::json resultToJsonString(ProfileResult& result, ProfileParameters& params);
     static nlohmann::json noRoutingFoundResponse(RouteParameters& params, NoRoutingReason noRoutingReason);
+    // Error code of the query_error responses for invalid parameters
+    static std::string getParameterErrorCode(ParameterException::Type type);
+    static nlohmann::json parameterErrorResponse(ParameterException::Type type);
   };
 
 }
@@ -8,6 +8,7 @@ namespace TrRouting
 {
 
   class AccessibilityParameters;
+  class AccessibilityBatchParameters;
 
   /**
    * @brief Convert a result object to a json object for the version 2 trRouting accessibility API
@@ -16,6 +17,10 @@ namespace TrRouting
   public:
     static nlohmann::json resultToJsonString(AllNodesResult& result, AccessibilityParameters& params);
     static nlohmann::json noRoutingFoundResponse(AccessibilityParameters& params, NoRoutingReason noRoutingReason);
+    // Batch response, with the status and accessible nodes of each place
+    static nlohmann::json resultToJsonString(std::vector<PlaceAllNodesResult>& results, AccessibilityBatchParameters& params);
+    // Time window response, with the travel time distribution of each node over the times of trip
+    static nlohmann::json resultToJsonString(AllNodesRangeResult& result, AccessibilityParameters& params);
   };
 
 }
@@ -0,0 +1,48 @@
+#ifndef TR_ROUTE_BATCH
+#define TR_ROUTE_BATCH
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <nlohmann/json.hpp>
+
+namespace TrRouting
+{
+  class Calculator;
+  class CalculatorPool;
+  class TransitData;
+  class WorkerPool;
+
+  /**
+   * @brief Calculates a batch of independent route queries on the worker pool
+   *
+   * Each query is a json object with the same fields as the /v2/route query
+   * string, and an optional id that is copied to its result. The results
+   * are the /v2/route responses, or the query_error response for invalid
+   * parameters.
+   */
+  class RouteBatch {
+
+  public:
+    RouteBatch(CalculatorPool &_calculatorPool, WorkerPool &_workerPool);
+
+    /**
+     * Calculate all the queries of the array. onResult is called once for
+     * each query, in the order of the array, as soon as the query and all
+     * those before it are calculated. The calls are never concurrent.
+     */
+    void calculate(const TransitData &transitData, const nlohmann::json &queries, const std::function<void(size_t, const nlohmann::json &)> &onResult);
+
+    // Calculate a single query of a batch with this calculator
+    static nlohmann::json calculateQuery(Calculator &calculator, const TransitData &transitData, const nlohmann::json &query);
+    // Convert the fields of a query to the parameters of the query string
+    static std::vector<std::pair<std::string, std::string>> queryToParameters(const nlohmann::json &query);
+
+  private:
+    CalculatorPool &calculatorPool;
+    WorkerPool &workerPool;
+  };
+
+}
+
+#endif // TR_ROUTE_BATCH
@@ -0,0 +1,60 @@
+#ifndef TR_WORKER_POOL
+#define TR_WORKER_POOL
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+namespace TrRouting
+{
+
+  /**
+   * @brief Long-lived threads running the tasks of the batch requests
+   *
+   * The threads are kept for the whole life of the pool, so the calculators
+   * of the CalculatorPool, which are per thread, are reused from one batch
+   * to the next. Concurrent batches are queued and run in order.
+   */
+  class WorkerPool {
+
+  public:
+    WorkerPool(unsigned int threadsCount);
+    virtual ~WorkerPool();
+
+    /**
+     * Call task with each index from 0 to tasksCount - 1, on the worker
+     * threads, and return when all tasks are done. If a task throws, the
+     * other tasks still run and the first exception is rethrown here.
+     */
+    void run(size_t tasksCount, const std::function<void(size_t)> &task);
+    unsigned int getThreadsCount() const {return threads.size();}
+
+  private:
+    class Job {
+    public:
+      Job(size_t _tasksCount, const std::function<void(size_t)> &_task) : tasksCount(_tasksCount), task(_task) {}
+      const size_t tasksCount;
+      const std::function<void(size_t)> &task;
+      size_t nextIndex {0};
+      size_t doneCount {0};
+      std::exception_ptr exception;
+    };
+
+    void work();
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable jobsAvailable;
+    std::condition_variable jobDone;
+    std::deque<std::shared_ptr<Job>> jobs; // Jobs with tasks that are not started yet
+    bool stopping {false};
+  };
+
+}
+
+#endif // TR_WORKER_POOL
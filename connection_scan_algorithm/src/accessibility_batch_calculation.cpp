@@ -0,0 +1,300 @@
+#include "spdlog/spdlog.h"
+
+#include "calculator.hpp"
+#include "toolbox.hpp"
+#include "parameters.hpp"
+#include "node.hpp"
+#include "trip.hpp"
+#include "line.hpp"
+#include "mode.hpp"
+#include "point.hpp"
+#include "routing_result.hpp"
+#include "transit_data.hpp"
+#include "connection_set.hpp"
+
+namespace TrRouting
+{
+
+  std::vector<PlaceAllNodesResult> Calculator::calculateAllNodesBatch(AccessibilityBatchParameters &parameters)
+  {
+    std::vector<PlaceAllNodesResult> results;
+    const std::vector<std::unique_ptr<Point>> & places = parameters.getPlaces();
+    results.reserve(places.size());
+
+    // The batches only apply to the forward scan, places at an arrival time are calculated one by one
+    if (!parameters.isForwardCalculation())
+    {
+      for (size_t placeIndex = 0; placeIndex < places.size(); placeIndex++)
+      {
+        const Point & place = *places[placeIndex].get();
+        AccessibilityParameters placeParameters(std::make_unique<Point>(place.latitude, place.longitude), parameters, parameters.getPlacesNodes()[placeIndex]);
+        try {
+          results.push_back(PlaceAllNodesResult(calculateAllNodes(placeParameters)));
+        } catch (NoRoutingFoundException &e) {
+          results.push_back(PlaceAllNodesResult(e.getReason()));
+        }
+      }
+      return results;
+    }
+
+    // The connection set and the trip filters are the same for all places, the access footpaths are set by batch
+    reset(parameters, std::nullopt, std::nullopt);
+
+    for (size_t firstPlaceIndex = 0; firstPlaceIndex < places.size(); firstPlaceIndex += ACCESSIBILITY_BATCH_LANES)
+    {
+      std::vector<std::reference_wrapper<const Point>> lanesPlaces;
+      std::vector<PrecomputedNodes> lanesNodes;
+      for (size_t placeIndex = firstPlaceIndex; placeIndex < std::min(firstPlaceIndex + ACCESSIBILITY_BATCH_LANES, places.size()); placeIndex++)
+      {
+        lanesPlaces.push_back(*places[placeIndex].get());
+        lanesNodes.push_back(parameters.getPlacesNodes()[placeIndex]);
+      }
+      forwardCalculationAllNodesBatch(parameters, lanesPlaces, lanesNodes, std::vector<int>(lanesPlaces.size(), departureTimeSeconds), results);
+
+      spdlog::debug("-- forward calculation all nodes batch -- {} places -- {} microseconds", std::min(ACCESSIBILITY_BATCH_LANES, places.size() - firstPlaceIndex), algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime);
+      calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+    }
+
+    return results;
+  }
+
+  std::unique_ptr<AllNodesRangeResult> Calculator::calculateAllNodesRange(AccessibilityParameters &parameters)
+  {
+    std::unique_ptr<AllNodesRangeResult> rangeResult = std::make_unique<AllNodesRangeResult>();
+    rangeResult.get()->timesOfTrip = parameters.getTimesOfTrip();
+    const std::vector<int> & timesOfTrip = rangeResult.get()->timesOfTrip;
+
+    // The lanes of a batch are the same place at consecutive departure times
+    reset(parameters, std::nullopt, std::nullopt);
+
+    std::vector<PlaceAllNodesResult> results;
+    results.reserve(timesOfTrip.size());
+    for (size_t firstTimeIndex = 0; firstTimeIndex < timesOfTrip.size(); firstTimeIndex += ACCESSIBILITY_BATCH_LANES)
+    {
+      size_t lanesCount = std::min(ACCESSIBILITY_BATCH_LANES, timesOfTrip.size() - firstTimeIndex);
+      std::vector<std::reference_wrapper<const Point>> lanesPlaces(lanesCount, *parameters.getPlace());
+      std::vector<PrecomputedNodes> lanesNodes(lanesCount, parameters.getPlaceNodes());
+      std::vector<int> lanesDepartureTimes(timesOfTrip.begin() + firstTimeIndex, timesOfTrip.begin() + firstTimeIndex + lanesCount);
+      forwardCalculationAllNodesBatch(parameters, lanesPlaces, lanesNodes, lanesDepartureTimes, results);
+
+      spdlog::debug("-- forward calculation all nodes range -- {} departure times -- {} microseconds", lanesCount, algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime);
+      calculationTime = algorithmCalculationTime.getDurationMicrosecondsNoStop();
+    }
+
+    // Travel times of each reached node, indexed by node uid then by time of trip
+    std::vector<std::vector<int>> nodesTravelTimes(transitData.getNodesMaxUid() + 1);
+    std::optional<NoRoutingReason> noRoutingReason;
+    bool hasResult {false};
+    for (size_t timeIndex = 0; timeIndex < results.size(); timeIndex++)
+    {
+      if (results[timeIndex].result.get() == nullptr)
+      {
+        noRoutingReason = noRoutingReason.value_or(results[timeIndex].noRoutingReason);
+        continue;
+      }
+      hasResult = true;
+      for (auto & accessibleNode : results[timeIndex].result.get()->nodes)
+      {
+        std::vector<int> & travelTimes = nodesTravelTimes[accessibleNode.node.uid];
+        if (travelTimes.empty())
+        {
+          travelTimes.assign(timesOfTrip.size(), -1);
+        }
+        travelTimes[timeIndex] = accessibleNode.totalTravelTime;
+      }
+    }
+    if (!hasResult)
+    {
+      throw NoRoutingFoundException(noRoutingReason.value_or(NoRoutingReason::NO_ROUTING_FOUND));
+    }
+
+    // Nodes are in the same order as the single time of trip result
+    for (auto nodeIte = transitData.getNodes().begin(); nodeIte != transitData.getNodes().end(); nodeIte++)
+    {
+      const Node & node = nodeIte->second;
+      if (!nodesTravelTimes[node.uid].empty())
+      {
+        rangeResult.get()->nodes.push_back(AccessibleNodeTravelTimes(node, std::move(nodesTravelTimes[node.uid])));
+      }
+    }
+    rangeResult.get()->totalNodeCount = transitData.getNodes().size();
+    return rangeResult;
+  }
+
+  // The per lane loops have a constant trip count and no data dependent branch, so the compiler can vectorize them
+  void Calculator::forwardCalculationAllNodesBatch(CommonParameters &parameters, const std::vector<std::reference_wrapper<const Point>> &lanesPlaces, const std::vector<PrecomputedNodes> &lanesNodes, const std::vector<int> &lanesDepartureTimes, std::vector<PlaceAllNodesResult> &results)
+  {
+    const size_t lanes = ACCESSIBILITY_BATCH_LANES;
+    const size_t placesCount = lanesPlaces.size();
+    const size_t nodesLanesCount = (transitData.getNodesMaxUid() + 1) * lanes;
+
+    nodesBatchTentativeTime.assign(nodesLanesCount, MAX_INT);
+    nodesBatchAccessedFromOrigin.assign(nodesLanesCount, 0);
+    nodesBatchArrivalTime.assign(nodesLanesCount, MAX_INT);
+    tripsBatchEnteredLanes.assign(transitData.getTripsMaxUid() + 1, 0);
+    // The boardings are only read for lanes with a valid time, they don't need to be reset
+    nodesBatchBoardings.resize(nodesLanesCount);
+    nodesBatchArrivalBoardings.resize(nodesLanesCount);
+    tripsBatchBoardings.resize((transitData.getTripsMaxUid() + 1) * lanes);
+
+    // Access footpaths of each place, in its own lane, with its own departure time
+    uint32_t accessedLanes      {0};
+    int      minAccessTime      {MAX_INT};
+    int      minDepartureTime   {MAX_INT};
+    int      maxDepartureTime   {0};
+    bool     placeAccessed      {false};
+    for (size_t lane = 0; lane < placesCount; lane++)
+    {
+      // Consecutive lanes of the same place at different departure times share its access footpaths
+      if (lane == 0 || &lanesPlaces[lane].get() != &lanesPlaces[lane - 1].get())
+      {
+        placeAccessed = resetAccessFootpaths(parameters, lanesPlaces[lane].get(), lanesNodes[lane]);
+      }
+      if (!placeAccessed)
+      {
+        continue;
+      }
+      accessedLanes |= 1u << lane;
+      minDepartureTime = std::min(minDepartureTime, lanesDepartureTimes[lane]);
+      maxDepartureTime = std::max(maxDepartureTime, lanesDepartureTimes[lane]);
+      for (auto & accessFootpath : accessFootpaths)
+      {
+        int footpathTravelTimeSeconds = (int)ceil((float)(accessFootpath.time) / parameters.getWalkingSpeedFactor());
+        size_t laneIndex = accessFootpath.node.uid * lanes + lane;
+        nodesBatchTentativeTime[laneIndex]      = lanesDepartureTimes[lane] + footpathTravelTimeSeconds;
+        nodesBatchAccessedFromOrigin[laneIndex] = 1;
+        nodesBatchBoardings[laneIndex]          = 0;
+        minAccessTime = std::min(minAccessTime, footpathTravelTimeSeconds);
+      }
+    }
+
+    uint32_t reachedLanes {0};
+    int maxFirstWaitingTime = parameters.getMaxFirstWaitingTimeSeconds();
+
+    auto & forwardConnections = connectionSet.get()->getForwardConnections();
+    const PackedConnections & packedConnections = connectionSet.get()->getForwardPackedConnections();
+
+    const ConnectionMask & forwardMask = connectionSet.get()->getForwardMask();
+    size_t lastConnectionIndex = packedConnections.size();
+    for (size_t connectionIndex = accessedLanes == 0 ? lastConnectionIndex : forwardMask.next(connectionSet.get()->getForwardConnectionsBeginIndexAtDepartureHour(minDepartureTime / 3600)); connectionIndex != lastConnectionIndex; connectionIndex = forwardMask.next(connectionIndex + 1))
+    {
+      int connectionDepartureTime = packedConnections.departureTimes[connectionIndex];
+      if (connectionDepartureTime < minDepartureTime + minAccessTime)
+      {
+        continue;
+      }
+      if (connectionDepartureTime - maxDepartureTime > parameters.getMaxTotalTravelTimeSeconds())
+      {
+        break;
+      }
+      Trip::uid_t tripUid = packedConnections.tripUids[connectionIndex];
+      if (isTripDisabled(tripUid))
+      {
+        continue;
+      }
+
+      // Same conditions as the single place calculation, evaluated for all lanes
+      int connectionReadyTime = connectionDepartureTime - packedConnections.getMinWaitingTimeOrDefault(connectionIndex, parameters.getMinWaitingTimeSeconds());
+      const size_t departureOffset = packedConnections.departureNodeUids[connectionIndex] * lanes;
+      uint32_t enteredLanes    = tripsBatchEnteredLanes[tripUid];
+      uint32_t readyLanes      {0};
+      uint32_t firstWaitLanes  {0};
+      for (size_t lane = 0; lane < lanes; lane++)
+      {
+        int nodeTentativeTime = nodesBatchTentativeTime[departureOffset + lane];
+        bool firstWaitOk = maxFirstWaitingTime <= 0 || !nodesBatchAccessedFromOrigin[departureOffset + lane] || connectionDepartureTime - nodeTentativeTime <= maxFirstWaitingTime;
+        readyLanes     |= (uint32_t)(nodeTentativeTime <= connectionReadyTime) << lane;
+        firstWaitLanes |= (uint32_t)firstWaitOk << lane;
+      }
+      uint32_t activeLanes = (enteredLanes | readyLanes) & firstWaitLanes;
+      if (activeLanes == 0)
+      {
+        continue;
+      }
+      reachedLanes |= activeLanes;
+
+      const size_t tripOffset = tripUid * lanes;
+      uint32_t boardingLanes = activeLanes & ~enteredLanes;
+      if (boardingLanes != 0 && packedConnections.canBoard(connectionIndex))
+      {
+        short tripBoarding = forwardConnections[connectionIndex].get().getTrip().line.mode.isTransferable() ? 0 : 1;
+        for (size_t lane = 0; lane < lanes; lane++)
+        {
+          bool boarding = (boardingLanes >> lane) & 1;
+          tripsBatchBoardings[tripOffset + lane] = boarding ? nodesBatchBoardings[departureOffset + lane] + tripBoarding : tripsBatchBoardings[tripOffset + lane];
+        }
+        enteredLanes |= boardingLanes;
+        tripsBatchEnteredLanes[tripUid] = enteredLanes;
+      }
+
+      uint32_t unboardingLanes = activeLanes & enteredLanes;
+      if (unboardingLanes == 0 || !packedConnections.canUnboard(connectionIndex))
+      {
+        continue;
+      }
+
+      const Node & nodeArrival = forwardConnections[connectionIndex].get().getArrivalNode();
+      int connectionArrivalTime = packedConnections.arrivalTimes[connectionIndex];
+      for (const NodeTimeDistance & transferableNode : nodeArrival.transferableNodes)
+      {
+        //TODO We should not do a direct == with float values
+        int footpathTravelTime = parameters.getWalkingSpeedFactor() == 1.0 ? transferableNode.time : (int)ceil((float)transferableNode.time / parameters.getWalkingSpeedFactor());
+        if (footpathTravelTime > parameters.getMaxTransferWalkingTravelTimeSeconds())
+        {
+          continue;
+        }
+        int transferArrivalTime = connectionArrivalTime + footpathTravelTime;
+        const size_t nodeOffset = transferableNode.node.uid * lanes;
+        for (size_t lane = 0; lane < lanes; lane++)
+        {
+          bool improves = ((unboardingLanes >> lane) & 1) && transferArrivalTime < nodesBatchTentativeTime[nodeOffset + lane];
+          nodesBatchTentativeTime[nodeOffset + lane]      = improves ? transferArrivalTime : nodesBatchTentativeTime[nodeOffset + lane];
+          nodesBatchBoardings[nodeOffset + lane]          = improves ? tripsBatchBoardings[tripOffset + lane] : nodesBatchBoardings[nodeOffset + lane];
+          nodesBatchAccessedFromOrigin[nodeOffset + lane] = improves ? 0 : nodesBatchAccessedFromOrigin[nodeOffset + lane];
+        }
+        if (nodeArrival == transferableNode.node)
+        {
+          for (size_t lane = 0; lane < lanes; lane++)
+          {
+            bool improves = ((unboardingLanes >> lane) & 1) && connectionArrivalTime < nodesBatchArrivalTime[nodeOffset + lane];
+            nodesBatchArrivalTime[nodeOffset + lane]      = improves ? connectionArrivalTime : nodesBatchArrivalTime[nodeOffset + lane];
+            nodesBatchArrivalBoardings[nodeOffset + lane] = improves ? tripsBatchBoardings[tripOffset + lane] : nodesBatchArrivalBoardings[nodeOffset + lane];
+          }
+        }
+      }
+    }
+
+    // Collect the accessible nodes of each place, the same way the single place journey does
+    for (size_t lane = 0; lane < placesCount; lane++)
+    {
+      if (((accessedLanes >> lane) & 1) == 0)
+      {
+        results.push_back(PlaceAllNodesResult(NoRoutingReason::NO_ACCESS_AT_ORIGIN));
+        continue;
+      }
+      if (((reachedLanes >> lane) & 1) == 0)
+      {
+        results.push_back(PlaceAllNodesResult(NoRoutingReason::NO_SERVICE_FROM_ORIGIN));
+        continue;
+      }
+
+      std::unique_ptr<AllNodesResult> allNodesResult = std::make_unique<AllNodesResult>();
+      int reachableNodesCount {0};
+      for (auto nodeIte = transitData.getNodes().begin(); nodeIte != transitData.getNodes().end(); nodeIte++)
+      {
+        const Node & node = nodeIte->second;
+        size_t laneIndex = node.uid * lanes + lane;
+        int arrivalTime = nodesBatchArrivalTime[laneIndex];
+        if (arrivalTime < MAX_INT && arrivalTime - lanesDepartureTimes[lane] <= parameters.getMaxTotalTravelTimeSeconds())
+        {
+          reachableNodesCount++;
+          allNodesResult.get()->nodes.push_back(AccessibleNodes(node, arrivalTime, arrivalTime - lanesDepartureTimes[lane], nodesBatchArrivalBoardings[laneIndex] - 1));
+        }
+      }
+      allNodesResult.get()->numberOfReachableNodes = reachableNodesCount;
+      allNodesResult.get()->totalNodeCount = transitData.getNodes().size();
+      results.push_back(PlaceAllNodesResult(std::move(allNodesResult)));
+    }
+  }
+
+}
@@ -82,10 +82,19 @@ namespace TrRouting
     void visitAllNodesResult(const AllNodesResult& ) override {
       // Nothing to do for this result
     }
+    void visitProfileResult(const ProfileResult& ) override {
+      // Nothing to do for this result
+    }
   };
 
   AlternativesResult Calculator::alternativesRouting(RouteParameters &parameters)
   {
+    // With a maximum number of transfers, the alternatives are the arrival time/transfers Pareto front, which is calculated in a single pass
+    if (parameters.getMaxTransfers().has_value() && parameters.isForwardCalculation())
+    {
+      return multiCriteriaRouting(parameters);
+    }
+
     using LineVector = std::vector<std::reference_wrapper<const Line>>;
     LineVector exceptLinesFromParameters = parameters.getExceptLines(); // make a copy of lines that are already disabled in parameters
     std::vector< LineVector >  allCombinations;
@@ -149,7 +158,10 @@ namespace TrRouting
     RouteParameters alternativeParameters = RouteParameters(std::make_unique<Point>(origin->latitude, origin->longitude),
       std::make_unique<Point>(dest->latitude, dest->longitude),
       parameters.isWithAlternatives(),
-      commonAlternativeParameters
+      commonAlternativeParameters,
+      std::nullopt,
+      parameters.getOriginNodes(),
+      parameters.getDestinationNodes()
     );
 
     //params.departureTimeSeconds = departureTimeSeconds;
@@ -0,0 +1,74 @@
+#include "spdlog/spdlog.h"
+
+#include "calculator_pool.hpp"
+#include "calculator.hpp"
+#include "transit_data.hpp"
+#include "geofilter.hpp"
+
+namespace TrRouting
+{
+
+  CalculatorPool::CalculatorPool(GeoFilter &_geoFilter) :
+    geoFilter(_geoFilter),
+    createdCount(0)
+  {
+
+  }
+
+  CalculatorPool::~CalculatorPool() {}
+
+  Calculator & CalculatorPool::getCalculator(const TransitData &transitData) {
+    unsigned int dataInstanceId = transitData.getInstanceId();
+    unsigned int dataVersion = transitData.getDataVersion();
+    PooledCalculator * pooledCalculator;
+    {
+      // Entries in unordered_map are stable, so the lock is only required to find or insert this thread's entry
+      std::lock_guard<std::mutex> lock(mutex);
+      pooledCalculator = &calculators[std::this_thread::get_id()];
+      pooledCalculator->users++;
+      if (pooledCalculator->calculator && pooledCalculator->dataInstanceId == dataInstanceId && pooledCalculator->dataVersion == dataVersion) {
+        return *pooledCalculator->calculator;
+      }
+      createdCount++;
+    }
+
+    spdlog::debug("Creating calculator for thread, data {} version {}", dataInstanceId, dataVersion);
+    pooledCalculator->calculator = std::make_unique<Calculator>(transitData, geoFilter);
+    pooledCalculator->dataInstanceId = dataInstanceId;
+    pooledCalculator->dataVersion = dataVersion;
+    return *pooledCalculator->calculator;
+  }
+
+  void CalculatorPool::releaseCalculator() {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto pooledCalculatorIte = calculators.find(std::this_thread::get_id());
+    if (pooledCalculatorIte == calculators.end() || pooledCalculatorIte->second.users == 0) {
+      return;
+    }
+    PooledCalculator &pooledCalculator = pooledCalculatorIte->second;
+    pooledCalculator.users--;
+    if (pooledCalculator.users == 0 && currentDataInstanceId != 0 && pooledCalculator.dataInstanceId != currentDataInstanceId) {
+      spdlog::debug("Deleting calculator of previous data {}", pooledCalculator.dataInstanceId);
+      calculators.erase(pooledCalculatorIte);
+    }
+  }
+
+  void CalculatorPool::releaseStaleCalculators(unsigned int _currentDataInstanceId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    currentDataInstanceId = _currentDataInstanceId;
+    // The calculators in use are deleted by their thread when released
+    for (auto pooledCalculatorIte = calculators.begin(); pooledCalculatorIte != calculators.end();) {
+      if (pooledCalculatorIte->second.users == 0 && pooledCalculatorIte->second.dataInstanceId != currentDataInstanceId) {
+        pooledCalculatorIte = calculators.erase(pooledCalculatorIte);
+      } else {
+        pooledCalculatorIte++;
+      }
+    }
+  }
+
+  size_t CalculatorPool::getCalculatorsCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return calculators.size();
+  }
+
+}
@@ -26,29 +26,36 @@ namespace TrRouting
     int   tentativeEgressNodeArrivalTime  {MAX_INT};
     bool  reachedAtLeastOneEgressNode     {false};
     bool  nodeWasAccessedFromOrigin       {false};
-    int   bestArrivalTime                 {MAX_INT};
+    int   scannedConnectionsCount         {0};
     
-    int  connectionsCount  = connectionSet.get()->getForwardConnections().size();
+    int  connectionsCount  = connectionSet.get()->getForwardConnectionsCount();
     int  departureTimeHour = departureTimeSeconds / 3600;
 
+    // The loop scans the packed columns, the connection objects are only used to record journey steps
+    auto & forwardConnections = connectionSet.get()->getForwardConnections();
+    const PackedConnections & packedConnections = connectionSet.get()->getForwardPackedConnections();
+
     // main loop:
-    auto lastConnection = connectionSet.get()->getForwardConnections().end(); // cache last connection for loop
-    for(auto connection = connectionSet.get()->getForwardConnectionsBeginAtDepartureHour(departureTimeHour); connection != lastConnection; ++connection)
+    // Only the connections enabled in the scenario's mask are scanned
+    const ConnectionMask & forwardMask = connectionSet.get()->getForwardMask();
+    size_t lastConnectionIndex = packedConnections.size(); // cache last connection for loop
+    for(size_t connectionIndex = forwardMask.next(connectionSet.get()->getForwardConnectionsBeginIndexAtDepartureHour(departureTimeHour)); connectionIndex != lastConnectionIndex; connectionIndex = forwardMask.next(connectionIndex + 1))
     {
-      
+      scannedConnectionsCount++;
+
       // ignore connections before departure time + minimum access travel time:
-      if ((*connection).get().getDepartureTime() >= departureTimeSeconds + minAccessTravelTime)
+      connectionDepartureTime = packedConnections.departureTimes[connectionIndex];
+      if (connectionDepartureTime >= departureTimeSeconds + minAccessTravelTime)
       {
-        const Trip & trip = (*connection).get().getTrip();
+        Trip::uid_t tripUid = packedConnections.tripUids[connectionIndex];
 
         // Cache the current query data overlay si we don't check the hashmap every time
-        auto & currentTripQueryOverlay = tripsQueryOverlay.at(trip.uid);
+        auto & currentTripQueryOverlay = tripsQueryOverlay[tripUid];
 
         // enabled trips only here:
-        if (!isTripDisabled(trip.uid))
+        if (!isTripDisabled(tripUid))
         {
-          connectionDepartureTime         = (*connection).get().getDepartureTime();
-          connectionMinWaitingTimeSeconds = (*connection).get().getMinWaitingTimeOrDefault(parameters.getMinWaitingTimeSeconds());
+          connectionMinWaitingTimeSeconds = packedConnections.getMinWaitingTimeOrDefault(connectionIndex, parameters.getMinWaitingTimeSeconds());
 
           // no need to parse next connections if already reached destination from all egress nodes:
           // yes, we mean connectionDepartureTime and not connectionArrivalTime because travel time for each connections, otherwise you can catch a very short/long connection
@@ -61,17 +68,17 @@ namespace TrRouting
             break;
           }
           std::optional<std::reference_wrapper<const Connection>> tripEnterConnection = currentTripQueryOverlay.enterConnection;
-          const Node &nodeDeparture = (*connection).get().getDepartureNode();
+          Node::uid_t nodeDepartureUid = packedConnections.departureNodeUids[connectionIndex];
 
           // Extract node departure time if we have a result or use default value
-          nodeDepartureTentativeTime = nodesTentativeTime.at(nodeDeparture.uid);
+          nodeDepartureTentativeTime = nodesTentativeTime.get(nodeDepartureUid);
 
           // TODO Do we need to make sure the departure node exists in the forwardJourneySteps map? For the reverse calculation, we had to in order to fix issue https://github.com/chairemobilite/trRouting/issues/250 The issue may apply to forward too, but we have no example
-          auto nodesAccessIte = nodesAccess.find(nodeDeparture.uid);          
+          auto nodesAccessIte = nodesAccess.find(nodeDepartureUid);          
           nodeWasAccessedFromOrigin  = parameters.getMaxFirstWaitingTimeSeconds() > 0 &&
             nodesAccessIte != nodesAccess.end() &&
             nodesAccessIte->second.time >= 0 &&
-            !forwardJourneysSteps.at(nodeDeparture.uid).getFinalEnterConnection().has_value();
+            !forwardJourneysSteps.get(nodeDepartureUid).getFinalEnterConnection().has_value();
 
           // reachable connections only here:
           if (
@@ -89,18 +96,29 @@ namespace TrRouting
           )
           {
             // TODO: add constrain for sameLineTransfer (check trip allowSameLineTransfers)
-            if ((*connection).get().canBoard() && (!tripEnterConnection.has_value()) )
+            if (packedConnections.canBoard(connectionIndex) && (!tripEnterConnection.has_value()) )
             {
               currentTripQueryOverlay.usable = true;
-              currentTripQueryOverlay.enterConnection = *connection;
-              currentTripQueryOverlay.enterConnectionTransferTravelTime = forwardJourneysSteps.at(nodeDeparture.uid).getTransferTravelTime();
+              currentTripQueryOverlay.enterConnection = forwardConnections[connectionIndex];
+              currentTripQueryOverlay.enterConnectionTransferTravelTime = forwardJourneysSteps.get(nodeDepartureUid).getTransferTravelTime();
+              if (recordForwardBoardings)
+              {
+                forwardBoardedTrips.push_back(tripUid);
+              }
             }
             
-            if ((*connection).get().canUnboard() && currentTripQueryOverlay.enterConnection.has_value())
+            if (packedConnections.canUnboard(connectionIndex) && currentTripQueryOverlay.enterConnection.has_value())
             {
+              const Connection & connection = forwardConnections[connectionIndex];
+              const Trip & trip = connection.getTrip();
               // get footpaths for the arrival node to get transferable nodes:
-              const Node &nodeArrival = (*connection).get().getArrivalNode();
-              connectionArrivalTime           = (*connection).get().getArrivalTime();
+              const Node &nodeArrival = connection.getArrivalNode();
+              connectionArrivalTime           = packedConnections.arrivalTimes[connectionIndex];
+
+              if (recordForwardBoardings && nodesFirstUnboardingIndex.get(nodeArrival.uid) == -1)
+              {
+                nodesFirstUnboardingIndex[nodeArrival.uid] = connectionIndex;
+              }
 
               auto nodeArrivalInNodesEgressIte = nodesEgress.find(nodeArrival.uid);              
               if (!reachedAtLeastOneEgressNode && nodeArrivalInNodesEgressIte != nodesEgress.end() && nodeArrivalInNodesEgressIte->second.time != -1) // check if the arrival node is egressable
@@ -112,7 +130,7 @@ namespace TrRouting
               for (const NodeTimeDistance & transferableNode : nodeArrival.transferableNodes)
               {
                 // Extract tentative time for current transferable node if found
-                int currentTransferablenNodesTentativeTime = nodesTentativeTime.at(transferableNode.node.uid);
+                int currentTransferablenNodesTentativeTime = nodesTentativeTime.get(transferableNode.node.uid);
 
                 if (nodeArrival != transferableNode.node &&
                     currentTransferablenNodesTentativeTime < connectionArrivalTime)
@@ -131,7 +149,7 @@ namespace TrRouting
                     nodesTentativeTime[transferableNode.node.uid] = footpathTravelTime + connectionArrivalTime;
 
                     //TODO DO we need a make_optional here??
-                    forwardJourneysSteps.at(transferableNode.node.uid) = JourneyStep(currentTripQueryOverlay.enterConnection, *connection, std::cref(trip), footpathTravelTime, (nodeArrival == transferableNode.node), footpathDistance);
+                    forwardJourneysSteps.at(transferableNode.node.uid) = JourneyStep(currentTripQueryOverlay.enterConnection, std::cref(connection), std::cref(trip), footpathTravelTime, (nodeArrival == transferableNode.node), footpathDistance);
                   }
 
                   if (
@@ -146,7 +164,7 @@ namespace TrRouting
                   )
                   {
                     footpathDistance = transferableNode.distance;
-                    forwardEgressJourneysSteps.insert_or_assign(transferableNode.node.uid, JourneyStep(currentTripQueryOverlay.enterConnection, *connection, std::cref(trip), footpathTravelTime, true, footpathDistance));
+                    forwardEgressJourneysSteps.insert_or_assign(transferableNode.node.uid, JourneyStep(currentTripQueryOverlay.enterConnection, std::cref(connection), std::cref(trip), footpathTravelTime, true, footpathDistance));
                   }
                 }
               }
@@ -158,11 +176,19 @@ namespace TrRouting
     }
 
     spdlog::debug("-- {} forward connections parsed on {}", reachableConnectionsCount, connectionsCount);
+    lastForwardScannedConnectionsCount = scannedConnectionsCount;
 
     if (reachableConnectionsCount == 0) {
       throw NoRoutingFoundException(NoRoutingReason::NO_SERVICE_FROM_ORIGIN);
     }
 
+    return getBestEgressNode(parameters, forwardEgressJourneysSteps);
+  }
+
+  std::optional<std::tuple<int, std::reference_wrapper<const Node>>> Calculator::getBestEgressNode(RouteParameters &parameters,
+                                                                                                   const std::unordered_map<Node::uid_t, JourneyStep> & forwardEgressJourneysSteps)
+  {
+    int bestArrivalTime {MAX_INT};
     int egressNodeArrivalTime {-1};
     std::optional<std::reference_wrapper<const Connection>> egressExitConnection;
     // find best egress node:
@@ -212,26 +238,32 @@ namespace TrRouting
     int   footpathDistance                {-1};
     bool  nodeWasAccessedFromOrigin       {false};
 
-    int  connectionsCount  = connectionSet.get()->getForwardConnections().size();
+    int  connectionsCount  = connectionSet.get()->getForwardConnectionsCount();
     int  departureTimeHour = departureTimeSeconds / 3600;
 
+    // The loop scans the packed columns, the connection objects are only used to record journey steps
+    auto & forwardConnections = connectionSet.get()->getForwardConnections();
+    const PackedConnections & packedConnections = connectionSet.get()->getForwardPackedConnections();
+
     // main loop:
-    auto lastConnection = connectionSet.get()->getForwardConnections().end(); // cache last connection for loop
-    for(auto connection = connectionSet.get()->getForwardConnectionsBeginAtDepartureHour(departureTimeHour); connection != lastConnection; ++connection)
+    // Only the connections enabled in the scenario's mask are scanned
+    const ConnectionMask & forwardMask = connectionSet.get()->getForwardMask();
+    size_t lastConnectionIndex = packedConnections.size(); // cache last connection for loop
+    for(size_t connectionIndex = forwardMask.next(connectionSet.get()->getForwardConnectionsBeginIndexAtDepartureHour(departureTimeHour)); connectionIndex != lastConnectionIndex; connectionIndex = forwardMask.next(connectionIndex + 1))
     {
       // ignore connections before departure time + minimum access travel time:
-      if ((*connection).get().getDepartureTime() >= departureTimeSeconds + minAccessTravelTime)
+      connectionDepartureTime = packedConnections.departureTimes[connectionIndex];
+      if (connectionDepartureTime >= departureTimeSeconds + minAccessTravelTime)
       {
-        const Trip & trip = (*connection).get().getTrip();
+        Trip::uid_t tripUid = packedConnections.tripUids[connectionIndex];
 
         // Cache the current query data overlay si we don't check the hashmap every time
-        auto & currentTripQueryOverlay = tripsQueryOverlay.at(trip.uid);
+        auto & currentTripQueryOverlay = tripsQueryOverlay[tripUid];
 
         // enabled trips only here:
-        if (!isTripDisabled(trip.uid))
+        if (!isTripDisabled(tripUid))
         {
-          connectionDepartureTime         = (*connection).get().getDepartureTime();
-          connectionMinWaitingTimeSeconds = (*connection).get().getMinWaitingTimeOrDefault(parameters.getMinWaitingTimeSeconds());
+          connectionMinWaitingTimeSeconds = packedConnections.getMinWaitingTimeOrDefault(connectionIndex, parameters.getMinWaitingTimeSeconds());
 
           //TODO When the allNodes clean, is the comment still releveant?
           // no need to parse next connections if already reached destination from all egress nodes:
@@ -241,16 +273,16 @@ namespace TrRouting
             break;
           }
           std::optional<std::reference_wrapper<const Connection>> tripEnterConnection = currentTripQueryOverlay.enterConnection;
-          const Node &nodeDeparture = (*connection).get().getDepartureNode();
+          Node::uid_t nodeDepartureUid = packedConnections.departureNodeUids[connectionIndex];
 
           // Extract node departure time if we have a result or use default value
-          nodeDepartureTentativeTime = nodesTentativeTime.at(nodeDeparture.uid);
+          nodeDepartureTentativeTime = nodesTentativeTime.get(nodeDepartureUid);
 
-          auto nodesAccessIte = nodesAccess.find(nodeDeparture.uid);
+          auto nodesAccessIte = nodesAccess.find(nodeDepartureUid);
           nodeWasAccessedFromOrigin  = parameters.getMaxFirstWaitingTimeSeconds() > 0 &&
             nodesAccessIte != nodesAccess.end() &&
             nodesAccessIte->second.time >= 0 &&
-            !forwardJourneysSteps.at(nodeDeparture.uid).getFinalEnterConnection().has_value();
+            !forwardJourneysSteps.get(nodeDepartureUid).getFinalEnterConnection().has_value();
 
           // reachable connections only here:
           if (
@@ -268,23 +300,25 @@ namespace TrRouting
           )
           {
             // TODO: add constrain for sameLineTransfer (check trip allowSameLineTransfers)
-            if ((*connection).get().canBoard() && ( !tripEnterConnection.has_value()))
+            if (packedConnections.canBoard(connectionIndex) && ( !tripEnterConnection.has_value()))
             {
               currentTripQueryOverlay.usable = true;
-              currentTripQueryOverlay.enterConnection = *connection;
-              currentTripQueryOverlay.enterConnectionTransferTravelTime = forwardJourneysSteps.at(nodeDeparture.uid).getTransferTravelTime();
+              currentTripQueryOverlay.enterConnection = forwardConnections[connectionIndex];
+              currentTripQueryOverlay.enterConnectionTransferTravelTime = forwardJourneysSteps.get(nodeDepartureUid).getTransferTravelTime();
             }
 
-            if ((*connection).get().canUnboard() && currentTripQueryOverlay.enterConnection.has_value())
+            if (packedConnections.canUnboard(connectionIndex) && currentTripQueryOverlay.enterConnection.has_value())
             {
+              const Connection & connection = forwardConnections[connectionIndex];
+              const Trip & trip = connection.getTrip();
               // get footpaths for the arrival node to get transferable nodes:
-              const Node &nodeArrival = (*connection).get().getArrivalNode();
-              connectionArrivalTime           = (*connection).get().getArrivalTime();
+              const Node &nodeArrival = connection.getArrivalNode();
+              connectionArrivalTime           = packedConnections.arrivalTimes[connectionIndex];
 
               for (const NodeTimeDistance & transferableNode : nodeArrival.transferableNodes)
               {
                 // Extract tentative time for current transferable node if found
-                int currentTransferablenNodesTentativeTime = nodesTentativeTime.at(transferableNode.node.uid);
+                int currentTransferablenNodesTentativeTime = nodesTentativeTime.get(transferableNode.node.uid);
 
                 if (nodeArrival != transferableNode.node &&
                     currentTransferablenNodesTentativeTime < connectionArrivalTime)
@@ -303,7 +337,7 @@ namespace TrRouting
                     nodesTentativeTime[transferableNode.node.uid] = footpathTravelTime + connectionArrivalTime;
 
                     //TODO DO we need a make_optional here??
-                    forwardJourneysSteps.at(transferableNode.node.uid) = JourneyStep(currentTripQueryOverlay.enterConnection, *connection, std::cref(trip), footpathTravelTime, (nodeArrival == transferableNode.node), footpathDistance);
+                    forwardJourneysSteps.at(transferableNode.node.uid) = JourneyStep(currentTripQueryOverlay.enterConnection, std::cref(connection), std::cref(trip), footpathTravelTime, (nodeArrival == transferableNode.node), footpathDistance);
                   }
 
                   if (
@@ -318,7 +352,7 @@ namespace TrRouting
                   )
                   {
                     footpathDistance = transferableNode.distance;
-                    forwardEgressJourneysSteps.insert_or_assign(transferableNode.node.uid, JourneyStep(currentTripQueryOverlay.enterConnection, *connection, std::cref(trip), footpathTravelTime, true, footpathDistance));
+                    forwardEgressJourneysSteps.insert_or_assign(transferableNode.node.uid, JourneyStep(currentTripQueryOverlay.enterConnection, std::cref(connection), std::cref(trip), footpathTravelTime, true, footpathDistance));
                   }
                 }
               }
@@ -52,13 +52,13 @@ namespace TrRouting
       {
         journey.push_front(resultingNodeJourneyStep);
         bestAccessNode = resultingNodeJourneyStep.getFinalEnterConnection().value().get().getDepartureNode();
-        resultingNodeJourneyStep = forwardJourneysSteps.at(bestAccessNode.value().get().uid);
+        resultingNodeJourneyStep = forwardJourneysSteps.get(bestAccessNode.value().get().uid);
       }
 
       journey.push_back(JourneyStep(std::nullopt,
                                     std::nullopt,
                                     std::nullopt,
-                                    nodesEgress.at(resultingNode.uid).distance,
+                                    nodesEgress.at(resultingNode.uid).time,
                                     false,
                                     nodesEgress.at(resultingNode.uid).distance));
 
@@ -293,7 +293,7 @@ namespace TrRouting
         }
 
         bestAccessNode = resultingNodeJourneyStep.getFinalEnterConnection().value().get().getDepartureNode();
-        resultingNodeJourneyStep = forwardJourneysSteps.at(bestAccessNode.value().get().uid);
+        resultingNodeJourneyStep = forwardJourneysSteps.get(bestAccessNode.value().get().uid);
       }
 
       if (forwardEgressJourneysSteps.at(resultingNode.uid).getFinalEnterConnection().has_value())
@@ -33,7 +33,9 @@ namespace TrRouting
     maxAccessTravelTime(0),
     minEgressTravelTime(0),
     calculationTime(0),
-    odTripGlob(std::nullopt)
+    odTripGlob(std::nullopt),
+    recordForwardBoardings(false),
+    lastForwardScannedConnectionsCount(0)
   {
     initializeCalculationData();
     algorithmCalculationTime.start(); //Automatically start timer on construction
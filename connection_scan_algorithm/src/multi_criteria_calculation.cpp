@@ -0,0 +1,264 @@
+#include <unordered_set>
+
+#include "spdlog/spdlog.h"
+
+#include "calculator.hpp"
+#include "toolbox.hpp"
+#include "parameters.hpp"
+#include "node.hpp"
+#include "trip.hpp"
+#include "line.hpp"
+#include "mode.hpp"
+#include "routing_result.hpp"
+#include "transit_data.hpp"
+#include "connection_set.hpp"
+
+namespace TrRouting
+{
+
+  // Same travel time limit as the alternatives, relative to the fastest travel time found
+  int getMultiCriteriaMaxTravelTime(RouteParameters &parameters, int fastestTravelTime)
+  {
+    int maxTravelTime = parameters.getAlternativesMaxTravelTimeRatio() * fastestTravelTime;
+    if (maxTravelTime < parameters.getMinAlternativeMaxTravelTimeSeconds())
+    {
+      maxTravelTime = parameters.getMinAlternativeMaxTravelTimeSeconds();
+    }
+    else if (maxTravelTime > fastestTravelTime + parameters.getAlternativesMaxAddedTravelTimeSeconds())
+    {
+      maxTravelTime = fastestTravelTime + parameters.getAlternativesMaxAddedTravelTimeSeconds();
+    }
+    return std::min(maxTravelTime, parameters.getMaxTotalTravelTimeSeconds());
+  }
+
+  AlternativesResult Calculator::multiCriteriaRouting(RouteParameters &parameters)
+  {
+    reset(parameters, *parameters.getOrigin(), *parameters.getDestination());
+
+    // Labels at index n are for journeys with at most n vehicle legs, index 0 is the access from origin.
+    // Trips of the transferable mode are walking, they do not count as legs, like in the journeys' number of transfers
+    size_t maxLegs = parameters.getMaxTransfers().value_or(0) + 1;
+    int    reachableConnectionsCount {0};
+
+    nodesTentativeTimeByLegs.resize(maxLegs + 1);
+    forwardJourneysStepsByLegs.resize(maxLegs + 1);
+    tripsEnterConnectionByLegs.resize(maxLegs + 1);
+    for (size_t legs = 0; legs <= maxLegs; legs++)
+    {
+      nodesTentativeTimeByLegs[legs].reset(transitData.getNodesMaxUid() + 1, MAX_INT);
+      forwardJourneysStepsByLegs[legs].reset(transitData.getNodesMaxUid() + 1, JourneyStep());
+      tripsEnterConnectionByLegs[legs].reset(transitData.getTripsMaxUid() + 1, std::nullopt);
+      for (auto & accessFootpath : accessFootpaths)
+      {
+        const NodeTimeDistance & access = nodesAccess.at(accessFootpath.node.uid);
+        nodesTentativeTimeByLegs[legs][access.node.uid] = departureTimeSeconds + access.time;
+        forwardJourneysStepsByLegs[legs][access.node.uid] = JourneyStep(std::nullopt, std::nullopt, std::nullopt, access.time, false, access.distance);
+      }
+    }
+
+    // Best egress for each number of legs: arrival time at destination, egress node and last journey step
+    std::vector<std::optional<std::tuple<int, std::reference_wrapper<const Node>, JourneyStep>>> bestEgressByLegs(maxLegs + 1);
+    int bestArrivalTime     {MAX_INT};
+    int lastArrivalTime     {MAX_INT}; // No connection departing after this time can improve the front
+    int singleLegArrivalTime {MAX_INT}; // Connections departing after this time can only improve journeys without legs
+
+    auto & forwardConnections = connectionSet.get()->getForwardConnections();
+    const PackedConnections & packedConnections = connectionSet.get()->getForwardPackedConnections();
+
+    const ConnectionMask & forwardMask = connectionSet.get()->getForwardMask();
+    size_t lastConnectionIndex = packedConnections.size();
+    for (size_t connectionIndex = forwardMask.next(connectionSet.get()->getForwardConnectionsBeginIndexAtDepartureHour(departureTimeSeconds / 3600)); connectionIndex != lastConnectionIndex; connectionIndex = forwardMask.next(connectionIndex + 1))
+    {
+      int connectionDepartureTime = packedConnections.departureTimes[connectionIndex];
+      if (connectionDepartureTime < departureTimeSeconds + minAccessTravelTime)
+      {
+        continue;
+      }
+      if (connectionDepartureTime > lastArrivalTime || connectionDepartureTime - departureTimeSeconds > parameters.getMaxTotalTravelTimeSeconds())
+      {
+        break;
+      }
+      Trip::uid_t tripUid = packedConnections.tripUids[connectionIndex];
+      if (isTripDisabled(tripUid))
+      {
+        continue;
+      }
+      Node::uid_t nodeDepartureUid = packedConnections.departureNodeUids[connectionIndex];
+      int connectionReadyTime = connectionDepartureTime - packedConnections.getMinWaitingTimeOrDefault(connectionIndex, parameters.getMinWaitingTimeSeconds());
+      bool canBoard   = packedConnections.canBoard(connectionIndex);
+      bool canUnboard = packedConnections.canUnboard(connectionIndex);
+
+      // A trip boarded with n legs can be boarded from the node labels with n - 1 legs, or n legs for a transferable trip
+      int tripLegs = forwardConnections[connectionIndex].get().getTrip().line.mode.isTransferable() ? 0 : 1;
+      int maxTripLegs = connectionDepartureTime > singleLegArrivalTime ? 0 : (int)maxLegs;
+      for (int legs = maxTripLegs; legs >= tripLegs; legs--)
+      {
+        int boardingLegs = legs - tripLegs;
+        auto & tripEnterConnection = tripsEnterConnectionByLegs[legs][tripUid];
+        if (!tripEnterConnection.has_value())
+        {
+          if (!canBoard || nodesTentativeTimeByLegs[boardingLegs].get(nodeDepartureUid) > connectionReadyTime)
+          {
+            continue;
+          }
+          // Limit the first waiting time when boarding directly from the origin
+          const JourneyStep & previousStep = forwardJourneysStepsByLegs[boardingLegs].get(nodeDepartureUid);
+          if (parameters.getMaxFirstWaitingTimeSeconds() > 0 && !previousStep.hasConnections() && connectionDepartureTime - nodesTentativeTimeByLegs[boardingLegs].get(nodeDepartureUid) > parameters.getMaxFirstWaitingTimeSeconds())
+          {
+            continue;
+          }
+          tripEnterConnection = forwardConnections[connectionIndex];
+          reachableConnectionsCount++;
+        }
+
+        if (!canUnboard)
+        {
+          continue;
+        }
+
+        const Connection & connection = forwardConnections[connectionIndex];
+        const Node & nodeArrival = connection.getArrivalNode();
+        int connectionArrivalTime = packedConnections.arrivalTimes[connectionIndex];
+
+        auto nodeArrivalInNodesEgressIte = nodesEgress.find(nodeArrival.uid);
+        if (nodeArrivalInNodesEgressIte != nodesEgress.end() && nodeArrivalInNodesEgressIte->second.time >= 0)
+        {
+          int egressArrivalTime = connectionArrivalTime + nodeArrivalInNodesEgressIte->second.time;
+          if (!bestEgressByLegs[legs].has_value() || egressArrivalTime < std::get<0>(bestEgressByLegs[legs].value()))
+          {
+            bestEgressByLegs[legs] = std::make_tuple(egressArrivalTime, std::cref(nodeArrival), JourneyStep(tripEnterConnection, std::cref(connection), std::cref(connection.getTrip()), 0, true, 0));
+          }
+          if (egressArrivalTime < bestArrivalTime)
+          {
+            bestArrivalTime = egressArrivalTime;
+          }
+          // Journeys with the fewest legs arrive the latest, once they are found, later connections are useless.
+          // After the single leg journey, only journeys without legs, on transferable trips, can still be improved
+          if (bestEgressByLegs[0].has_value())
+          {
+            lastArrivalTime = std::get<0>(bestEgressByLegs[0].value());
+          }
+          if (bestEgressByLegs[1].has_value())
+          {
+            singleLegArrivalTime = std::get<0>(bestEgressByLegs[1].value());
+          }
+          lastArrivalTime = std::min(lastArrivalTime, departureTimeSeconds + getMultiCriteriaMaxTravelTime(parameters, bestArrivalTime - departureTimeSeconds));
+        }
+
+        for (const NodeTimeDistance & transferableNode : nodeArrival.transferableNodes)
+        {
+          //TODO We should not do a direct == with float values
+          int footpathTravelTime = parameters.getWalkingSpeedFactor() == 1.0 ? transferableNode.time : (int)ceil((float)transferableNode.time / parameters.getWalkingSpeedFactor());
+          if (footpathTravelTime > parameters.getMaxTransferWalkingTravelTimeSeconds())
+          {
+            continue;
+          }
+          int transferArrivalTime = connectionArrivalTime + footpathTravelTime;
+          // A label with n legs is also valid for more legs, stop at the first label that is already as good
+          for (size_t legsLabel = legs; legsLabel <= maxLegs; legsLabel++)
+          {
+            if (transferArrivalTime >= nodesTentativeTimeByLegs[legsLabel].get(transferableNode.node.uid))
+            {
+              break;
+            }
+            nodesTentativeTimeByLegs[legsLabel][transferableNode.node.uid] = transferArrivalTime;
+            forwardJourneysStepsByLegs[legsLabel][transferableNode.node.uid] = JourneyStep(tripEnterConnection, std::cref(connection), std::cref(connection.getTrip()), footpathTravelTime, nodeArrival == transferableNode.node, transferableNode.distance);
+          }
+        }
+      }
+    }
+
+    spdlog::debug("-- multi-criteria calculation -- {} connections boarded with at most {} legs", reachableConnectionsCount, maxLegs);
+
+    if (reachableConnectionsCount == 0)
+    {
+      throw NoRoutingFoundException(NoRoutingReason::NO_SERVICE_FROM_ORIGIN);
+    }
+
+    // Keep the journeys that arrive strictly earlier than all journeys with fewer legs, the fastest first like the alternatives
+    AlternativesResult alternatives = AlternativesResult();
+    alternatives.totalAlternativesCalculated = 1;
+    if (bestArrivalTime == MAX_INT)
+    {
+      throw NoRoutingFoundException(NoRoutingReason::NO_ROUTING_FOUND);
+    }
+    int maxArrivalTime = departureTimeSeconds + getMultiCriteriaMaxTravelTime(parameters, bestArrivalTime - departureTimeSeconds);
+    int fewerLegsArrivalTime = MAX_INT;
+    std::vector<std::unique_ptr<SingleCalculationResult>> journeys;
+    for (size_t legs = 0; legs <= maxLegs; legs++)
+    {
+      if (!bestEgressByLegs[legs].has_value())
+      {
+        continue;
+      }
+      auto & [egressArrivalTime, egressNode, egressJourneyStep] = bestEgressByLegs[legs].value();
+      if (egressArrivalTime >= fewerLegsArrivalTime || egressArrivalTime > maxArrivalTime)
+      {
+        continue;
+      }
+      fewerLegsArrivalTime = egressArrivalTime;
+      std::unique_ptr<SingleCalculationResult> journey = multiCriteriaJourney(parameters, legs, egressNode.get(), egressJourneyStep);
+      if (journey.get() != nullptr)
+      {
+        journeys.push_back(std::move(journey));
+      }
+    }
+    for (auto journeyIte = journeys.rbegin(); journeyIte != journeys.rend(); journeyIte++)
+    {
+      alternatives.alternatives.push_back(std::move(*journeyIte));
+    }
+
+    spdlog::debug("-- multi-criteria journeys -- {} journeys in the Pareto front", alternatives.alternatives.size());
+
+    if (alternatives.alternatives.empty())
+    {
+      throw NoRoutingFoundException(NoRoutingReason::NO_ROUTING_FOUND);
+    }
+    return alternatives;
+  }
+
+  std::unique_ptr<SingleCalculationResult> Calculator::multiCriteriaJourney(RouteParameters &parameters, size_t legsCount, const Node &egressNode, const JourneyStep &egressJourneyStep)
+  {
+    // Copy the steps of this journey to the journey steps, so the forward journey can be reused
+    forwardJourneysSteps.clear();
+    std::unordered_map<Node::uid_t, JourneyStep> forwardEgressJourneysSteps;
+    forwardEgressJourneysSteps.insert_or_assign(egressNode.uid, egressJourneyStep);
+
+    std::unordered_set<Node::uid_t> boardingNodes;
+    JourneyStep currentStep = egressJourneyStep;
+    std::reference_wrapper<const Connection> firstEnterConnection = egressJourneyStep.getFinalEnterConnection().value();
+    size_t legs = legsCount;
+    while (currentStep.hasConnections())
+    {
+      firstEnterConnection = currentStep.getFinalEnterConnection().value();
+      const Node & boardingNode = firstEnterConnection.get().getDepartureNode();
+      // Labels are only improved during the scan, but make sure a journey does not go through the same node twice
+      if (!boardingNodes.insert(boardingNode.uid).second)
+      {
+        spdlog::debug("Multi-criteria journey boards twice at node {}", boardingNode.name);
+        return nullptr;
+      }
+      // Transferable trips were boarded from the labels with the same number of legs
+      if (!firstEnterConnection.get().getTrip().line.mode.isTransferable())
+      {
+        if (legs == 0)
+        {
+          spdlog::debug("Multi-criteria journey has more legs than its label");
+          return nullptr;
+        }
+        legs--;
+      }
+      currentStep = forwardJourneysStepsByLegs[legs].get(boardingNode.uid);
+      forwardJourneysSteps[boardingNode.uid] = currentStep;
+    }
+
+    // Leave the origin as late as possible for the first boarding, like the reverse calculation does for the single route
+    int queryDepartureTime = departureTimeSeconds;
+    const Connection & firstConnection = firstEnterConnection.get();
+    departureTimeSeconds = firstConnection.getDepartureTime() - nodesAccess.at(firstConnection.getDepartureNode().uid).time - firstConnection.getMinWaitingTimeOrDefault(parameters.getMinWaitingTimeSeconds());
+    std::unique_ptr<SingleCalculationResult> journey = forwardJourneyStep(parameters, egressNode, forwardEgressJourneysSteps);
+    departureTimeSeconds = queryDepartureTime;
+    return journey;
+  }
+
+}
@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <filesystem>
+#include "spdlog/spdlog.h"
+
+#include "od_trips_checkpoint.hpp"
+
+namespace TrRouting
+{
+
+  OdTripsCheckpoint::OdTripsCheckpoint(const std::string &_filePath) :
+    filePath(_filePath),
+    resultsFilePath(_filePath + ".odtrips.ndjson"),
+    savedOdTripsCount(0),
+    writtenOdTripsCount(0),
+    resultsFileSize(0)
+  {
+
+  }
+
+  std::optional<nlohmann::json> OdTripsCheckpoint::load() const
+  {
+    std::ifstream checkpointFile(filePath);
+    if (!checkpointFile.is_open())
+    {
+      return std::nullopt;
+    }
+    try {
+      nlohmann::json state = nlohmann::json::parse(checkpointFile);
+      if (!state.contains("odTripsCount") || !state.contains("resultsFileSize"))
+      {
+        spdlog::warn("Ignoring incomplete od trips checkpoint {}", filePath);
+        return std::nullopt;
+      }
+      return state;
+    } catch (const nlohmann::json::exception &e) {
+      spdlog::warn("Ignoring invalid od trips checkpoint {}: {}", filePath, e.what());
+      return std::nullopt;
+    }
+  }
+
+  void OdTripsCheckpoint::resume(const std::optional<nlohmann::json> &state, const std::function<void(const nlohmann::json &)> &onOdTrip)
+  {
+    savedOdTripsCount = 0;
+    resultsFileSize = 0;
+    if (state.has_value())
+    {
+      savedOdTripsCount = state.value()["odTripsCount"].get<size_t>();
+      resultsFileSize = state.value()["resultsFileSize"].get<uintmax_t>();
+
+      std::ifstream savedResultsFile(resultsFilePath);
+      std::string line;
+      for (size_t i = 0; i < savedOdTripsCount; i++)
+      {
+        if (!std::getline(savedResultsFile, line))
+        {
+          throw std::runtime_error("Missing od trip results in " + resultsFilePath);
+        }
+        onOdTrip(nlohmann::json::parse(line));
+      }
+    }
+    writtenOdTripsCount = savedOdTripsCount;
+
+    // Drop the results written after the checkpoint
+    resultsFile.close();
+    resultsFile.open(resultsFilePath, std::ios::out | std::ios::app);
+    resultsFile.close();
+    std::filesystem::resize_file(resultsFilePath, resultsFileSize);
+    resultsFile.open(resultsFilePath, std::ios::out | std::ios::app);
+  }
+
+  void OdTripsCheckpoint::writeOdTrip(const nlohmann::json &odTripJson)
+  {
+    std::string line = odTripJson.dump() + '\n';
+    resultsFile << line;
+    resultsFileSize += line.size();
+    writtenOdTripsCount++;
+  }
+
+  bool OdTripsCheckpoint::save(nlohmann::json state)
+  {
+    resultsFile.flush();
+    if (!resultsFile)
+    {
+      spdlog::error("Error writing od trips results {}", resultsFilePath);
+      return false;
+    }
+    state["odTripsCount"] = writtenOdTripsCount;
+    state["resultsFileSize"] = resultsFileSize;
+
+    // Write to a temporary file first, so an interrupted save keeps the previous checkpoint
+    std::string temporaryFilePath = filePath + ".tmp";
+    std::ofstream checkpointFile(temporaryFilePath, std::ios::out | std::ios::trunc);
+    checkpointFile << state.dump();
+    checkpointFile.close();
+    if (!checkpointFile || std::rename(temporaryFilePath.c_str(), filePath.c_str()) != 0)
+    {
+      spdlog::error("Error writing od trips checkpoint {}", filePath);
+      return false;
+    }
+    savedOdTripsCount = writtenOdTripsCount;
+    spdlog::info("Saved od trips checkpoint {} after {} od trips", filePath, savedOdTripsCount);
+    return true;
+  }
+
+  void OdTripsCheckpoint::remove()
+  {
+    resultsFile.close();
+    std::remove(filePath.c_str());
+    std::remove(resultsFilePath.c_str());
+  }
+
+}
@@ -1,4 +1,6 @@
 #include <random>
+#include <algorithm>
+#include <mutex>
 #include "spdlog/spdlog.h"
 #include <nlohmann/json.hpp>
 
@@ -16,6 +18,11 @@
 #include "od_trip.hpp"
 #include "node.hpp"
 #include "transit_data.hpp"
+#include "calculator_pool.hpp"
+#include "worker_pool.hpp"
+#include "od_trips_writer.hpp"
+#include "od_trips_checkpoint.hpp"
+#include "connection_set.hpp"
 
 namespace TrRouting
 {
@@ -79,6 +86,7 @@ namespace TrRouting
     void visitSingleCalculationResult(const SingleCalculationResult& result) override;
     void visitAlternativesResult(const AlternativesResult& result) override;
     void visitAllNodesResult(const AllNodesResult& result) override;
+    void visitProfileResult(const ProfileResult& result) override;
   };
 
   void ResultToOdTripJsonVisitor::visitSingleCalculationResult(const SingleCalculationResult& result)
@@ -134,6 +142,13 @@ namespace TrRouting
     response = json;
   }
 
+  void ResultToOdTripJsonVisitor::visitProfileResult(const ProfileResult& )
+  {
+    nlohmann::json json;
+    // This type of result should not be visited here
+    response = json;
+  }
+
   nlohmann::json noRoutingFoundResultToJson(RouteParameters& params)
   {
     nlohmann::json json;
@@ -145,48 +160,343 @@ namespace TrRouting
     return json;
   }
 
+
+  // Minimum number of od trips taken at once by a worker thread
+  static const size_t OD_TRIPS_CHUNK_SIZE = 32;
+  //TODO Why is it 28 ? That seems too many hours in a day
+  // Number of hours in the path profiles, from 0 to 28
+  static const int OD_TRIPS_PROFILE_HOURS_COUNT = 29;
+
+  // Routing of a single od trip, kept until its demand is added to the profiles
+  class OdTripRoutingResult {
+  public:
+    nlohmann::json json;
+    std::vector<Leg> legs;
+    float expansionFactor {0.0};
+    int totalTravelTime {0};
+    bool forwardCalculationReused {false}; // whether the forward calculation of a previous od trip of the group was used
+    int scannedConnectionsCount {0}; // forward connections scanned for this od trip, 0 if reused
+  };
+
+  bool odTripMatchesParameters(const OdTrip &odTrip, const OdTripLegacyParameters &params)
+  {
+    // verify that od trip matches selected attributes:
+    // TODO Find a way to simplify this if
+    if ( (params.odTripsAgeGroups.size()   > 0 && (!odTrip.person.has_value() || (std::find(params.odTripsAgeGroups.begin(),   params.odTripsAgeGroups.end(), odTrip.person.value().get().ageGroup) == params.odTripsAgeGroups.end())))
+         || (params.odTripsGenders.size()  > 0 && (!odTrip.person.has_value() || (std::find(params.odTripsGenders.begin(),     params.odTripsGenders.end(), odTrip.person.value().get().gender) == params.odTripsGenders.end())))
+         || (params.odTripsOccupations.size() > 0 &&  (!odTrip.person.has_value() || (std::find(params.odTripsOccupations.begin(), params.odTripsOccupations.end(), odTrip.person.value().get().occupation) == params.odTripsOccupations.end())))
+      || (params.odTripsActivities.size()  > 0 && std::find(params.odTripsActivities.begin(),  params.odTripsActivities.end(),  odTrip.destinationActivity)            == params.odTripsActivities.end())
+      || (params.odTripsModes.size()       > 0 && std::find(params.odTripsModes.begin(),       params.odTripsModes.end(),       odTrip.mode)                           == params.odTripsModes.end())
+    )
+    {
+      return false;
+    }
+
+    // filter wrong data source if only data source is provided:
+    if (params.onlyDataSource && odTrip.dataSource != params.onlyDataSource.value())
+    {
+      return false;
+    }
+
+    // verify that od trip matches at least one selected period:
+    if (params.odTripsPeriods.size() == 0)
+    {
+      return true;
+    }
+    for (auto & period : params.odTripsPeriods)
+    {
+      if (odTrip.departureTimeSeconds >= period.first && odTrip.departureTimeSeconds < period.second)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Order of the od trips by departure time and access nodes, the od trips of a group are equivalent
+  int compareOdTripsOrigins(const OdTrip &odTripA, const OdTrip &odTripB)
+  {
+    if (odTripA.departureTimeSeconds != odTripB.departureTimeSeconds)
+    {
+      return odTripA.departureTimeSeconds < odTripB.departureTimeSeconds ? -1 : 1;
+    }
+    if (odTripA.originNodes.size() != odTripB.originNodes.size())
+    {
+      return odTripA.originNodes.size() < odTripB.originNodes.size() ? -1 : 1;
+    }
+    for (size_t i = 0; i < odTripA.originNodes.size(); i++)
+    {
+      const NodeTimeDistance &nodeA = odTripA.originNodes[i];
+      const NodeTimeDistance &nodeB = odTripB.originNodes[i];
+      if (nodeA.node.uid != nodeB.node.uid)
+      {
+        return nodeA.node.uid < nodeB.node.uid ? -1 : 1;
+      }
+      if (nodeA.time != nodeB.time)
+      {
+        return nodeA.time < nodeB.time ? -1 : 1;
+      }
+      if (nodeA.distance != nodeB.distance)
+      {
+        return nodeA.distance < nodeB.distance ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  // Create a parameter that is a copy of the original parameters, except for the origin and destination
+  RouteParameters createOdTripParameters(RouteParameters &parameters, const OdTrip &odTrip)
+  {
+    return RouteParameters(std::make_unique<Point>(odTrip.origin.get()->latitude, odTrip.origin.get()->longitude),
+      std::make_unique<Point>(odTrip.destination.get()->latitude, odTrip.destination.get()->longitude),
+      parameters.isWithAlternatives(),
+      parameters);
+  }
+
+  // Add the od trip fields to its result
+  void addOdTripFields(nlohmann::json &odTripJson, const OdTrip &odTrip, float expansionFactor)
+  {
+    odTripJson["uuid"] = boost::uuids::to_string(odTrip.uuid);
+    odTripJson["internalId"]                    = odTrip.internalId;
+    odTripJson["originActivity"]                = odTrip.originActivity;
+    odTripJson["destinationActivity"]           = odTrip.destinationActivity;
+    odTripJson["declaredMode"]                  = odTrip.mode;
+    odTripJson["expansionFactor"]               = expansionFactor;
+    odTripJson["onlyWalkingTravelTimeSeconds"]  = odTrip.walkingTravelTimeSeconds;
+    odTripJson["onlyCyclingTravelTimeSeconds"]  = odTrip.cyclingTravelTimeSeconds;
+    odTripJson["onlyDrivingTravelTimeSeconds"]  = odTrip.drivingTravelTimeSeconds;
+    odTripJson["declaredDepartureTimeSeconds"]  = odTrip.departureTimeSeconds;
+    odTripJson["declaredArrivalTimeSeconds"]    = odTrip.arrivalTimeSeconds;
+  }
+
+  OdTripRoutingResult Calculator::odTripRouting(RouteParameters &parameters, const OdTrip &odTrip, float sampleRatio, bool &resetFilters)
+  {
+    //TODO We need to initialise the global odTrip object. Downstream calculation needs it. (Mostly in reset() it seems).
+    // Should be changed to not have to rely on this global variable.
+    // (Code was changed to work with a local odTrip, but we still need to set the global one)
+    odTripGlob = odTrip;
+    lastForwardScannedConnectionsCount = 0;
+
+    RouteParameters odTripParameters = createOdTripParameters(parameters, odTrip);
+
+    OdTripRoutingResult result;
+    result.expansionFactor = odTrip.expansionFactor / sampleRatio;
+    try {
+      std::unique_ptr<RoutingResult> routingResult = calculateSingle(odTripParameters, true, resetFilters); // reset filters only on first calculation
+      resetFilters = false;
+      ResultToOdTripJsonVisitor visitor = ResultToOdTripJsonVisitor(odTripParameters);
+      result.json = routingResult.get()->accept(visitor);
+      result.legs = visitor.getLegs();
+      if (result.legs.size() > 0)
+      {
+        result.totalTravelTime = visitor.getTotalTravelTime();
+      }
+    } catch (NoRoutingFoundException& e) {
+      result.json = noRoutingFoundResultToJson(odTripParameters);
+    } catch (...) {
+      odTripGlob.reset();
+      throw;
+    }
+    // The calculator may be used for other queries afterwards
+    odTripGlob.reset();
+    result.scannedConnectionsCount = lastForwardScannedConnectionsCount;
+
+    // Add additional fields to response
+    addOdTripFields(result.json, odTrip, result.expansionFactor);
+    return result;
+  }
+
+  std::vector<OdTripRoutingResult> Calculator::odTripsGroupRouting(RouteParameters &parameters, const std::vector<std::reference_wrapper<const OdTrip>> &odTrips, float sampleRatio, bool &resetFilters)
+  {
+    std::vector<OdTripRoutingResult> results(odTrips.size());
+    for (size_t i = 0; i < odTrips.size(); i++)
+    {
+      results[i].expansionFactor = odTrips[i].get().expansionFactor / sampleRatio;
+      results[i].forwardCalculationReused = i > 0;
+    }
+
+    // Forward calculation from the common origin, without destination, so it is not stopped when reaching one of them
+    std::unordered_map<Node::uid_t, JourneyStep> forwardEgressJourneysSteps;
+    bool forwardCalculationOk = true;
+    odTripGlob = odTrips[0].get();
+    lastForwardScannedConnectionsCount = 0;
+    try {
+      RouteParameters originParameters = createOdTripParameters(parameters, odTrips[0].get());
+      reset(originParameters, *originParameters.getOrigin(), std::nullopt, true, resetFilters);
+      resetFilters = false;
+      nodesEgress.clear();
+      forwardBoardedTrips.clear();
+      nodesFirstUnboardingIndex.reset(transitData.getNodesMaxUid() + 1, -1);
+      recordForwardBoardings = true;
+      forwardCalculation(originParameters, forwardEgressJourneysSteps);
+      recordForwardBoardings = false;
+    } catch (NoRoutingFoundException& e) {
+      // No od trip of the group can be routed
+      recordForwardBoardings = false;
+      forwardCalculationOk = false;
+    } catch (...) {
+      recordForwardBoardings = false;
+      odTripGlob.reset();
+      throw;
+    }
+    results[0].scannedConnectionsCount = lastForwardScannedConnectionsCount;
+
+    const PackedConnections & packedConnections = connectionSet.get()->getForwardPackedConnections();
+    size_t usableTripsCount = forwardBoardedTrips.size(); // All boarded trips are usable after the forward calculation
+    size_t exitTripsCount = 0; // Trips that may have an exit connection from the previous reverse calculation
+    for (size_t i = 0; i < odTrips.size(); i++)
+    {
+      const OdTrip &odTrip = odTrips[i].get();
+      OdTripRoutingResult &result = results[i];
+      odTripGlob = odTrip;
+      RouteParameters odTripParameters = createOdTripParameters(parameters, odTrip);
+      try {
+        if (!forwardCalculationOk)
+        {
+          throw NoRoutingFoundException(NoRoutingReason::NO_ROUTING_FOUND);
+        }
+        arrivalTimeSeconds = -1;
+        if (!resetDestination(odTripParameters, *odTripParameters.getDestination(), true))
+        {
+          throw NoRoutingFoundException(NoRoutingReason::NO_ACCESS_AT_DESTINATION);
+        }
+        auto bestEgress = getBestEgressNode(odTripParameters, forwardEgressJourneysSteps);
+        if (!bestEgress.has_value())
+        {
+          throw NoRoutingFoundException(NoRoutingReason::NO_ROUTING_FOUND);
+        }
+
+        // The forward calculation for this destination alone would stop after the connections departing later than the
+        // first arrival at one of its egress nodes plus the max egress time. Only the trips boarded until then are usable
+        int firstUnboardingIndex = -1;
+        for (auto & egressFootpath : egressFootpaths)
+        {
+          int unboardingIndex = nodesFirstUnboardingIndex.get(egressFootpath.node.uid);
+          if (unboardingIndex != -1 && nodesEgress.at(egressFootpath.node.uid).time != -1 && (firstUnboardingIndex == -1 || unboardingIndex < firstUnboardingIndex))
+          {
+            firstUnboardingIndex = unboardingIndex;
+          }
+        }
+        int lastBoardingDepartureTime = MAX_INT;
+        if (firstUnboardingIndex != -1 && maxEgressTravelTime >= 0)
+        {
+          lastBoardingDepartureTime = packedConnections.arrivalTimes[firstUnboardingIndex] + maxEgressTravelTime;
+        }
+        size_t tripsCount = std::upper_bound(forwardBoardedTrips.begin(), forwardBoardedTrips.end(), lastBoardingDepartureTime, [this](int departureTime, Trip::uid_t tripUid) {
+          return departureTime < tripsQueryOverlay[tripUid].enterConnection.value().get().getDepartureTime();
+        }) - forwardBoardedTrips.begin();
+        for (size_t tripIndex = tripsCount; tripIndex < usableTripsCount; tripIndex++)
+        {
+          tripsQueryOverlay[forwardBoardedTrips[tripIndex]].usable = false;
+        }
+        for (size_t tripIndex = usableTripsCount; tripIndex < tripsCount; tripIndex++)
+        {
+          tripsQueryOverlay[forwardBoardedTrips[tripIndex]].usable = true;
+        }
+        usableTripsCount = tripsCount;
+        // The reverse calculation only sets the exit connection of usable trips
+        for (size_t tripIndex = 0; tripIndex < exitTripsCount; tripIndex++)
+        {
+          TripQueryData &tripQueryData = tripsQueryOverlay[forwardBoardedTrips[tripIndex]];
+          tripQueryData.exitConnection = std::nullopt;
+          tripQueryData.exitConnectionTransferTravelTime = MAX_INT;
+        }
+        exitTripsCount = usableTripsCount;
+
+        arrivalTimeSeconds = std::get<0>(*bestEgress);
+        for (auto & egressFootpath : egressFootpaths) // reset nodes reverse tentative times with new arrival time:
+        {
+          nodesReverseTentativeTime[egressFootpath.node.uid] = arrivalTimeSeconds - egressFootpath.time;
+        }
+        std::unique_ptr<RoutingResult> routingResult = calculateSingleReverse(odTripParameters);
+        ResultToOdTripJsonVisitor visitor = ResultToOdTripJsonVisitor(odTripParameters);
+        result.json = routingResult.get()->accept(visitor);
+        result.legs = visitor.getLegs();
+        if (result.legs.size() > 0)
+        {
+          result.totalTravelTime = visitor.getTotalTravelTime();
+        }
+      } catch (NoRoutingFoundException& e) {
+        result.json = noRoutingFoundResultToJson(odTripParameters);
+      } catch (...) {
+        odTripGlob.reset();
+        throw;
+      }
+      addOdTripFields(result.json, odTrip, result.expansionFactor);
+    }
+    // The calculator may be used for other queries afterwards
+    odTripGlob.reset();
+    return results;
+  }
+
   std::string Calculator::odTripsRouting(RouteParameters &parameters)
+  {
+    OdTripsJsonWriter writer;
+    odTripsRouting(parameters, writer);
+    return writer.getJsonString();
+  }
+
+  void Calculator::odTripsRouting(RouteParameters &parameters, OdTripsWriter &writer, const OdTripLegacyParameters &odTripParameters)
+  {
+    odTripsRoutingByChunks(parameters, transitData, [this](size_t chunksCount, const std::function<void(size_t, Calculator &)> &task) {
+      for (size_t chunkIndex = 0; chunkIndex < chunksCount; chunkIndex++)
+      {
+        task(chunkIndex, *this);
+      }
+    }, writer, odTripParameters);
+  }
+
+  std::string Calculator::odTripsRouting(RouteParameters &parameters, const TransitData &transitData, CalculatorPool &calculatorPool, WorkerPool &workerPool)
+  {
+    OdTripsJsonWriter writer;
+    odTripsRouting(parameters, transitData, calculatorPool, workerPool, writer);
+    return writer.getJsonString();
+  }
+
+  void Calculator::odTripsRouting(RouteParameters &parameters, const TransitData &transitData, CalculatorPool &calculatorPool, WorkerPool &workerPool, OdTripsWriter &writer, const OdTripLegacyParameters &odTripParameters)
+  {
+    odTripsRoutingByChunks(parameters, transitData, [&transitData, &calculatorPool, &workerPool](size_t chunksCount, const std::function<void(size_t, Calculator &)> &task) {
+      workerPool.run(chunksCount, [&](size_t chunkIndex) {
+        Calculator &calculator = calculatorPool.getCalculator(transitData);
+        CalculatorRelease calculatorRelease(calculatorPool);
+        task(chunkIndex, calculator);
+      });
+    }, writer, odTripParameters);
+  }
+
+  void Calculator::odTripsRoutingByChunks(RouteParameters &parameters, const TransitData &transitData, const OdTripsChunksRunner &runChunks, OdTripsWriter &writer, const OdTripLegacyParameters &params)
   {
     
     spdlog::debug("  preparing odTripsRouting");
 
-    std::unique_ptr<RoutingResult>  routingResult;
-    nlohmann::json json;
-    nlohmann::json odTripJson;
     nlohmann::json lineProfilesJson;
     nlohmann::json pathProfilesJson;
-    std::map<boost::uuids::uuid, float> lineProfiles; // key: line uuid, value: count od trips using this line
-    std::map<boost::uuids::uuid, std::vector<std::vector<float>>> pathProfiles; // key: path uuid, value: [index: segment index, value: [index: hourOfDay, demand]]
-    std::map<boost::uuids::uuid, std::vector<float>> pathTotalProfiles; // key: path uuid, value: [index: segment index, value: totalDemand]
-    std::vector<float> demandByHourOfDay;
+    // The profiles are flat arrays indexed by uid, they are converted to json by uuid only for the output
+    std::vector<float> lineProfiles(transitData.getLinesMaxUid() + 1, 0.0); // index: Line::uid, value: count od trips using this line
+    std::vector<int> pathsFirstSegmentIndex(transitData.getPathsMaxUid() + 1, -1); // index: Path::uid, value: index of the first segment of the path in the segment profiles
+    std::vector<bool> pathsUsed(transitData.getPathsMaxUid() + 1, false); // index: Path::uid, only the used paths are in the output
+    std::vector<float> pathProfiles; // index: (first segment index of the path + segment index) * hours count + hourOfDay, value: demand
+    std::vector<float> pathTotalProfiles; // index: first segment index of the path + segment index, value: totalDemand
  
     int    legConnectionStartIdx;
     int    legConnectionEndIdx;
     int    connectionDepartureTimeSeconds;
     int    connectionDepartureTimeHour;
-    bool   atLeastOneCompatiblePeriod {false};
-    bool   attributesMatches          {true};
-    bool   resetFilters               {true};
     int    odTripsCount = transitData.getOdTrips().size();
     float  maximumSegmentHourlyDemand = 0.0;
     float  maximumSegmentTotalDemand  = 0.0;
     int    totalTravelTimeSeconds     = 0;
 
-    // Moved the legacy V1 parameters into this object. For now, we don't have an API for it
-    // So it's just a series of constants
-    OdTripLegacyParameters params;
-    json["odTrips"] = nlohmann::json::array();
-
-    // Initialize lineProfiles
-    for (auto & linePair : transitData.getLines())
+    // Initialize the path profiles, with the segments of each path one after the other
+    int segmentsCount = 0;
+    for (auto & pathPair : transitData.getPaths())
     {
-      lineProfiles[linePair.first] = 0.0;
-    }
-    //TODO Why is it 28 ? That seems too many hours in a day
-    for (int i = 0; i <= 28; i++)
-    {
-      demandByHourOfDay.push_back(0.0);
+      const Path &path = pathPair.second;
+      pathsFirstSegmentIndex[path.uid] = segmentsCount;
+      segmentsCount += std::max(0, (int)path.nodesRef.size() - 1);
     }
+    pathProfiles.resize(segmentsCount * OD_TRIPS_PROFILE_HOURS_COUNT, 0.0);
+    pathTotalProfiles.resize(segmentsCount, 0.0);
 
     spdlog::debug("  starting odTripsRouting (count: {})", odTripsCount);
 
@@ -196,178 +506,298 @@ namespace TrRouting
     for (auto odTripIte = transitData.getOdTrips().begin(); odTripIte != transitData.getOdTrips().end(); odTripIte++) {
       odTripVector.push_back(odTripIte->second);
     }
-    
-    int stopAtI {-1}; //TODO Seem unused
 
     if (odTripsCount == 0)
     {
-      return json.dump(2);
+      return;
     }
-    if (params.odTripsSampleRatio > 0.0 && params.odTripsSampleRatio < 1.0)
-    {
 
-      //std::random_device rd;
-      //std::mt19937 engine(rd(params.seed));
+    // Resume from the last checkpoint if it was saved by a run with the same od trips selection
+    std::optional<OdTripsCheckpoint> checkpoint;
+    std::optional<nlohmann::json> checkpointState;
+    nlohmann::json checkpointRunJson;
+    checkpointRunJson["odTripsCount"]       = odTripsCount;
+    checkpointRunJson["odTripsSampleRatio"] = params.odTripsSampleRatio;
+    checkpointRunJson["odTripsSampleSize"]  = params.odTripsSampleSize;
+    checkpointRunJson["batchNumber"]        = params.batchNumber;
+    checkpointRunJson["batchesCount"]       = params.batchesCount;
+    checkpointRunJson["onlyDataSource"]     = params.onlyDataSource.has_value() ? boost::uuids::to_string(params.onlyDataSource.value().uuid) : "";
+    checkpointRunJson["odTripsPeriods"]     = params.odTripsPeriods;
+    checkpointRunJson["odTripsGenders"]     = params.odTripsGenders;
+    checkpointRunJson["odTripsAgeGroups"]   = params.odTripsAgeGroups;
+    checkpointRunJson["odTripsOccupations"] = params.odTripsOccupations;
+    checkpointRunJson["odTripsActivities"]  = params.odTripsActivities;
+    checkpointRunJson["odTripsModes"]       = params.odTripsModes;
+    checkpointRunJson["groupOdTrips"]       = params.groupOdTrips && parameters.isForwardCalculation();
+    if (!params.checkpointFilePath.empty())
+    {
+      checkpoint.emplace(params.checkpointFilePath);
+      checkpointState = checkpoint->load();
+      if (checkpointState.has_value() && checkpointState.value()["run"] != checkpointRunJson)
+      {
+        spdlog::warn("The od trips checkpoint {} is for another run, starting from the beginning", params.checkpointFilePath);
+        checkpointState.reset();
+      }
+    }
+    // The seed of the checkpoint is used when resuming, so the od trips are shuffled the same way
+    unsigned int seed = checkpointState.has_value() ? checkpointState.value()["seed"].get<unsigned int>() : params.seed;
 
-      //std::cout << " shuffle odTrips with seed: " << params.seed << " generates number " << engine() << std::endl;
-      //engine.seed(params.seed);
+    if (params.odTripsSampleRatio > 0.0 && params.odTripsSampleRatio < 1.0)
+    {
       // sort by departure time seconds before shuffling so seeds are consistent:
-
       spdlog::debug(" first ODTrip uuid: {} ", boost::uuids::to_string(odTripVector[0].get().uuid));
-      std::shuffle(odTripVector.begin(), odTripVector.end(), std::mt19937{params.seed});
+      std::shuffle(odTripVector.begin(), odTripVector.end(), std::mt19937{seed});
       spdlog::debug(" first ODTrip uuid after shuffle: {}", boost::uuids::to_string(odTripVector[0].get().uuid));
-      //stopAtI = ceil((float)(odTrips.size()) * params.odTripsSampleRatio);
     }
 
-
     int sampleSize {(int)(ceil((float)(odTripsCount) * params.odTripsSampleRatio))};
 
+    // Indexes in odTripVector of the od trips to route, in the order of the sequential calculation
+    std::vector<int> routedOdTripIndexes;
     for (int i = 0; i < sampleSize; i++)
     {
-
-      const OdTrip & odTrip = odTripVector[i].get();
-      //TODO We need to initialise the global odTrip object. Downstream calculation needs it. (Mostly in reset() it seems).
-      // Should be changed to not have to rely on this global variable.
-      // (Code was changed to work with a local odTrip, but we still need to set the global one)
-      odTripGlob = odTrip;
-
       if ( i % params.batchesCount != params.batchNumber - 1) // when using multiple parallel calculators
       {
         continue;
       }
 
-      /*if (stopAtI != -1 && i == stopAtI)
-      {
-        break;
-      }*/
-
-      attributesMatches          = true;
-      atLeastOneCompatiblePeriod = false;
-
-      // verify that od trip matches selected attributes:
-      // TODO Find a way to simplify this if
-      if ( (params.odTripsAgeGroups.size()   > 0 && (!odTrip.person.has_value() || (std::find(params.odTripsAgeGroups.begin(),   params.odTripsAgeGroups.end(), odTrip.person.value().get().ageGroup) == params.odTripsAgeGroups.end())))
-           || (params.odTripsGenders.size()  > 0 && (!odTrip.person.has_value() || (std::find(params.odTripsGenders.begin(),     params.odTripsGenders.end(), odTrip.person.value().get().gender) == params.odTripsGenders.end())))
-           || (params.odTripsOccupations.size() > 0 &&  (!odTrip.person.has_value() || (std::find(params.odTripsOccupations.begin(), params.odTripsOccupations.end(), odTrip.person.value().get().occupation) == params.odTripsOccupations.end())))
-        || (params.odTripsActivities.size()  > 0 && std::find(params.odTripsActivities.begin(),  params.odTripsActivities.end(),  odTrip.destinationActivity)            == params.odTripsActivities.end())
-        || (params.odTripsModes.size()       > 0 && std::find(params.odTripsModes.begin(),       params.odTripsModes.end(),       odTrip.mode)                           == params.odTripsModes.end())
-      )
+      if (odTripMatchesParameters(odTripVector[i].get(), params))
       {
-        attributesMatches = false;
+        routedOdTripIndexes.push_back(i);
       }
 
-      // filter wrong data source if only data source is provided:
-      if (params.onlyDataSource && odTrip.dataSource != params.onlyDataSource.value())
+      if (params.odTripsSampleSize > 0 && i + 1 >= params.odTripsSampleSize)
       {
-        attributesMatches = false;
+        break;
       }
+    }
 
-      // verify that od trip matches at least one selected period:
-      for (auto & period : params.odTripsPeriods)
+    // Group the od trips with the same departure time and access nodes, they are routed with a single forward calculation
+    bool groupOdTrips = params.groupOdTrips && parameters.isForwardCalculation();
+    if (groupOdTrips)
+    {
+      std::stable_sort(routedOdTripIndexes.begin(), routedOdTripIndexes.end(), [&odTripVector](int indexA, int indexB) {
+        return compareOdTripsOrigins(odTripVector[indexA].get(), odTripVector[indexB].get()) < 0;
+      });
+    }
+
+    // Split the od trips in chunks of at least OD_TRIPS_CHUNK_SIZE od trips, without splitting a group
+    std::vector<size_t> chunksStart;
+    std::vector<size_t> groupsStart;
+    for (size_t resultIndex = 0; resultIndex < routedOdTripIndexes.size(); resultIndex++)
+    {
+      bool newGroup = !groupOdTrips || resultIndex == 0 || compareOdTripsOrigins(odTripVector[routedOdTripIndexes[resultIndex - 1]].get(), odTripVector[routedOdTripIndexes[resultIndex]].get()) != 0;
+      if (!newGroup)
       {
-        if (odTrip.departureTimeSeconds >= period.first && odTrip.departureTimeSeconds < period.second)
-        {
-          atLeastOneCompatiblePeriod = true;
-        }
+        continue;
       }
-
-      if (attributesMatches && (atLeastOneCompatiblePeriod || params.odTripsPeriods.size() == 0))
+      if (chunksStart.empty() || resultIndex - chunksStart.back() >= OD_TRIPS_CHUNK_SIZE)
       {
+        chunksStart.push_back(resultIndex);
+      }
+      groupsStart.push_back(resultIndex);
+    }
+    chunksStart.push_back(routedOdTripIndexes.size());
+    groupsStart.push_back(routedOdTripIndexes.size());
 
-        spdlog::debug("od trip uuid {} ({}/{}) dts: {} atLeastOneCompatiblePeriod: {} attributesMatches: {}",
-                        to_string(odTrip.uuid),
-                        (i+1),
-                        odTripsCount,
-                        odTrip.departureTimeSeconds,
-                        (atLeastOneCompatiblePeriod ? "true" : "false"),
-                        (attributesMatches ? "true " : "false "));                       
+    int forwardCalculationsCount = 0;
+    int reusedForwardCalculationsCount = 0;
+    long long scannedConnectionsCount = 0;
 
-        if ((i + 1) % 1000 == 0)
+    // Add up the demand of an od trip and write it. This is done in the order of the od trips, so the floating point sums are the same as the sequential calculation
+    auto addResult = [&](const OdTripRoutingResult &result) {
+      float correctedExpansionFactor = result.expansionFactor;
+      if (result.legs.size() > 0)
+      {
+        totalTravelTimeSeconds += correctedExpansionFactor * result.totalTravelTime;
+        for (auto & leg : result.legs)
         {
-          if (stopAtI > 0)
+          const Trip &legTrip   = std::get<0>(leg).get();
+          const Line &legLine   = legTrip.line;
+          const Path &legPath   = legTrip.path;
+          legConnectionStartIdx = std::get<1>(leg);
+          legConnectionEndIdx   = std::get<2>(leg);
+          lineProfiles[legLine.uid] += correctedExpansionFactor;
+          pathsUsed[legPath.uid] = true;
+
+          int firstSegmentIndex = pathsFirstSegmentIndex[legPath.uid];
+          for (int connectionIndex = legConnectionStartIdx; connectionIndex <= legConnectionEndIdx; connectionIndex++)
           {
-            spdlog::info("{}/{}", (i+1), (stopAtI + 1));
+            connectionDepartureTimeSeconds = legTrip.connectionDepartureTimes[connectionIndex];
+            connectionDepartureTimeHour    = connectionDepartureTimeSeconds / 3600;
+
+            float &segmentHourlyDemand = pathProfiles[(firstSegmentIndex + connectionIndex) * OD_TRIPS_PROFILE_HOURS_COUNT + connectionDepartureTimeHour];
+            float &segmentTotalDemand  = pathTotalProfiles[firstSegmentIndex + connectionIndex];
+            segmentHourlyDemand += correctedExpansionFactor;
+            segmentTotalDemand  += correctedExpansionFactor;
+            if (maximumSegmentHourlyDemand < segmentHourlyDemand)
+            {
+              maximumSegmentHourlyDemand = segmentHourlyDemand;
+            }
+            if (maximumSegmentTotalDemand < segmentTotalDemand)
+            {
+              maximumSegmentTotalDemand = segmentTotalDemand;
+            }
           }
-          else
+        }
+      }
+      writer.writeOdTrip(result.json);
+      if (result.forwardCalculationReused)
+      {
+        reusedForwardCalculationsCount++;
+      }
+      else
+      {
+        forwardCalculationsCount++;
+      }
+      scannedConnectionsCount += result.scannedConnectionsCount;
+    };
+
+    // Save the progress and partial aggregates, with the lines and paths in the order of their uuid since the uids are not kept between runs
+    size_t nextChunkIndex = 0;
+    auto getCheckpointState = [&]() {
+      nlohmann::json state;
+      state["run"]                            = checkpointRunJson;
+      state["seed"]                           = seed;
+      state["chunksCount"]                    = nextChunkIndex;
+      state["totalTravelTimeSeconds"]         = totalTravelTimeSeconds;
+      state["maxSegmentHourlyDemand"]         = maximumSegmentHourlyDemand;
+      state["maxSegmentTotalDemand"]          = maximumSegmentTotalDemand;
+      state["forwardCalculationsCount"]       = forwardCalculationsCount;
+      state["reusedForwardCalculationsCount"] = reusedForwardCalculationsCount;
+      state["scannedConnectionsCount"]        = scannedConnectionsCount;
+      state["lineProfiles"]                   = nlohmann::json::array();
+      for (auto & linePair : transitData.getLines())
+      {
+        state["lineProfiles"].push_back(lineProfiles[linePair.second.uid]);
+      }
+      state["usedPaths"] = nlohmann::json::array(); // indexes of the used paths
+      int pathIndex = 0;
+      for (auto & pathPair : transitData.getPaths())
+      {
+        if (pathsUsed[pathPair.second.uid])
+        {
+          state["usedPaths"].push_back(pathIndex);
+        }
+        pathIndex++;
+      }
+      state["pathProfiles"]      = pathProfiles;
+      state["pathTotalProfiles"] = pathTotalProfiles;
+      return state;
+    };
+
+    if (checkpointState.has_value())
+    {
+      const nlohmann::json &state = checkpointState.value();
+      nextChunkIndex = state["chunksCount"].get<size_t>();
+      if (nextChunkIndex >= chunksStart.size() || chunksStart[nextChunkIndex] != state["odTripsCount"].get<size_t>()
+        || state["lineProfiles"].size() != transitData.getLines().size() || state["pathProfiles"].size() != pathProfiles.size())
+      {
+        spdlog::warn("The od trips checkpoint {} does not match the od trips, starting from the beginning", params.checkpointFilePath);
+        checkpointState.reset();
+        nextChunkIndex = 0;
+      }
+    }
+    if (checkpointState.has_value())
+    {
+      const nlohmann::json &state = checkpointState.value();
+      totalTravelTimeSeconds         = state["totalTravelTimeSeconds"].get<int>();
+      maximumSegmentHourlyDemand     = state["maxSegmentHourlyDemand"].get<float>();
+      maximumSegmentTotalDemand      = state["maxSegmentTotalDemand"].get<float>();
+      forwardCalculationsCount       = state["forwardCalculationsCount"].get<int>();
+      reusedForwardCalculationsCount = state["reusedForwardCalculationsCount"].get<int>();
+      scannedConnectionsCount        = state["scannedConnectionsCount"].get<long long>();
+      size_t lineIndex = 0;
+      for (auto & linePair : transitData.getLines())
+      {
+        lineProfiles[linePair.second.uid] = state["lineProfiles"][lineIndex++].get<float>();
+      }
+      std::vector<std::reference_wrapper<const Path>> paths;
+      for (auto & pathPair : transitData.getPaths())
+      {
+        paths.push_back(pathPair.second);
+      }
+      for (auto & pathIndex : state["usedPaths"])
+      {
+        pathsUsed[paths.at(pathIndex.get<size_t>()).get().uid] = true;
+      }
+      pathProfiles      = state["pathProfiles"].get<std::vector<float>>();
+      pathTotalProfiles = state["pathTotalProfiles"].get<std::vector<float>>();
+      spdlog::info("Resuming the od trips routing from checkpoint {} after {} od trips", params.checkpointFilePath, chunksStart[nextChunkIndex]);
+    }
+    if (checkpoint.has_value())
+    {
+      // The results of the od trips before the checkpoint are written again to the output
+      checkpoint->resume(checkpointState, [&writer](const nlohmann::json &odTripJson) { writer.writeOdTrip(odTripJson); });
+    }
+    size_t firstChunkIndex = nextChunkIndex;
+    size_t lastCheckpointOdTripsCount = chunksStart[firstChunkIndex];
+
+    // Route the od trips by chunks. A chunk is kept only until all the chunks before it are done, so the memory used does not depend on the number of od trips
+    std::mutex resultsMutex;
+    std::map<size_t, std::vector<OdTripRoutingResult>> pendingChunks;
+    runChunks(chunksStart.size() - 1 - firstChunkIndex, [&](size_t runChunkIndex, Calculator &calculator) {
+      size_t chunkIndex = firstChunkIndex + runChunkIndex;
+      bool resetFilters = true;
+      std::vector<OdTripRoutingResult> chunkResults;
+      auto groupStart = std::lower_bound(groupsStart.begin(), groupsStart.end(), chunksStart[chunkIndex]);
+      for (; *groupStart < chunksStart[chunkIndex + 1]; groupStart++)
+      {
+        std::vector<std::reference_wrapper<const OdTrip>> groupOdTrips;
+        for (size_t resultIndex = *groupStart; resultIndex < *(groupStart + 1); resultIndex++)
+        {
+          int i = routedOdTripIndexes[resultIndex];
+          const OdTrip & odTrip = odTripVector[i].get();
+          spdlog::debug("od trip uuid {} ({}/{}) dts: {}", to_string(odTrip.uuid), (i+1), odTripsCount, odTrip.departureTimeSeconds);
+          if ((resultIndex + 1) % 1000 == 0)
           {
-            spdlog::info("{}/{}", (i+1), odTripsCount);
+            spdlog::info("{}/{}", (resultIndex + 1), routedOdTripIndexes.size());
           }
+          groupOdTrips.push_back(odTrip);
         }
-        // Create a parameter that is a copy of the original parameters, except for the origin and destination
-        RouteParameters odTripParameters = RouteParameters(std::make_unique<Point>(odTrip.origin.get()->latitude, odTrip.origin.get()->longitude),
-          std::make_unique<Point>(odTrip.destination.get()->latitude, odTrip.destination.get()->longitude),
-          parameters.isWithAlternatives(),
-          parameters);
-
-        float correctedExpansionFactor = odTrip.expansionFactor / params.odTripsSampleRatio;
-
-        try {
-          routingResult = calculateSingle(odTripParameters, true, resetFilters); // reset filters only on first calculation
-          resetFilters  = false;
-          ResultToOdTripJsonVisitor visitor = ResultToOdTripJsonVisitor(odTripParameters);
-          odTripJson = routingResult.get()->accept(visitor);
-          
-          if (visitor.getLegs().size() > 0)
+        if (groupOdTrips.size() == 1)
+        {
+          chunkResults.push_back(calculator.odTripRouting(parameters, groupOdTrips[0].get(), params.odTripsSampleRatio, resetFilters));
+        }
+        else
+        {
+          for (auto & result : calculator.odTripsGroupRouting(parameters, groupOdTrips, params.odTripsSampleRatio, resetFilters))
           {
-            totalTravelTimeSeconds += correctedExpansionFactor * visitor.getTotalTravelTime();
-            for (auto & leg : visitor.getLegs())
-            {
-              const Trip &legTrip   = std::get<0>(leg).get();
-              const Line &legLine   = legTrip.line;
-              const Path &legPath   = legTrip.path;
-              legConnectionStartIdx = std::get<1>(leg);
-              legConnectionEndIdx   = std::get<2>(leg);
-              lineProfiles.at(legLine.uuid) += correctedExpansionFactor;
-
-              if (pathProfiles.find(legPath.uuid) == pathProfiles.end())
-              {
-                pathProfiles[legPath.uuid] = std::vector<std::vector<float>>(legPath.nodesRef.size() - 1, demandByHourOfDay);
-                pathTotalProfiles[legPath.uuid] = std::vector<float>(legPath.nodesRef.size() - 1, 0.0);
-              }
-              for (int connectionIndex = legConnectionStartIdx; connectionIndex <= legConnectionEndIdx; connectionIndex++)
-              {
-                connectionDepartureTimeSeconds = legTrip.connectionDepartureTimes[connectionIndex];
-                connectionDepartureTimeHour    = connectionDepartureTimeSeconds / 3600;
-
-                pathProfiles[legPath.uuid][connectionIndex][connectionDepartureTimeHour] += correctedExpansionFactor;
-                pathTotalProfiles[legPath.uuid][connectionIndex] += correctedExpansionFactor;
-                if (maximumSegmentHourlyDemand < pathProfiles[legPath.uuid][connectionIndex][connectionDepartureTimeHour])
-                {
-                  maximumSegmentHourlyDemand = pathProfiles[legPath.uuid][connectionIndex][connectionDepartureTimeHour];
-                }
-                if (maximumSegmentTotalDemand < pathTotalProfiles[legPath.uuid][connectionIndex])
-                {
-                  maximumSegmentTotalDemand = pathTotalProfiles[legPath.uuid][connectionIndex];
-                }
-              }
-            }
+            chunkResults.push_back(std::move(result));
           }
-
-        } catch (NoRoutingFoundException& e) {
-          odTripJson = noRoutingFoundResultToJson(odTripParameters);
         }
-
-        // Add additional fields to response
-        odTripJson["uuid"] = boost::uuids::to_string(odTrip.uuid);
-        odTripJson["internalId"]                    = odTrip.internalId;
-        odTripJson["originActivity"]                = odTrip.originActivity;
-        odTripJson["destinationActivity"]           = odTrip.destinationActivity;
-        odTripJson["declaredMode"]                  = odTrip.mode;
-        odTripJson["expansionFactor"]               = correctedExpansionFactor;
-        odTripJson["onlyWalkingTravelTimeSeconds"]  = odTrip.walkingTravelTimeSeconds;
-        odTripJson["onlyCyclingTravelTimeSeconds"]  = odTrip.cyclingTravelTimeSeconds;
-        odTripJson["onlyDrivingTravelTimeSeconds"]  = odTrip.drivingTravelTimeSeconds;
-        odTripJson["declaredDepartureTimeSeconds"]  = odTrip.departureTimeSeconds;
-        odTripJson["declaredArrivalTimeSeconds"]    = odTrip.arrivalTimeSeconds;
-        json["odTrips"].push_back(odTripJson);
       }
 
-      if (params.odTripsSampleSize > 0 && i + 1 >= params.odTripsSampleSize)
+      std::lock_guard<std::mutex> lock(resultsMutex);
+      pendingChunks.emplace(chunkIndex, std::move(chunkResults));
+      while (!pendingChunks.empty() && pendingChunks.begin()->first == nextChunkIndex)
       {
-        break;
+        for (auto & result : pendingChunks.begin()->second)
+        {
+          addResult(result);
+          if (checkpoint.has_value())
+          {
+            checkpoint->writeOdTrip(result.json);
+          }
+        }
+        pendingChunks.erase(pendingChunks.begin());
+        nextChunkIndex++;
+        if (checkpoint.has_value() && chunksStart[nextChunkIndex] - lastCheckpointOdTripsCount >= (size_t)std::max(1, params.checkpointInterval))
+        {
+          checkpoint->save(getCheckpointState());
+          lastCheckpointOdTripsCount = chunksStart[nextChunkIndex];
+        }
       }
+    });
+
+    if (routedOdTripIndexes.size() > 0)
+    {
+      spdlog::info("  od trips routed with {} forward calculations, {}% reused, {} connections scanned per od trip", forwardCalculationsCount, (100 * reusedForwardCalculationsCount) / routedOdTripIndexes.size(), scannedConnectionsCount / (long long)routedOdTripIndexes.size());
     }
 
+    nlohmann::json json;
+    json["forwardCalculationsCount"] = forwardCalculationsCount;
+    json["scannedConnectionsCount"]  = scannedConnectionsCount;
     json["maxSegmentHourlyDemand"] = maximumSegmentHourlyDemand;
     json["maxSegmentTotalDemand"]  = maximumSegmentTotalDemand;
     json["totalTravelTimeSeconds"] = totalTravelTimeSeconds;
@@ -377,37 +807,41 @@ namespace TrRouting
 
       lineProfilesJson = {};
 
-      for (auto & lineCount : lineProfiles)
+      for (auto & linePair : transitData.getLines())
       {
-        lineProfilesJson[boost::uuids::to_string(lineCount.first)] = lineCount.second;
+        lineProfilesJson[boost::uuids::to_string(linePair.first)] = lineProfiles[linePair.second.uid];
       }
 
       json["lineProfiles"] = lineProfilesJson;
 
       pathProfilesJson = {};
 
-      for (auto & pathProfile : pathProfiles)
+      for (auto & pathPair : transitData.getPaths())
       {
-        pathProfilesJson[boost::uuids::to_string(pathProfile.first)] = pathProfile.second;
-        //pathsOdTripsProfilesSequenceJson = {};
-        /*for (auto & segmentProfile : pathProfile)
+        const Path &path = pathPair.second;
+        if (!pathsUsed[path.uid])
         {
-
-          //pathsOdTripsProfilesOdTripUuids.clear();
-          //for (auto & odTripUuid : std::get<1>(sequenceProfile.second))
-          //{
-          //  pathsOdTripsProfilesOdTripUuids.push_back()
-          //}
-          //pathsOdTripsProfilesSequenceJson[std::to_string(sequenceProfile.first)] = {{"demand", std::get<0>(sequenceProfile.second)}, {"odTripUuids", Toolbox::uuidsToStrings(std::get<1>(sequenceProfile.second))}};
-        }*/
-        //pathsOdTripsProfilesJson[boost::uuids::to_string(pathProfile.first)] = pathsProfile;
+          continue;
+        }
+        // value: [index: segment index, value: [index: hourOfDay, demand]]
+        nlohmann::json segmentsProfilesJson = nlohmann::json::array();
+        for (size_t segmentIndex = 0; segmentIndex + 1 < path.nodesRef.size(); segmentIndex++)
+        {
+          auto segmentProfileBegin = pathProfiles.begin() + (pathsFirstSegmentIndex[path.uid] + segmentIndex) * OD_TRIPS_PROFILE_HOURS_COUNT;
+          segmentsProfilesJson.push_back(std::vector<float>(segmentProfileBegin, segmentProfileBegin + OD_TRIPS_PROFILE_HOURS_COUNT));
+        }
+        pathProfilesJson[boost::uuids::to_string(pathPair.first)] = segmentsProfilesJson;
       }
 
       json["pathProfiles"] = pathProfilesJson;
 
     }
     json["status"] = STATUS_SUCCESS;
-    return json.dump(2);
+    writer.writeSummary(json);
+    if (checkpoint.has_value())
+    {
+      checkpoint->remove();
+    }
 
   }
 
@@ -0,0 +1,41 @@
+#include "od_trips_writer.hpp"
+
+namespace TrRouting
+{
+
+  OdTripsJsonWriter::OdTripsJsonWriter()
+  {
+    json["odTrips"] = nlohmann::json::array();
+  }
+
+  void OdTripsJsonWriter::writeOdTrip(const nlohmann::json &odTripJson)
+  {
+    json["odTrips"].push_back(odTripJson);
+  }
+
+  void OdTripsJsonWriter::writeSummary(const nlohmann::json &summaryJson)
+  {
+    for (auto & [field, value] : summaryJson.items())
+    {
+      json[field] = value;
+    }
+  }
+
+  OdTripsNdjsonWriter::OdTripsNdjsonWriter(std::ostream &_output) :
+    output(_output)
+  {
+
+  }
+
+  void OdTripsNdjsonWriter::writeOdTrip(const nlohmann::json &odTripJson)
+  {
+    output << odTripJson.dump() << '\n';
+  }
+
+  void OdTripsNdjsonWriter::writeSummary(const nlohmann::json &summaryJson)
+  {
+    output << summaryJson.dump() << '\n';
+    output.flush();
+  }
+
+}
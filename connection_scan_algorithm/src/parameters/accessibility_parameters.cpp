@@ -1,3 +1,4 @@
+#include <cstdint>
 #include <boost/uuid/string_generator.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -5,6 +6,9 @@
 #include "parameters.hpp"
 #include "scenario.hpp"
 #include "point.hpp"
+#include "node.hpp"
+#include "place.hpp"
+#include "household.hpp"
 
 namespace TrRouting
 {
@@ -28,20 +32,58 @@ namespace TrRouting
                       maxTransferTime,
                       maxFirstWaitingTime,
                       forward),
-        place(std::move(place_))
+        place(std::move(place_)),
+        timeWindowEnd(std::nullopt),
+        stepSeconds(DEFAULT_ACCESSIBILITY_TIME_WINDOW_STEP)
   {
   }
 
   AccessibilityParameters::AccessibilityParameters(std::unique_ptr<Point> place_,
-    const CommonParameters &common_) : 
+    const CommonParameters &common_,
+    PrecomputedNodes _placeNodes) : 
         CommonParameters(common_),
-        place(std::move(place_))
+        place(std::move(place_)),
+        timeWindowEnd(std::nullopt),
+        stepSeconds(DEFAULT_ACCESSIBILITY_TIME_WINDOW_STEP),
+        placeNodes(_placeNodes)
   {
   }
 
+  AccessibilityParameters::AccessibilityParameters(std::unique_ptr<Point> place_,
+    std::optional<int> _timeWindowEnd,
+    int _stepSeconds,
+    const CommonParameters &common_,
+    PrecomputedNodes _placeNodes) :
+        CommonParameters(common_),
+        place(std::move(place_)),
+        timeWindowEnd(_timeWindowEnd),
+        stepSeconds(_stepSeconds),
+        placeNodes(_placeNodes)
+  {
+  }
+
+  std::vector<int> AccessibilityParameters::getTimesOfTrip() const
+  {
+    std::vector<int> timesOfTrip;
+    // In 64 bits, so the last step cannot overflow with a window end close to the max int
+    for (int64_t timeOfTrip = getTimeOfTrip(); timeOfTrip <= getTimeWindowEnd(); timeOfTrip += stepSeconds)
+    {
+      timesOfTrip.push_back((int)timeOfTrip);
+    }
+    return timesOfTrip;
+  }
+
   AccessibilityParameters AccessibilityParameters::createAccessibilityParameter(std::vector<std::pair<std::string, std::string>> &parameters, const std::map<boost::uuids::uuid, Scenario> &scenarios)
+  {
+    return createAccessibilityParameter(parameters, scenarios, std::map<boost::uuids::uuid, Place>(), std::map<boost::uuids::uuid, Household>());
+  }
+
+  AccessibilityParameters AccessibilityParameters::createAccessibilityParameter(std::vector<std::pair<std::string, std::string>> &parameters, const std::map<boost::uuids::uuid, Scenario> &scenarios, const std::map<boost::uuids::uuid, Place> &places, const std::map<boost::uuids::uuid, Household> &households)
   {
     std::optional<Point> place;
+    PrecomputedNodes placeNodes;
+    std::optional<int> timeWindowEnd;
+    int stepSeconds = DEFAULT_ACCESSIBILITY_TIME_WINDOW_STEP;
 
     std::vector<std::string> latitudeLongitudeVector;
 
@@ -61,12 +103,38 @@ namespace TrRouting
             throw ParameterException(ParameterException::Type::INVALID_PLACE);
           }
           place = Point(std::stod(latitudeLongitudeVector[1]), std::stod(latitudeLongitudeVector[0]));
+          placeNodes.reset();
         }
         catch (...)
         {
           throw ParameterException(ParameterException::Type::INVALID_PLACE);
         }
       }
+      // place or household with precomputed nodes:
+      else if (parameterWithValue.first == "place_uuid")
+      {
+        const Place &placeByUuid = CommonParameters::getPlace(parameterWithValue.second, places, ParameterException::Type::INVALID_PLACE);
+        place = Point(placeByUuid.point.get()->latitude, placeByUuid.point.get()->longitude);
+        placeNodes = placeByUuid.nodes;
+      }
+      else if (parameterWithValue.first == "household_uuid")
+      {
+        const Household &household = CommonParameters::getHousehold(parameterWithValue.second, households, ParameterException::Type::INVALID_PLACE);
+        place = Point(household.point.get()->latitude, household.point.get()->longitude);
+        placeNodes = household.homeNodes;
+      }
+      else if (parameterWithValue.first == "time_window_end")
+      {
+        timeWindowEnd = CommonParameters::getIntegerValue(parameterWithValue.second);
+      }
+      else if (parameterWithValue.first == "step_seconds")
+      {
+        stepSeconds = CommonParameters::getIntegerValue(parameterWithValue.second);
+        if (stepSeconds <= 0)
+        {
+          throw ParameterException(ParameterException::Type::INVALID_NUMERICAL_DATA);
+        }
+      }
 
     }
 
@@ -77,9 +145,131 @@ namespace TrRouting
     
     CommonParameters common = CommonParameters::createCommonParameter(parameters, scenarios);
 
+    // The time window is a range of departure times, from the time of trip to its end, with a limited duration and number of steps
+    if (timeWindowEnd.has_value())
+    {
+      int64_t windowSeconds = (int64_t)timeWindowEnd.value() - common.getTimeOfTrip();
+      if (!common.isForwardCalculation() || windowSeconds < 0 || windowSeconds > MAX_ACCESSIBILITY_TIME_WINDOW || (windowSeconds > 0 && stepSeconds > windowSeconds) || windowSeconds / stepSeconds >= MAX_ACCESSIBILITY_TIME_WINDOW_STEPS)
+      {
+        throw ParameterException(ParameterException::Type::INVALID_TIME_WINDOW);
+      }
+    }
+
     return AccessibilityParameters(std::make_unique<TrRouting::Point>(place->latitude, place->longitude),
-      common
+      timeWindowEnd,
+      stepSeconds,
+      common,
+      placeNodes
     );
   }
 
+  AccessibilityBatchParameters::AccessibilityBatchParameters(std::vector<std::unique_ptr<Point>> places_,
+    const CommonParameters &common_) :
+        CommonParameters(common_),
+        places(std::move(places_)),
+        placesUuids(places.size()),
+        placesNodes(places.size())
+  {
+  }
+
+  AccessibilityBatchParameters::AccessibilityBatchParameters(std::vector<std::unique_ptr<Point>> places_,
+    std::vector<std::optional<boost::uuids::uuid>> placesUuids_,
+    std::vector<PrecomputedNodes> placesNodes_,
+    const CommonParameters &common_) :
+        CommonParameters(common_),
+        places(std::move(places_)),
+        placesUuids(std::move(placesUuids_)),
+        placesNodes(std::move(placesNodes_))
+  {
+  }
+
+  AccessibilityBatchParameters AccessibilityBatchParameters::createAccessibilityBatchParameter(std::vector<std::pair<std::string, std::string>> &parameters, const std::map<boost::uuids::uuid, Scenario> &scenarios)
+  {
+    return createAccessibilityBatchParameter(parameters, scenarios, std::map<boost::uuids::uuid, Place>());
+  }
+
+  AccessibilityBatchParameters AccessibilityBatchParameters::createAccessibilityBatchParameter(std::vector<std::pair<std::string, std::string>> &parameters, const std::map<boost::uuids::uuid, Scenario> &scenarios, const std::map<boost::uuids::uuid, Place> &placesByUuid)
+  {
+    std::vector<std::unique_ptr<Point>> places;
+    std::vector<std::optional<boost::uuids::uuid>> placesUuids;
+    std::vector<PrecomputedNodes> placesNodes;
+    boost::uuids::string_generator uuidGenerator;
+
+    // Add a place given by uuid, with its precomputed nodes
+    auto addPlace = [&](const Place &place) {
+      places.push_back(std::make_unique<Point>(place.point.get()->latitude, place.point.get()->longitude));
+      placesUuids.push_back(place.uuid);
+      placesNodes.push_back(place.nodes);
+    };
+
+    std::vector<std::string> placesVector;
+    std::vector<std::string> latitudeLongitudeVector;
+
+    // TODO Replace manually parsing parameters by a library that does this
+    for (auto & parameterWithValue : parameters)
+    {
+      spdlog::debug(" received parameter {} with value {}", parameterWithValue.first, parameterWithValue.second);
+
+      // places coordinates, separated by semicolons:
+      if (parameterWithValue.first == "places")
+      {
+        boost::split(placesVector, parameterWithValue.second, boost::is_any_of(";"));
+        for (auto & placeString : placesVector)
+        {
+          try
+          {
+            boost::split(latitudeLongitudeVector, placeString, boost::is_any_of(","));
+            if (latitudeLongitudeVector.size() != 2)
+            {
+              throw ParameterException(ParameterException::Type::INVALID_PLACE);
+            }
+            places.push_back(std::make_unique<Point>(std::stod(latitudeLongitudeVector[1]), std::stod(latitudeLongitudeVector[0])));
+            placesUuids.push_back(std::nullopt);
+            placesNodes.push_back(std::nullopt);
+          }
+          catch (...)
+          {
+            throw ParameterException(ParameterException::Type::INVALID_PLACE);
+          }
+        }
+      }
+      // places uuids, separated by semicolons:
+      else if (parameterWithValue.first == "place_uuids")
+      {
+        boost::split(placesVector, parameterWithValue.second, boost::is_any_of(";"));
+        for (auto & placeUuidString : placesVector)
+        {
+          addPlace(CommonParameters::getPlace(placeUuidString, placesByUuid, ParameterException::Type::INVALID_PLACE));
+        }
+      }
+      // all the places of a data source:
+      else if (parameterWithValue.first == "places_data_source_uuid")
+      {
+        boost::uuids::uuid dataSourceUuid;
+        try {
+          dataSourceUuid = uuidGenerator(parameterWithValue.second);
+        } catch (std::runtime_error const& exc) {
+          throw ParameterException(ParameterException::Type::INVALID_PLACE);
+        }
+        for (auto & [uuid, place] : placesByUuid)
+        {
+          if (place.dataSource.uuid == dataSourceUuid)
+          {
+            addPlace(place);
+          }
+        }
+      }
+
+    }
+
+    if (places.empty())
+    {
+      throw ParameterException(ParameterException::Type::MISSING_PLACE);
+    }
+
+    CommonParameters common = CommonParameters::createCommonParameter(parameters, scenarios);
+
+    return AccessibilityBatchParameters(std::move(places), std::move(placesUuids), std::move(placesNodes), common);
+  }
+
 }
@@ -4,6 +4,9 @@
 #include "parameters.hpp"
 #include "scenario.hpp"
 #include "point.hpp"
+#include "node.hpp"
+#include "place.hpp"
+#include "household.hpp"
 
 namespace TrRouting
 {
@@ -16,7 +19,8 @@ namespace TrRouting
     int maxEgressTime,
     int maxTransferTime,
     int maxFirstWaitingTime,
-    bool forward) :
+    bool forward,
+    std::optional<boost::gregorian::date> _date) :
         scenario(scenario_),
         timeOfTrip(_timeOfTrip),
         minWaitingTimeSeconds(minWaitingTime),
@@ -25,7 +29,8 @@ namespace TrRouting
         maxEgressWalkingTravelTimeSeconds(maxEgressTime),
         maxTransferWalkingTravelTimeSeconds(maxTransferTime),
         maxFirstWaitingTimeSeconds(maxFirstWaitingTime),
-        forwardCalculation(forward)
+        forwardCalculation(forward),
+        date(_date)
   {
     scenarioUuid = scenario.uuid; //TODO Check if this is used somewhere
   }
@@ -49,7 +54,8 @@ namespace TrRouting
     exceptAgencies(baseParams.exceptAgencies),
     exceptModes(baseParams.exceptModes),
     exceptNodes(baseParams.exceptNodes),
-    forwardCalculation(baseParams.forwardCalculation)
+    forwardCalculation(baseParams.forwardCalculation),
+    date(baseParams.date)
   {
   }
 
@@ -65,6 +71,31 @@ namespace TrRouting
     }
   }
 
+  // Find the object with the uuid string value in the map, or throw a ParameterException of the invalidType
+  template <typename T>
+  static const T& getObjectByUuid(const std::string &uuidStr, const std::map<boost::uuids::uuid, T> &objects, ParameterException::Type invalidType) {
+    boost::uuids::string_generator uuidGenerator;
+    boost::uuids::uuid uuid;
+    try {
+      uuid = uuidGenerator(uuidStr);
+    } catch (std::runtime_error const& exc) {
+      throw ParameterException(invalidType);
+    }
+    auto objectIte = objects.find(uuid);
+    if (objectIte == objects.end()) {
+      throw ParameterException(invalidType);
+    }
+    return objectIte->second;
+  }
+
+  const Place& CommonParameters::getPlace(const std::string &uuidStr, const std::map<boost::uuids::uuid, Place> &places, ParameterException::Type invalidType) {
+    return getObjectByUuid(uuidStr, places, invalidType);
+  }
+
+  const Household& CommonParameters::getHousehold(const std::string &uuidStr, const std::map<boost::uuids::uuid, Household> &households, ParameterException::Type invalidType) {
+    return getObjectByUuid(uuidStr, households, invalidType);
+  }
+
   CommonParameters CommonParameters::createCommonParameter(std::vector<std::pair<std::string, std::string>> &parameters, const std::map<boost::uuids::uuid, Scenario> &scenarios)
   {
     boost::uuids::string_generator uuidGenerator;
@@ -80,6 +111,7 @@ namespace TrRouting
     int maxTransferWalkingTravelTimeSeconds = DEFAULT_MAX_TRANSFER_TRAVEL_TIME;
     int maxFirstWaitingTimeSeconds = DEFAULT_FIRST_WAITING_TIME; // Ignore all connections at access nodes if waiting time would be more than this value.
     bool forwardCalculation = true;
+    std::optional<boost::gregorian::date> date;
 
     // TODO Replace manually parsing parameters by a library that does this
     for (auto & parameterWithValue : parameters)
@@ -93,6 +125,19 @@ namespace TrRouting
           timeOfTrip = -1;
         }
       }
+      else if (parameterWithValue.first == "date")
+      {
+        try {
+          date = boost::gregorian::from_simple_string(parameterWithValue.second);
+        } catch (...) {
+          throw ParameterException(ParameterException::Type::INVALID_DATE);
+        }
+        if (date.value().is_special())
+        {
+          throw ParameterException(ParameterException::Type::INVALID_DATE);
+        }
+        continue;
+      }
       else if (parameterWithValue.first == "time_type")
       {
         if (parameterWithValue.second == "1")
@@ -202,7 +247,8 @@ namespace TrRouting
       maxEgressWalkingTravelTimeSeconds,
       maxTransferWalkingTravelTimeSeconds,
       maxFirstWaitingTimeSeconds,
-      forwardCalculation);
+      forwardCalculation,
+      date);
   }
 
  
@@ -27,6 +27,9 @@ namespace TrRouting
     odTripUuid.reset();
     odTripsSampleSize                      = -1;
     calculateProfiles                      = true;
+    groupOdTrips                           = true;
+    checkpointFilePath                     = "";
+    checkpointInterval                     = 1000;
     seed                                   = std::chrono::system_clock::now().time_since_epoch().count();
 
   }
@@ -0,0 +1,65 @@
+#include "parameters.hpp"
+#include "scenario.hpp"
+#include "point.hpp"
+#include "node.hpp"
+#include "place.hpp"
+#include "household.hpp"
+
+namespace TrRouting
+{
+
+  ProfileParameters::ProfileParameters(std::unique_ptr<Point> orig_,
+    std::unique_ptr<Point> dest_,
+    int _timeWindowEnd,
+    const CommonParameters &common_,
+    PrecomputedNodes _originNodes,
+    PrecomputedNodes _destinationNodes) :
+        RouteParameters(std::move(orig_), std::move(dest_), false, common_, std::nullopt, _originNodes, _destinationNodes),
+        timeWindowEnd(_timeWindowEnd)
+  {
+  }
+
+  ProfileParameters ProfileParameters::createProfileParameter(std::vector<std::pair<std::string, std::string>> &parameters, const std::map<boost::uuids::uuid, Scenario> &scenarios)
+  {
+    return createProfileParameter(parameters, scenarios, std::map<boost::uuids::uuid, Place>(), std::map<boost::uuids::uuid, Household>());
+  }
+
+  ProfileParameters ProfileParameters::createProfileParameter(std::vector<std::pair<std::string, std::string>> &parameters, const std::map<boost::uuids::uuid, Scenario> &scenarios, const std::map<boost::uuids::uuid, Place> &places, const std::map<boost::uuids::uuid, Household> &households)
+  {
+    std::optional<int> timeWindowEnd;
+
+    // TODO Replace manually parsing parameters by a library that does this
+    for (auto & parameterWithValue : parameters)
+    {
+      if (parameterWithValue.first == "time_window_end")
+      {
+        timeWindowEnd = CommonParameters::getIntegerValue(parameterWithValue.second);
+      }
+    }
+
+    // Origin, destination and common parameters are the same as the route
+    RouteParameters route = RouteParameters::createRouteODParameter(parameters, scenarios, places, households);
+
+    // The profile is a range of departure times
+    if (!route.isForwardCalculation())
+    {
+      throw ParameterException(ParameterException::Type::INVALID_TIME_WINDOW);
+    }
+    if (!timeWindowEnd.has_value())
+    {
+      timeWindowEnd = route.getTimeOfTrip() + DEFAULT_PROFILE_TIME_WINDOW;
+    }
+    else if (timeWindowEnd.value() < route.getTimeOfTrip())
+    {
+      throw ParameterException(ParameterException::Type::INVALID_TIME_WINDOW);
+    }
+
+    return ProfileParameters(std::make_unique<TrRouting::Point>(route.getOrigin()->latitude, route.getOrigin()->longitude),
+      std::make_unique<TrRouting::Point>(route.getDestination()->latitude, route.getDestination()->longitude),
+      timeWindowEnd.value(),
+      route,
+      route.getOriginNodes(),
+      route.getDestinationNodes());
+  }
+
+}
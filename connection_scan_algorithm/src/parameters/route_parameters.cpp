@@ -5,6 +5,9 @@
 #include "parameters.hpp"
 #include "scenario.hpp"
 #include "point.hpp"
+#include "node.hpp"
+#include "place.hpp"
+#include "household.hpp"
 
 namespace TrRouting
 {
@@ -39,11 +42,17 @@ namespace TrRouting
   RouteParameters::RouteParameters(std::unique_ptr<Point> orig_,
     std::unique_ptr<Point> dest_,
     bool alt,
-    const CommonParameters &common_) : 
+    const CommonParameters &common_,
+    std::optional<int> _maxTransfers,
+    PrecomputedNodes _originNodes,
+    PrecomputedNodes _destinationNodes) : 
         CommonParameters(common_),
         origin(std::move(orig_)),
         destination(std::move(dest_)),
-        withAlternatives(alt)
+        withAlternatives(alt),
+        maxTransfers(_maxTransfers),
+        originNodes(_originNodes),
+        destinationNodes(_destinationNodes)
   {
   }
 
@@ -51,16 +60,27 @@ namespace TrRouting
     CommonParameters(routeParams),
     origin(std::make_unique<Point>(routeParams.origin.get()->latitude, routeParams.origin.get()->longitude)),
     destination(std::make_unique<Point>(routeParams.destination.get()->latitude, routeParams.destination.get()->longitude)),
-    withAlternatives(routeParams.withAlternatives)
+    withAlternatives(routeParams.withAlternatives),
+    maxTransfers(routeParams.maxTransfers),
+    originNodes(routeParams.originNodes),
+    destinationNodes(routeParams.destinationNodes)
   {
   }
 
   RouteParameters RouteParameters::createRouteODParameter(std::vector<std::pair<std::string, std::string>> &parameters, const std::map<boost::uuids::uuid, Scenario> &scenarios)
+  {
+    return createRouteODParameter(parameters, scenarios, std::map<boost::uuids::uuid, Place>(), std::map<boost::uuids::uuid, Household>());
+  }
+
+  RouteParameters RouteParameters::createRouteODParameter(std::vector<std::pair<std::string, std::string>> &parameters, const std::map<boost::uuids::uuid, Scenario> &scenarios, const std::map<boost::uuids::uuid, Place> &places, const std::map<boost::uuids::uuid, Household> &households)
   {
 
     std::optional<Point> origin;
     std::optional<Point> destination;
+    PrecomputedNodes originNodes;
+    PrecomputedNodes destinationNodes;
     bool alternatives = false;
+    std::optional<int> maxTransfers;
 
     std::vector<std::string> latitudeLongitudeVector;
 
@@ -80,6 +100,7 @@ namespace TrRouting
             throw ParameterException(ParameterException::Type::INVALID_ORIGIN);
           }
           origin = Point(std::stod(latitudeLongitudeVector[1]), std::stod(latitudeLongitudeVector[0]));
+          originNodes.reset();
         }
         catch (...)
         {
@@ -96,12 +117,38 @@ namespace TrRouting
             throw ParameterException(ParameterException::Type::INVALID_DESTINATION);
           }
           destination = Point(std::stod(latitudeLongitudeVector[1]), std::stod(latitudeLongitudeVector[0]));
+          destinationNodes.reset();
         }
         catch (...)
         {
           throw ParameterException(ParameterException::Type::INVALID_DESTINATION);
         }
       }
+      // origin and destination from a place or household, with their precomputed nodes:
+      else if (parameterWithValue.first == "origin_place_uuid")
+      {
+        const Place &place = CommonParameters::getPlace(parameterWithValue.second, places, ParameterException::Type::INVALID_ORIGIN);
+        origin = Point(place.point.get()->latitude, place.point.get()->longitude);
+        originNodes = place.nodes;
+      }
+      else if (parameterWithValue.first == "origin_household_uuid")
+      {
+        const Household &household = CommonParameters::getHousehold(parameterWithValue.second, households, ParameterException::Type::INVALID_ORIGIN);
+        origin = Point(household.point.get()->latitude, household.point.get()->longitude);
+        originNodes = household.homeNodes;
+      }
+      else if (parameterWithValue.first == "destination_place_uuid")
+      {
+        const Place &place = CommonParameters::getPlace(parameterWithValue.second, places, ParameterException::Type::INVALID_DESTINATION);
+        destination = Point(place.point.get()->latitude, place.point.get()->longitude);
+        destinationNodes = place.nodes;
+      }
+      else if (parameterWithValue.first == "destination_household_uuid")
+      {
+        const Household &household = CommonParameters::getHousehold(parameterWithValue.second, households, ParameterException::Type::INVALID_DESTINATION);
+        destination = Point(household.point.get()->latitude, household.point.get()->longitude);
+        destinationNodes = household.homeNodes;
+      }
       else if (parameterWithValue.first == "alternatives")
       {
         if (parameterWithValue.second == "true" || parameterWithValue.second == "1")
@@ -110,6 +157,14 @@ namespace TrRouting
         }
         continue;
       }
+      else if (parameterWithValue.first == "max_transfers")
+      {
+        maxTransfers = CommonParameters::getIntegerValue(parameterWithValue.second);
+        if (maxTransfers.value() < 0 || maxTransfers.value() > MAX_TRANSFERS_LIMIT)
+        {
+          throw ParameterException(ParameterException::Type::INVALID_NUMERICAL_DATA);
+        }
+      }
     }
 
     // Validate parameters
@@ -124,10 +179,19 @@ namespace TrRouting
 
     CommonParameters common = CommonParameters::createCommonParameter(parameters, scenarios);
 
+    // The maximum number of transfers is only used by the multi-criteria alternatives, which are calculated forward
+    if (maxTransfers.has_value() && (!alternatives || !common.isForwardCalculation()))
+    {
+      throw ParameterException(ParameterException::Type::INVALID_MAX_TRANSFERS);
+    }
+
     return RouteParameters(std::make_unique<TrRouting::Point>(origin->latitude, origin->longitude),
       std::make_unique<TrRouting::Point>(destination->latitude, destination->longitude),
       alternatives,
-      common);
+      common,
+      maxTransfers,
+      originNodes,
+      destinationNodes);
   }
 
 }
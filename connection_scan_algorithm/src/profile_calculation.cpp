@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <unordered_set>
+
+#include "spdlog/spdlog.h"
+
+#include "calculator.hpp"
+#include "toolbox.hpp"
+#include "parameters.hpp"
+#include "node.hpp"
+#include "trip.hpp"
+#include "routing_result.hpp"
+#include "transit_data.hpp"
+#include "connection_set.hpp"
+
+namespace TrRouting
+{
+
+  // Find the entry with the earliest arrival among the ones that can be boarded when ready at readyTime.
+  // Entries are sorted by decreasing ready time, with decreasing arrival times, so it is the last one with a ready time >= readyTime
+  std::optional<std::reference_wrapper<const ProfileEntry>> getProfileEntryReadyAt(const std::vector<ProfileEntry> &profile, int readyTime)
+  {
+    auto firstTooEarly = std::partition_point(profile.begin(), profile.end(), [readyTime](const ProfileEntry &entry) {
+      return entry.readyTime >= readyTime;
+    });
+    if (firstTooEarly == profile.begin()) {
+      return std::nullopt;
+    }
+    return std::cref(*(firstTooEarly - 1));
+  }
+
+  // Add an entry to a node profile, keeping only the entries that are not dominated by another
+  void addProfileEntry(std::vector<ProfileEntry> &profile, const ProfileEntry &entry)
+  {
+    // Connections are scanned by decreasing departure time, so the new entry is usually the earliest one
+    if (profile.empty() || entry.readyTime <= profile.back().readyTime) {
+      if (!profile.empty() && entry.arrivalTime >= profile.back().arrivalTime) {
+        return;
+      }
+      if (!profile.empty() && entry.readyTime == profile.back().readyTime) {
+        profile.back() = entry;
+      } else {
+        profile.push_back(entry);
+      }
+      return;
+    }
+
+    // Connection specific minimum waiting times can make the ready time later than the last entry's
+    std::optional<std::reference_wrapper<const ProfileEntry>> readyEntry = getProfileEntryReadyAt(profile, entry.readyTime);
+    if (readyEntry.has_value() && readyEntry.value().get().arrivalTime <= entry.arrivalTime) {
+      return;
+    }
+    // Remove the entries dominated by the new one and insert it in order
+    profile.erase(std::remove_if(profile.begin(), profile.end(), [&entry](const ProfileEntry &other) {
+      return other.readyTime <= entry.readyTime && other.arrivalTime >= entry.arrivalTime;
+    }), profile.end());
+    auto position = std::partition_point(profile.begin(), profile.end(), [&entry](const ProfileEntry &other) {
+      return other.readyTime > entry.readyTime;
+    });
+    profile.insert(position, entry);
+  }
+
+  std::optional<std::tuple<std::reference_wrapper<const ProfileEntry>, std::reference_wrapper<const NodeTimeDistance>>> Calculator::getBestTransferProfileEntry(const CommonParameters &parameters, const Node &node, int arrivalTime)
+  {
+    std::optional<std::tuple<std::reference_wrapper<const ProfileEntry>, std::reference_wrapper<const NodeTimeDistance>>> bestTransfer;
+    for (const NodeTimeDistance & transferableNode : node.transferableNodes)
+    {
+      //TODO We should not do a direct == with float values
+      int footpathTravelTime = parameters.getWalkingSpeedFactor() == 1.0 ? transferableNode.time : (int)ceil((float)transferableNode.time / parameters.getWalkingSpeedFactor());
+      if (footpathTravelTime > parameters.getMaxTransferWalkingTravelTimeSeconds())
+      {
+        continue;
+      }
+      auto entry = getProfileEntryReadyAt(nodesProfiles[transferableNode.node.uid], arrivalTime + footpathTravelTime);
+      if (entry.has_value() && (!bestTransfer.has_value() || entry.value().get().arrivalTime < std::get<0>(bestTransfer.value()).get().arrivalTime))
+      {
+        bestTransfer = std::make_tuple(entry.value(), std::cref(transferableNode));
+      }
+    }
+    return bestTransfer;
+  }
+
+  std::unique_ptr<ProfileResult> Calculator::calculateProfile(ProfileParameters &parameters)
+  {
+    reset(parameters, *parameters.getOrigin(), *parameters.getDestination());
+
+    int windowStart = parameters.getTimeWindowStart();
+    int windowEnd   = parameters.getTimeWindowEnd();
+    // Connections departing after the window are still useful for the later legs of the journeys
+    int lastDepartureTime = parameters.getMaxTotalTravelTimeSeconds() >= MAX_INT - windowEnd ? MAX_INT : windowEnd + parameters.getMaxTotalTravelTimeSeconds();
+    int reachableConnectionsCount {0};
+
+    // Clear the profiles without releasing the memory, this calculator may be reused for other profiles
+    nodesProfiles.resize(transitData.getNodesMaxUid() + 1);
+    for (auto & profile : nodesProfiles) {
+      profile.clear();
+    }
+    tripsProfiles.assign(transitData.getTripsMaxUid() + 1, TripProfileData());
+
+    auto & forwardConnections = connectionSet.get()->getForwardConnections();
+    const PackedConnections & packedConnections = connectionSet.get()->getForwardPackedConnections();
+
+    // Scan the forward connections backward, ie by decreasing departure time and decreasing sequence in trip
+    const ConnectionMask & forwardMask = connectionSet.get()->getForwardMask();
+    size_t connectionIndex = std::upper_bound(packedConnections.departureTimes.begin(), packedConnections.departureTimes.end(), lastDepartureTime) - packedConnections.departureTimes.begin();
+    while ((connectionIndex = forwardMask.previous(connectionIndex)) != forwardMask.size())
+    {
+      int connectionDepartureTime = packedConnections.departureTimes[connectionIndex];
+      if (connectionDepartureTime < windowStart + minAccessTravelTime)
+      {
+        break;
+      }
+      Trip::uid_t tripUid = packedConnections.tripUids[connectionIndex];
+      if (isTripDisabled(tripUid))
+      {
+        continue;
+      }
+      TripProfileData & tripProfile = tripsProfiles[tripUid];
+
+      if (packedConnections.canUnboard(connectionIndex))
+      {
+        const Node &nodeArrival = forwardConnections[connectionIndex].get().getArrivalNode();
+        int connectionArrivalTime = packedConnections.arrivalTimes[connectionIndex];
+
+        // Arrival at destination when getting off here, either walking to destination or transferring
+        auto nodeArrivalInNodesEgressIte = nodesEgress.find(nodeArrival.uid);
+        if (nodeArrivalInNodesEgressIte != nodesEgress.end() && nodeArrivalInNodesEgressIte->second.time >= 0 && connectionArrivalTime + nodeArrivalInNodesEgressIte->second.time < tripProfile.arrivalTime)
+        {
+          tripProfile.arrivalTime  = connectionArrivalTime + nodeArrivalInNodesEgressIte->second.time;
+          tripProfile.exitIndex    = connectionIndex;
+          tripProfile.exitToEgress = true;
+        }
+        auto bestTransfer = getBestTransferProfileEntry(parameters, nodeArrival, connectionArrivalTime);
+        if (bestTransfer.has_value() && std::get<0>(bestTransfer.value()).get().arrivalTime < tripProfile.arrivalTime)
+        {
+          tripProfile.arrivalTime  = std::get<0>(bestTransfer.value()).get().arrivalTime;
+          tripProfile.exitIndex    = connectionIndex;
+          tripProfile.exitToEgress = false;
+        }
+      }
+
+      if (packedConnections.canBoard(connectionIndex) && tripProfile.arrivalTime < MAX_INT)
+      {
+        ProfileEntry entry;
+        entry.readyTime    = connectionDepartureTime - packedConnections.getMinWaitingTimeOrDefault(connectionIndex, parameters.getMinWaitingTimeSeconds());
+        entry.arrivalTime  = tripProfile.arrivalTime;
+        entry.boardIndex   = connectionIndex;
+        entry.exitIndex    = tripProfile.exitIndex;
+        entry.exitToEgress = tripProfile.exitToEgress;
+        addProfileEntry(nodesProfiles[packedConnections.departureNodeUids[connectionIndex]], entry);
+        reachableConnectionsCount++;
+      }
+    }
+
+    spdlog::debug("-- profile calculation -- {} boardable connections reaching destination", reachableConnectionsCount);
+
+    // Departures from origin: the access node entries, shifted by the access time
+    std::vector<std::tuple<int, std::reference_wrapper<const ProfileEntry>, std::reference_wrapper<const Node>>> departures;
+    for (auto & accessFootpath : accessFootpaths)
+    {
+      int accessTime = nodesAccess.at(accessFootpath.node.uid).time;
+      for (auto & entry : nodesProfiles[accessFootpath.node.uid])
+      {
+        int departureTime = entry.readyTime - accessTime;
+        if (departureTime >= windowStart && departureTime <= windowEnd && entry.arrivalTime - departureTime <= parameters.getMaxTotalTravelTimeSeconds())
+        {
+          departures.push_back(std::make_tuple(departureTime, std::cref(entry), std::cref(accessFootpath.node)));
+        }
+      }
+    }
+
+    // Keep the Pareto set: by decreasing departure time, a journey is kept only if it arrives strictly earlier than all later departures
+    std::sort(departures.begin(), departures.end(), [](const auto &departureA, const auto &departureB) {
+      if (std::get<0>(departureA) != std::get<0>(departureB)) {
+        return std::get<0>(departureA) > std::get<0>(departureB);
+      }
+      return std::get<1>(departureA).get().arrivalTime < std::get<1>(departureB).get().arrivalTime;
+    });
+
+    std::unique_ptr<ProfileResult> result = std::make_unique<ProfileResult>();
+    int bestArrivalTime = MAX_INT;
+    for (auto & departure : departures)
+    {
+      const ProfileEntry & entry = std::get<1>(departure).get();
+      if (entry.arrivalTime >= bestArrivalTime)
+      {
+        continue;
+      }
+      bestArrivalTime = entry.arrivalTime;
+      std::unique_ptr<SingleCalculationResult> journey = profileJourney(parameters, std::get<0>(departure), std::get<2>(departure).get(), entry);
+      if (journey.get() != nullptr)
+      {
+        result.get()->journeys.push_back(std::move(journey));
+      }
+    }
+    std::reverse(result.get()->journeys.begin(), result.get()->journeys.end());
+
+    spdlog::debug("-- profile journeys -- {} journeys in time window", result.get()->journeys.size());
+
+    if (result.get()->journeys.empty())
+    {
+      throw NoRoutingFoundException(NoRoutingReason::NO_ROUTING_FOUND);
+    }
+    return result;
+  }
+
+  std::unique_ptr<SingleCalculationResult> Calculator::profileJourney(ProfileParameters &parameters, int departureTime, const Node &accessNode, const ProfileEntry &entry)
+  {
+    auto & forwardConnections = connectionSet.get()->getForwardConnections();
+
+    // Fill the journey steps of the nodes along the journey, the same way the forward calculation does, to reuse the forward journey
+    forwardJourneysSteps.clear();
+    std::unordered_map<Node::uid_t, JourneyStep> forwardEgressJourneysSteps;
+    std::unordered_set<Node::uid_t> boardingNodes { accessNode.uid };
+    std::reference_wrapper<const ProfileEntry> currentEntry = entry;
+    while (true)
+    {
+      const Connection & enterConnection = forwardConnections[currentEntry.get().boardIndex];
+      const Connection & exitConnection = forwardConnections[currentEntry.get().exitIndex];
+      const Node & nodeArrival = exitConnection.getArrivalNode();
+      if (currentEntry.get().exitToEgress)
+      {
+        forwardEgressJourneysSteps.insert_or_assign(nodeArrival.uid, JourneyStep(std::cref(enterConnection), std::cref(exitConnection), std::cref(exitConnection.getTrip()), 0, true, 0));
+        departureTimeSeconds = departureTime;
+        return forwardJourneyStep(parameters, std::cref(nodeArrival), forwardEgressJourneysSteps);
+      }
+
+      auto bestTransfer = getBestTransferProfileEntry(parameters, nodeArrival, exitConnection.getArrivalTime());
+      if (!bestTransfer.has_value())
+      {
+        spdlog::debug("Profile journey could not be reconstructed after exit at node {}", nodeArrival.name);
+        return nullptr;
+      }
+      currentEntry = std::get<0>(bestTransfer.value());
+      const NodeTimeDistance & transferableNode = std::get<1>(bestTransfer.value()).get();
+      // Journeys that board twice at the same node are dominated, but make sure not to loop forever
+      if (!boardingNodes.insert(transferableNode.node.uid).second)
+      {
+        spdlog::debug("Profile journey boards twice at node {}", transferableNode.node.name);
+        return nullptr;
+      }
+      forwardJourneysSteps.at(transferableNode.node.uid) = JourneyStep(std::cref(enterConnection), std::cref(exitConnection), std::cref(exitConnection.getTrip()), transferableNode.time, nodeArrival == transferableNode.node, transferableNode.distance);
+    }
+  }
+
+}
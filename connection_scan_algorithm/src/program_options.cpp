@@ -1,6 +1,7 @@
 #include "program_options.hpp"
 #include <iostream>
 #include <cstdlib>
+#include <algorithm>
 
 namespace TrRouting {
 
@@ -18,6 +19,8 @@ namespace TrRouting {
       ("cachePath",                                         boost::program_options::value<std::string>()->default_value("cache"), "cache path");
    options.add_options()
       ("cacheAllConnectionSets",                            boost::program_options::value<bool>()       ->default_value(false), "cache all connections set instead of the ones from the last used scenario");
+    options.add_options()
+      ("connectionCacheSizeMb",                             boost::program_options::value<int>()        ->default_value(0), "cache the connections sets of the most recently used scenarios up to this size in MB, 0 to cache only the last used scenario");
     options.add_options()
       ("useEuclideanDistance",                              boost::program_options::value<bool>()       ->default_value(false), "Use euclidean distance calculation instead of OSRM for access and egress calculations");
     options.add_options()
@@ -34,6 +37,14 @@ namespace TrRouting {
       ("osrmCyclingHost",                                   boost::program_options::value<std::string>()->default_value("localhost"), "osrm cycling host");
     options.add_options()
       ("osrmDrivingHost",                                   boost::program_options::value<std::string>()->default_value("localhost"), "osrm driving host");
+    options.add_options()
+      ("osrmCacheSize",                                     boost::program_options::value<int>()        ->default_value(10000), "Number of points for which the osrm footpaths are cached, 0 to disable the cache");
+    options.add_options()
+      ("maxBatchQueries",                                   boost::program_options::value<int>()        ->default_value(1000), "maximum number of queries in a /v2/route/batch request");
+    options.add_options()
+      ("snapshot",                                          boost::program_options::value<std::string>()->default_value(""), "load the data from this snapshot file instead of the cache");
+    options.add_options()
+      ("compileSnapshot",                                   boost::program_options::value<std::string>()->default_value(""), "load the data from the cache, write it to this snapshot file and exit");
 
   }
 
@@ -47,6 +58,7 @@ namespace TrRouting {
     dataFetcherShortname = "cache";
     cachePath            = "cache";
     cacheAllConnectionSets = false;
+    connectionCacheSizeMb = 0;
     useEuclideanDistance = false;
     numberOfThreads      = 1;
     osrmWalkingPort      = "5000";
@@ -55,6 +67,10 @@ namespace TrRouting {
     osrmWalkingHost      = "localhost";
     osrmCyclingHost      = "localhost";
     osrmDrivingHost      = "localhost";
+    osrmCacheSize        = 10000;
+    maxBatchQueries      = 1000;
+    snapshotPath         = "";
+    compileSnapshotPath  = "";
 
     if(variablesMap.count("help")) {
       std::cout << options << std::endl;
@@ -84,6 +100,10 @@ namespace TrRouting {
     {
       cacheAllConnectionSets = variablesMap["cacheAllConnectionSets"].as<bool>();
     }
+    if(variablesMap.count("connectionCacheSizeMb") == 1)
+    {
+      connectionCacheSizeMb = std::max(variablesMap["connectionCacheSizeMb"].as<int>(), 0);
+    }
     if(variablesMap.count("useEuclideanDistance") == 1)
     {
       useEuclideanDistance = variablesMap["useEuclideanDistance"].as<bool>();
@@ -134,6 +154,22 @@ namespace TrRouting {
     {
       osrmDrivingHost = variablesMap["osrmDrivingHost"].as<std::string>();
     }
+    if(variablesMap.count("osrmCacheSize") == 1)
+    {
+      osrmCacheSize = std::max(variablesMap["osrmCacheSize"].as<int>(), 0);
+    }
+    if(variablesMap.count("maxBatchQueries") == 1)
+    {
+      maxBatchQueries = std::max(variablesMap["maxBatchQueries"].as<int>(), 1);
+    }
+    if(variablesMap.count("snapshot") == 1)
+    {
+      snapshotPath = variablesMap["snapshot"].as<std::string>();
+    }
+    if(variablesMap.count("compileSnapshot") == 1)
+    {
+      compileSnapshotPath = variablesMap["compileSnapshot"].as<std::string>();
+    }
 
   }
 
@@ -12,6 +12,7 @@
 #include "node.hpp"
 #include "transit_data.hpp"
 #include "connection_set.hpp"
+#include "trip_filter.hpp"
 #include "geofilter.hpp"
 
 namespace TrRouting
@@ -33,7 +34,7 @@ namespace TrRouting
       egressFootpaths.clear();
       egressFootpaths.shrink_to_fit();
     }
-    tripsQueryOverlay.assign(Trip::getMaxUid()+1, TripQueryData());
+    tripsQueryOverlay.reset(transitData.getTripsMaxUid()+1, TripQueryData());
     forwardJourneysSteps.clear();
     reverseJourneysSteps.clear();
 
@@ -70,7 +71,7 @@ namespace TrRouting
     {
       if (resetAccessPaths)
       {
-        accessFootpathOk = resetAccessFootpaths(parameters, origin.value());
+        accessFootpathOk = resetAccessFootpaths(parameters, origin.value(), parameters.getOriginNodes());
       }
 
       spdlog::debug("  parsing access footpaths to find min/max access travel times");
@@ -78,8 +79,8 @@ namespace TrRouting
       int footpathTravelTimeSeconds;
       int footpathDistanceMeters;
       nodesAccess.clear();
-      forwardJourneysSteps.assign(Node::getMaxUid() + 1, JourneyStep());
-      nodesTentativeTime.assign(Node::getMaxUid() + 1, MAX_INT); //Assign default values to all indexes
+      forwardJourneysSteps.reset(transitData.getNodesMaxUid() + 1, JourneyStep());
+      nodesTentativeTime.reset(transitData.getNodesMaxUid() + 1, MAX_INT); //Invalidate all indexes, they will be read as the default value
       
       for (auto & accessFootpath : accessFootpaths)
       {
@@ -104,41 +105,7 @@ namespace TrRouting
   
     if (destination.has_value())
     {
-      if (resetAccessPaths)
-      {
-        egressFootpathOk = resetEgressFootpaths(parameters, destination.value());
-      }
-      
-      spdlog::debug("  parsing egress footpaths to find min/max egress travel times");
-
-      int footpathTravelTimeSeconds;
-      int footpathDistanceMeters;
-      nodesEgress.clear();
-      reverseJourneysSteps.assign(Node::getMaxUid() + 1, JourneyStep());
-      nodesReverseTentativeTime.assign(Node::getMaxUid() + 1, -1); //Assign default values to all indexes
-      for (auto & egressFootpath : egressFootpaths)
-      {
-        footpathTravelTimeSeconds  = (int)ceil((float)(egressFootpath.time) / parameters.getWalkingSpeedFactor());
-        footpathDistanceMeters     = egressFootpath.distance;
-
-        nodesEgress.emplace(egressFootpath.node.uid, NodeTimeDistance(egressFootpath.node,
-                                                                       footpathTravelTimeSeconds,
-                                                                       footpathDistanceMeters));
-
-        reverseJourneysSteps.at(egressFootpath.node.uid) = JourneyStep(std::nullopt, std::nullopt, std::nullopt, footpathTravelTimeSeconds, false, footpathDistanceMeters);
-        nodesReverseTentativeTime[egressFootpath.node.uid] = arrivalTimeSeconds - footpathTravelTimeSeconds;
-        if (footpathTravelTimeSeconds > maxEgressTravelTime)
-        {
-          maxEgressTravelTime = footpathTravelTimeSeconds;
-        }
-        if (footpathTravelTimeSeconds < minEgressTravelTime)
-        {
-          minEgressTravelTime = footpathTravelTimeSeconds;
-        }
-        //nodesD[std::get<0>(egressFootpath)]                = std::get<1>(egressFootpath);
-        //result.json += "destination_node: " + nodes[std::get<0>(egressFootpath)].get()->name + " - " + Toolbox::convertSecondsToFormattedTime(nodesTentativeTime[std::get<0>(accessFootpath)]) + "\n";
-        //result.json += std::to_string((int)(ceil(std::get<1>(egressFootpath)))) + ",";
-      }
+      egressFootpathOk = resetDestination(parameters, destination.value(), resetAccessPaths);
     }
 
     // Throw proper exceptions when no access at origin and/or destination
@@ -169,7 +136,63 @@ namespace TrRouting
 
   }
 
-  bool Calculator::resetAccessFootpaths(const CommonParameters &parameters, const Point& origin) {
+  bool Calculator::resetDestination(CommonParameters &parameters, const Point& destination, bool resetAccessPaths)
+  {
+    bool egressFootpathOk = true;
+    maxEgressTravelTime = -1;
+    minEgressTravelTime = MAX_INT;
+
+    if (resetAccessPaths)
+    {
+      egressFootpathOk = resetEgressFootpaths(parameters, destination, parameters.getDestinationNodes());
+    }
+    
+    spdlog::debug("  parsing egress footpaths to find min/max egress travel times");
+
+    int footpathTravelTimeSeconds;
+    int footpathDistanceMeters;
+    nodesEgress.clear();
+    reverseJourneysSteps.reset(transitData.getNodesMaxUid() + 1, JourneyStep());
+    nodesReverseTentativeTime.reset(transitData.getNodesMaxUid() + 1, -1); //Invalidate all indexes, they will be read as the default value
+    for (auto & egressFootpath : egressFootpaths)
+    {
+      footpathTravelTimeSeconds  = (int)ceil((float)(egressFootpath.time) / parameters.getWalkingSpeedFactor());
+      footpathDistanceMeters     = egressFootpath.distance;
+
+      nodesEgress.emplace(egressFootpath.node.uid, NodeTimeDistance(egressFootpath.node,
+                                                                     footpathTravelTimeSeconds,
+                                                                     footpathDistanceMeters));
+
+      reverseJourneysSteps.at(egressFootpath.node.uid) = JourneyStep(std::nullopt, std::nullopt, std::nullopt, footpathTravelTimeSeconds, false, footpathDistanceMeters);
+      nodesReverseTentativeTime[egressFootpath.node.uid] = arrivalTimeSeconds - footpathTravelTimeSeconds;
+      if (footpathTravelTimeSeconds > maxEgressTravelTime)
+      {
+        maxEgressTravelTime = footpathTravelTimeSeconds;
+      }
+      if (footpathTravelTimeSeconds < minEgressTravelTime)
+      {
+        minEgressTravelTime = footpathTravelTimeSeconds;
+      }
+      //nodesD[std::get<0>(egressFootpath)]                = std::get<1>(egressFootpath);
+      //result.json += "destination_node: " + nodes[std::get<0>(egressFootpath)].get()->name + " - " + Toolbox::convertSecondsToFormattedTime(nodesTentativeTime[std::get<0>(accessFootpath)]) + "\n";
+      //result.json += std::to_string((int)(ceil(std::get<1>(egressFootpath)))) + ",";
+    }
+    return egressFootpathOk;
+  }
+
+  // Copy the precomputed nodes reachable within the max walking travel time, at the walking speed of the parameters
+  static void copyPrecomputedFootpaths(const std::vector<NodeTimeDistance> &precomputedNodes, int maxWalkingTravelTimeSeconds, float walkingSpeedFactor, std::vector<NodeTimeDistance> &footpaths)
+  {
+    footpaths.clear();
+    for (auto & precomputedNode : precomputedNodes) {
+      // Same travel time as the one used for the footpaths in reset()
+      if ((int)ceil((float)(precomputedNode.time) / walkingSpeedFactor) <= maxWalkingTravelTimeSeconds) {
+        footpaths.push_back(precomputedNode);
+      }
+    }
+  }
+
+  bool Calculator::resetAccessFootpaths(const CommonParameters &parameters, const Point& origin, PrecomputedNodes precomputedNodes) {
     spdlog::debug("  resetting access paths ");
     bool accessFootpathOk = true;
 
@@ -182,11 +205,18 @@ namespace TrRouting
         accessFootpaths.push_back(accessNode);
       }
     }
+    else if (precomputedNodes.has_value())
+    {
+      spdlog::debug("  using {} precomputed accessible nodes", precomputedNodes.value().get().size());
+
+      copyPrecomputedFootpaths(precomputedNodes.value().get(), parameters.getMaxAccessWalkingTravelTimeSeconds(), parameters.getWalkingSpeedFactor(), accessFootpaths);
+      accessFootpathOk = accessFootpaths.size() > 0;
+    }
     else
     {
       spdlog::debug("  fetching nodes with osrm");
 
-      accessFootpaths = geoFilter.getAccessibleNodesFootpathsFromPoint(origin, transitData.getNodes(), parameters.getMaxAccessWalkingTravelTimeSeconds(), parameters.getWalkingSpeedMetersPerSecond());
+      accessFootpaths = geoFilter.getAccessibleNodesFootpathsFromPoint(origin, transitData.getNodesSpatialIndex(), parameters.getMaxAccessWalkingTravelTimeSeconds(), parameters.getWalkingSpeedMetersPerSecond());
       if (accessFootpaths.size() == 0) {
         accessFootpathOk = false;
       }
@@ -194,7 +224,7 @@ namespace TrRouting
     return accessFootpathOk;
   }
 
-  bool Calculator::resetEgressFootpaths(const CommonParameters &parameters, const Point & destination) {
+  bool Calculator::resetEgressFootpaths(const CommonParameters &parameters, const Point & destination, PrecomputedNodes precomputedNodes) {
     bool egressFootpathOk = true;
 
     // fetch nodes footpaths accessible to destination using params or osrm fetcher if not provided:
@@ -208,9 +238,16 @@ namespace TrRouting
         egressFootpaths.push_back(egressNode);
       }
     }
+    else if (precomputedNodes.has_value())
+    {
+      spdlog::debug("  using {} precomputed egressible nodes", precomputedNodes.value().get().size());
+
+      copyPrecomputedFootpaths(precomputedNodes.value().get(), parameters.getMaxEgressWalkingTravelTimeSeconds(), parameters.getWalkingSpeedFactor(), egressFootpaths);
+      egressFootpathOk = egressFootpaths.size() > 0;
+    }
     else
     {
-      egressFootpaths = geoFilter.getAccessibleNodesFootpathsFromPoint(destination, transitData.getNodes(), parameters.getMaxEgressWalkingTravelTimeSeconds(), parameters.getWalkingSpeedMetersPerSecond());
+      egressFootpaths = geoFilter.getAccessibleNodesFootpathsFromPoint(destination, transitData.getNodesSpatialIndex(), parameters.getMaxEgressWalkingTravelTimeSeconds(), parameters.getWalkingSpeedMetersPerSecond());
       if (egressFootpaths.size() == 0) {
         egressFootpathOk = false;
       }
@@ -222,106 +259,21 @@ namespace TrRouting
     spdlog::debug("  resetting filters");
 
     // TODO med term. Instead of the scenario as cache key, it could be the parameters, with services, lines and agencies
-    connectionSet = transitData.getConnectionsForScenario(parameters.getScenario());
+    connectionSet = transitData.getConnectionsForScenario(parameters.getScenario(), parameters.getDate());
 
-    // This loop is required for alternatives, where parameters have more
+    // The filter is required for alternatives, where parameters have more
     // exclusions than the scenario (the combinations of lines). It is not
     // redundant with the one in the connection cache generator
-    // TODO: This code is very similar to the one in getConnectionsForScenario, extract it
-    tripsDisabled.clear();
-    for (auto & tripIte : connectionSet.get()->getTrips())
-    {
-      const Trip & trip = tripIte.get();
-      bool enabled = true;
-
-      if (enabled && parameters.getOnlyServices().size() > 0)
-      {
-        if (std::find(parameters.getOnlyServices().begin(), parameters.getOnlyServices().end(), trip.service) == parameters.getOnlyServices().end())
-        {
-          enabled = false;
-        }
-      }
-
-      if (enabled && parameters.getOnlyLines().size() > 0)
-      {
-        if (std::find(parameters.getOnlyLines().begin(), parameters.getOnlyLines().end(), trip.line) == parameters.getOnlyLines().end())
-        {
-          enabled = false;
-        }
-      }
-
-      if (enabled && parameters.getOnlyModes().size() > 0)
-      {
-        if (std::find(parameters.getOnlyModes().begin(), parameters.getOnlyModes().end(), trip.mode) == parameters.getOnlyModes().end())
-        {
-          enabled = false;
-        }
-      }
-
-      if (enabled  && parameters.getOnlyNodes().size() > 0)
-      {
-        // FIXME: This is not right, it should look for a node, not the mode
-        // FIXME2: Commented out, since mode is now typed, it won't match
-        /*if (std::find(parameters.getOnlyNodesIdx()->begin(), parameters.getOnlyNodesIdx()->end(), trip->modeIdx) == parameters.getOnlyNodesIdx()->end())
-          {
-          enabled = -1;
-          }(*/
-      }
-
-      if (enabled && parameters.getOnlyAgencies().size() > 0)
-      {
-        if (std::find(parameters.getOnlyAgencies().begin(), parameters.getOnlyAgencies().end(), trip.agency) == parameters.getOnlyAgencies().end())
-        {
-          enabled = false;
-        }
-      }
-
-      if (enabled && parameters.getExceptServices().size() > 0)
-      {
-        if (std::find(parameters.getExceptServices().begin(), parameters.getExceptServices().end(), trip.service) != parameters.getExceptServices().end())
-        {
-          enabled = false;
-        }
-      }
-
-      if (enabled && parameters.getExceptLines().size() > 0)
-      {
-        if (std::find(parameters.getExceptLines().begin(), parameters.getExceptLines().end(), trip.line) != parameters.getExceptLines().end())
-        {
-          enabled = false;
-        }
-      }
-      if (enabled && parameters.getExceptNodes().size() > 0)
-      {
-        // FIXME: This is not right, it should look for a node, not the mode
-        // FIXME2: Commented out, since mode is now typed, it won't match
-        /*
-          if (std::find(parameters.getExceptNodesIdx()->begin(), parameters.getExceptNodesIdx()->end(), trip.modeIdx) != parameters.getExceptNodesIdx()->end())
-          {
-          enabled = false;
-          }*/
-      }
-
-      if (enabled && parameters.getExceptModes().size() > 0)
-      {
-        if (std::find(parameters.getExceptModes().begin(), parameters.getExceptModes().end(), trip.mode) != parameters.getExceptModes().end())
-        {
-          enabled = false;
-        }
-      }
-
-      if (enabled && parameters.getExceptAgencies().size() > 0)
-      {
-        if (std::find(parameters.getExceptAgencies().begin(), parameters.getExceptAgencies().end(), trip.agency) != parameters.getExceptAgencies().end())
-        {
-          enabled = false;
-        }
-      }
-      if (!enabled) {
-        tripsDisabled[trip.uid] = true;
-      }
-    }
-
+    // FIXME: The only/except nodes parameters are not supported, they were never applied
+    TripFilter tripFilter(parameters.getOnlyServices(),
+                          parameters.getExceptServices(),
+                          parameters.getOnlyLines(),
+                          parameters.getExceptLines(),
+                          parameters.getOnlyModes(),
+                          parameters.getExceptModes(),
+                          parameters.getOnlyAgencies(),
+                          parameters.getExceptAgencies());
+    tripsDisabled = tripFilter.getDisabledTrips(connectionSet.get()->getTrips());
   }
 
 }
@@ -144,6 +144,34 @@ namespace TrRouting
     return json;
   }
 
+  std::string ResultToV2Response::getParameterErrorCode(ParameterException::Type type)
+  {
+    switch(type)
+    {
+      case ParameterException::Type::EMPTY_SCENARIO: return "EMPTY_SCENARIO";
+      case ParameterException::Type::MISSING_SCENARIO: return "MISSING_PARAM_SCENARIO";
+      case ParameterException::Type::MISSING_ORIGIN: return "MISSING_PARAM_ORIGIN";
+      case ParameterException::Type::MISSING_DESTINATION: return "MISSING_PARAM_DESTINATION";
+      case ParameterException::Type::MISSING_TIME_OF_TRIP: return "MISSING_PARAM_TIME_OF_TRIP";
+      case ParameterException::Type::INVALID_SCENARIO: return "INVALID_SCENARIO";
+      case ParameterException::Type::INVALID_ORIGIN: return "INVALID_ORIGIN";
+      case ParameterException::Type::INVALID_DESTINATION: return "INVALID_DESTINATION";
+      case ParameterException::Type::INVALID_NUMERICAL_DATA: return "INVALID_NUMERICAL_DATA";
+      case ParameterException::Type::INVALID_TIME_WINDOW: return "INVALID_TIME_WINDOW";
+      case ParameterException::Type::INVALID_DATE: return "INVALID_DATE";
+      case ParameterException::Type::INVALID_MAX_TRANSFERS: return "INVALID_MAX_TRANSFERS";
+      default: return "PARAM_ERROR_UNKNOWN";
+    }
+  }
+
+  nlohmann::json ResultToV2Response::parameterErrorResponse(ParameterException::Type type)
+  {
+    nlohmann::json json;
+    json["status"] = "query_error";
+    json["errorCode"] = getParameterErrorCode(type);
+    return json;
+  }
+
   nlohmann::json ResultToV2Response::noRoutingFoundResponse(RouteParameters& params, NoRoutingReason noRoutingReason)
   {
     nlohmann::json json;
@@ -209,4 +237,22 @@ namespace TrRouting
 
     return json;
   }
+
+  nlohmann::json ResultToV2Response::resultToJsonString(ProfileResult& result, ProfileParameters& params)
+  {
+    nlohmann::json json;
+    json["status"] = STATUS_SUCCESS;
+    json["query"] = parametersToRouteQueryResponse(params);
+    json["query"]["timeWindowEnd"] = params.getTimeWindowEnd();
+
+    nlohmann::json resultJson;
+    resultJson["routes"] = nlohmann::json::array();
+    for (auto &journey : result.journeys) {
+      resultJson["routes"].push_back(getSingleResultJsonString(*journey.get()));
+    }
+    resultJson["totalRoutesCalculated"] = result.journeys.size();
+    json["result"] = resultJson;
+
+    return json;
+  }
 }
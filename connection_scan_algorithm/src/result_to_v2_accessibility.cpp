@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <nlohmann/json.hpp>
 #include "constants.hpp"
 #include "result_constants.hpp"
@@ -21,15 +23,15 @@ namespace TrRouting
     queryJson["place"] = pointToAccessibilityJson(*params.getPlace());
     queryJson["timeOfTrip"] = params.getTimeOfTrip();
     queryJson["timeType"] = params.isForwardCalculation() ? 0 : 1;
+    if (params.hasTimeWindow()) {
+      queryJson["timeWindowEnd"] = params.getTimeWindowEnd();
+      queryJson["stepSeconds"] = params.getStepSeconds();
+    }
     return queryJson;
   }
 
-  nlohmann::json ResultToV2AccessibilityResponse::noRoutingFoundResponse(AccessibilityParameters& params, NoRoutingReason noRoutingReason)
+  std::string noRoutingReasonToString(NoRoutingReason noRoutingReason)
   {
-    nlohmann::json json;
-    json["status"] = STATUS_NO_ROUTING_FOUND;
-    json["query"] = parametersToAccessibilityQueryResponse(params);
-
     std::string reason;
     switch(noRoutingReason) {
       case NoRoutingReason::NO_ROUTING_FOUND:
@@ -47,7 +49,16 @@ namespace TrRouting
         reason = NO_ROUTING_REASON_DEFAULT;
         break;
     }
-    json["reason"] = reason;
+    return reason;
+  }
+
+  nlohmann::json ResultToV2AccessibilityResponse::noRoutingFoundResponse(AccessibilityParameters& params, NoRoutingReason noRoutingReason)
+  {
+    nlohmann::json json;
+    json["status"] = STATUS_NO_ROUTING_FOUND;
+    json["query"] = parametersToAccessibilityQueryResponse(params);
+
+    json["reason"] = noRoutingReasonToString(noRoutingReason);
     return json;
   }
 
@@ -83,4 +94,104 @@ namespace TrRouting
     return json;
     
   }
+
+  nlohmann::json ResultToV2AccessibilityResponse::resultToJsonString(std::vector<PlaceAllNodesResult>& results, AccessibilityBatchParameters& params)
+  {
+    // Initialize response
+    nlohmann::json json;
+    json["status"] = STATUS_SUCCESS;
+
+    nlohmann::json queryJson;
+    queryJson["places"] = nlohmann::json::array();
+    for (auto &place : params.getPlaces()) {
+      queryJson["places"].push_back(pointToAccessibilityJson(*place.get()));
+    }
+    queryJson["timeOfTrip"] = params.getTimeOfTrip();
+    queryJson["timeType"] = params.isForwardCalculation() ? 0 : 1;
+    json["query"] = queryJson;
+
+    // One result per place, in the order of the query
+    json["result"] = nlohmann::json::array();
+    for (size_t i = 0; i < results.size(); i++) {
+      nlohmann::json placeJson;
+      placeJson["place"] = pointToAccessibilityJson(*params.getPlaces()[i].get());
+      if (params.getPlacesUuids()[i].has_value()) {
+        placeJson["placeUuid"] = boost::uuids::to_string(params.getPlacesUuids()[i].value());
+      }
+      if (results[i].result.get() == nullptr) {
+        placeJson["status"] = STATUS_NO_ROUTING_FOUND;
+        placeJson["reason"] = noRoutingReasonToString(results[i].noRoutingReason);
+      } else {
+        placeJson["status"] = STATUS_SUCCESS;
+        placeJson["totalNodeCount"] = results[i].result.get()->totalNodeCount;
+        placeJson["nodes"] = nlohmann::json::array();
+        for (auto &node : results[i].result.get()->nodes) {
+          placeJson["nodes"].push_back(nodeToJson(node, params.isForwardCalculation()));
+        }
+      }
+      json["result"].push_back(placeJson);
+    }
+
+    return json;
+  }
+
+  // Travel time distribution of a node over the times of trip, where the times at which it is not reached count as infinite travel times
+  nlohmann::json nodeTravelTimesToJson(const AccessibleNodeTravelTimes & node)
+  {
+    std::vector<int> sortedTravelTimes;
+    for (int travelTime : node.travelTimes) {
+      if (travelTime >= 0) {
+        sortedTravelTimes.push_back(travelTime);
+      }
+    }
+    std::sort(sortedTravelTimes.begin(), sortedTravelTimes.end());
+    long long travelTimesSum = 0;
+    for (int travelTime : sortedTravelTimes) {
+      travelTimesSum += travelTime;
+    }
+
+    // Nearest rank percentile over all the times of trip, null if the node is not reached at this rank
+    auto percentileToJson = [&node, &sortedTravelTimes](int percentile) -> nlohmann::json {
+      size_t rank = std::max((size_t)1, (size_t)ceil(percentile * node.travelTimes.size() / 100.0));
+      return rank <= sortedTravelTimes.size() ? nlohmann::json(sortedTravelTimes[rank - 1]) : nlohmann::json(nullptr);
+    };
+
+    nlohmann::json nodeResult;
+    nodeResult["nodeName"] = node.node.name;
+    nodeResult["nodeCode"] = node.node.code;
+    nodeResult["nodeUuid"] = boost::uuids::to_string(node.node.uuid);
+    nodeResult["nodeCoordinates"] = { node.node.point->longitude, node.node.point->latitude };
+    nodeResult["reachableCount"] = sortedTravelTimes.size();
+    nodeResult["minTravelTime"] = sortedTravelTimes.front();
+    nodeResult["averageTravelTime"] = (int)round((double)travelTimesSum / sortedTravelTimes.size());
+    nodeResult["medianTravelTime"] = percentileToJson(50);
+    nodeResult["travelTimePercentiles"] = {
+      {"p10", percentileToJson(10)},
+      {"p25", percentileToJson(25)},
+      {"p50", percentileToJson(50)},
+      {"p75", percentileToJson(75)},
+      {"p90", percentileToJson(90)}
+    };
+    return nodeResult;
+  }
+
+  nlohmann::json ResultToV2AccessibilityResponse::resultToJsonString(AllNodesRangeResult& result, AccessibilityParameters& params)
+  {
+    // Initialize response
+    nlohmann::json json;
+    json["status"] = STATUS_SUCCESS;
+    json["query"] = parametersToAccessibilityQueryResponse(params);
+
+    // Result response
+    nlohmann::json resultJson;
+    resultJson["totalNodeCount"] = result.totalNodeCount;
+    resultJson["timesOfTripCount"] = result.timesOfTrip.size();
+    resultJson["nodes"] = nlohmann::json::array();
+    for (auto &node : result.nodes) {
+      resultJson["nodes"].push_back(nodeTravelTimesToJson(node));
+    }
+    json["result"] = resultJson;
+
+    return json;
+  }
 }
@@ -33,27 +33,32 @@ namespace TrRouting
     //TODO could be passed as a parameter
     auto & reverseConnections = connectionSet.get()->getReverseConnections();
     
-    int  connectionsCount = reverseConnections.size();
+    int  connectionsCount = connectionSet.get()->getReverseConnectionsCount();
     int  arrivalTimeHour  = arrivalTimeSeconds / 3600;
 
     // reverse calculation:
 
+    // The loop scans the packed columns, the connection objects are only used to record journey steps
+    const PackedConnections & packedConnections = connectionSet.get()->getReversePackedConnections();
+
     // main loop for reverse connections:
-    auto lastConnection = reverseConnections.end();
-    for(auto connection = connectionSet.get()->getReverseConnectionsBeginAtArrivalHour(arrivalTimeHour + 1); connection != lastConnection; ++connection)
+    // Only the connections enabled in the scenario's mask are scanned
+    const ConnectionMask & reverseMask = connectionSet.get()->getReverseMask();
+    size_t lastConnectionIndex = packedConnections.size();
+    for(size_t connectionIndex = reverseMask.next(connectionSet.get()->getReverseConnectionsBeginIndexAtArrivalHour(arrivalTimeHour + 1)); connectionIndex != lastConnectionIndex; connectionIndex = reverseMask.next(connectionIndex + 1))
     {
       // ignore connections after arrival time - minimum egress travel time:
-      if ((*connection).get().getArrivalTime() <= arrivalTimeSeconds - minEgressTravelTime)
+      connectionArrivalTime = packedConnections.arrivalTimes[connectionIndex];
+      if (connectionArrivalTime <= arrivalTimeSeconds - minEgressTravelTime)
       {
         
-        const Trip & trip = (*connection).get().getTrip();
+        Trip::uid_t tripUid = packedConnections.tripUids[connectionIndex];
         
         // enabled trips only here:
-        auto & currentTripQueryOverlay = tripsQueryOverlay.at(trip.uid);
-        if (currentTripQueryOverlay.usable && !isTripDisabled(trip.uid))
+        auto & currentTripQueryOverlay = tripsQueryOverlay[tripUid];
+        if (currentTripQueryOverlay.usable && !isTripDisabled(tripUid))
         {
 
-          connectionArrivalTime           = (*connection).get().getArrivalTime();
 
           // no need to parse next connections if already reached destination from all egress nodes, except if max travel time is set, so we can get a reverse profile in the next loop calculation:
           // yes, we mean connectionArrivalTime and not connectionDepartureTime because travel time for each connections, otherwise you can catch a very short/long connection
@@ -63,10 +68,10 @@ namespace TrRouting
           }
 
           tripExitConnection   = currentTripQueryOverlay.exitConnection;
-          const Node &nodeArrival = (*connection).get().getArrivalNode();
+          Node::uid_t nodeArrivalUid = packedConnections.arrivalNodeUids[connectionIndex];
 
           // Extract node arrival time
-          int nodeArrivalTentativeTime = nodesReverseTentativeTime.at(nodeArrival.uid);
+          int nodeArrivalTentativeTime = nodesReverseTentativeTime.get(nodeArrivalUid);
 
           // reachable connections only here:
           if (
@@ -77,13 +82,13 @@ namespace TrRouting
           {
             
             // Make sure the arrival of the connection can unboard and is a candidate for the journey. Nodes are candidate if they can either reach the destination by foot, or a connection that can reach the destination within the specified parameters.
-            if ((*connection).get().canUnboard())
+            if (packedConnections.canUnboard(connectionIndex))
             {
               // Extract journeyStep once from map
-              const JourneyStep & reverseStepAtArrival = reverseJourneysSteps.at(nodeArrival.uid);
+              const JourneyStep & reverseStepAtArrival = reverseJourneysSteps.get(nodeArrivalUid);
               if (!tripExitConnection.has_value()) // <= to make sure we get the same result as forward calculation, which uses >
               {
-                currentTripQueryOverlay.exitConnection = *connection;
+                currentTripQueryOverlay.exitConnection = reverseConnections[connectionIndex];
                 currentTripQueryOverlay.exitConnectionTransferTravelTime = reverseStepAtArrival.getTransferTravelTime();
               }
               else if (
@@ -99,19 +104,21 @@ namespace TrRouting
 
                 if (connectionArrivalTime + journeyConnectionMinWaitingTimeSeconds <= nodeArrivalTentativeTime)
                 {
-                  currentTripQueryOverlay.exitConnection = *connection;
+                  currentTripQueryOverlay.exitConnection = reverseConnections[connectionIndex];
                   currentTripQueryOverlay.exitConnectionTransferTravelTime = reverseStepAtArrival.getTransferTravelTime();
                 }
               }
 
             }
             
-            if ((*connection).get().canBoard() && currentTripQueryOverlay.exitConnection.has_value())
+            if (packedConnections.canBoard(connectionIndex) && currentTripQueryOverlay.exitConnection.has_value())
             {
+              const Connection & connection = reverseConnections[connectionIndex];
+              const Trip & trip = connection.getTrip();
               // get footpaths for the arrival node to get transferable nodes:
-              const Node &nodeDeparture = (*connection).get().getDepartureNode();
-              connectionDepartureTime         = (*connection).get().getDepartureTime();
-              connectionMinWaitingTimeSeconds = (*connection).get().getMinWaitingTimeOrDefault(parameters.getMinWaitingTimeSeconds());
+              const Node &nodeDeparture = connection.getDepartureNode();
+              connectionDepartureTime         = packedConnections.departureTimes[connectionIndex];
+              connectionMinWaitingTimeSeconds = packedConnections.getMinWaitingTimeOrDefault(connectionIndex, parameters.getMinWaitingTimeSeconds());
 
               auto nodeDepartureInNodesAccessIte = nodesAccess.find(nodeDeparture.uid);
               if (!reachedAtLeastOneAccessNode &&  nodeDepartureInNodesAccessIte != nodesAccess.end() &&  nodeDepartureInNodesAccessIte->second.time != -1) // check if the departure node is accessable
@@ -124,7 +131,7 @@ namespace TrRouting
               for (const NodeTimeDistance & transferableNode : nodeDeparture.reverseTransferableNodes)
               {
 
-                if (nodeDeparture != transferableNode.node && nodesReverseTentativeTime.at(transferableNode.node.uid) > connectionDepartureTime - connectionMinWaitingTimeSeconds)
+                if (nodeDeparture != transferableNode.node && nodesReverseTentativeTime.get(transferableNode.node.uid) > connectionDepartureTime - connectionMinWaitingTimeSeconds)
                 {
                   footpathIndex++;
                   continue;
@@ -135,12 +142,12 @@ namespace TrRouting
 
                 if (footpathTravelTime <= parameters.getMaxTransferWalkingTravelTimeSeconds())
                 {                  
-                  if (connectionDepartureTime - footpathTravelTime - connectionMinWaitingTimeSeconds >= nodesReverseTentativeTime.at(transferableNode.node.uid))
+                  if (connectionDepartureTime - footpathTravelTime - connectionMinWaitingTimeSeconds >= nodesReverseTentativeTime.get(transferableNode.node.uid))
                   {
                     footpathDistance = transferableNode.distance;
                     nodesReverseTentativeTime[transferableNode.node.uid] = connectionDepartureTime - footpathTravelTime - connectionMinWaitingTimeSeconds;
                     //TODO Do we need a make_optional<...>(connection) ??
-                    reverseJourneysSteps.at(transferableNode.node.uid) =  JourneyStep(*connection, currentTripQueryOverlay.exitConnection, std::cref(trip), footpathTravelTime, (nodeDeparture == transferableNode.node), footpathDistance);
+                    reverseJourneysSteps.at(transferableNode.node.uid) =  JourneyStep(std::cref(connection), currentTripQueryOverlay.exitConnection, std::cref(trip), footpathTravelTime, (nodeDeparture == transferableNode.node), footpathDistance);
                   }
                   if (
                     nodeDeparture == transferableNode.node
@@ -168,7 +175,7 @@ namespace TrRouting
                         connectionDepartureTime - departureTimeSeconds - nodeDepartureInNodesAccessIte->second.time <= parameters.getMaxFirstWaitingTimeSeconds()
                       )
                       {
-                        reverseAccessJourneysSteps.insert_or_assign(transferableNode.node.uid, JourneyStep(*connection, currentTripQueryOverlay.exitConnection, std::cref(trip), 0, true, 0));
+                        reverseAccessJourneysSteps.insert_or_assign(transferableNode.node.uid, JourneyStep(std::cref(connection), currentTripQueryOverlay.exitConnection, std::cref(trip), 0, true, 0));
                       }
                     }
                   }
@@ -237,26 +244,31 @@ namespace TrRouting
     //TODO could be passed as a parameter
     auto & reverseConnections = connectionSet.get()->getReverseConnections();
 
-    int  connectionsCount = reverseConnections.size();
+    int  connectionsCount = connectionSet.get()->getReverseConnectionsCount();
     int  arrivalTimeHour  = arrivalTimeSeconds / 3600;
 
     // reverse calculation:
 
+    // The loop scans the packed columns, the connection objects are only used to record journey steps
+    const PackedConnections & packedConnections = connectionSet.get()->getReversePackedConnections();
+
     // main loop for reverse connections:
-    auto lastConnection = reverseConnections.end();
-    for(auto connection = connectionSet.get()->getReverseConnectionsBeginAtArrivalHour(arrivalTimeHour + 1); connection != lastConnection; ++connection)
+    // Only the connections enabled in the scenario's mask are scanned
+    const ConnectionMask & reverseMask = connectionSet.get()->getReverseMask();
+    size_t lastConnectionIndex = packedConnections.size();
+    for(size_t connectionIndex = reverseMask.next(connectionSet.get()->getReverseConnectionsBeginIndexAtArrivalHour(arrivalTimeHour + 1)); connectionIndex != lastConnectionIndex; connectionIndex = reverseMask.next(connectionIndex + 1))
     {
       // ignore connections after arrival time - minimum egress travel time:
-      if ((*connection).get().getArrivalTime() <= arrivalTimeSeconds)
+      connectionArrivalTime = packedConnections.arrivalTimes[connectionIndex];
+      if (connectionArrivalTime <= arrivalTimeSeconds)
       {
-        const Trip & trip = (*connection).get().getTrip();
+        Trip::uid_t tripUid = packedConnections.tripUids[connectionIndex];
 
         // enabled trips only here:
-        auto & currentTripQueryOverlay = tripsQueryOverlay.at(trip.uid);
+        auto & currentTripQueryOverlay = tripsQueryOverlay[tripUid];
         // FIXME Determine with the new connection cache if a trip could be disabled in the all nodes path
-        if ((currentTripQueryOverlay.usable) && !isTripDisabled(trip.uid))
+        if ((currentTripQueryOverlay.usable) && !isTripDisabled(tripUid))
         {
-          connectionArrivalTime           = (*connection).get().getArrivalTime();
 
           // no need to parse next connections if already reached destination from all egress nodes, except if max travel time is set, so we can get a reverse profile in the next loop calculation:
           // yes, we mean connectionArrivalTime and not connectionDepartureTime because travel time for each connections, otherwise you can catch a very short/long connection
@@ -266,10 +278,10 @@ namespace TrRouting
           }
 
           tripExitConnection   = currentTripQueryOverlay.exitConnection;
-          const Node &nodeArrival = (*connection).get().getArrivalNode();
+          Node::uid_t nodeArrivalUid = packedConnections.arrivalNodeUids[connectionIndex];
 
           // Extract node arrival time
-          int nodeArrivalTentativeTime = nodesReverseTentativeTime.at(nodeArrival.uid);
+          int nodeArrivalTentativeTime = nodesReverseTentativeTime.get(nodeArrivalUid);
 
           // reachable connections only here:
           if (
@@ -278,13 +290,13 @@ namespace TrRouting
             nodeArrivalTentativeTime >= connectionArrivalTime
           )
           {
-            if ((*connection).get().canUnboard())
+            if (packedConnections.canUnboard(connectionIndex))
             {
               // Extract journeyStep once from map
-              const JourneyStep & reverseStepAtArrival = reverseJourneysSteps.at(nodeArrival.uid);
+              const JourneyStep & reverseStepAtArrival = reverseJourneysSteps.get(nodeArrivalUid);
               if (!tripExitConnection.has_value()) // <= to make sure we get the same result as forward calculation, which uses >
               {
-                currentTripQueryOverlay.exitConnection = *connection;
+                currentTripQueryOverlay.exitConnection = reverseConnections[connectionIndex];
                 currentTripQueryOverlay.exitConnectionTransferTravelTime = reverseStepAtArrival.getTransferTravelTime();
               }
               else if (
@@ -300,25 +312,27 @@ namespace TrRouting
 
                 if (connectionArrivalTime + journeyConnectionMinWaitingTimeSeconds <= nodeArrivalTentativeTime)
                 {
-                  currentTripQueryOverlay.exitConnection = *connection;
+                  currentTripQueryOverlay.exitConnection = reverseConnections[connectionIndex];
                   currentTripQueryOverlay.exitConnectionTransferTravelTime = reverseStepAtArrival.getTransferTravelTime();
                 }
               }
 
             }
 
-            if ((*connection).get().canBoard() && currentTripQueryOverlay.exitConnection.has_value())
+            if (packedConnections.canBoard(connectionIndex) && currentTripQueryOverlay.exitConnection.has_value())
             {
+              const Connection & connection = reverseConnections[connectionIndex];
+              const Trip & trip = connection.getTrip();
               // get footpaths for the arrival node to get transferable nodes:
-              const Node &nodeDeparture = (*connection).get().getDepartureNode();
-              connectionDepartureTime         = (*connection).get().getDepartureTime();
-              connectionMinWaitingTimeSeconds = (*connection).get().getMinWaitingTimeOrDefault(parameters.getMinWaitingTimeSeconds());
+              const Node &nodeDeparture = connection.getDepartureNode();
+              connectionDepartureTime         = packedConnections.departureTimes[connectionIndex];
+              connectionMinWaitingTimeSeconds = packedConnections.getMinWaitingTimeOrDefault(connectionIndex, parameters.getMinWaitingTimeSeconds());
 
               auto nodeDepartureInNodesAccessIte = nodesAccess.find(nodeDeparture.uid);
               for (const NodeTimeDistance & transferableNode : nodeDeparture.reverseTransferableNodes)
               {
 
-                if (nodeDeparture != transferableNode.node && nodesReverseTentativeTime.at(transferableNode.node.uid) > connectionDepartureTime - connectionMinWaitingTimeSeconds)
+                if (nodeDeparture != transferableNode.node && nodesReverseTentativeTime.get(transferableNode.node.uid) > connectionDepartureTime - connectionMinWaitingTimeSeconds)
                 {
                   continue;
                 }
@@ -328,12 +342,12 @@ namespace TrRouting
 
                 if (footpathTravelTime <= parameters.getMaxTransferWalkingTravelTimeSeconds())
                 {
-                  if (connectionDepartureTime - footpathTravelTime - connectionMinWaitingTimeSeconds >= nodesReverseTentativeTime.at(transferableNode.node.uid))
+                  if (connectionDepartureTime - footpathTravelTime - connectionMinWaitingTimeSeconds >= nodesReverseTentativeTime.get(transferableNode.node.uid))
                   {
                     footpathDistance = transferableNode.distance;
                     nodesReverseTentativeTime[transferableNode.node.uid] = connectionDepartureTime - footpathTravelTime - connectionMinWaitingTimeSeconds;
                     //TODO Do we need a make_optional<...>(connection) ??
-                    reverseJourneysSteps.at(transferableNode.node.uid) = JourneyStep(*connection, currentTripQueryOverlay.exitConnection, std::cref(trip), footpathTravelTime, (nodeDeparture == transferableNode.node), footpathDistance);
+                    reverseJourneysSteps.at(transferableNode.node.uid) = JourneyStep(std::cref(connection), currentTripQueryOverlay.exitConnection, std::cref(trip), footpathTravelTime, (nodeDeparture == transferableNode.node), footpathDistance);
                   }
                   if (
                     nodeDeparture == transferableNode.node
@@ -361,7 +375,7 @@ namespace TrRouting
                         connectionDepartureTime - departureTimeSeconds - nodeDepartureInNodesAccessIte->second.time <= parameters.getMaxFirstWaitingTimeSeconds()
                       )
                       {
-                        reverseAccessJourneysSteps.insert_or_assign(transferableNode.node.uid, JourneyStep(*connection, currentTripQueryOverlay.exitConnection, std::cref(trip), 0, true, 0));
+                        reverseAccessJourneysSteps.insert_or_assign(transferableNode.node.uid, JourneyStep(std::cref(connection), currentTripQueryOverlay.exitConnection, std::cref(trip), 0, true, 0));
                       }
                     }
                   }
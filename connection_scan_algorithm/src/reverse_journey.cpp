@@ -54,7 +54,7 @@ namespace TrRouting
             }
           journey.push_back(resultingNodeJourneyStep);
           bestEgressNode = resultingNodeJourneyStep.getFinalExitConnection().value().get().getArrivalNode();
-          resultingNodeJourneyStep = reverseJourneysSteps.at(bestEgressNode.value().get().uid);
+          resultingNodeJourneyStep = reverseJourneysSteps.get(bestEgressNode.value().get().uid);
         }
 
       journey.push_front(JourneyStep(std::nullopt,
@@ -293,7 +293,7 @@ namespace TrRouting
         }
         journey.push_back(resultingNodeJourneyStep);
         bestEgressNode = resultingNodeJourneyStep.getFinalExitConnection().value().get().getArrivalNode();
-        resultingNodeJourneyStep = reverseJourneysSteps.at(bestEgressNode.value().get().uid);
+        resultingNodeJourneyStep = reverseJourneysSteps.get(bestEgressNode.value().get().uid);
       }
 
       journey.push_back(JourneyStep(std::nullopt,
@@ -0,0 +1,113 @@
+#include <mutex>
+#include <optional>
+#include "spdlog/spdlog.h"
+
+#include "route_batch.hpp"
+#include "calculator.hpp"
+#include "calculator_pool.hpp"
+#include "worker_pool.hpp"
+#include "transit_data.hpp"
+#include "parameters.hpp"
+#include "routing_result.hpp"
+#include "result_to_v2.hpp"
+
+namespace TrRouting
+{
+
+  RouteBatch::RouteBatch(CalculatorPool &_calculatorPool, WorkerPool &_workerPool) :
+    calculatorPool(_calculatorPool),
+    workerPool(_workerPool)
+  {
+
+  }
+
+  std::vector<std::pair<std::string, std::string>> RouteBatch::queryToParameters(const nlohmann::json &query)
+  {
+    std::vector<std::pair<std::string, std::string>> parametersWithValues;
+    if (!query.is_object()) {
+      return parametersWithValues;
+    }
+    for (auto & [field, value] : query.items()) {
+      if (field == "id") {
+        continue;
+      }
+      if (value.is_string()) {
+        parametersWithValues.push_back(std::make_pair(field, value.get<std::string>()));
+      } else if (value.is_array()) {
+        // Coordinates can be given as a [longitude, latitude] array
+        std::string joinedValue;
+        for (auto & item : value) {
+          joinedValue += (joinedValue.empty() ? "" : ",") + (item.is_string() ? item.get<std::string>() : item.dump());
+        }
+        parametersWithValues.push_back(std::make_pair(field, joinedValue));
+      } else {
+        parametersWithValues.push_back(std::make_pair(field, value.dump()));
+      }
+    }
+    return parametersWithValues;
+  }
+
+  nlohmann::json RouteBatch::calculateQuery(Calculator &calculator, const TransitData &transitData, const nlohmann::json &query)
+  {
+    nlohmann::json response;
+    std::vector<std::pair<std::string, std::string>> parametersWithValues = queryToParameters(query);
+    try
+    {
+      RouteParameters queryParams = RouteParameters::createRouteODParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
+      try {
+        if (queryParams.isWithAlternatives())
+        {
+          TrRouting::AlternativesResult alternativeResult = calculator.alternativesRouting(queryParams);
+          response = ResultToV2Response::resultToJsonString(alternativeResult, queryParams);
+        }
+        else
+        {
+          std::unique_ptr<TrRouting::SingleCalculationResult> routingResult = calculator.calculateSingle(queryParams);
+          if (routingResult.get() != nullptr) {
+            response = ResultToV2Response::resultToJsonString(*routingResult.get(), queryParams);
+          }
+        }
+      } catch (NoRoutingFoundException &e) {
+        response = ResultToV2Response::noRoutingFoundResponse(queryParams, e.getReason());
+      }
+    } catch (ParameterException &exp) {
+      response = ResultToV2Response::parameterErrorResponse(exp.getType());
+    } catch (const std::exception &e) {
+      spdlog::error("-- unknown exception in batch route calculation -- {}", e.what());
+      response["status"] = "query_error";
+      response["errorCode"] = "PARAM_ERROR_UNKNOWN";
+    }
+
+    if (query.is_object() && query.contains("id")) {
+      response["id"] = query["id"];
+    }
+    return response;
+  }
+
+  void RouteBatch::calculate(const TransitData &transitData, const nlohmann::json &queries, const std::function<void(size_t, const nlohmann::json &)> &onResult)
+  {
+    std::vector<std::optional<nlohmann::json>> results(queries.size());
+    size_t nextResultIndex = 0;
+    std::mutex resultsMutex;
+
+    workerPool.run(queries.size(), [&](size_t index) {
+      // Each worker thread has its own calculator, kept between batches
+      nlohmann::json result;
+      {
+        Calculator &calculator = calculatorPool.getCalculator(transitData);
+        CalculatorRelease calculatorRelease(calculatorPool);
+        result = calculateQuery(calculator, transitData, queries[index]);
+      }
+
+      std::lock_guard<std::mutex> lock(resultsMutex);
+      results[index] = std::move(result);
+      // Pass the results in order, as soon as all the previous ones are done
+      while (nextResultIndex < results.size() && results[nextResultIndex].has_value()) {
+        onResult(nextResultIndex, results[nextResultIndex].value());
+        results[nextResultIndex].reset();
+        nextResultIndex++;
+      }
+    });
+  }
+
+}
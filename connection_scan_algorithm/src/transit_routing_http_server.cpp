@@ -8,25 +8,32 @@
 #include <algorithm>
 #include <string>
 #include <iterator>
+#include <functional>
 #include "spdlog/spdlog.h"
 
 #include <boost/uuid/uuid.hpp>
+#include <boost/uuid/string_generator.hpp>
 #include <boost/program_options.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include "cache_fetcher.hpp"
+#include "snapshot_data_fetcher.hpp"
 #include "calculation_time.hpp"
 #include "parameters.hpp"
 #include "scenario.hpp"
 #include "calculator.hpp"
+#include "calculator_pool.hpp"
+#include "worker_pool.hpp"
+#include "route_batch.hpp"
 #include "program_options.hpp"
 #include "result_to_v2.hpp"
 #include "result_to_v2_summary.hpp"
 #include "result_to_v2_accessibility.hpp"
 #include "routing_result.hpp"
 #include "transit_data.hpp"
+#include "transit_data_holder.hpp"
 #include "osrmgeofilter.hpp"
 #include "euclideangeofilter.hpp"
 
@@ -83,20 +90,60 @@ std::string getFastErrorResponse(DataStatus status)
   }
 }
 
-std::string getResponseCode(ParameterException::Type type)
+void writeJsonResponse(std::shared_ptr<HttpServer::Response> serverResponse, const std::string &httpStatus, const std::string &response)
 {
-  switch(type)
+  *serverResponse << "HTTP/1.1 " << httpStatus << "\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
+}
+
+// Calculates the json response of a request from its query parameters, the last argument is the id of the request for the logs
+typedef std::function<std::string(const TransitData &, Calculator &, std::vector<std::pair<std::string, std::string>> &, int)> CalculationRequestFunction;
+
+/**
+ * Handle a calculation request on the current data with the calculator of
+ * the server thread: check the data status, get the query parameters, call
+ * the calculation and write its response. Parameter errors are answered
+ * with their error code and other exceptions with an unknown error.
+ */
+void handleCalculationRequest(std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request, const TransitDataHolder &transitDataHolder, CalculatorPool &calculatorPool, const std::string &requestName, int requestId, const CalculationRequestFunction &calculate)
+{
+  // Keep the same data until the end of the request, even if it is updated in the meantime
+  std::shared_ptr<const TransitData> currentTransitData = transitDataHolder.get();
+  const TransitData &transitData = *currentTransitData;
+  std::string response = getFastErrorResponse(transitData.getDataStatus());
+
+  if (!response.empty()) {
+    writeJsonResponse(serverResponse, "200 OK", response);
+    return;
+  }
+  Calculator & calculator = calculatorPool.getCalculator(transitData);
+  CalculatorRelease calculatorRelease(calculatorPool);
+
+  // prepare parameters:
+  std::vector<std::pair<std::string, std::string>> parametersWithValues;
+  auto queryFields = request->parse_query_string();
+  for(auto &field : queryFields)
   {
-    case ParameterException::Type::EMPTY_SCENARIO: return "EMPTY_SCENARIO";
-    case ParameterException::Type::MISSING_SCENARIO: return "MISSING_PARAM_SCENARIO";
-    case ParameterException::Type::MISSING_ORIGIN: return "MISSING_PARAM_ORIGIN";
-    case ParameterException::Type::MISSING_DESTINATION: return "MISSING_PARAM_DESTINATION";
-    case ParameterException::Type::MISSING_TIME_OF_TRIP: return "MISSING_PARAM_TIME_OF_TRIP";
-    case ParameterException::Type::INVALID_SCENARIO: return "INVALID_SCENARIO";
-    case ParameterException::Type::INVALID_ORIGIN: return "INVALID_ORIGIN";
-    case ParameterException::Type::INVALID_DESTINATION: return "INVALID_DESTINATION";
-    case ParameterException::Type::INVALID_NUMERICAL_DATA: return "INVALID_NUMERICAL_DATA";
-    default: return "PARAM_ERROR_UNKNOWN";
+    parametersWithValues.push_back(std::make_pair(field.first, field.second));
+  }
+  spdlog::info("-- calculating {} request -- {}", requestName, requestId);
+
+  try
+  {
+    response = calculate(transitData, calculator, parametersWithValues, requestId);
+    writeJsonResponse(serverResponse, "200 OK", response);
+  } catch (ParameterException &exp) {
+    auto responseCode = ResultToV2Response::getParameterErrorCode(exp.getType());
+    spdlog::info("-- parameter exception in {} calculation -- {}", requestName, responseCode);
+    response = "{\"status\": \"query_error\", \"errorCode\": \"" + responseCode + "\"}";
+    writeJsonResponse(serverResponse, "400 OK", response);
+  } catch (const std::exception &e) {
+    spdlog::error("-- unknown exception in {} calculation -- {}", requestName, e.what());
+    response = "{\"status\": \"query_error\", \"errorCode\": \"PARAM_ERROR_UNKNOWN\"}";
+    writeJsonResponse(serverResponse, "400 OK", response);
+  } catch (...) {
+    spdlog::error("-- unknown exception in {} calculation", requestName);
+    response = "{\"status\": \"query_error\", \"errorCode\": \"PARAM_ERROR_UNKNOWN\"}";
+    writeJsonResponse(serverResponse, "400 OK", response);
   }
 }
 
@@ -114,7 +161,10 @@ int main(int argc, char** argv) {
   }
 
   DataFetcher *fetcher = 0;
-  if (programOptions.dataFetcherShortname == "cache") {
+  if (!programOptions.snapshotPath.empty() && programOptions.compileSnapshotPath.empty()) {
+    spdlog::info("Loading the data from the snapshot {}", programOptions.snapshotPath);
+    fetcher = new SnapshotDataFetcher(programOptions.snapshotPath);
+  } else if (programOptions.dataFetcherShortname == "cache") {
     fetcher = new CacheFetcher(programOptions.cachePath);
   } else {
     spdlog::error("Using invalid DataFetcher {}", programOptions.dataFetcherShortname);
@@ -122,10 +172,20 @@ int main(int argc, char** argv) {
   }
 
   spdlog::info("preparing calculator...");
-  TransitData transitData(*fetcher, programOptions.cacheAllConnectionSets);
+  // Requests get the current data when they start, updates publish a new data without blocking them
+  TransitDataHolder transitDataHolder(*fetcher, programOptions.cacheAllConnectionSets, (size_t)programOptions.connectionCacheSizeMb * 1024 * 1024);
   //TODO We wanted to handle error in the constructor, but later part of this code expect a dataStatus
   // leaving as a todo
-  DataStatus dataStatus = transitData.getDataStatus();
+  DataStatus dataStatus = transitDataHolder.get()->getDataStatus();
+
+  if (!programOptions.compileSnapshotPath.empty()) {
+    if (dataStatus != DataStatus::READY) {
+      spdlog::error("Cannot write the snapshot, the data is not ready: {}", intializeResponse(dataStatus));
+      exit(-3);
+    }
+    int ret = SnapshotDataFetcher::writeSnapshot(*transitDataHolder.get(), programOptions.compileSnapshotPath);
+    exit(ret == 0 ? 0 : -3);
+  }
 
   // Selection which geofilter to use. OSRM is the default one. Euclidean mostly used for debugging and testing
   GeoFilter *geoFilter = 0;
@@ -133,10 +193,16 @@ int main(int argc, char** argv) {
     geoFilter = new EuclideanGeoFilter();
     spdlog::info("Using Euclidean distance for access/egress node time/distance");
   } else {
-    geoFilter = new OsrmGeoFilter("walking", programOptions.osrmWalkingHost, programOptions.osrmWalkingPort);
-    spdlog::info("Using OSRM for access/egress node time/distance");
+    geoFilter = new OsrmGeoFilter("walking", programOptions.osrmWalkingHost, programOptions.osrmWalkingPort, programOptions.osrmCacheSize);
+    spdlog::info("Using OSRM for access/egress node time/distance, caching the footpaths of {} points", programOptions.osrmCacheSize);
   }
 
+  // Each server thread reuses its own calculator from one request to the next
+  CalculatorPool calculatorPool(*geoFilter);
+  // The batch requests are spread over these threads, which also keep their calculators
+  WorkerPool workerPool(programOptions.numberOfThreads);
+  RouteBatch routeBatch(calculatorPool, workerPool);
+
   spdlog::info("preparing server with {} threads...", programOptions.numberOfThreads);
 
   HttpServer server;
@@ -144,7 +210,8 @@ int main(int argc, char** argv) {
   server.config.thread_pool_size = programOptions.numberOfThreads;
 
   // updateCache:
-  server.resource["^/updateCache[/]?$"]["GET"]=[&server, &transitData](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
+  bool usingSnapshot = !programOptions.snapshotPath.empty();
+  server.resource["^/updateCache[/]?$"]["GET"]=[&server, &transitDataHolder, &calculatorPool, usingSnapshot](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
 
     std::string              response {""};
     std::vector<std::string> parametersWithValues;
@@ -183,91 +250,44 @@ int main(int argc, char** argv) {
       }
     }
 
-    bool correctCacheName {false};
     //TODO Merge this and the preparations.cpp code
+    std::vector<std::string> validCacheNames;
     for(std::string cacheName : cacheNames)
     {
-      if (cacheName == "data_sources" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updateDataSources(customCacheDirectoryPath);
-      }
-      /* TODO #167
-      if (cacheName == "households" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updateHouseholds(customCacheDirectoryPath);
-      }
-      */
-      if (cacheName == "persons" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updatePersons(customCacheDirectoryPath);
-      }
-      if (cacheName == "od_trips" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updateOdTrips(customCacheDirectoryPath);
-      }
-      /* TODO #167
-      if (cacheName == "places" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updatePlaces(customCacheDirectoryPath);
-      }
-      */
-      if (cacheName == "agencies" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updateAgencies(customCacheDirectoryPath);
-      }
-      if (cacheName == "services" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updateServices(customCacheDirectoryPath);
-      }
-      if (cacheName == "nodes" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updateNodes(customCacheDirectoryPath);
-      }
-      if (cacheName == "lines" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updateLines(customCacheDirectoryPath);
-      }
-      if (cacheName == "paths" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updatePaths(customCacheDirectoryPath);
-      }
-      if (cacheName == "scenarios" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updateScenarios(customCacheDirectoryPath);
-      }
-      if (cacheName == "schedules" || cacheName == "all")
-      {
-        correctCacheName = true;
-        transitData.updateSchedules(customCacheDirectoryPath);
-      }
-
-      //TODO This is incorrect if we have multiple name and the second one is wrong, correctCacheName is always true
-      if (correctCacheName)
+      if (TransitDataHolder::isCacheName(cacheName))
       {
+        validCacheNames.push_back(cacheName);
         cacheNamesStr += cacheName;
         cacheNamesStr += ",";
       }
     }
 
-    //TODO do this only if we had at least one correct name
     //Reinit some data after the update
-    // TODO Just the schedules???
-    if (cacheNames.size() > 0)
+    if (validCacheNames.size() > 0 && !customCacheDirectoryPath.empty() && usingSnapshot)
+    {
+      // The snapshot data fetcher only reads the snapshot file
+      response = "{\"status\": \"error\", \"error\": \"custom cache path not supported with a snapshot\"}";
+    }
+    else if (validCacheNames.size() > 0)
     {
+      // A complete new data is loaded and published, in-flight requests keep the previous data until they end.
+      // Caches from a custom path, in this request or the previous ones, are read from it when loading the new data.
+      DataStatus reloadStatus = transitDataHolder.reloadCaches(validCacheNames, customCacheDirectoryPath);
+      // The idle calculators of the previous data would keep its memory until their thread serves another request
+      calculatorPool.releaseStaleCalculators(transitDataHolder.get()->getInstanceId());
+
       // Remove last ","
       cacheNamesStr.pop_back();
-      response = "{\"status\": \"success\", \"cache_names\": \"" + cacheNamesStr + "\", \"custom_cache_path\": \"" + customCacheDirectoryPath + "\"}";
+      if (reloadStatus == DataStatus::READY)
+      {
+        spdlog::info("Updated caches {} in {} ms", cacheNamesStr, transitDataHolder.getLastBuildDurationMicroseconds() / 1000);
+        response = "{\"status\": \"success\", \"cache_names\": \"" + cacheNamesStr + "\", \"custom_cache_path\": \"" + customCacheDirectoryPath + "\"}";
+      }
+      else
+      {
+        spdlog::error("Error updating the caches {}: {}", cacheNamesStr, intializeResponse(reloadStatus));
+        response = intializeResponse(reloadStatus);
+      }
     }
     else
     {
@@ -283,6 +303,74 @@ int main(int argc, char** argv) {
 
 
 
+  // warmup: build the connections of scenarios before they are queried, all scenarios if none is specified
+  server.resource["^/warmup[/]?$"]["GET"]=[&server, &transitDataHolder](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
+    std::shared_ptr<const TransitData> currentTransitData = transitDataHolder.get();
+    const TransitData &transitData = *currentTransitData;
+    std::string response = getFastErrorResponse(transitData.getDataStatus());
+    if (!response.empty()) {
+      *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
+      return;
+    }
+
+    std::vector<std::reference_wrapper<const Scenario>> scenarios;
+    boost::uuids::string_generator uuidGenerator;
+    auto queryFields = request->parse_query_string();
+    for(auto &field : queryFields)
+    {
+      if (field.first != "scenarios" || field.second == "all")
+      {
+        continue;
+      }
+      std::vector<std::string> scenarioUuids;
+      boost::split(scenarioUuids, field.second, boost::is_any_of(","));
+      for (auto & scenarioUuid : scenarioUuids)
+      {
+        auto scenarioIte = transitData.getScenarios().end();
+        try {
+          scenarioIte = transitData.getScenarios().find(uuidGenerator(scenarioUuid));
+        } catch (std::runtime_error const& exc) {
+          // Invalid uuid, handled like a missing scenario
+        }
+        if (scenarioIte == transitData.getScenarios().end())
+        {
+          response = "{\"status\": \"query_error\", \"errorCode\": \"" + ResultToV2Response::getParameterErrorCode(ParameterException::Type::INVALID_SCENARIO) + "\"}";
+          *serverResponse << "HTTP/1.1 400 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
+          return;
+        }
+        scenarios.push_back(scenarioIte->second);
+      }
+    }
+    if (scenarios.empty())
+    {
+      for (auto & scenarioIte : transitData.getScenarios())
+      {
+        scenarios.push_back(scenarioIte.second);
+      }
+    }
+
+    CalculationTime warmupTime;
+    warmupTime.start();
+    unsigned int buildCountBefore = transitData.getConnectionSetBuildCount();
+    transitData.warmupConnectionsForScenarios(scenarios, std::thread::hardware_concurrency());
+    unsigned int builtCount = transitData.getConnectionSetBuildCount() - buildCountBefore;
+    int durationMilliseconds = warmupTime.getDurationMicrosecondsNoStop() / 1000;
+    spdlog::info("Warmed up {} scenarios in {} ms, {} connection sets built", scenarios.size(), durationMilliseconds, builtCount);
+
+    response = "{\"status\": \"success\", \"scenarios\": " + std::to_string(scenarios.size()) + ", \"built\": " + std::to_string(builtCount) + ", \"durationMs\": " + std::to_string(durationMilliseconds) + "}";
+    *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
+  };
+
+  // cacheStats: content and hit counters of the connection sets cache, to tune the --connectionCacheSizeMb value
+  server.resource["^/cacheStats[/]?$"]["GET"]=[&server, &transitDataHolder](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> ) {
+    std::shared_ptr<const TransitData> currentTransitData = transitDataHolder.get();
+    ScenarioConnectionCacheStats stats = currentTransitData->getConnectionCacheStats();
+    spdlog::info("Connection cache: {} sets, {} bytes, {} hits, {} misses, {} evictions", stats.count, stats.sizeBytes, stats.hits, stats.misses, stats.evictions);
+
+    std::string response = "{\"status\": \"success\", \"count\": " + std::to_string(stats.count) + ", \"sizeBytes\": " + std::to_string(stats.sizeBytes) + ", \"hits\": " + std::to_string(stats.hits) + ", \"misses\": " + std::to_string(stats.misses) + ", \"evictions\": " + std::to_string(stats.evictions) + "}";
+    *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
+  };
+
   // closeServer and exit app:
   server.resource["^/exit[/]?\\?([0-9a-zA-Z&=_,:/.-]+)$"]["GET"]=[&server](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> ) {
 
@@ -300,16 +388,20 @@ int main(int argc, char** argv) {
 
   // Routing request for a single origin destination
   // TODO Copy-pasted and adapted from /route/v1/transit. There's still a lot of common code. Application code should be extracted to common functions outside the web server
-  server.resource["^/v2/route[/]?$"]["GET"]=[&server, &dataStatus, &transitData, &geoFilter](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
+  server.resource["^/v2/route[/]?$"]["GET"]=[&server, &transitDataHolder, &calculatorPool](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
     // Have a global id to match the requests in the logs
     static int routeRequestId = 0;
-    std::string response = getFastErrorResponse(dataStatus);
+    // Keep the same data until the end of the request, even if it is updated in the meantime
+    std::shared_ptr<const TransitData> currentTransitData = transitDataHolder.get();
+    const TransitData &transitData = *currentTransitData;
+    std::string response = getFastErrorResponse(transitData.getDataStatus());
 
     if (!response.empty()) {
       *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
       return;
     }
-    Calculator calculator(transitData, *geoFilter);
+    Calculator & calculator = calculatorPool.getCalculator(transitData);
+    CalculatorRelease calculatorRelease(calculatorPool);
 
     // prepare parameters:
     std::vector<std::pair<std::string, std::string>> parametersWithValues;
@@ -323,7 +415,7 @@ int main(int argc, char** argv) {
 
     try
     {
-      RouteParameters queryParams = RouteParameters::createRouteODParameter(parametersWithValues, transitData.getScenarios());
+      RouteParameters queryParams = RouteParameters::createRouteODParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
 
       try {
         if (queryParams.isWithAlternatives())
@@ -350,7 +442,7 @@ int main(int argc, char** argv) {
       *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
 
     } catch (ParameterException &exp) {
-      auto responseCode = getResponseCode(exp.getType());
+      auto responseCode = ResultToV2Response::getParameterErrorCode(exp.getType());
       spdlog::info("-- parameter exception in route calculation -- {}", responseCode);
       response = "{\"status\": \"query_error\", \"errorCode\": \"" + responseCode + "\"}";
       *serverResponse << "HTTP/1.1 400 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
@@ -368,19 +460,89 @@ int main(int argc, char** argv) {
 
   };
 
+  // Batch of independent route queries, posted as a json array of objects with the /v2/route parameters and an optional id.
+  // The results are streamed back as a json array, in the order of the queries, with the id of their query
+  server.resource["^/v2/route/batch[/]?$"]["POST"]=[&server, &transitDataHolder, &routeBatch, &programOptions](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
+    // Have a global id to match the requests in the logs
+    static int batchRequestId = 0;
+    // Keep the same data until the end of the request, even if it is updated in the meantime
+    std::shared_ptr<const TransitData> currentTransitData = transitDataHolder.get();
+    const TransitData &transitData = *currentTransitData;
+    std::string response = getFastErrorResponse(transitData.getDataStatus());
+
+    if (!response.empty()) {
+      *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
+      return;
+    }
+
+    nlohmann::json queries = nlohmann::json::parse(request->content.string(), nullptr, false);
+    if (!queries.is_array()) {
+      response = "{\"status\": \"query_error\", \"errorCode\": \"INVALID_BATCH\"}";
+      *serverResponse << "HTTP/1.1 400 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
+      return;
+    }
+    if (queries.size() > (size_t)programOptions.maxBatchQueries) {
+      spdlog::info("-- route batch request rejected, {} queries for a maximum of {}", queries.size(), programOptions.maxBatchQueries);
+      response = "{\"status\": \"query_error\", \"errorCode\": \"BATCH_TOO_LARGE\"}";
+      *serverResponse << "HTTP/1.1 400 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
+      return;
+    }
+    int currentRequestId = batchRequestId++;
+    spdlog::info("-- calculating route batch request -- {} ({} queries)", currentRequestId, queries.size());
+    CalculationTime batchCalculationTime;
+    batchCalculationTime.start();
+
+    // Each result is sent in its own chunk, as soon as it and the previous ones are calculated
+    auto sendChunk = [&serverResponse](const std::string &chunk) {
+      *serverResponse << std::hex << chunk.length() << std::dec << "\r\n" << chunk << "\r\n";
+      serverResponse->send();
+    };
+    *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nTransfer-Encoding: chunked\r\n\r\n";
+    sendChunk("[");
+    routeBatch.calculate(transitData, queries, [&sendChunk](size_t index, const nlohmann::json &result) {
+      sendChunk((index > 0 ? ",\n" : "\n") + result.dump());
+    });
+    sendChunk("\n]");
+    *serverResponse << "0\r\n\r\n";
+    serverResponse->send();
+
+    spdlog::info("-- route batch request complete -- {} in {} ms", currentRequestId, batchCalculationTime.getDurationMicrosecondsNoStop() / 1000);
+  };
+
+  // Profile request for a single origin destination: all the best journeys departing in a time window
+  server.resource["^/v2/profile[/]?$"]["GET"]=[&server, &transitDataHolder, &calculatorPool](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
+    // Have a global id to match the requests in the logs
+    static int profileRequestId = 0;
+    handleCalculationRequest(serverResponse, request, transitDataHolder, calculatorPool, "profile", profileRequestId++, [](const TransitData &transitData, Calculator &calculator, std::vector<std::pair<std::string, std::string>> &parametersWithValues, int currentRequestId) {
+      ProfileParameters queryParams = ProfileParameters::createProfileParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
+      try {
+        std::unique_ptr<TrRouting::ProfileResult> profileResult = calculator.calculateProfile(queryParams);
+        spdlog::info("-- profile request complete -- {}", currentRequestId);
+        return ResultToV2Response::resultToJsonString(*profileResult.get(), queryParams).dump(2);
+      } catch (NoRoutingFoundException &e) {
+        spdlog::info("-- profile request not found -- {}", currentRequestId);
+        return ResultToV2Response::noRoutingFoundResponse(queryParams, e.getReason()).dump(2);
+      }
+    });
+  };
+
   // Request a summary of lines data for a route
   // TODO Copy pasted from v2/route. There's a lot in common, it should be extracted to common class, just the response parser is different
-  server.resource["^/v2/summary[/]?$"]["GET"]=[&server, &dataStatus, &transitData, &geoFilter](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
+  server.resource["^/v2/summary[/]?$"]["GET"]=[&server, &transitDataHolder, &calculatorPool](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
     // Have a global id to match the requests in the logs
     static int summaryRequestId = 0;
 
-    std::string response = getFastErrorResponse(dataStatus);
+    // Keep the same data until the end of the request, even if it is updated in the meantime
+    std::shared_ptr<const TransitData> currentTransitData = transitDataHolder.get();
+    const TransitData &transitData = *currentTransitData;
+    std::string response = getFastErrorResponse(transitData.getDataStatus());
 
     if (!response.empty()) {
       *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
       return;
     }
-    Calculator calculator(transitData, *geoFilter);
+    Calculator & calculator = calculatorPool.getCalculator(transitData);
+    CalculatorRelease calculatorRelease(calculatorPool);
 
     // prepare parameters:
     std::vector<std::pair<std::string, std::string>> parametersWithValues;
@@ -395,7 +557,7 @@ int main(int argc, char** argv) {
 
     try
     {
-      RouteParameters queryParams = RouteParameters::createRouteODParameter(parametersWithValues, transitData.getScenarios());
+      RouteParameters queryParams = RouteParameters::createRouteODParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
 
       try {
         if (queryParams.isWithAlternatives())
@@ -421,7 +583,7 @@ int main(int argc, char** argv) {
       *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
 
     } catch (ParameterException &exp) {
-      auto responseCode = getResponseCode(exp.getType());
+      auto responseCode = ResultToV2Response::getParameterErrorCode(exp.getType());
       spdlog::info("-- parameter exception in summary calculation -- {}", responseCode);
       response = "{\"status\": \"query_error\", \"errorCode\": \"" + responseCode + "\"}";
       *serverResponse << "HTTP/1.1 400 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
@@ -441,17 +603,21 @@ int main(int argc, char** argv) {
 
   // Routing request for a single origin destination
   // TODO Copy-pasted and adapted from /route/v1/transit. There's still a lot of common code. Application code should be extracted to common functions outside the web server
-  server.resource["^/v2/accessibility[/]?$"]["GET"]=[&server, &dataStatus, &transitData, &geoFilter](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
+  server.resource["^/v2/accessibility[/]?$"]["GET"]=[&server, &transitDataHolder, &calculatorPool](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
     // Have a global id to match the requests in the logs
     static int accessibilityRequestId = 0;
 
-    std::string response = getFastErrorResponse(dataStatus);
+    // Keep the same data until the end of the request, even if it is updated in the meantime
+    std::shared_ptr<const TransitData> currentTransitData = transitDataHolder.get();
+    const TransitData &transitData = *currentTransitData;
+    std::string response = getFastErrorResponse(transitData.getDataStatus());
 
     if (!response.empty()) {
       *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
       return;
     }
-    Calculator calculator(transitData, *geoFilter);
+    Calculator & calculator = calculatorPool.getCalculator(transitData);
+    CalculatorRelease calculatorRelease(calculatorPool);
 
     // prepare parameters:
     std::vector<std::pair<std::string, std::string>> parametersWithValues;
@@ -466,12 +632,20 @@ int main(int argc, char** argv) {
 
     try
     {
-      AccessibilityParameters queryParams = AccessibilityParameters::createAccessibilityParameter(parametersWithValues, transitData.getScenarios());
+      AccessibilityParameters queryParams = AccessibilityParameters::createAccessibilityParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
 
       try {
-        std::unique_ptr<AllNodesResult> accessibilityResult = calculator.calculateAllNodes(queryParams);
-        if (accessibilityResult.get() != nullptr) {
-          response = ResultToV2AccessibilityResponse::resultToJsonString(*accessibilityResult.get(), queryParams).dump(2);
+        if (queryParams.hasTimeWindow())
+        {
+          std::unique_ptr<AllNodesRangeResult> rangeResult = calculator.calculateAllNodesRange(queryParams);
+          response = ResultToV2AccessibilityResponse::resultToJsonString(*rangeResult.get(), queryParams).dump(2);
+        }
+        else
+        {
+          std::unique_ptr<AllNodesResult> accessibilityResult = calculator.calculateAllNodes(queryParams);
+          if (accessibilityResult.get() != nullptr) {
+            response = ResultToV2AccessibilityResponse::resultToJsonString(*accessibilityResult.get(), queryParams).dump(2);
+          }
         }
 
         spdlog::info("-- accessibility request complete -- {}", currentRequestId);
@@ -484,7 +658,7 @@ int main(int argc, char** argv) {
       *serverResponse << "HTTP/1.1 200 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
 
     } catch (ParameterException &exp) {
-      auto responseCode = getResponseCode(exp.getType());
+      auto responseCode = ResultToV2Response::getParameterErrorCode(exp.getType());
       spdlog::info("-- parameter exception in accessibility map calculation -- {}", responseCode);
       response = "{\"status\": \"query_error\", \"errorCode\": \"" + responseCode + "\"}";
       *serverResponse << "HTTP/1.1 400 OK\r\nAccess-Control-Allow-Origin: *\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " << response.length() << "\r\n\r\n" << response;
@@ -502,6 +676,20 @@ int main(int argc, char** argv) {
 
   };
 
+  // Accessibility from many places at once, the nodes reachable from each place
+  server.resource["^/v2/accessibility/batch[/]?$"]["GET"]=[&server, &transitDataHolder, &calculatorPool](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
+    // Have a global id to match the requests in the logs
+    static int accessibilityBatchRequestId = 0;
+    handleCalculationRequest(serverResponse, request, transitDataHolder, calculatorPool, "accessibility batch", accessibilityBatchRequestId++, [](const TransitData &transitData, Calculator &calculator, std::vector<std::pair<std::string, std::string>> &parametersWithValues, int currentRequestId) {
+      AccessibilityBatchParameters queryParams = AccessibilityBatchParameters::createAccessibilityBatchParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces());
+
+      // Places without accessible nodes have their own no routing status in the result
+      std::vector<PlaceAllNodesResult> accessibilityResults = calculator.calculateAllNodesBatch(queryParams);
+      spdlog::info("-- accessibility batch request complete -- {} places -- {}", accessibilityResults.size(), currentRequestId);
+      return ResultToV2AccessibilityResponse::resultToJsonString(accessibilityResults, queryParams).dump(2);
+    });
+  };
+
   server.default_resource["GET"] = [](std::shared_ptr<HttpServer::Response> serverResponse, std::shared_ptr<HttpServer::Request> request) {
     spdlog::info("calculating request: {}", request->content.string());
 
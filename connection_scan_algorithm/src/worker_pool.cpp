@@ -0,0 +1,75 @@
+#include <algorithm>
+
+#include "worker_pool.hpp"
+
+namespace TrRouting
+{
+
+  WorkerPool::WorkerPool(unsigned int threadsCount)
+  {
+    threadsCount = std::max(1u, threadsCount);
+    for (unsigned int i = 0; i < threadsCount; i++) {
+      threads.push_back(std::thread(&WorkerPool::work, this));
+    }
+  }
+
+  WorkerPool::~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    jobsAvailable.notify_all();
+    for (auto & thread : threads) {
+      thread.join();
+    }
+  }
+
+  void WorkerPool::run(size_t tasksCount, const std::function<void(size_t)> &task)
+  {
+    if (tasksCount == 0) {
+      return;
+    }
+    std::shared_ptr<Job> job = std::make_shared<Job>(tasksCount, task);
+    std::unique_lock<std::mutex> lock(mutex);
+    jobs.push_back(job);
+    jobsAvailable.notify_all();
+    jobDone.wait(lock, [&job]() { return job->doneCount == job->tasksCount; });
+    if (job->exception) {
+      std::rethrow_exception(job->exception);
+    }
+  }
+
+  void WorkerPool::work()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      jobsAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (jobs.empty()) {
+        return;
+      }
+      std::shared_ptr<Job> job = jobs.front();
+      size_t index = job->nextIndex++;
+      if (job->nextIndex == job->tasksCount) {
+        jobs.pop_front();
+      }
+
+      lock.unlock();
+      std::exception_ptr exception;
+      try {
+        job->task(index);
+      } catch (...) {
+        exception = std::current_exception();
+      }
+      lock.lock();
+
+      if (exception && !job->exception) {
+        job->exception = exception;
+      }
+      if (++job->doneCount == job->tasksCount) {
+        jobDone.notify_all();
+      }
+    }
+  }
+
+}
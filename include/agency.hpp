@@ -1,6 +1,7 @@
 #ifndef TR_AGENCY
 #define TR_AGENCY
 
+#include <atomic>
 #include <string>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -11,12 +12,16 @@ namespace TrRouting
   class Agency {
     
   public:
+    typedef int uid_t; //Type for a local temporary ID
+
+    Agency(): uid(++global_uid) {}
 
     boost::uuids::uuid uuid;
     std::string acronym;
     std::string name;
     std::string internalId;
     boost::uuids::uuid simulationUuid;
+    uid_t uid; //Local, temporary unique id, used to speed up lookups
 
     const std::string toString() {
       return "Agency " + boost::uuids::to_string(uuid) + "\n  acronym " + acronym + "\n  name " + name;
@@ -24,6 +29,13 @@ namespace TrRouting
 
     // Equal operator. We only compare the uuid, since they should be unique.
     inline bool operator==(const Agency& other ) const { return uuid == other.uuid; }
+
+    static uid_t getMaxUid() { return global_uid; }
+    static void resetUids() { global_uid = 0; }
+
+  private:
+    //TODO, this could probably be an unsigned long, but current MAX_INT is good enough for our needs
+    inline static std::atomic<uid_t> global_uid {0};
   };
 
   // To use std::find with a vector<reference_wrapper<const Agency>>
@@ -32,16 +32,22 @@ namespace TrRouting
   
   public:
     
-    CacheFetcher(const std::string &cacheDir);
+    /**
+     * @param loadingThreadsCount Number of threads reading the line schedules
+     * files, 0 to use the number of cores
+     */
+    CacheFetcher(const std::string &cacheDir, unsigned int loadingThreadsCount = 0);
     virtual ~CacheFetcher();
     
     template<class T>
 
     /**
      * Save data to a cache file. The cache file path can be obtained using the
-     * getFilePath function
+     * getFilePath function. With mappable true, the file is written unpacked,
+     * to be mapped in memory and read in place. Otherwise it is packed, which
+     * is smaller but needs to be decoded. The fetchers read both formats.
      */
-    static void saveToCapnpCacheFile(T& data, std::string cacheFilePath);
+    static void saveToCapnpCacheFile(T& data, std::string cacheFilePath, bool mappable = true);
     /**
      * Returns whether a cache file exists. The cache file path can be obtained
      * using the getFilePath function
@@ -67,6 +73,13 @@ namespace TrRouting
       std::string customPath = ""
     );
 
+    virtual int getHouseholds(
+      std::map<boost::uuids::uuid, Household>& ts,
+      const std::map<boost::uuids::uuid, DataSource>& dataSources,
+      const std::map<boost::uuids::uuid, Node>& nodes,
+      std::string customPath = ""
+    );
+
     virtual int getPersons(
       std::map<boost::uuids::uuid, Person>& ts,
       const std::map<boost::uuids::uuid, DataSource>& dataSources,
@@ -81,6 +94,13 @@ namespace TrRouting
       std::string customPath = ""
     );
 
+    virtual int getPlaces(
+      std::map<boost::uuids::uuid, Place>& ts,
+      const std::map<boost::uuids::uuid, DataSource>& dataSources,
+      const std::map<boost::uuids::uuid, Node>& nodes,
+      std::string customPath = ""
+    );
+
     virtual int getAgencies(
       std::map<boost::uuids::uuid, Agency>& ts,
       std::string customPath = ""
@@ -131,6 +151,7 @@ namespace TrRouting
         
   private:
     std::string cacheDirectoryPath;
+    unsigned int loadingThreadsCount;
   };
     
 }
@@ -0,0 +1,48 @@
+#ifndef TR_CACHE_FILE_READER
+#define TR_CACHE_FILE_READER
+
+#include <memory>
+#include <capnp/message.h>
+
+namespace TrRouting
+{
+
+  /**
+   * @brief Header of the cache files in the memory mappable format
+   *
+   * These files contain the header, followed by the unpacked Cap'n Proto
+   * message. The 8 bytes header keeps the message aligned on words, so it can
+   * be read in place from the mapped file.
+   */
+  static const char MAPPABLE_CACHE_FILE_HEADER[8] = {'T', 'R', 'C', 'A', 'P', 'N', 'P', '1'};
+
+  /**
+   * @brief Reads the Cap'n Proto message of a cache file, in either format
+   *
+   * Files starting with the mappable header are mapped in memory and read in
+   * place, without decoding or copying the message. Other files are read as
+   * packed messages. The file descriptor must stay open for the lifetime of
+   * the reader, like with the capnp readers.
+   */
+  class CacheFileReader {
+
+  public:
+    CacheFileReader(int fd, ::capnp::ReaderOptions options);
+    ~CacheFileReader();
+    CacheFileReader(const CacheFileReader&) = delete;
+    CacheFileReader& operator=(const CacheFileReader&) = delete;
+
+    template <typename RootType>
+    typename RootType::Reader getRoot() { return messageReader->getRoot<RootType>(); }
+
+    bool isMapped() const { return mappedData != nullptr; }
+
+  private:
+    void *mappedData {nullptr};
+    size_t mappedSize {0};
+    std::unique_ptr<::capnp::MessageReader> messageReader;
+  };
+
+}
+
+#endif // TR_CACHE_FILE_READER
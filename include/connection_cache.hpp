@@ -7,6 +7,9 @@
 #include <memory>
 #include <map>
 #include <shared_mutex>
+#include <mutex>
+#include <list>
+#include <atomic>
 
 namespace TrRouting {
 
@@ -14,12 +17,24 @@ class Connection;
 class ConnectionSet;
 
 
+/**
+ * @brief Content and usage counters of a connection cache, to tune its size
+ */
+class ScenarioConnectionCacheStats {
+  public:
+    size_t count {0};
+    // Sum of the memory size of the cached connection sets
+    size_t sizeBytes {0};
+    unsigned long hits {0};
+    unsigned long misses {0};
+    unsigned long evictions {0};
+};
+
 /**
  * @brief Interface for the caches of the connection sets used by different transit scenarios.
  *
- * // TODO Currently caches only the last queried scenario or all of them. We could make this a
- * real lru cache eventually, or not, if we find a better way to handle scenario
- * query data.
+ * Caches the last queried scenario, all of them, or the least recently used
+ * ones within a memory budget.
  */
 class ScenarioConnectionCache {
 
@@ -28,6 +43,14 @@ class ScenarioConnectionCache {
     
     virtual std::optional<std::shared_ptr<ConnectionSet>> get(boost::uuids::uuid uuid) const = 0;
     virtual void set(boost::uuids::uuid uuid, std::shared_ptr<ConnectionSet> cache) = 0;
+    virtual ScenarioConnectionCacheStats getStats() const = 0;
+
+    unsigned long getHits() const {return hits;}
+    unsigned long getMisses() const {return misses;}
+
+  protected:
+    mutable std::atomic<unsigned long> hits {0};
+    mutable std::atomic<unsigned long> misses {0};
 };
 
 /**
@@ -45,6 +68,7 @@ class ScenarioConnectionCacheOne : public ScenarioConnectionCache {
 
     virtual std::optional<std::shared_ptr<ConnectionSet>> get(boost::uuids::uuid uuid) const;
     virtual void set(boost::uuids::uuid uuid, std::shared_ptr<ConnectionSet> cache);
+    virtual ScenarioConnectionCacheStats getStats() const;
 
   private:
   mutable std::shared_mutex mutex; //Reader/Writer locking
@@ -68,12 +92,59 @@ class ScenarioConnectionCacheAll : public ScenarioConnectionCache {
 
     virtual std::optional<std::shared_ptr<ConnectionSet>> get(boost::uuids::uuid uuid) const;
     virtual void set(boost::uuids::uuid uuid, std::shared_ptr<ConnectionSet> cache);
+    virtual ScenarioConnectionCacheStats getStats() const;
 
   private:
     mutable std::shared_mutex mutex; //Reader/Writer locking
     std::map<boost::uuids::uuid, std::shared_ptr<ConnectionSet> > connectionSets;
 };
 
+
+/**
+ * @brief Caches the connection sets of the most recently used scenarios, up to
+ * a total memory size.
+ *
+ * When adding a connection set exceeds the budget, the least recently used
+ * sets are evicted. The last added set is always kept, even if it is larger
+ * than the budget by itself.
+ */
+class ScenarioConnectionCacheLru : public ScenarioConnectionCache {
+
+  public:
+    ScenarioConnectionCacheLru(size_t _maxSizeBytes) : maxSizeBytes(_maxSizeBytes)
+    {
+
+    }
+    virtual ~ScenarioConnectionCacheLru(){}
+
+    virtual std::optional<std::shared_ptr<ConnectionSet>> get(boost::uuids::uuid uuid) const;
+    virtual void set(boost::uuids::uuid uuid, std::shared_ptr<ConnectionSet> cache);
+    virtual ScenarioConnectionCacheStats getStats() const;
+
+    size_t getMaxSizeBytes() const {return maxSizeBytes;}
+    // Sum of the memory size of the cached connection sets
+    size_t getSizeBytes() const;
+    size_t getCount() const;
+    unsigned long getEvictions() const {return evictions;}
+
+  private:
+    class CacheEntry {
+    public:
+      std::shared_ptr<ConnectionSet> connectionSet;
+      size_t sizeBytes;
+      std::list<boost::uuids::uuid>::iterator recentUse;
+    };
+
+    size_t maxSizeBytes;
+    // A read also updates the order of use, so all accesses lock exclusively
+    mutable std::mutex mutex;
+    // Scenario uuids, the most recently used first
+    mutable std::list<boost::uuids::uuid> recentUses;
+    std::map<boost::uuids::uuid, CacheEntry> connectionSets;
+    size_t sizeBytes {0};
+    std::atomic<unsigned long> evictions {0};
+};
+
 }
 
 #endif // TR_CONNECTION_CACHE
@@ -2,6 +2,10 @@
 #define TR_CONNECTION_SET
 
 #include <vector>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <algorithm>
 
 
 namespace TrRouting {
@@ -9,30 +13,166 @@ namespace TrRouting {
 class Connection;
 class Trip;
 
+/**
+ * @brief Columnar copy of an ordered vector of connections
+ *
+ * Each column is indexed like the vector it was built from, so index i in
+ * the columns matches the i-th connection. The calculation loops scan those
+ * contiguous arrays instead of dereferencing every Connection, its Trip and
+ * its Nodes. The Connection object itself is only needed when a journey step
+ * is recorded.
+ */
+class PackedConnections {
+
+  public:
+    // Bits of the flags column
+    static const uint8_t CAN_BOARD = 0x01;
+    static const uint8_t CAN_UNBOARD = 0x02;
+    static const uint8_t HAS_MIN_WAITING_TIME = 0x04; // Not set when the connection inherits the min waiting time from parameters
+
+    PackedConnections(const std::vector<std::reference_wrapper<const Connection>> & connections);
+
+    size_t size() const {return departureTimes.size();}
+    // Bytes allocated for the columns
+    size_t getMemorySize() const;
+    bool canBoard(size_t index) const {return flags[index] & CAN_BOARD;}
+    bool canUnboard(size_t index) const {return flags[index] & CAN_UNBOARD;}
+    short getMinWaitingTimeOrDefault(size_t index, short defaultMinWaitingTime) const {
+      return (flags[index] & HAS_MIN_WAITING_TIME) ? minWaitingTimesSeconds[index] : defaultMinWaitingTime;
+    }
+
+    std::vector<int32_t> departureNodeUids; // Node::uid of the departure node
+    std::vector<int32_t> arrivalNodeUids; // Node::uid of the arrival node
+    std::vector<int32_t> departureTimes;
+    std::vector<int32_t> arrivalTimes;
+    std::vector<int32_t> tripUids; // Trip::uid of the connection's trip
+    std::vector<uint8_t> flags;
+    std::vector<int16_t> minWaitingTimesSeconds; // Only meaningful if HAS_MIN_WAITING_TIME is set
+};
+
+/**
+ * @brief One bit per connection of an ordered connections vector, set for
+ * the connections that are enabled
+ *
+ * The scans find the next enabled connection a 64 bits word at a time, so
+ * long runs of disabled connections are skipped without reading their
+ * packed columns.
+ */
+class ConnectionMask {
+
+  public:
+    ConnectionMask(size_t _bitsCount, bool allSet = false);
+
+    void set(size_t index) {
+      if (!isSet(index)) {
+        words[index >> 6] |= (uint64_t)1 << (index & 63);
+        setCount++;
+      }
+    }
+    bool isSet(size_t index) const {return (words[index >> 6] >> (index & 63)) & 1;}
+    // Number of bits, ie the size of the connections vector it applies to
+    size_t size() const {return bitsCount;}
+    // Number of bits that are set
+    size_t count() const {return setCount;}
+    size_t getMemorySize() const {return words.capacity() * sizeof(uint64_t);}
+
+    // Index of the first set bit at or after index, or size() if there is none
+    size_t next(size_t index) const {
+      size_t wordIndex = index >> 6;
+      if (wordIndex >= words.size()) {
+        return bitsCount;
+      }
+      uint64_t word = words[wordIndex] & (~(uint64_t)0 << (index & 63));
+      while (word == 0) {
+        if (++wordIndex == words.size()) {
+          return bitsCount;
+        }
+        word = words[wordIndex];
+      }
+      return (wordIndex << 6) + __builtin_ctzll(word);
+    }
+
+    // Index of the last set bit before index, or size() if there is none
+    size_t previous(size_t index) const {
+      if (index == 0) {
+        return bitsCount;
+      }
+      index = std::min(index, bitsCount) - 1;
+      size_t wordIndex = index >> 6;
+      uint64_t word = words[wordIndex] & (~(uint64_t)0 >> (63 - (index & 63)));
+      while (word == 0) {
+        if (wordIndex == 0) {
+          return bitsCount;
+        }
+        word = words[--wordIndex];
+      }
+      return (wordIndex << 6) + 63 - __builtin_clzll(word);
+    }
+
+  private:
+    std::vector<uint64_t> words; // The bits after bitsCount in the last word are never set
+    size_t bitsCount;
+    size_t setCount;
+};
+
 /**
  * @brief Encapsulates a subset of the whole connection set, ie the connections
  * that are used by the trips
+ *
+ * A connection set either owns its sorted connections, or is a view of the
+ * connections of a base set, keeping only a mask of the connections that are
+ * enabled. Views share the base set's connections vectors, packed columns and
+ * hour caches, so the indexes are the same for all sets of a TransitData and
+ * a scenario only costs one bit per connection in each direction, plus its
+ * trips. The calculations must skip the connections that are not enabled in
+ * the masks.
  */
 class ConnectionSet {
 
   public:
     
+    // Set owning its connections, which are all enabled
+    ConnectionSet(
+        std::vector<std::reference_wrapper<const Trip>> _trips,
+        std::vector<std::reference_wrapper<const Connection>> _forwardConnections,
+        std::vector<std::reference_wrapper<const Connection>> _reverseConnections
+    );
+    // View of the connections of the base set that are enabled in the masks
     ConnectionSet(
-        const std::vector<std::reference_wrapper<const Trip>> _trips,
-        const std::vector<std::reference_wrapper<const Connection>> _forwardConnections,
-        const std::vector<std::reference_wrapper<const Connection>> _reverseConnections
+        std::shared_ptr<const ConnectionSet> _baseSet,
+        std::vector<std::reference_wrapper<const Trip>> _trips,
+        ConnectionMask _forwardMask,
+        ConnectionMask _reverseMask
     );
     const std::vector<std::reference_wrapper<const Trip>> & getTrips() const {return trips;}
-    const std::vector<std::reference_wrapper<const Connection>> & getForwardConnections() const {return forwardConnections;}
-    const std::vector<std::reference_wrapper<const Connection>> & getReverseConnections() const {return reverseConnections;}
+    // The connections vectors, including those not enabled in this set
+    const std::vector<std::reference_wrapper<const Connection>> & getForwardConnections() const {return baseSet ? baseSet->getForwardConnections() : forwardConnections;}
+    const std::vector<std::reference_wrapper<const Connection>> & getReverseConnections() const {return baseSet ? baseSet->getReverseConnections() : reverseConnections;}
+    const PackedConnections & getForwardPackedConnections() const {return baseSet ? baseSet->getForwardPackedConnections() : forwardPackedConnections;}
+    const PackedConnections & getReversePackedConnections() const {return baseSet ? baseSet->getReversePackedConnections() : reversePackedConnections;}
+    // Connections enabled in this set, indexed like the connections vectors
+    const ConnectionMask & getForwardMask() const {return forwardMask;}
+    const ConnectionMask & getReverseMask() const {return reverseMask;}
+    size_t getForwardConnectionsCount() const {return forwardMask.count();}
+    size_t getReverseConnectionsCount() const {return reverseMask.count();}
 
     std::vector<std::reference_wrapper<const Connection>>::const_iterator getForwardConnectionsBeginAtDepartureHour(int hour) const;
     std::vector<std::reference_wrapper<const Connection>>::const_iterator getReverseConnectionsBeginAtArrivalHour(int hour) const;
+    // Same as the iterator functions above, but return the index in the connections vectors and packed columns
+    size_t getForwardConnectionsBeginIndexAtDepartureHour(int hour) const {return getForwardConnectionsBeginAtDepartureHour(hour) - getForwardConnections().cbegin();}
+    size_t getReverseConnectionsBeginIndexAtArrivalHour(int hour) const {return getReverseConnectionsBeginAtArrivalHour(hour) - getReverseConnections().cbegin();}
+    // Approximate bytes used by this connection set, including its vectors, but not the connections and trips it references, nor its base set
+    size_t getMemorySize() const;
 
   private:
+    std::shared_ptr<const ConnectionSet> baseSet; // Set this one is a view of, null if this set owns its connections
     std::vector<std::reference_wrapper<const Trip>> trips;
-    std::vector<std::reference_wrapper<const Connection>> forwardConnections; // Forward connections, sorted by departure time ascending
-    std::vector<std::reference_wrapper<const Connection>> reverseConnections; // Reverse connections, sorted by arrival time descending
+    std::vector<std::reference_wrapper<const Connection>> forwardConnections; // Forward connections, sorted by departure time ascending, empty for views
+    std::vector<std::reference_wrapper<const Connection>> reverseConnections; // Reverse connections, sorted by arrival time descending, empty for views
+    PackedConnections forwardPackedConnections; // Columns of the forwardConnections, same order
+    PackedConnections reversePackedConnections; // Columns of the reverseConnections, same order
+    ConnectionMask forwardMask;
+    ConnectionMask reverseMask;
 
     // Contains iterator matching each hour of the day from the corresponding connections container.
     // Used to speed up iterating the connections by skipping the connections that are too early or too late
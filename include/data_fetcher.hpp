@@ -11,10 +11,10 @@
 namespace TrRouting
 {
   class DataSource;
-  //class Household;  //TODO #167
+  class Household;
   class Person;
   class OdTrip;
-  //class Place;  //TODO #167
+  class Place;
   class Agency;
   class Service;
   class Node;
@@ -55,12 +55,12 @@ namespace TrRouting
      * -EINVAL For any other data related error
      * -(error codes from the open system call)
      */
-    //TODO #167 Place/Household removed while refactoring
-    // virtual int getHouseholds(
-    //  std::vector<std::unique_ptr<Household>>& ts,
-    //  std::map<boost::uuids::uuid, int>& tIndexesById,
-    //  const std::map<boost::uuids::uuid, int>& nodeIndexesByUuid,
-    //  std::string customPath = "") = 0;
+    virtual int getHouseholds(
+      std::map<boost::uuids::uuid, Household>& ts,
+      const std::map<boost::uuids::uuid, DataSource>& dataSources,
+      const std::map<boost::uuids::uuid, Node>& nodes,
+      std::string customPath = ""
+    ) = 0;
 
     /**
      * Read the persons cache file and fill the persons vector.
@@ -103,14 +103,12 @@ namespace TrRouting
      * -EINVAL For any other data related error
      * -(error codes from the open system call)
      */
-    //TODO #167 Place/Household removed while refactoring
-    //virtual int getPlaces(
-    //  std::vector<std::unique_ptr<Place>>& ts,
-    //  std::map<boost::uuids::uuid, int>& tIndexesById,
-    //  const std::map<boost::uuids::uuid, int>& dataSourceIndexesByUuid,
-    //  const std::map<boost::uuids::uuid, int>& nodeIndexesByUuid,
-    //  std::string customPath = ""
-    //) = 0;
+    virtual int getPlaces(
+      std::map<boost::uuids::uuid, Place>& ts,
+      const std::map<boost::uuids::uuid, DataSource>& dataSources,
+      const std::map<boost::uuids::uuid, Node>& nodes,
+      std::string customPath = ""
+    ) = 0;
 
     /**
      * Read the agencies cache file and fill the agencies vector.
@@ -222,6 +220,17 @@ namespace TrRouting
       std::vector<Connection>& connections,
       std::string customPath = "") = 0;
 
+    /**
+     * Get the forward and reverse orders of the connections returned by the
+     * last getSchedules call, when the data source already has them sorted.
+     *
+     * @return false if the orders are not available, the connections will then
+     * be sorted after loading
+     */
+    virtual bool getSortedConnectionsOrders(
+      std::vector<size_t>& /*forwardOrder*/,
+      std::vector<size_t>& /*reverseOrder*/) { return false; }
+
   };    
 }
 #endif
@@ -40,6 +40,13 @@ namespace TrRouting
       std::map<boost::uuids::uuid, DataSource>& ,
       std::string = "") {return 0;}
 
+    virtual int getHouseholds(
+      std::map<boost::uuids::uuid, Household>& ,
+      const std::map<boost::uuids::uuid, DataSource>& ,
+      const std::map<boost::uuids::uuid, Node>& ,
+      std::string = ""
+                              ) {return 0;}
+
     virtual int getPersons(
       std::map<boost::uuids::uuid, Person>& ,
       const std::map<boost::uuids::uuid, DataSource>& ,
@@ -54,6 +61,13 @@ namespace TrRouting
       std::string = ""
                            ) {return 0;}
 
+    virtual int getPlaces(
+      std::map<boost::uuids::uuid, Place>& ,
+      const std::map<boost::uuids::uuid, DataSource>& ,
+      const std::map<boost::uuids::uuid, Node>& ,
+      std::string = ""
+                          ) {return 0;}
+
     virtual int getAgencies(
       std::map<boost::uuids::uuid, Agency>& ,
       std::string = ""
@@ -0,0 +1,86 @@
+#ifndef TR_EPOCH_VECTOR
+#define TR_EPOCH_VECTOR
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+namespace TrRouting
+{
+
+  /**
+   * @brief Fixed size vector of scratch values that can be reset in constant time
+   *
+   * Each slot is stamped with the epoch at which it was last written. Resetting
+   * the vector only increments the current epoch, so that slots written during a
+   * previous epoch are read back as the default value. This avoids re-assigning
+   * the whole vector before each query, whose cost depends on the network size.
+   */
+  template <typename T>
+  class EpochVector {
+
+  public:
+    EpochVector() : defaultValue(T()), epoch(1) {}
+
+    /**
+     * Invalidate all the values and make sure the vector contains at least
+     * size elements. Elements will be read as defaultValue until they are
+     * written to. Only resizing the vector is linear in its size.
+     */
+    void reset(size_t size, const T& _defaultValue) {
+      defaultValue = _defaultValue;
+      if (size != values.size()) {
+        values.assign(size, defaultValue);
+        epochs.assign(size, 0);
+      }
+      nextEpoch();
+    }
+
+    // Invalidate all values, without changing the size of the vector
+    void clear() {
+      nextEpoch();
+    }
+
+    size_t size() const { return values.size(); }
+
+    // Read-only access to a value, returns the default value for slots not written in the current epoch
+    const T& get(size_t index) const {
+      return epochs[index] == epoch ? values[index] : defaultValue;
+    }
+
+    // Mutable access to a value. A stale slot is set back to the default value before being returned
+    T& operator[](size_t index) {
+      if (epochs[index] != epoch) {
+        values[index] = defaultValue;
+        epochs[index] = epoch;
+      }
+      return values[index];
+    }
+
+    // Bound checked mutable access, like std::vector::at
+    T& at(size_t index) {
+      if (index >= values.size()) {
+        throw std::out_of_range("EpochVector index out of range");
+      }
+      return (*this)[index];
+    }
+
+  private:
+    std::vector<T> values;
+    std::vector<uint32_t> epochs; // epoch at which each value was last written
+    T defaultValue;
+    uint32_t epoch;
+
+    void nextEpoch() {
+      epoch++;
+      // On overflow, really clear the stamps so old values do not become valid again
+      if (epoch == 0) {
+        epochs.assign(epochs.size(), 0);
+        epoch = 1;
+      }
+    }
+  };
+
+}
+
+#endif // TR_EPOCH_VECTOR
@@ -13,7 +13,7 @@ namespace TrRouting
     EuclideanGeoFilter();
     
     virtual std::vector<NodeTimeDistance> getAccessibleNodesFootpathsFromPoint(const Point &point,
-                                                                       const std::map<boost::uuids::uuid, Node> &nodes,
+                                                                       const NodeSpatialIndex &nodesIndex,
                                                                        int maxWalkingTravelTime,
                                                                        float walkingSpeedMetersPerSecond,
                                                                        bool reversed = false);    
@@ -0,0 +1,80 @@
+#ifndef TR_FOOTPATH_CACHE
+#define TR_FOOTPATH_CACHE
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <optional>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+namespace TrRouting
+{
+  class Point;
+  class NodeTimeDistance;
+
+  // Key of the footpaths from a point, the coordinates are rounded to about one meter
+  class FootpathCacheKey {
+  public:
+    FootpathCacheKey(const std::string &mode, const Point &point, int maxWalkingTravelTime, float walkingSpeedMetersPerSecond, bool reversed);
+
+    std::string mode;
+    long long quantizedLatitude;
+    long long quantizedLongitude;
+    int maxWalkingTravelTime;
+    float walkingSpeedMetersPerSecond;
+    bool reversed;
+
+    bool operator==(const FootpathCacheKey &other) const;
+
+    // Number of coordinate steps per degree, 1e-5 degree is about one meter
+    static constexpr double COORDINATES_PER_DEGREE = 100000.0;
+  };
+
+  class FootpathCacheKeyHash {
+  public:
+    size_t operator()(const FootpathCacheKey &key) const;
+  };
+
+  /**
+   * @brief Thread safe least recently used cache of the footpaths from a point
+   *
+   * The footpaths reference the nodes, so the cache is cleared when it is used
+   * with a newer nodes index build. While a new data is published, requests
+   * still using the nodes of an older build bypass the cache.
+   */
+  class FootpathCache {
+
+  public:
+    // A capacity of 0 disables the cache
+    FootpathCache(size_t _capacity) : capacity(_capacity) {}
+
+    std::optional<std::vector<NodeTimeDistance>> get(const FootpathCacheKey &key, unsigned int nodesBuildId);
+    void set(const FootpathCacheKey &key, unsigned int nodesBuildId, const std::vector<NodeTimeDistance> &footpaths);
+
+    size_t getCapacity() const { return capacity; }
+    size_t size() const;
+    unsigned long long getHits() const { return hits; }
+    unsigned long long getMisses() const { return misses; }
+
+  private:
+    typedef std::pair<FootpathCacheKey, std::vector<NodeTimeDistance>> Entry;
+
+    // Clear the entries of an older nodes build. Returns false if the nodes are older than the cached ones
+    bool useNodesBuild(unsigned int nodesBuildId);
+
+    const size_t capacity;
+    mutable std::mutex mutex;
+    // Most recently used entries first
+    std::list<Entry> entries;
+    std::unordered_map<FootpathCacheKey, std::list<Entry>::iterator, FootpathCacheKeyHash> entriesByKey;
+    unsigned int cachedNodesBuildId {0};
+    std::atomic<unsigned long long> hits {0};
+    std::atomic<unsigned long long> misses {0};
+  };
+
+}
+
+#endif // TR_FOOTPATH_CACHE
@@ -2,8 +2,7 @@
 #define TR_GEO_FILTER
 
 #include <vector>
-#include <map> //For node map types, TODO have a typedef somewhere for the nodes array
-#include <boost/uuid/uuid.hpp>
+#include <functional>
 #include <tuple>
 
 namespace TrRouting
@@ -11,13 +10,14 @@ namespace TrRouting
   class Point;
   class Node;
   class NodeTimeDistance;
+  class NodeSpatialIndex;
 
   /* Base class to implement filter based in geography */
   class GeoFilter
   {
   public:
     virtual std::vector<NodeTimeDistance> getAccessibleNodesFootpathsFromPoint(const Point &point,
-                                                                       const std::map<boost::uuids::uuid, Node> &nodes,
+                                                                       const NodeSpatialIndex &nodesIndex,
                                                                        int maxWalkingTravelTime,
                                                                        float walkingSpeedMetersPerSecond,
                                                                        bool reversed = false) = 0;
@@ -27,6 +27,8 @@ namespace TrRouting
     static float calculateMaxDistanceSquared(int maxWalkingTravelTime, float walkingSpeed);
     //TODO WHy one point * and other &
     static float calculateNodeDistanceSquared(const Point *node, const Point &point, const std::tuple<float, float> &lengthOfOneDegree);
+    // Nodes of the index that may be within the max distance of the point, the distance of each node still needs to be checked
+    static std::vector<std::reference_wrapper<const Node>> getCandidateNodes(const Point &point, const NodeSpatialIndex &nodesIndex, float maxDistanceMetersSquared, const std::tuple<float, float> &lengthOfOneDegree);
 
   };
 }
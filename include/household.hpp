@@ -3,30 +3,57 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <boost/uuid/uuid.hpp>
 #include "point.hpp"
 
 
 namespace TrRouting
 {
-  
+  class DataSource;
+  class NodeTimeDistance;
+
   class Household {
   
   public:
-   
+    Household(boost::uuids::uuid auuid,
+              unsigned long long aid,
+              const std::string &ainternalId,
+              const DataSource &adataSource,
+              float aexpansionFactor,
+              int asize,
+              int acarNumber,
+              int aincomeLevel,
+              const std::string &aincomeLevelGroup,
+              const std::string &acategory,
+              const std::vector<NodeTimeDistance> &ahomeNodes,
+              std::unique_ptr<Point> apoint)
+    : uuid(auuid),
+      id(aid),
+      internalId(ainternalId),
+      dataSource(adataSource),
+      expansionFactor(aexpansionFactor),
+      size(asize),
+      carNumber(acarNumber),
+      incomeLevel(aincomeLevel),
+      incomeLevelGroup(aincomeLevelGroup),
+      category(acategory),
+      homeNodes(ahomeNodes),
+      point(std::move(apoint)) {}
+
     boost::uuids::uuid uuid;
     unsigned long long id;
+    std::string internalId;
+    const DataSource & dataSource;
     float expansionFactor;
     int size;
     int carNumber;
     int incomeLevel;
     std::string incomeLevelGroup;
     std::string category;
-    std::string internalId;
+    // Nodes accessible by walking from home, precomputed with their travel time and distance
+    std::vector<NodeTimeDistance> homeNodes;
     std::unique_ptr<Point> point;
-    std::vector<int> homeNodesIdx;
-    std::vector<int> homeNodesTravelTimesSeconds;
-    std::vector<int> homeNodesDistancesMeters;
 
     const std::string toString() {
       return "Household " + boost::uuids::to_string(uuid) + " size " + std::to_string(size);
@@ -1,6 +1,7 @@
 #ifndef TR_LINE
 #define TR_LINE
 
+#include <atomic>
 #include <string>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -52,10 +53,11 @@ namespace TrRouting
     inline bool operator!=(const Line& other ) const { return uid != other.uid; }
 
     static uid_t getMaxUid() { return global_uid; }
+    static void resetUids() { global_uid = 0; }
 
   private:
     //TODO, this could probably be an unsigned long, but current MAX_INT is good enough for our needs
-    inline static uid_t global_uid = 0;
+    inline static std::atomic<uid_t> global_uid {0};
   };
 
   // To use std::find with a vector<reference_wrapper<const Line>>
@@ -1,6 +1,7 @@
 #ifndef TR_MODE
 #define TR_MODE
 
+#include <atomic>
 #include <string>
 
 namespace TrRouting
@@ -9,6 +10,8 @@ namespace TrRouting
   class Mode {
   
   public:
+    typedef int uid_t; //Type for a local temporary ID
+
     inline static const std::string TRANSFERABLE {"transferable"}; 
 
     Mode(const std::string &ashortname,
@@ -17,12 +20,14 @@ namespace TrRouting
          int aextendedGtfsId) : shortname(ashortname),
                                 name(aname),
                                 gtfsId(agtfsId),
-                                extendedGtfsId(aextendedGtfsId) {}
+                                extendedGtfsId(aextendedGtfsId),
+                                uid(++global_uid) {}
 
     std::string shortname;
     std::string name;
     int gtfsId;
     int extendedGtfsId;
+    uid_t uid; //Local, temporary unique id, used to speed up lookups
 
     const std::string toString() {
       return "Mode\n  shortname " + shortname + "\n  name " + name + "\n  gtfsId " + std::to_string(gtfsId) + "\n  extendedGtfsId " + std::to_string(extendedGtfsId);
@@ -35,6 +40,13 @@ namespace TrRouting
 
     // Equal operator. We only compare the shortname, since they should be unique.
     inline bool operator==(const Mode& other ) const { return shortname == other.shortname; }
+
+    static uid_t getMaxUid() { return global_uid; }
+    static void resetUids() { global_uid = 0; }
+
+  private:
+    //TODO, this could probably be an unsigned long, but current MAX_INT is good enough for our needs
+    inline static std::atomic<uid_t> global_uid {0};
   };
 
   // To use std::find with a vector<reference_wrapper<const Mode>>
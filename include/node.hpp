@@ -1,6 +1,7 @@
 #ifndef TR_NODE
 #define TR_NODE
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <boost/uuid/uuid.hpp>
@@ -53,10 +54,11 @@ namespace TrRouting
     inline bool operator!=(const Node& other ) const { return uid != other.uid; }
 
     static uid_t getMaxUid() { return global_uid; }
+    static void resetUids() { global_uid = 0; }
 
   private:
     //TODO, this could probably be an unsigned long, but current MAX_INT is good enough for our needs
-    inline static uid_t global_uid = 0;
+    inline static std::atomic<uid_t> global_uid {0};
   };
 
   inline bool operator==(const std::reference_wrapper<const TrRouting::Node>& lhs, const std::reference_wrapper<const Node>& rhs)
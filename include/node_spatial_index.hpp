@@ -0,0 +1,72 @@
+#ifndef TR_NODE_SPATIAL_INDEX
+#define TR_NODE_SPATIAL_INDEX
+
+#include <vector>
+#include <map>
+#include <functional>
+#include <atomic>
+#include <boost/uuid/uuid.hpp>
+
+namespace TrRouting
+{
+  class Point;
+  class Node;
+
+  /**
+   * @brief Uniform grid over the nodes coordinates, to find the nodes around a point
+   *
+   * The grid is built once when the nodes are loaded and stores the nodes of
+   * each cell contiguously in flat arrays. Finding the nodes around a point
+   * only visits the cells overlapping the requested bounding box, instead of
+   * all the nodes of the network.
+   */
+  class NodeSpatialIndex {
+
+  public:
+    NodeSpatialIndex() {}
+
+    // Rebuild the grid for these nodes. The nodes are referenced by the index, so the map must outlive it
+    void build(const std::map<boost::uuids::uuid, Node> &nodes);
+
+    /**
+     * Get the nodes in the cells covering the bounding box of +/- longitudeDelta
+     * and latitudeDelta degrees around the point. It is a superset of the nodes
+     * in the bounding box, the caller needs to check the actual distance. Nodes
+     * are returned in the same order as in the nodes map.
+     */
+    std::vector<std::reference_wrapper<const Node>> getNodesInBoundingBox(const Point &point, double longitudeDelta, double latitudeDelta) const;
+
+    size_t size() const { return nodes.size(); }
+    // Unique id of the last build, data derived from the indexed nodes can use it to know they are stale
+    unsigned int getBuildId() const { return buildId; }
+
+  private:
+    // Approximate cell size, the actual size in degrees is calculated at the middle latitude of the nodes
+    static constexpr double CELL_SIZE_METERS = 500.0;
+    // Limit the grid size when the nodes are spread over a very large area
+    static constexpr int MAX_CELLS_PER_DIMENSION = 2048;
+
+    inline static std::atomic<unsigned int> lastBuildId {0};
+    unsigned int buildId {0};
+
+    double minLongitude {0.0};
+    double minLatitude {0.0};
+    double cellLongitudeSize {1.0};
+    double cellLatitudeSize {1.0};
+    int columnsCount {0};
+    int rowsCount {0};
+
+    // Node references, in the nodes map order
+    std::vector<std::reference_wrapper<const Node>> nodes;
+    // For each cell, in row major order, the range of its nodes in cellNodeIndexes
+    std::vector<size_t> cellStarts;
+    // Index in nodes of the nodes of each cell, sorted by cell, then by index
+    std::vector<size_t> cellNodeIndexes;
+
+    int getColumn(double longitude) const;
+    int getRow(double latitude) const;
+  };
+
+}
+
+#endif // TR_NODE_SPATIAL_INDEX
@@ -2,25 +2,34 @@
 #define TR_OSRM_GEO_FILTER
 
 #include "geofilter.hpp"
+#include "footpath_cache.hpp"
 #include <string>
 
 namespace TrRouting
 {
+  // Default number of points for which the OSRM footpaths are kept in memory
+  static const size_t DEFAULT_OSRM_CACHE_SIZE = 10000;
+
   /* Filter nodes using OSRM */
   class OsrmGeoFilter : public GeoFilter
   {
   public:
-    OsrmGeoFilter(const std::string &mode, const std::string &host, const std::string & port);
+    OsrmGeoFilter(const std::string &mode, const std::string &host, const std::string & port, size_t cacheSize = DEFAULT_OSRM_CACHE_SIZE);
     
     virtual std::vector<NodeTimeDistance> getAccessibleNodesFootpathsFromPoint(const Point &point,
-                                                                       const std::map<boost::uuids::uuid, Node> &nodes,
+                                                                       const NodeSpatialIndex &nodesIndex,
                                                                        int maxWalkingTravelTime,
                                                                        float walkingSpeedMetersPerSecond,
                                                                        bool reversed = false);
+    // Statistics of the footpaths cache, to monitor how many OSRM requests are avoided
+    unsigned long long getCacheHits() const { return footpathCache.getHits(); }
+    unsigned long long getCacheMisses() const { return footpathCache.getMisses(); }
   protected:
     std::string mode;
     std::string host;
     std::string port; //Could be an int, but it's used as a string every where. Keep a string remove conversions
+    // Repeated queries from the same place return the previous OSRM response
+    FootpathCache footpathCache;
 
   };
 }
@@ -5,7 +5,10 @@
 #include <vector>
 #include <map>
 #include <optional>
+#include <memory>
+#include <functional>
 #include <boost/uuid/uuid.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
 #include "data_source.hpp"
 #include "toolbox.hpp" //MAX_INT
 
@@ -21,6 +24,12 @@ namespace TrRouting
   class Agency;
   class Service;
   class Line;
+  class Place;
+  class Household;
+  class NodeTimeDistance;
+
+  // Nodes precomputed with their footpath travel time and distance for a place, household or od trip. When set, the footpaths are not fetched with the geofilter
+  typedef std::optional<std::reference_wrapper<const std::vector<NodeTimeDistance>>> PrecomputedNodes;
 
   // Default values for parameters
   static const int DEFAULT_MIN_WAITING_TIME = 3 * 60;
@@ -29,6 +38,11 @@ namespace TrRouting
   static const int DEFAULT_MAX_EGRESS_TRAVEL_TIME = 20 * 60;
   static const int DEFAULT_MAX_TRANSFER_TRAVEL_TIME = 20 * 60;
   static const int DEFAULT_FIRST_WAITING_TIME = 30 * 60;
+  static const int DEFAULT_PROFILE_TIME_WINDOW = 2 * 60 * 60;
+  static const int DEFAULT_ACCESSIBILITY_TIME_WINDOW_STEP = 60;
+  static const int MAX_ACCESSIBILITY_TIME_WINDOW_STEPS = 24 * 60; // Maximum number of times of trip in an accessibility time window
+  static const int MAX_ACCESSIBILITY_TIME_WINDOW = 24 * 60 * 60; // Maximum duration of an accessibility time window, in seconds
+  static const int MAX_TRANSFERS_LIMIT = 10; // The multi-criteria calculation keeps one label per node for each number of transfers
 
   class ParameterException : public std::exception
   {
@@ -56,7 +70,13 @@ namespace TrRouting
         // Place data received is invalid. Expected comma-separated lon/lat
         INVALID_PLACE,
         // Some parameter value is invalid. Expected an integer
-        INVALID_NUMERICAL_DATA
+        INVALID_NUMERICAL_DATA,
+        // The time window is invalid: it must end after the time of trip and be a departure time window
+        INVALID_TIME_WINDOW,
+        // The date is invalid. Expected YYYY-MM-DD
+        INVALID_DATE,
+        // A maximum number of transfers is only supported for alternatives with a departure time
+        INVALID_MAX_TRANSFERS
       };
       ParameterException(Type type_) : std::exception(), type(type_) {};
       Type getType() const { return type; };
@@ -100,6 +120,7 @@ namespace TrRouting
       std::vector<std::reference_wrapper<const Mode>> exceptModes;
       std::vector<std::reference_wrapper<const Node>> exceptNodes;
       bool forwardCalculation; // forward calculation: default true. if false: reverse calculation, will ride connections backward (useful when setting the arrival time)
+      std::optional<boost::gregorian::date> date; // If set, only the services active on this date are used
 
     protected:
       CommonParameters(const CommonParameters& baseParams);
@@ -113,7 +134,8 @@ namespace TrRouting
         int maxEgressTime,
         int maxTransferTime,
         int maxFirstWaitingTime,
-        bool forward
+        bool forward,
+        std::optional<boost::gregorian::date> date = std::nullopt
       );
       virtual ~CommonParameters() {}
       // FIXME Temporary method, will be removed once calculation specific parameters are implemented. Try not to use.
@@ -125,7 +147,8 @@ namespace TrRouting
       int getMaxEgressWalkingTravelTimeSeconds() const { return maxEgressWalkingTravelTimeSeconds; }
       int getMaxTransferWalkingTravelTimeSeconds() const { return maxTransferWalkingTravelTimeSeconds; }
       int getMaxFirstWaitingTimeSeconds() const { return maxFirstWaitingTimeSeconds; }
-      bool isForwardCalculation() { return forwardCalculation; }
+      bool isForwardCalculation() const { return forwardCalculation; }
+      const std::optional<boost::gregorian::date>& getDate() const { return date; }
       const std::vector<std::reference_wrapper<const Service>>& getOnlyServices() const { return onlyServices; }
       const std::vector<std::reference_wrapper<const Service>>& getExceptServices() const { return exceptServices; }
       const std::vector<std::reference_wrapper<const Line>>& getOnlyLines() const { return onlyLines; }
@@ -138,6 +161,9 @@ namespace TrRouting
       const std::vector<std::reference_wrapper<const Node>>& getExceptNodes() const { return exceptNodes; }
       float getWalkingSpeedFactor() const { return 1.0; } // all walking segments are weighted with this value. > 1.0 means faster walking, < 1.0 means slower walking
       float getWalkingSpeedMetersPerSecond() const { return 5/3.6; } // 5 km/h;
+      // Precomputed access and egress nodes of the origin and destination, if any
+      virtual PrecomputedNodes getOriginNodes() const { return std::nullopt; }
+      virtual PrecomputedNodes getDestinationNodes() const { return std::nullopt; }
 
       static CommonParameters createCommonParameter(std::vector<std::pair<std::string, std::string>> &parameters,
                                                     const std::map<boost::uuids::uuid, Scenario> &scenarios
@@ -154,6 +180,15 @@ namespace TrRouting
        * @return int The converted integer
        */
       static int getIntegerValue(std::string strValue);
+
+      /**
+       * @brief Helper functions to get the place or household with the uuid
+       * string value, or throw a ParameterException of the invalidType if it
+       * does not exist. Its point and precomputed nodes can be used instead of
+       * coordinates.
+       */
+      static const Place& getPlace(const std::string &uuidStr, const std::map<boost::uuids::uuid, Place> &places, ParameterException::Type invalidType);
+      static const Household& getHousehold(const std::string &uuidStr, const std::map<boost::uuids::uuid, Household> &households, ParameterException::Type invalidType);
   };
 
   class RouteParameters : public CommonParameters {
@@ -161,6 +196,9 @@ namespace TrRouting
       std::unique_ptr<Point> origin;
       std::unique_ptr<Point> destination;
       bool withAlternatives; // calculate alternatives or not
+      std::optional<int> maxTransfers; // if set, alternatives are the arrival time/number of transfers Pareto front, calculated in a single pass
+      PrecomputedNodes originNodes;
+      PrecomputedNodes destinationNodes;
       
     public:
       RouteParameters(std::unique_ptr<Point> orig,
@@ -179,7 +217,10 @@ namespace TrRouting
       RouteParameters(std::unique_ptr<Point> orig,
         std::unique_ptr<Point> dest,
         bool alternatives,
-        const CommonParameters &common_
+        const CommonParameters &common_,
+        std::optional<int> maxTransfers = std::nullopt,
+        PrecomputedNodes originNodes = std::nullopt,
+        PrecomputedNodes destinationNodes = std::nullopt
       );
       RouteParameters(const RouteParameters& routeParams);
       virtual ~RouteParameters() {}
@@ -187,6 +228,9 @@ namespace TrRouting
       Point* getOrigin() const { return origin.get(); }
       Point* getDestination() const { return destination.get(); }
       bool isWithAlternatives() { return withAlternatives; }
+      std::optional<int> getMaxTransfers() const { return maxTransfers; }
+      virtual PrecomputedNodes getOriginNodes() const { return originNodes; }
+      virtual PrecomputedNodes getDestinationNodes() const { return destinationNodes; }
 
       // TODO Those values used to be in the legacy parameters object. They are not exposed
       // in the V2 api yet, but we used the default values in the alternative calculation.
@@ -209,12 +253,70 @@ namespace TrRouting
       static RouteParameters createRouteODParameter(std::vector<std::pair<std::string, std::string>> &parameters,
                                                     const std::map<boost::uuids::uuid, Scenario> &scenarios
       );
+      /**
+       * Same as above, but the origin and destination can also be given by
+       * the uuid of a place or household, with the origin_place_uuid,
+       * origin_household_uuid, destination_place_uuid and
+       * destination_household_uuid parameters. Their precomputed nodes are
+       * then used as access and egress nodes.
+       **/
+      static RouteParameters createRouteODParameter(std::vector<std::pair<std::string, std::string>> &parameters,
+                                                    const std::map<boost::uuids::uuid, Scenario> &scenarios,
+                                                    const std::map<boost::uuids::uuid, Place> &places,
+                                                    const std::map<boost::uuids::uuid, Household> &households
+      );
+  };
+
+  /**
+   * Parameters for a profile calculation, which returns all the Pareto-optimal
+   * journeys departing from the origin between the time of trip and the end
+   * of the time window.
+   */
+  class ProfileParameters : public RouteParameters {
+    private:
+      int timeWindowEnd;
+
+    public:
+      ProfileParameters(std::unique_ptr<Point> orig,
+        std::unique_ptr<Point> dest,
+        int timeWindowEnd,
+        const CommonParameters &common_,
+        PrecomputedNodes originNodes = std::nullopt,
+        PrecomputedNodes destinationNodes = std::nullopt
+      );
+      virtual ~ProfileParameters() {}
+      int getTimeWindowStart() const { return getTimeOfTrip(); }
+      int getTimeWindowEnd() const { return timeWindowEnd; }
+
+      /**
+       * Factory function to create a ProfileParameters object from a map of
+       * parameters coming from the profile endpoint. It accepts the same
+       * parameters as the route, with an additional time_window_end.
+       *
+       * If there are missing or invalid parameters, this function will throw a
+       * ParameterException error
+       **/
+      static ProfileParameters createProfileParameter(std::vector<std::pair<std::string, std::string>> &parameters,
+                                                      const std::map<boost::uuids::uuid, Scenario> &scenarios
+      );
+      /**
+       * Same as above, but the origin and destination can also be given by
+       * the uuid of a place or household, like for the route
+       **/
+      static ProfileParameters createProfileParameter(std::vector<std::pair<std::string, std::string>> &parameters,
+                                                      const std::map<boost::uuids::uuid, Scenario> &scenarios,
+                                                      const std::map<boost::uuids::uuid, Place> &places,
+                                                      const std::map<boost::uuids::uuid, Household> &households
+      );
   };
 
   class AccessibilityParameters : public CommonParameters {
     private:
       std::unique_ptr<Point> place;
-      
+      std::optional<int> timeWindowEnd;
+      int stepSeconds;
+      PrecomputedNodes placeNodes;
+
     public:
       AccessibilityParameters(std::unique_ptr<Point> place,
         const Scenario& scenario,
@@ -228,16 +330,33 @@ namespace TrRouting
         bool forward
       );
       AccessibilityParameters(std::unique_ptr<Point> place,
-        const CommonParameters &common_
+        const CommonParameters &common_,
+        PrecomputedNodes placeNodes = std::nullopt
+      );
+      AccessibilityParameters(std::unique_ptr<Point> place,
+        std::optional<int> timeWindowEnd,
+        int stepSeconds,
+        const CommonParameters &common_,
+        PrecomputedNodes placeNodes = std::nullopt
       );
       virtual ~AccessibilityParameters() {}
       // TODO Should Point be const here?
       Point* getPlace() const { return place.get(); }
+      // With a time window, the accessibility is calculated every stepSeconds from the time of trip to the end of the window, inclusively
+      bool hasTimeWindow() const { return timeWindowEnd.has_value(); }
+      int getTimeWindowEnd() const { return timeWindowEnd.value_or(getTimeOfTrip()); }
+      int getStepSeconds() const { return stepSeconds; }
+      std::vector<int> getTimesOfTrip() const;
+      // The precomputed nodes of the place are its access nodes, or its egress nodes for a reverse calculation
+      PrecomputedNodes getPlaceNodes() const { return placeNodes; }
+      virtual PrecomputedNodes getOriginNodes() const { return isForwardCalculation() ? placeNodes : std::nullopt; }
+      virtual PrecomputedNodes getDestinationNodes() const { return isForwardCalculation() ? std::nullopt : placeNodes; }
 
       /**
        * Factory function to create a AccessibilityParameters object from  a map of
        * parameters coming from the accessibility endpoint. It returns a new
        * immutable AccessibilityParameters object with complete parameter initialization.
+       * The optional time_window_end and step_seconds parameters set the time window.
        *
        * If there are missing or invalid parameters, this function will throw a
        * ParameterException error
@@ -245,6 +364,65 @@ namespace TrRouting
       static AccessibilityParameters createAccessibilityParameter(std::vector<std::pair<std::string, std::string>> &parameters,
                                                     const std::map<boost::uuids::uuid, Scenario> &scenarios
       );
+      /**
+       * Same as above, but the place can also be given by the uuid of a place
+       * or household, with the place_uuid or household_uuid parameters. Its
+       * precomputed nodes are then used instead of the geofilter.
+       **/
+      static AccessibilityParameters createAccessibilityParameter(std::vector<std::pair<std::string, std::string>> &parameters,
+                                                    const std::map<boost::uuids::uuid, Scenario> &scenarios,
+                                                    const std::map<boost::uuids::uuid, Place> &places,
+                                                    const std::map<boost::uuids::uuid, Household> &households
+      );
+  };
+
+  /**
+   * Parameters for the accessibility to all nodes from/to many places at the
+   * same time of trip. The places are calculated together by batches, so the
+   * connections are scanned once per batch instead of once per place.
+   */
+  class AccessibilityBatchParameters : public CommonParameters {
+    private:
+      std::vector<std::unique_ptr<Point>> places;
+      // For the places given by uuid, their uuid and precomputed nodes, at the same index as the place
+      std::vector<std::optional<boost::uuids::uuid>> placesUuids;
+      std::vector<PrecomputedNodes> placesNodes;
+
+    public:
+      AccessibilityBatchParameters(std::vector<std::unique_ptr<Point>> places,
+        const CommonParameters &common_
+      );
+      AccessibilityBatchParameters(std::vector<std::unique_ptr<Point>> places,
+        std::vector<std::optional<boost::uuids::uuid>> placesUuids,
+        std::vector<PrecomputedNodes> placesNodes,
+        const CommonParameters &common_
+      );
+      virtual ~AccessibilityBatchParameters() {}
+      const std::vector<std::unique_ptr<Point>>& getPlaces() const { return places; }
+      const std::vector<std::optional<boost::uuids::uuid>>& getPlacesUuids() const { return placesUuids; }
+      const std::vector<PrecomputedNodes>& getPlacesNodes() const { return placesNodes; }
+
+      /**
+       * Factory function to create a AccessibilityBatchParameters object from
+       * a map of parameters coming from the batch accessibility endpoint. The
+       * places are semicolon-separated lon,lat coordinates.
+       *
+       * If there are missing or invalid parameters, this function will throw a
+       * ParameterException error
+       **/
+      static AccessibilityBatchParameters createAccessibilityBatchParameter(std::vector<std::pair<std::string, std::string>> &parameters,
+                                                    const std::map<boost::uuids::uuid, Scenario> &scenarios
+      );
+      /**
+       * Same as above, but places can also be given by their uuid, with the
+       * semicolon-separated place_uuids parameter, or all the places of a data
+       * source with the places_data_source_uuid parameter. Their precomputed
+       * nodes are then used instead of the geofilter.
+       **/
+      static AccessibilityBatchParameters createAccessibilityBatchParameter(std::vector<std::pair<std::string, std::string>> &parameters,
+                                                    const std::map<boost::uuids::uuid, Scenario> &scenarios,
+                                                    const std::map<boost::uuids::uuid, Place> &places
+      );
   };
 
   class OdTripLegacyParameters {
@@ -271,6 +449,9 @@ namespace TrRouting
       std::optional<boost::uuids::uuid> odTripUuid;
 
       bool calculateProfiles;            // calculate profiles for lines, paths and trips (od trips only)
+      bool groupOdTrips;                 // route the od trips with the same access nodes and departure time with a single forward calculation
+      std::string checkpointFilePath;    // file where the progress is saved to resume an interrupted run, no checkpoint if empty
+      int checkpointInterval;            // minimum number of od trips routed between two checkpoints
 
       ~OdTripLegacyParameters() {}
       OdTripLegacyParameters();
@@ -1,6 +1,7 @@
 #ifndef TR_PATH
 #define TR_PATH
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <boost/uuid/uuid.hpp>
@@ -14,6 +15,9 @@ namespace TrRouting
   class Path {
   
   public:
+
+    typedef int uid_t; //Type for a local temporary ID
+
     Path(const boost::uuids::uuid &auuid,
          const Line &aline,
          const std::string &adirection,
@@ -29,7 +33,8 @@ namespace TrRouting
       nodesRef(anodesRef),
       tripsRef(atripsRef),
       segmentsTravelTimeSeconds(asegmentsTravelTimeSeconds),
-      segmentsDistanceMeters(asegmentsDistanceMeters) {}
+      segmentsDistanceMeters(asegmentsDistanceMeters),
+      uid(++global_uid) {}
 
     /* Alternative constructor where we pass a NodeTimeDistance vector instead of
      separate vectors for nodes, segments time and distance. Easier to handle in some cases */
@@ -43,7 +48,8 @@ namespace TrRouting
       line(aline),
       direction(adirection),
       internalId(ainternalId),
-      tripsRef(atripsRef)
+      tripsRef(atripsRef),
+      uid(++global_uid)
       {
         for (const NodeTimeDistance & ntd: anodesTimeDistance) {
           nodesRef.push_back(ntd.node);
@@ -62,11 +68,19 @@ namespace TrRouting
     // to validate their usage
     std::vector<int> segmentsTravelTimeSeconds;
     std::vector<int> segmentsDistanceMeters;
+    uid_t uid; //Local, temporary unique id, used to speed up lookups
 
     const std::string toString() {
       return "Path " + boost::uuids::to_string(uuid) + "\n  direction " + direction;
     }
 
+    static uid_t getMaxUid() { return global_uid; }
+    static void resetUids() { global_uid = 0; }
+
+  private:
+    //TODO, this could probably be an unsigned long, but current MAX_INT is good enough for our needs
+    inline static std::atomic<uid_t> global_uid {0};
+
   };
 
 }
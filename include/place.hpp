@@ -3,28 +3,45 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <boost/uuid/uuid.hpp>
 #include "point.hpp"
 
 
 namespace TrRouting
 {
-  
+  class DataSource;
+  class NodeTimeDistance;
+
   class Place {
   
   public:
-   
+    Place(boost::uuids::uuid auuid,
+          unsigned long long aid,
+          const std::string &ainternalId,
+          const std::string &ashortname,
+          const std::string &aname,
+          const DataSource &adataSource,
+          const std::vector<NodeTimeDistance> &anodes,
+          std::unique_ptr<Point> apoint)
+    : uuid(auuid),
+      id(aid),
+      internalId(ainternalId),
+      shortname(ashortname),
+      name(aname),
+      dataSource(adataSource),
+      nodes(anodes),
+      point(std::move(apoint)) {}
+
     boost::uuids::uuid uuid;
     unsigned long long id;
+    std::string internalId;
     std::string shortname;
     std::string name;
-    std::string osmFeatureKey;
-    std::string osmFeatureValue;
-    std::string internalId;
+    const DataSource & dataSource;
+    // Nodes accessible by walking from the place, precomputed with their travel time and distance
+    std::vector<NodeTimeDistance> nodes;
     std::unique_ptr<Point> point;
-    std::vector<int> nodesIdx;
-    std::vector<int> nodesTravelTimesSeconds;
-    std::vector<int> nodesDistancesMeters;
 
     const std::string toString() {
       return "Place " + boost::uuids::to_string(uuid);
@@ -16,7 +16,7 @@ namespace TrRouting
   class Node;
 
   // TODO These enums are used temporarily, while we need the class hierarchy to be able to determine which type is returned when dynamic cast is necessary
-  enum result_type { SINGLE_CALCULATION, ALTERNATIVES, ALL_NODES };
+  enum result_type { SINGLE_CALCULATION, ALTERNATIVES, ALL_NODES, PROFILE };
   enum result_step_type { WALKING, BOARDING, UNBOARDING };
 
   // Walking step types
@@ -217,6 +217,21 @@ namespace TrRouting
     }
   };
 
+  /**
+   * @brief Result class describing the Pareto-optimal journeys departing in a
+   * time window, ie each journey is the only one to arrive at its arrival time
+   * when departing at or after its departure time. Journeys are sorted by
+   * departure time.
+   */
+  class ProfileResult : public RoutingResult {
+  public:
+    std::vector<std::unique_ptr<SingleCalculationResult>> journeys;
+    ProfileResult(): RoutingResult(result_type::PROFILE) {}
+    void do_accept(ResultVisitorBase &visitor) const override {
+      return visitor.visitProfileResult(*this);
+    }
+  };
+
   /**
    * @brief A class describing a single accessible node details, with the time to reach the node
    * and the number of transfers for the requested departure time
@@ -270,6 +285,41 @@ namespace TrRouting
     NO_ACCESS_AT_ORIGIN_AND_DESTINATION
   };
 
+  /**
+   * @brief Accessibility result of one place of a batch: the accessible
+   * nodes, or the reason why there are none if result is empty
+   */
+  class PlaceAllNodesResult {
+  public:
+    std::unique_ptr<AllNodesResult> result;
+    NoRoutingReason noRoutingReason;
+    PlaceAllNodesResult(std::unique_ptr<AllNodesResult> _result): result(std::move(_result)), noRoutingReason(NoRoutingReason::NO_ROUTING_FOUND) {}
+    PlaceAllNodesResult(NoRoutingReason _noRoutingReason): result(nullptr), noRoutingReason(_noRoutingReason) {}
+  };
+
+  /**
+   * @brief Travel times to a node for each time of a time window, in the
+   * order of the times, -1 when the node is not reached at this time
+   */
+  class AccessibleNodeTravelTimes {
+  public:
+    const Node & node;
+    std::vector<int> travelTimes;
+    AccessibleNodeTravelTimes(const Node & _node, std::vector<int> _travelTimes): node(_node), travelTimes(std::move(_travelTimes)) {}
+  };
+
+  /**
+   * @brief Accessibility result for a time window: the times of trip of the
+   * window and the travel times to each node reached at least once
+   */
+  class AllNodesRangeResult {
+  public:
+    std::vector<int> timesOfTrip;
+    std::vector<AccessibleNodeTravelTimes> nodes;
+    int totalNodeCount;
+    AllNodesRangeResult(): totalNodeCount(0) {}
+  };
+
   /**
    * @brief Exception class thrown when no routing is found
    * 
@@ -7,6 +7,7 @@ namespace TrRouting
   class SingleCalculationResult;
   class AlternativesResult;
   class AllNodesResult;
+  class ProfileResult;
 
   class BoardingStep;
   class UnboardingStep;
@@ -23,6 +24,7 @@ namespace TrRouting
     virtual void visitSingleCalculationResult(const SingleCalculationResult& result) = 0;
     virtual void visitAlternativesResult(const AlternativesResult& result) = 0;
     virtual void visitAllNodesResult(const AllNodesResult& result) = 0;
+    virtual void visitProfileResult(const ProfileResult& result) = 0;
   };
 
   /**
@@ -1,9 +1,12 @@
 #ifndef TR_SERVICE
 #define TR_SERVICE
 
+#include <atomic>
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_io.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
 
 namespace TrRouting
@@ -12,22 +15,52 @@ namespace TrRouting
   class Service {
   
   public:
-   
+    typedef int uid_t; //Type for a local temporary ID
+
+    Service(): uid(++global_uid) {}
+
     boost::uuids::uuid uuid;
     std::string name;
     std::string internalId;
     boost::uuids::uuid simulationUuid;
-    short monday;
-    short tuesday;
-    short wednesday;
-    short thursday;
-    short friday;
-    short saturday;
-    short sunday;
+    short monday {0};
+    short tuesday {0};
+    short wednesday {0};
+    short thursday {0};
+    short friday {0};
+    short saturday {0};
+    short sunday {0};
     std::vector<boost::gregorian::date> onlyDates;
     std::vector<boost::gregorian::date> exceptDates;
     boost::gregorian::date startDate;
     boost::gregorian::date endDate;
+    uid_t uid; //Local, temporary unique id, used to speed up lookups
+
+    /**
+     * Whether the service runs on this date: the only dates are always
+     * active and the except dates never, otherwise the date must be between
+     * the start and end dates, if they are set, and on an active weekday.
+     */
+    bool isActiveOnDate(const boost::gregorian::date &date) const {
+      if (std::find(onlyDates.begin(), onlyDates.end(), date) != onlyDates.end()) {
+        return true;
+      }
+      if (std::find(exceptDates.begin(), exceptDates.end(), date) != exceptDates.end()) {
+        return false;
+      }
+      if ((!startDate.is_special() && date < startDate) || (!endDate.is_special() && date > endDate)) {
+        return false;
+      }
+      switch (date.day_of_week()) {
+        case boost::date_time::Monday: return monday;
+        case boost::date_time::Tuesday: return tuesday;
+        case boost::date_time::Wednesday: return wednesday;
+        case boost::date_time::Thursday: return thursday;
+        case boost::date_time::Friday: return friday;
+        case boost::date_time::Saturday: return saturday;
+        default: return sunday;
+      }
+    }
 
     const std::string toString() {
       return "Service " + boost::uuids::to_string(uuid) + "\n  name " + name;
@@ -35,6 +68,13 @@ namespace TrRouting
 
     // Equal operator. We only compare the uuid, since they should be unique.
     inline bool operator==(const Service& other ) const { return uuid == other.uuid; }
+
+    static uid_t getMaxUid() { return global_uid; }
+    static void resetUids() { global_uid = 0; }
+
+  private:
+    //TODO, this could probably be an unsigned long, but current MAX_INT is good enough for our needs
+    inline static std::atomic<uid_t> global_uid {0};
   };
 
   // To use std::find with a vector<reference_wrapper<const Service>>
@@ -0,0 +1,49 @@
+#ifndef TR_SERVICE_CALENDAR
+#define TR_SERVICE_CALENDAR
+
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <boost/uuid/uuid.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+
+namespace TrRouting
+{
+  class Service;
+
+  /**
+   * @brief Days on which each service is active
+   *
+   * For each service, a bitmap has one bit per day between the first and last
+   * dates of all the services' calendars, so finding the services of a date is
+   * one bit test per service. Dates outside this range use the service's
+   * calendar directly.
+   */
+  class ServiceCalendar {
+
+  public:
+    ServiceCalendar() {}
+    ServiceCalendar(const std::map<boost::uuids::uuid, Service> &services);
+
+    bool isServiceActive(const Service &service, const boost::gregorian::date &date) const;
+    // Keep only the services that are active on this date
+    std::vector<std::reference_wrapper<const Service>> getActiveServices(const std::vector<std::reference_wrapper<const Service>> &services, const boost::gregorian::date &date) const;
+
+    // Range of the bitmaps, not_a_date_time if there are no dated services
+    boost::gregorian::date getFirstDate() const { return firstDate; }
+    boost::gregorian::date getLastDate() const { return lastDate; }
+
+  private:
+    // Limit the range of the bitmaps, in case some services have unreasonable dates
+    static const long MAX_DAYS = 10 * 366;
+
+    boost::gregorian::date firstDate;
+    boost::gregorian::date lastDate;
+    // Indexed by Service::uid, empty for services that were not in the map
+    std::vector<std::vector<uint64_t>> activeDays;
+  };
+
+}
+
+#endif // TR_SERVICE_CALENDAR
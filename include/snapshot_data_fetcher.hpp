@@ -0,0 +1,161 @@
+#ifndef TR_SNAPSHOT_DATA_FETCHER
+#define TR_SNAPSHOT_DATA_FETCHER
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <boost/uuid/uuid.hpp>
+#include "data_fetcher.hpp"
+
+namespace TrRouting
+{
+  class TransitData;
+
+  /**
+   * @brief Fetch the transit data from a single snapshot file
+   *
+   * The snapshot contains the data after it was loaded and processed by
+   * TransitData: the transferable nodes of each node and the sorted orders of
+   * the connections. It is written once with writeSnapshot, then mapped in
+   * memory when starting the server, so the startup does not need to read
+   * the cache files nor sort the connections.
+   */
+  class SnapshotDataFetcher : public DataFetcher
+  {
+  public:
+    SnapshotDataFetcher(const std::string &snapshotFilePath);
+    virtual ~SnapshotDataFetcher();
+    SnapshotDataFetcher(const SnapshotDataFetcher&) = delete;
+    SnapshotDataFetcher& operator=(const SnapshotDataFetcher&) = delete;
+
+    /**
+     * Write the current data of transitData to a snapshot file
+     *
+     * @return 0 in case of success, the negative errno otherwise
+     */
+    static int writeSnapshot(const TransitData &transitData, const std::string &snapshotFilePath);
+
+    /** Refer to the base class for these functions documentations. The
+     * customPath is ignored, all data comes from the snapshot file */
+    virtual const std::map<std::string, Mode> getModes();
+
+    virtual int getDataSources(
+      std::map<boost::uuids::uuid, DataSource>& ts,
+      std::string customPath = ""
+    );
+
+    virtual int getHouseholds(
+      std::map<boost::uuids::uuid, Household>& ts,
+      const std::map<boost::uuids::uuid, DataSource>& dataSources,
+      const std::map<boost::uuids::uuid, Node>& nodes,
+      std::string customPath = ""
+    );
+
+    virtual int getPersons(
+      std::map<boost::uuids::uuid, Person>& ts,
+      const std::map<boost::uuids::uuid, DataSource>& dataSources,
+      std::string customPath = ""
+    );
+
+    virtual int getOdTrips(
+      std::map<boost::uuids::uuid, OdTrip>& ts,
+      const std::map<boost::uuids::uuid, DataSource>& dataSources,
+      const std::map<boost::uuids::uuid, Person>& persons,
+      const std::map<boost::uuids::uuid, Node>& nodes,
+      std::string customPath = ""
+    );
+
+    virtual int getPlaces(
+      std::map<boost::uuids::uuid, Place>& ts,
+      const std::map<boost::uuids::uuid, DataSource>& dataSources,
+      const std::map<boost::uuids::uuid, Node>& nodes,
+      std::string customPath = ""
+    );
+
+    virtual int getAgencies(
+      std::map<boost::uuids::uuid, Agency>& ts,
+      std::string customPath = ""
+    );
+
+    virtual int getServices(
+      std::map<boost::uuids::uuid, Service>& ts,
+      std::string customPath = ""
+    );
+
+    virtual int getNodes(
+      std::map<boost::uuids::uuid, Node>& ts,
+      std::string customPath = ""
+    );
+
+    virtual int getLines(
+      std::map<boost::uuids::uuid, Line>& ts,
+      const std::map<boost::uuids::uuid, Agency>& agencies,
+      const std::map<std::string, Mode>& modes,
+      std::string customPath = ""
+    );
+
+    virtual int getPaths(
+      std::map<boost::uuids::uuid, Path>& ts,
+      const std::map<boost::uuids::uuid, Line>& lines,
+      const std::map<boost::uuids::uuid, Node>& nodes,
+      std::string customPath = ""
+    );
+
+    virtual int getScenarios(
+      std::map<boost::uuids::uuid, Scenario>& ts,
+      const std::map<boost::uuids::uuid, Service>& services,
+      const std::map<boost::uuids::uuid, Line>& lines,
+      const std::map<boost::uuids::uuid, Agency>& agencies,
+      const std::map<boost::uuids::uuid, Node>& nodes,
+      const std::map<std::string, Mode>& modes,
+      std::string customPath = ""
+    );
+
+    virtual int getSchedules(
+      std::map<boost::uuids::uuid, Trip>& trips,
+      const std::map<boost::uuids::uuid, Line>& lines,
+      std::map<boost::uuids::uuid, Path>& paths,
+      const std::map<boost::uuids::uuid, Service>& services,
+      std::vector<Connection>& connections,
+      std::string customPath = ""
+    );
+
+    virtual bool getSortedConnectionsOrders(
+      std::vector<size_t>& forwardOrder,
+      std::vector<size_t>& reverseOrder
+    );
+
+    // Sections of the snapshot file, in the order they are written
+    enum class Section {
+      MODES = 0,
+      DATA_SOURCES,
+      HOUSEHOLDS,
+      PERSONS,
+      OD_TRIPS,
+      PLACES,
+      AGENCIES,
+      SERVICES,
+      NODES,
+      LINES,
+      PATHS,
+      SCENARIOS,
+      SCHEDULES,
+      CONNECTIONS_ORDERS,
+      SECTIONS_COUNT
+    };
+
+  private:
+    std::string snapshotFilePath;
+    const char *mappedData {nullptr};
+    size_t mappedSize {0};
+    int mapError {0};
+    // Offset and size of each section in the mapped file
+    std::vector<std::pair<size_t, size_t>> sections;
+
+    bool getSection(Section section, const char *&begin, const char *&end) const;
+  };
+
+}
+
+#endif // TR_SNAPSHOT_DATA_FETCHER
@@ -5,10 +5,16 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <optional>
 
 #include <boost/uuid/uuid.hpp>
 #include "connection.hpp"
 #include "connection_cache.hpp"
+#include "node_spatial_index.hpp"
+#include "service_calendar.hpp"
 
 
 namespace TrRouting {
@@ -52,25 +58,63 @@ namespace TrRouting {
 
   class TransitData {
   public:
-    TransitData(DataFetcher& dataFetcher, bool cacheAllScenarios = false);
+    /**
+     * @param cacheAllScenarios Keep the connection sets of all the queried scenarios
+     * @param connectionCacheMaxBytes If not caching all scenarios, keep the most recently
+     * used connection sets up to this size. With 0, only the last one is kept
+     * @param customCachePaths Custom path from which to read some caches, by cache name
+     */
+    TransitData(DataFetcher& dataFetcher, bool cacheAllScenarios = false, size_t connectionCacheMaxBytes = 0, const std::map<std::string, std::string> &customCachePaths = std::map<std::string, std::string>());
     virtual ~TransitData();
     DataStatus getDataStatus() const;
+    // Names of the caches, in the order they are loaded
+    static const std::vector<std::string> & getCacheNames();
     
     // const data access functions
     const std::map<std::string, Mode> & getModes() const {return modes;}
     const std::map<boost::uuids::uuid, DataSource> & getDataSources() const {return dataSources;}
+    const std::map<boost::uuids::uuid, Household> & getHouseholds() const {return households;}
     const std::map<boost::uuids::uuid, Person> & getPersons() const {return persons;}
     const std::map<boost::uuids::uuid, OdTrip> & getOdTrips() const {return odTrips;}
+    const std::map<boost::uuids::uuid, Place> & getPlaces() const {return places;}
     const std::map<boost::uuids::uuid, Agency> & getAgencies() const {return agencies;}
     const std::map<boost::uuids::uuid, Service> & getServices() const {return services;}
+    // Days on which each service is active
+    const ServiceCalendar & getServiceCalendar() const {return serviceCalendar;}
     const std::map<boost::uuids::uuid, Node> & getNodes() const {return nodes;}
+    // Grid index over the nodes, to find the nodes around a point
+    const NodeSpatialIndex & getNodesSpatialIndex() const {return nodesSpatialIndex;}
     const std::map<boost::uuids::uuid, Line> & getLines() const {return lines;}
     const std::map<boost::uuids::uuid, Path> & getPaths() const {return paths;}
     const std::map<boost::uuids::uuid, Scenario> & getScenarios() const {return scenarios;}
     const std::map<boost::uuids::uuid, Trip> & getTrips() const {return trips;}
     unsigned int getConnectionCount() const {return connections.size();}
+    const std::vector<Connection> & getConnections() const {return connections;}
+    const std::vector<std::reference_wrapper<const Connection>> & getForwardConnections() const;
+    const std::vector<std::reference_wrapper<const Connection>> & getReverseConnections() const;
+    // Incremented each time some data is updated, objects depending on the data can use it to know they are stale
+    unsigned int getDataVersion() const {return dataVersion;}
+    // Unique id of this object, a new TransitData replacing this one has a different id
+    unsigned int getInstanceId() const {return instanceId;}
+    // Highest uid of the objects of this data, to size the vectors indexed by uid
+    int getNodesMaxUid() const {return nodesMaxUid;}
+    int getLinesMaxUid() const {return linesMaxUid;}
+    int getPathsMaxUid() const {return pathsMaxUid;}
+    int getTripsMaxUid() const {return tripsMaxUid;}
 
-    std::shared_ptr<ConnectionSet> getConnectionsForScenario(const Scenario & scenario) const;
+    /**
+     * Get the connections of the scenario from the cache, or build them. When
+     * multiple threads request a scenario that is not in the cache, it is only
+     * built once and all of them get the same connection set. If a date is
+     * set, only the trips of the services active on that date are kept.
+     */
+    std::shared_ptr<ConnectionSet> getConnectionsForScenario(const Scenario & scenario, const std::optional<boost::gregorian::date> & date = std::nullopt) const;
+    // Build the connection sets of these scenarios in parallel, so that they are in the cache before they are queried
+    void warmupConnectionsForScenarios(const std::vector<std::reference_wrapper<const Scenario>> & scenariosToWarmup, unsigned int threadsCount) const;
+    // Number of connection sets built since this object was created
+    unsigned int getConnectionSetBuildCount() const {return connectionSetBuildCount;}
+    // Content and hit counters of the connection sets cache
+    ScenarioConnectionCacheStats getConnectionCacheStats() const {return scenarioConnectionCache->getStats();}
 
     /**
      * The update* methods get the data from the data fetcher
@@ -82,12 +126,10 @@ namespace TrRouting {
      * -(error codes from the open system call)
      */
     int updateDataSources(std::string customPath = "");
-    // TODO #167
-    //int updateHouseholds(std::string customPath = "");
+    int updateHouseholds(std::string customPath = "");
     int updatePersons(std::string customPath = "");
     int updateOdTrips(std::string customPath = "");
-    // TODO #167
-    //int updatePlaces(std::string customPath = "");
+    int updatePlaces(std::string customPath = "");
 
     int updateStations(std::string customPath = "");
     int updateAgencies(std::string customPath = "");
@@ -99,15 +141,23 @@ namespace TrRouting {
     int updateSchedules(std::string customPath = "");
     
   protected:
-    DataStatus loadAllData();
+    DataStatus loadAllData(const std::map<std::string, std::string> &customCachePaths);
     int generateForwardAndReverseConnections();
+    std::shared_ptr<ConnectionSet> buildConnectionsForScenario(const Scenario & scenario, const std::optional<boost::gregorian::date> & date) const;
 
     DataFetcher &dataFetcher;
+    std::atomic<unsigned int> dataVersion;
+    inline static std::atomic<unsigned int> lastInstanceId {0};
+    unsigned int instanceId;
+    // Whether a cache could not be read when loading the data
+    bool dataReadError {false};
 
     std::map<std::string, Mode>              modes;
     std::map<boost::uuids::uuid, DataSource> dataSources;
+    std::map<boost::uuids::uuid, Household>  households;
     std::map<boost::uuids::uuid, Person>     persons;
     std::map<boost::uuids::uuid, OdTrip>     odTrips;
+    std::map<boost::uuids::uuid, Place>      places;
     std::map<boost::uuids::uuid, Agency>     agencies;
     std::map<boost::uuids::uuid, Service>    services;
     std::map<boost::uuids::uuid, Node>       nodes;
@@ -116,12 +166,24 @@ namespace TrRouting {
     std::map<boost::uuids::uuid, Scenario>   scenarios;
     std::map<boost::uuids::uuid, Trip>       trips;
 
+    int nodesMaxUid {0};
+    int linesMaxUid {0};
+    int pathsMaxUid {0};
+    int tripsMaxUid {0};
+
+    NodeSpatialIndex nodesSpatialIndex;
+    ServiceCalendar serviceCalendar;
+
     std::vector<Connection> connections;
-    std::vector<std::reference_wrapper<const Connection>> forwardConnections; // Forward connections, sorted by departure time ascending
-    std::vector<std::reference_wrapper<const Connection>> reverseConnections; // Reverse connections, sorted by arrival time descending
+    // All the sorted connections, the scenarios' connection sets are masks over its connections
+    std::shared_ptr<const ConnectionSet> allConnections;
 
     //TODO Consider using a reference instead, making sure the object is always valid
     mutable ScenarioConnectionCache *scenarioConnectionCache;
+    // Connection sets being built, other threads requesting the same scenario wait for their result
+    mutable std::mutex pendingConnectionSetsMutex;
+    mutable std::map<boost::uuids::uuid, std::shared_future<std::shared_ptr<ConnectionSet>>> pendingConnectionSets;
+    mutable std::atomic<unsigned int> connectionSetBuildCount {0};
   };
 
 }
@@ -0,0 +1,89 @@
+#ifndef TR_TRANSIT_DATA_HOLDER
+#define TR_TRANSIT_DATA_HOLDER
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include "transit_data.hpp"
+
+namespace TrRouting
+{
+  class DataFetcher;
+
+  /**
+   * @brief Publishes the current TransitData to the server threads
+   *
+   * The published data is never modified. A reload builds a complete new
+   * TransitData, then swaps it atomically with the current one. Requests get
+   * the current data once when they start and keep their reference until
+   * they end, so in-flight requests continue on the previous data, which is
+   * deleted when its last reader is done.
+   *
+   * Caches read from a custom path are read from the same path again by the
+   * following reloads, until they are reloaded from another path.
+   */
+  class TransitDataHolder {
+
+  public:
+    TransitDataHolder(DataFetcher &_dataFetcher, bool _cacheAllScenarios = false, size_t _connectionCacheMaxBytes = 0);
+
+    // Get the current data. The caller should keep the pointer for the whole duration of a request
+    std::shared_ptr<const TransitData> get() const { return std::atomic_load(&transitData); }
+
+    /**
+     * Load a new TransitData from the data fetcher, with the caches from a
+     * custom path of the previous reloads, and publish it. The
+     * updateNewData function, if set, can update the new data before it is
+     * published, for example from a custom path. New data that is not ready
+     * is not published, unless the current data is not ready either.
+     * Concurrent reloads are serialized.
+     *
+     * @return The status of the new data
+     */
+    DataStatus reload(const std::function<void(TransitData &)> &updateNewData = nullptr);
+
+    /**
+     * Reload the data, reading these caches from the custom path, or from the
+     * data fetcher if the path is empty. The "all" name is for all caches.
+     * The custom paths are kept for the next reloads once the new data is
+     * published. The new data is not ready if a custom cache cannot be read.
+     *
+     * @return The status of the new data
+     */
+    DataStatus reloadCaches(const std::vector<std::string> &cacheNames, const std::string &customPath);
+
+    // Whether a cache can be reloaded from a custom path
+    static bool isCacheName(const std::string &cacheName);
+    // Custom path of each cache that is not read from the data fetcher
+    std::map<std::string, std::string> getCustomCachePaths();
+
+    // Number of times a new data was published, after the initial one
+    unsigned int getPublishedCount() const { return publishedCount; }
+    // Time to build the last reloaded data and to publish it, in microseconds
+    long long getLastBuildDurationMicroseconds() const { return lastBuildDuration; }
+    long long getLastPublishDurationMicroseconds() const { return lastPublishDuration; }
+
+  private:
+    // Build a new data, with these caches from a custom path, and publish it if it is ready. The buildNewData function returns the status of the new data
+    DataStatus reloadLocked(const std::map<std::string, std::string> &cachePaths, const std::function<DataStatus(TransitData &)> &buildNewData);
+
+    DataFetcher &dataFetcher;
+    bool cacheAllScenarios;
+    size_t connectionCacheMaxBytes;
+    // Only accessed with the std::atomic_* functions for shared_ptr
+    std::shared_ptr<const TransitData> transitData;
+    std::mutex reloadMutex;
+    // Guarded by the reload mutex
+    std::map<std::string, std::string> customCachePaths;
+    std::atomic<unsigned int> publishedCount {0};
+    std::atomic<long long> lastBuildDuration {0};
+    std::atomic<long long> lastPublishDuration {0};
+  };
+
+}
+
+#endif // TR_TRANSIT_DATA_HOLDER
@@ -1,14 +1,17 @@
 #ifndef TR_TRIP
 #define TR_TRIP
 
+#include <atomic>
 #include <boost/uuid/uuid.hpp>
 #include <vector>
+#include <optional>
 #include "toolbox.hpp" //MAX_INT
 
 namespace TrRouting
 {
   class Mode;
   class Agency;
+  class Line;
   class Service;
   class Path;
   class Connection;
@@ -55,9 +58,10 @@ namespace TrRouting
     inline bool operator==(const Trip& other ) const { return uuid == other.uuid; }
 
     static uid_t getMaxUid() { return global_uid; }
+    static void resetUids() { global_uid = 0; }
   private:
     //TODO, this could probably be an unsigned long, but current MAX_INT is good enough for our needs
-    inline static uid_t global_uid = 0;    
+    inline static std::atomic<uid_t> global_uid {0};
   };
   inline bool operator==(const std::reference_wrapper<const TrRouting::Trip>& lhs, const std::reference_wrapper<const Trip>& rhs)
   {
@@ -0,0 +1,71 @@
+#ifndef TR_TRIP_FILTER
+#define TR_TRIP_FILTER
+
+#include <vector>
+#include <functional>
+
+namespace TrRouting
+{
+  class Trip;
+  class Service;
+  class Line;
+  class Mode;
+  class Agency;
+
+  /**
+   * @brief Only/except filters on the services, lines, modes and agencies of
+   * trips, compiled into bitsets indexed by the uid of each object.
+   *
+   * The filter lists are read only once at construction, so testing a trip is
+   * a constant number of bit lookups, whatever the size of the lists.
+   */
+  class TripFilter {
+
+  public:
+    TripFilter(const std::vector<std::reference_wrapper<const Service>> &onlyServices,
+               const std::vector<std::reference_wrapper<const Service>> &exceptServices,
+               const std::vector<std::reference_wrapper<const Line>> &onlyLines,
+               const std::vector<std::reference_wrapper<const Line>> &exceptLines,
+               const std::vector<std::reference_wrapper<const Mode>> &onlyModes,
+               const std::vector<std::reference_wrapper<const Mode>> &exceptModes,
+               const std::vector<std::reference_wrapper<const Agency>> &onlyAgencies,
+               const std::vector<std::reference_wrapper<const Agency>> &exceptAgencies);
+
+    bool isTripEnabled(const Trip &trip) const;
+
+    /**
+     * Evaluate the filter on a list of trips. The returned bitset is indexed
+     * by Trip::uid, up to the highest uid of the trips, and has a bit set
+     * for each trip rejected by the filter.
+     */
+    std::vector<bool> getDisabledTrips(const std::vector<std::reference_wrapper<const Trip>> &trips) const;
+
+  private:
+    // Empty when there is no filter on this field
+    typedef std::vector<bool> UidBitset;
+
+    UidBitset onlyServices;
+    UidBitset exceptServices;
+    UidBitset onlyLines;
+    UidBitset exceptLines;
+    UidBitset onlyModes;
+    UidBitset exceptModes;
+    UidBitset onlyAgencies;
+    UidBitset exceptAgencies;
+
+    template <class T>
+    static UidBitset toBitset(const std::vector<std::reference_wrapper<const T>> &objects);
+
+    static bool contains(const UidBitset &bitset, int uid) {
+      return (size_t)uid < bitset.size() && bitset[uid];
+    }
+
+    // A trip passes an only filter if the filter is empty or contains its uid
+    static bool passesOnly(const UidBitset &bitset, int uid) {
+      return bitset.empty() || contains(bitset, uid);
+    }
+  };
+
+}
+
+#endif // TR_TRIP_FILTER
@@ -12,7 +12,7 @@
 #include "spdlog/spdlog.h"
 
 #include <capnp/message.h>
-#include <capnp/serialize-packed.h>
+#include "cache_file_reader.hpp"
 
 #include "cache_fetcher.hpp"
 #include "agency.hpp"
@@ -62,7 +62,7 @@ namespace TrRouting
 
     try
     {
-      ::capnp::PackedFdMessageReader capnpTCollectionMessage(fd, {16 * 1024 * 1024});
+      CacheFileReader capnpTCollectionMessage(fd, {16 * 1024 * 1024});
       TCollection::Reader capnpTCollection = capnpTCollectionMessage.getRoot<TCollection>();
       for (cT::Reader capnpT : capnpTCollection.getAgencies())
       {
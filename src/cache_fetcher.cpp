@@ -1,26 +1,39 @@
 #include <fstream>
 #include <fcntl.h>
+#include <capnp/serialize.h>
 #include <capnp/serialize-packed.h>
+#include <unistd.h>
 #include "spdlog/spdlog.h"
 #include "cache_fetcher.hpp"
+#include "cache_file_reader.hpp"
 #include "parameters.hpp"
 
 namespace TrRouting
 {
-  CacheFetcher::CacheFetcher(const std::string &cacheDir)
-    : cacheDirectoryPath(cacheDir) {
+  CacheFetcher::CacheFetcher(const std::string &cacheDir, unsigned int _loadingThreadsCount)
+    : cacheDirectoryPath(cacheDir), loadingThreadsCount(_loadingThreadsCount) {
   }
   CacheFetcher::~CacheFetcher() {}
 
   template<class T>
-  void CacheFetcher::saveToCapnpCacheFile(T& data, std::string cacheFilePath) {
+  void CacheFetcher::saveToCapnpCacheFile(T& data, std::string cacheFilePath, bool mappable) {
     std::ofstream oCacheFile;
     oCacheFile.open(cacheFilePath, std::ios::out | std::ios::trunc | std::ios::binary);
     oCacheFile.close();
     int fd = open(cacheFilePath.c_str(), O_WRONLY);
-    ::capnp::writePackedMessageToFd(fd, data);
+    if (mappable) {
+      if (write(fd, MAPPABLE_CACHE_FILE_HEADER, sizeof(MAPPABLE_CACHE_FILE_HEADER)) != (ssize_t)sizeof(MAPPABLE_CACHE_FILE_HEADER)) {
+        spdlog::error("Error writing cache file header {}", cacheFilePath);
+        close(fd);
+        return;
+      }
+      ::capnp::writeMessageToFd(fd, data);
+    } else {
+      ::capnp::writePackedMessageToFd(fd, data);
+    }
     close(fd);
   }
+  template void CacheFetcher::saveToCapnpCacheFile<::capnp::MallocMessageBuilder>(::capnp::MallocMessageBuilder& data, std::string cacheFilePath, bool mappable);
 
   bool CacheFetcher::capnpCacheFileExists(std::string cacheFilePath) {
     std::ifstream iCacheFile;
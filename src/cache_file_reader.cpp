@@ -0,0 +1,61 @@
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <capnp/serialize.h>
+#include <capnp/serialize-packed.h>
+#include "spdlog/spdlog.h"
+#include "cache_file_reader.hpp"
+
+namespace TrRouting
+{
+
+  CacheFileReader::CacheFileReader(int fd, ::capnp::ReaderOptions options)
+  {
+    char header[sizeof(MAPPABLE_CACHE_FILE_HEADER)];
+    struct stat fileStat;
+    bool isMappable = fstat(fd, &fileStat) == 0 &&
+      (size_t)fileStat.st_size > sizeof(header) &&
+      pread(fd, header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+      memcmp(header, MAPPABLE_CACHE_FILE_HEADER, sizeof(header)) == 0;
+
+    if (isMappable)
+    {
+      void *data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED)
+      {
+        mappedData = data;
+        mappedSize = fileStat.st_size;
+        // The mapping is page aligned and the header is one word, so the message is word aligned
+        const ::capnp::word *words = reinterpret_cast<const ::capnp::word *>(static_cast<const char *>(mappedData) + sizeof(header));
+        size_t wordsCount = (mappedSize - sizeof(header)) / sizeof(::capnp::word);
+        try {
+          messageReader = std::make_unique<::capnp::FlatArrayMessageReader>(kj::arrayPtr(words, wordsCount), options);
+        } catch (...) {
+          // The destructor is not called when the constructor throws
+          munmap(mappedData, mappedSize);
+          throw;
+        }
+        return;
+      }
+      spdlog::warn("Could not map cache file in memory ({}), reading it instead", errno);
+      lseek(fd, sizeof(header), SEEK_SET);
+      messageReader = std::make_unique<::capnp::StreamFdMessageReader>(fd, options);
+      return;
+    }
+
+    messageReader = std::make_unique<::capnp::PackedFdMessageReader>(fd, options);
+  }
+
+  CacheFileReader::~CacheFileReader()
+  {
+    // The message reader references the mapped data, release it first
+    messageReader.reset();
+    if (mappedData != nullptr)
+    {
+      munmap(mappedData, mappedSize);
+    }
+  }
+
+}
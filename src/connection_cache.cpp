@@ -10,8 +10,10 @@ namespace TrRouting {
   std::optional<std::shared_ptr<ConnectionSet>> ScenarioConnectionCacheOne::get(boost::uuids::uuid uuid) const {
     std::shared_lock lock(mutex); //Sharing lock when reading
     if (uuid == lastUuid) {
+      hits++;
       return std::optional(lastConnection);
     } else {
+      misses++;
       return std::nullopt;
     }
   }
@@ -22,14 +24,28 @@ namespace TrRouting {
     lastConnection = cache;
   }
 
+  ScenarioConnectionCacheStats ScenarioConnectionCacheOne::getStats() const {
+    std::shared_lock lock(mutex);
+    ScenarioConnectionCacheStats stats;
+    if (lastConnection) {
+      stats.count = 1;
+      stats.sizeBytes = lastConnection->getMemorySize();
+    }
+    stats.hits = hits;
+    stats.misses = misses;
+    return stats;
+  }
+
   // ScenarioConnectionCacheAll
   std::optional<std::shared_ptr<ConnectionSet>> ScenarioConnectionCacheAll::get(boost::uuids::uuid uuid) const {
     std::shared_lock lock(mutex); //Sharing lock when reading
     // Lookup the scenario uuid in the map. If found, returns it, if not, return a null_opt
     auto connectionSetItr = connectionSets.find(uuid);
     if (connectionSetItr != connectionSets.end()) {
+      hits++;
       return std::optional(connectionSetItr->second);
     } else {
+      misses++;
       return std::nullopt;
     }
   }
@@ -39,4 +55,76 @@ namespace TrRouting {
     std::unique_lock lock(mutex); //Exclusive lock when writing
     connectionSets[uuid] = cache;
   }
+
+  ScenarioConnectionCacheStats ScenarioConnectionCacheAll::getStats() const {
+    std::shared_lock lock(mutex);
+    ScenarioConnectionCacheStats stats;
+    stats.count = connectionSets.size();
+    for (auto & connectionSetIte : connectionSets) {
+      stats.sizeBytes += connectionSetIte.second->getMemorySize();
+    }
+    stats.hits = hits;
+    stats.misses = misses;
+    return stats;
+  }
+
+  // ScenarioConnectionCacheLru
+  std::optional<std::shared_ptr<ConnectionSet>> ScenarioConnectionCacheLru::get(boost::uuids::uuid uuid) const {
+    std::lock_guard lock(mutex);
+    auto connectionSetItr = connectionSets.find(uuid);
+    if (connectionSetItr == connectionSets.end()) {
+      misses++;
+      return std::nullopt;
+    }
+    hits++;
+    // Move to the front of the recent uses
+    recentUses.splice(recentUses.begin(), recentUses, connectionSetItr->second.recentUse);
+    return std::optional(connectionSetItr->second.connectionSet);
+  }
+
+  void ScenarioConnectionCacheLru::set(boost::uuids::uuid uuid, std::shared_ptr<ConnectionSet> cache) {
+    size_t cacheSizeBytes = cache->getMemorySize();
+    std::lock_guard lock(mutex);
+    auto connectionSetItr = connectionSets.find(uuid);
+    if (connectionSetItr != connectionSets.end()) {
+      sizeBytes -= connectionSetItr->second.sizeBytes;
+      recentUses.erase(connectionSetItr->second.recentUse);
+      connectionSets.erase(connectionSetItr);
+    }
+    recentUses.push_front(uuid);
+    connectionSets[uuid] = CacheEntry{cache, cacheSizeBytes, recentUses.begin()};
+    sizeBytes += cacheSizeBytes;
+
+    // Evict the least recently used sets, but keep the one just added
+    while (sizeBytes > maxSizeBytes && recentUses.size() > 1) {
+      auto evictedItr = connectionSets.find(recentUses.back());
+      spdlog::debug("Evicting connection set for scenario {} ({} bytes)", boost::uuids::to_string(evictedItr->first), evictedItr->second.sizeBytes);
+      sizeBytes -= evictedItr->second.sizeBytes;
+      connectionSets.erase(evictedItr);
+      recentUses.pop_back();
+      evictions++;
+    }
+    spdlog::debug("Caching connection set for scenario {} ({} bytes), {} sets use {} bytes", boost::uuids::to_string(uuid), cacheSizeBytes, connectionSets.size(), sizeBytes);
+  }
+
+  size_t ScenarioConnectionCacheLru::getSizeBytes() const {
+    std::lock_guard lock(mutex);
+    return sizeBytes;
+  }
+
+  size_t ScenarioConnectionCacheLru::getCount() const {
+    std::lock_guard lock(mutex);
+    return connectionSets.size();
+  }
+
+  ScenarioConnectionCacheStats ScenarioConnectionCacheLru::getStats() const {
+    std::lock_guard lock(mutex);
+    ScenarioConnectionCacheStats stats;
+    stats.count = connectionSets.size();
+    stats.sizeBytes = sizeBytes;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    return stats;
+  }
 }
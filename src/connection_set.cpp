@@ -1,15 +1,91 @@
 #include "connection_set.hpp"
 #include "spdlog/spdlog.h"
 #include "connection.hpp"
+#include "node.hpp"
+#include "line.hpp"
+#include "trip.hpp"
 
 
 namespace TrRouting {
 
+  PackedConnections::PackedConnections(const std::vector<std::reference_wrapper<const Connection>> & connections)
+  {
+    size_t count = connections.size();
+    departureNodeUids.reserve(count);
+    arrivalNodeUids.reserve(count);
+    departureTimes.reserve(count);
+    arrivalTimes.reserve(count);
+    tripUids.reserve(count);
+    flags.reserve(count);
+    minWaitingTimesSeconds.reserve(count);
+
+    for (const Connection & connection : connections)
+    {
+      departureNodeUids.push_back(connection.getDepartureNode().uid);
+      arrivalNodeUids.push_back(connection.getArrivalNode().uid);
+      departureTimes.push_back(connection.getDepartureTime());
+      arrivalTimes.push_back(connection.getArrivalTime());
+      tripUids.push_back(connection.getTrip().uid);
+
+      uint8_t connectionFlags = 0;
+      if (connection.canBoard()) {
+        connectionFlags |= CAN_BOARD;
+      }
+      if (connection.canUnboard()) {
+        connectionFlags |= CAN_UNBOARD;
+      }
+      if (connection.getMinWaitingTime() >= 0) {
+        connectionFlags |= HAS_MIN_WAITING_TIME;
+      }
+      flags.push_back(connectionFlags);
+      minWaitingTimesSeconds.push_back(connection.getMinWaitingTime());
+    }
+  }
+
+  size_t PackedConnections::getMemorySize() const
+  {
+    return departureNodeUids.capacity() * sizeof(int32_t) +
+      arrivalNodeUids.capacity() * sizeof(int32_t) +
+      departureTimes.capacity() * sizeof(int32_t) +
+      arrivalTimes.capacity() * sizeof(int32_t) +
+      tripUids.capacity() * sizeof(int32_t) +
+      flags.capacity() * sizeof(uint8_t) +
+      minWaitingTimesSeconds.capacity() * sizeof(int16_t);
+  }
+
+  ConnectionMask::ConnectionMask(size_t _bitsCount, bool allSet) :
+    words((_bitsCount + 63) / 64, allSet ? ~(uint64_t)0 : 0),
+    bitsCount(_bitsCount),
+    setCount(allSet ? _bitsCount : 0)
+  {
+    // Clear the bits past the end, so the scans never return them
+    if (allSet && (bitsCount & 63) != 0) {
+      words.back() = ((uint64_t)1 << (bitsCount & 63)) - 1;
+    }
+  }
+
+  size_t ConnectionSet::getMemorySize() const
+  {
+    return sizeof(ConnectionSet) +
+      trips.capacity() * sizeof(std::reference_wrapper<const Trip>) +
+      forwardConnections.capacity() * sizeof(std::reference_wrapper<const Connection>) +
+      reverseConnections.capacity() * sizeof(std::reference_wrapper<const Connection>) +
+      forwardPackedConnections.getMemorySize() +
+      reversePackedConnections.getMemorySize() +
+      forwardMask.getMemorySize() +
+      reverseMask.getMemorySize() +
+      forwardConnectionsBeginIteratorCache.capacity() * sizeof(std::vector<std::reference_wrapper<const Connection>>::const_iterator) +
+      reverseConnectionsBeginIteratorCache.capacity() * sizeof(std::vector<std::reference_wrapper<const Connection>>::const_iterator);
+  }
+
   const int CONNECTION_ITERATOR_CACHE_BEGIN_HOUR = 0;
   const int CONNECTION_ITERATOR_CACHE_END_HOUR = 32;
 
   std::vector<std::reference_wrapper<const Connection>>::const_iterator ConnectionSet::getForwardConnectionsBeginAtDepartureHour(int hour) const
   {
+    if (baseSet) {
+      return baseSet->getForwardConnectionsBeginAtDepartureHour(hour);
+    }
     if (hour > CONNECTION_ITERATOR_CACHE_END_HOUR || hour  < CONNECTION_ITERATOR_CACHE_BEGIN_HOUR) {
       return forwardConnections.cend();
     }
@@ -19,6 +95,9 @@ namespace TrRouting {
 
   std::vector<std::reference_wrapper<const Connection>>::const_iterator ConnectionSet::getReverseConnectionsBeginAtArrivalHour(int hour) const
   {
+    if (baseSet) {
+      return baseSet->getReverseConnectionsBeginAtArrivalHour(hour);
+    }
     if (hour < CONNECTION_ITERATOR_CACHE_BEGIN_HOUR) {
       return reverseConnections.cend();
     } else if (hour > CONNECTION_ITERATOR_CACHE_END_HOUR - 1) {
@@ -74,11 +153,31 @@ namespace TrRouting {
   }
 
   ConnectionSet::ConnectionSet(
-    const std::vector<std::reference_wrapper<const Trip>> _trips,
-    const std::vector<std::reference_wrapper<const Connection>> _forwardConnections,
-    const std::vector<std::reference_wrapper<const Connection>> _reverseConnections
-  ): trips(_trips), forwardConnections(_forwardConnections), reverseConnections(_reverseConnections) {
+    std::vector<std::reference_wrapper<const Trip>> _trips,
+    std::vector<std::reference_wrapper<const Connection>> _forwardConnections,
+    std::vector<std::reference_wrapper<const Connection>> _reverseConnections
+  ): trips(std::move(_trips)),
+     forwardConnections(std::move(_forwardConnections)),
+     reverseConnections(std::move(_reverseConnections)),
+     forwardPackedConnections(forwardConnections),
+     reversePackedConnections(reverseConnections),
+     forwardMask(forwardConnections.size(), true),
+     reverseMask(reverseConnections.size(), true) {
     generateConnectionsIteratorCache();
   }
 
-}
\ No newline at end of file
+  ConnectionSet::ConnectionSet(
+    std::shared_ptr<const ConnectionSet> _baseSet,
+    std::vector<std::reference_wrapper<const Trip>> _trips,
+    ConnectionMask _forwardMask,
+    ConnectionMask _reverseMask
+  ): baseSet(std::move(_baseSet)),
+     trips(std::move(_trips)),
+     forwardPackedConnections(forwardConnections),
+     reversePackedConnections(reverseConnections),
+     forwardMask(std::move(_forwardMask)),
+     reverseMask(std::move(_reverseMask)) {
+    // The hour caches are the base set's
+  }
+
+}
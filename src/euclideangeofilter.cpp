@@ -1,6 +1,7 @@
 #include "euclideangeofilter.hpp"
 #include "point.hpp"
 #include "node.hpp"
+#include "node_spatial_index.hpp"
 #include "spdlog/spdlog.h"
 
 namespace TrRouting
@@ -10,7 +11,7 @@ namespace TrRouting
 
 
   std::vector<NodeTimeDistance> EuclideanGeoFilter::getAccessibleNodesFootpathsFromPoint(const Point &point,
-                                                                                         const std::map<boost::uuids::uuid, Node> &nodes,
+                                                                                         const NodeSpatialIndex &nodesIndex,
                                                                                          int maxWalkingTravelTime,
                                                                                          float walkingSpeedMetersPerSecond,
                                                                                          bool /*Unused reversed*/) {
@@ -22,7 +23,7 @@ namespace TrRouting
 
     spdlog::debug("use of bird distance ");
 
-    for (auto &&[uuid,node] : nodes)
+    for (const Node & node : getCandidateNodes(point, nodesIndex, maxDistanceMetersSquared, lengthOfOneDegree))
     {
       distanceMetersSquared = calculateNodeDistanceSquared(node.point.get(), point, lengthOfOneDegree);
 
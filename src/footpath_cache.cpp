@@ -0,0 +1,108 @@
+#include <cmath>
+#include <boost/functional/hash.hpp>
+
+#include "footpath_cache.hpp"
+#include "point.hpp"
+#include "node.hpp"
+#include "spdlog/spdlog.h"
+
+namespace TrRouting
+{
+
+  FootpathCacheKey::FootpathCacheKey(const std::string &_mode, const Point &point, int _maxWalkingTravelTime, float _walkingSpeedMetersPerSecond, bool _reversed) :
+    mode(_mode),
+    quantizedLatitude(std::llround(point.latitude * COORDINATES_PER_DEGREE)),
+    quantizedLongitude(std::llround(point.longitude * COORDINATES_PER_DEGREE)),
+    maxWalkingTravelTime(_maxWalkingTravelTime),
+    walkingSpeedMetersPerSecond(_walkingSpeedMetersPerSecond),
+    reversed(_reversed)
+  {
+  }
+
+  bool FootpathCacheKey::operator==(const FootpathCacheKey &other) const
+  {
+    return quantizedLatitude == other.quantizedLatitude &&
+      quantizedLongitude == other.quantizedLongitude &&
+      maxWalkingTravelTime == other.maxWalkingTravelTime &&
+      walkingSpeedMetersPerSecond == other.walkingSpeedMetersPerSecond &&
+      reversed == other.reversed &&
+      mode == other.mode;
+  }
+
+  size_t FootpathCacheKeyHash::operator()(const FootpathCacheKey &key) const
+  {
+    size_t seed = 0;
+    boost::hash_combine(seed, key.quantizedLatitude);
+    boost::hash_combine(seed, key.quantizedLongitude);
+    boost::hash_combine(seed, key.maxWalkingTravelTime);
+    boost::hash_combine(seed, key.walkingSpeedMetersPerSecond);
+    boost::hash_combine(seed, key.reversed);
+    boost::hash_combine(seed, key.mode);
+    return seed;
+  }
+
+  bool FootpathCache::useNodesBuild(unsigned int nodesBuildId)
+  {
+    // Build ids only increase, the cache never goes back to the nodes of a previous data
+    if (nodesBuildId < cachedNodesBuildId) {
+      return false;
+    }
+    if (nodesBuildId > cachedNodesBuildId) {
+      entriesByKey.clear();
+      entries.clear();
+      cachedNodesBuildId = nodesBuildId;
+    }
+    return true;
+  }
+
+  std::optional<std::vector<NodeTimeDistance>> FootpathCache::get(const FootpathCacheKey &key, unsigned int nodesBuildId)
+  {
+    if (capacity == 0) {
+      return std::nullopt;
+    }
+    std::lock_guard lock(mutex);
+    if (!useNodesBuild(nodesBuildId)) {
+      misses++;
+      return std::nullopt;
+    }
+    auto entryIte = entriesByKey.find(key);
+    if (entryIte == entriesByKey.end()) {
+      misses++;
+      return std::nullopt;
+    }
+    hits++;
+    // Move the entry to the front, as the most recently used
+    entries.splice(entries.begin(), entries, entryIte->second);
+    return entryIte->second->second;
+  }
+
+  void FootpathCache::set(const FootpathCacheKey &key, unsigned int nodesBuildId, const std::vector<NodeTimeDistance> &footpaths)
+  {
+    if (capacity == 0) {
+      return;
+    }
+    std::lock_guard lock(mutex);
+    if (!useNodesBuild(nodesBuildId)) {
+      return;
+    }
+    auto entryIte = entriesByKey.find(key);
+    if (entryIte != entriesByKey.end()) {
+      // Another thread fetched the same footpaths in the meantime, they should be the same
+      entries.splice(entries.begin(), entries, entryIte->second);
+      return;
+    }
+    entries.emplace_front(key, footpaths);
+    entriesByKey.emplace(key, entries.begin());
+    if (entries.size() > capacity) {
+      entriesByKey.erase(entries.back().first);
+      entries.pop_back();
+    }
+  }
+
+  size_t FootpathCache::size() const
+  {
+    std::lock_guard lock(mutex);
+    return entries.size();
+  }
+
+}
@@ -1,6 +1,7 @@
 #include "geofilter.hpp"
 #include "point.hpp"
 #include "node.hpp"
+#include "node_spatial_index.hpp"
 
 namespace TrRouting
 {
@@ -27,4 +28,11 @@ namespace TrRouting
     return distanceMetersSquared;
   }
 
+  std::vector<std::reference_wrapper<const Node>> GeoFilter::getCandidateNodes(const Point &point, const NodeSpatialIndex &nodesIndex, float maxDistanceMetersSquared, const std::tuple<float, float> &lengthOfOneDegree)
+  {
+    // Slightly enlarge the bounding box, so float rounding does not exclude nodes at the max distance
+    double maxDistanceMeters = sqrt(maxDistanceMetersSquared) * 1.001 + 1.0;
+    return nodesIndex.getNodesInBoundingBox(point, maxDistanceMeters / std::get<0>(lengthOfOneDegree), maxDistanceMeters / std::get<1>(lengthOfOneDegree));
+  }
+
 }
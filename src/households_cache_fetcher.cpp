@@ -8,7 +8,7 @@
 #include <fcntl.h>
 #include <kj/exception.h>
 #include <boost/uuid/string_generator.hpp>
-#include <capnp/serialize-packed.h>
+#include "cache_file_reader.hpp"
 #include "cache_fetcher.hpp"
 #include "household.hpp"
 #include "point.hpp"
@@ -20,10 +20,9 @@ namespace TrRouting
 {
 
   int CacheFetcher::getHouseholds(
-    std::vector<std::unique_ptr<Household>>& ts,
-    std::map<boost::uuids::uuid, int>& tIndexesByUuid,
-    const std::map<boost::uuids::uuid, int>& dataSourceIndexesByUuid,
-    const std::map<boost::uuids::uuid, int>& nodeIndexesByUuid,
+    std::map<boost::uuids::uuid, Household>& ts,
+    const std::map<boost::uuids::uuid, DataSource>& dataSources,
+    const std::map<boost::uuids::uuid, Node>& nodes,
     std::string customPath
   )
   {
@@ -37,14 +36,13 @@ namespace TrRouting
     std::string TStr  = "Households";
 
     ts.clear();
-    tIndexesByUuid.clear();
 
     std::string cacheFileName{tStr};
     boost::uuids::string_generator uuidGenerator;
 
     spdlog::info("Fetching {} from cache... {}", tStr, customPath);
 
-    for(std::map<boost::uuids::uuid, int>::const_iterator iter = dataSourceIndexesByUuid.begin(); iter != dataSourceIndexesByUuid.end(); ++iter)
+    for(std::map<boost::uuids::uuid, DataSource>::const_iterator iter = dataSources.begin(); iter != dataSources.end(); ++iter)
     {
       boost::uuids::uuid dataSourceUuid = iter->first;
 
@@ -76,64 +74,63 @@ namespace TrRouting
 
         try
         {
-          ::capnp::PackedFdMessageReader capnpTCollectionMessage(fd, {64 * 1024 * 1024});
+          CacheFileReader capnpTCollectionMessage(fd, {64 * 1024 * 1024});
           TCollection::Reader capnpTCollection = capnpTCollectionMessage.getRoot<TCollection>();
           for (cT::Reader capnpT : capnpTCollection.getHouseholds())
           {
-            std::string uuid           {capnpT.getUuid()};
-            std::string dataSourceUuid {capnpT.getDataSourceUuid()};
-            std::unique_ptr<Point> point = std::make_unique<Point>();
-            std::unique_ptr<T>     t     = std::make_unique<T>();
-            t->uuid            = uuidGenerator(uuid);
-            t->id              = capnpT.getId();
-            t->expansionFactor = capnpT.getExpansionFactor();
-            t->size            = capnpT.getSize();
-            t->carNumber       = capnpT.getCarNumber();
-            t->incomeLevel     = capnpT.getIncomeLevel();
-            t->internalId      = capnpT.getInternalId();
-            t->dataSourceIdx   = dataSourceUuid.length() > 0 ? dataSourceIndexesByUuid.at(uuidGenerator(dataSourceUuid)) : -1;
+            std::string uuid              {capnpT.getUuid()};
+            std::string dataSourceUuidStr {capnpT.getDataSourceUuid()};
 
+            std::string incomeLevelGroup;
             switch (capnpT.getIncomeLevelGroup()) {
-              case household::Household::IncomeLevelGroup::NONE      : t->incomeLevelGroup = "none";     break;
-              case household::Household::IncomeLevelGroup::VERY_LOW  : t->incomeLevelGroup = "veryLow";  break;
-              case household::Household::IncomeLevelGroup::LOW       : t->incomeLevelGroup = "low";      break;
-              case household::Household::IncomeLevelGroup::MEDIUM    : t->incomeLevelGroup = "medium";   break;
-              case household::Household::IncomeLevelGroup::HIGH      : t->incomeLevelGroup = "high";     break;
-              case household::Household::IncomeLevelGroup::VERY_HIGH : t->incomeLevelGroup = "veryHigh"; break;
-              case household::Household::IncomeLevelGroup::UNKNOWN   : t->incomeLevelGroup = "unknown";  break;
+              case household::Household::IncomeLevelGroup::NONE      : incomeLevelGroup = "none";     break;
+              case household::Household::IncomeLevelGroup::VERY_LOW  : incomeLevelGroup = "veryLow";  break;
+              case household::Household::IncomeLevelGroup::LOW       : incomeLevelGroup = "low";      break;
+              case household::Household::IncomeLevelGroup::MEDIUM    : incomeLevelGroup = "medium";   break;
+              case household::Household::IncomeLevelGroup::HIGH      : incomeLevelGroup = "high";     break;
+              case household::Household::IncomeLevelGroup::VERY_HIGH : incomeLevelGroup = "veryHigh"; break;
+              case household::Household::IncomeLevelGroup::UNKNOWN   : incomeLevelGroup = "unknown";  break;
             }
 
+            std::string category;
             switch (capnpT.getCategory()) {
-              case household::Household::Category::NONE                : t->category = "none";               break;
-              case household::Household::Category::SINGLE_PERSON       : t->category = "singlePerson";       break;
-              case household::Household::Category::COUPLE              : t->category = "couple";             break;
-              case household::Household::Category::MONOPARENTAL_FAMILY : t->category = "monoparentalFamily"; break;
-              case household::Household::Category::BIPARENTAL_FAMILY   : t->category = "biparentalFamily";   break;
-              case household::Household::Category::OTHER               : t->category = "other";              break;
-              case household::Household::Category::UNKNOWN             : t->category = "unknown";            break;
+              case household::Household::Category::NONE                : category = "none";               break;
+              case household::Household::Category::SINGLE_PERSON       : category = "singlePerson";       break;
+              case household::Household::Category::COUPLE              : category = "couple";             break;
+              case household::Household::Category::MONOPARENTAL_FAMILY : category = "monoparentalFamily"; break;
+              case household::Household::Category::BIPARENTAL_FAMILY   : category = "biparentalFamily";   break;
+              case household::Household::Category::OTHER               : category = "other";              break;
+              case household::Household::Category::UNKNOWN             : category = "unknown";            break;
             }
 
+            std::unique_ptr<Point> point = std::make_unique<Point>();
             point->latitude  = ((double)capnpT.getHomeLatitude())  / 1000000.0;
             point->longitude = ((double)capnpT.getHomeLongitude()) / 1000000.0;
-            t->point         = std::move(point);
-            
+
             const unsigned int homeNodesCount {capnpT.getHomeNodesUuids().size()};
-            std::vector<int> homeNodesIdx(homeNodesCount);
-            std::vector<int> homeNodesTravelTimesSeconds(homeNodesCount);
-            std::vector<int> homeNodesDistancesMeters(homeNodesCount);
-            for (int i = 0; i < homeNodesCount; i++)
+            std::vector<NodeTimeDistance> homeNodes;
+            for (unsigned int j = 0; j < homeNodesCount; j++)
             {
-              std::string nodeUuid {capnpT.getHomeNodesUuids()[i]};
-              homeNodesIdx               [i] = nodeIndexesByUuid.at(uuidGenerator(nodeUuid));
-              homeNodesTravelTimesSeconds[i] = capnpT.getHomeNodesTravelTimes()[i];
-              homeNodesDistancesMeters   [i] = capnpT.getHomeNodesDistances()[i];
+              std::string nodeUuid {capnpT.getHomeNodesUuids()[j]};
+              homeNodes.push_back(NodeTimeDistance(nodes.at(uuidGenerator(nodeUuid)),
+                                                   capnpT.getHomeNodesTravelTimes()[j],
+                                                   capnpT.getHomeNodesDistances()[j]));
             }
-            t->homeNodesIdx                = homeNodesIdx;
-            t->homeNodesTravelTimesSeconds = homeNodesTravelTimesSeconds;
-            t->homeNodesDistancesMeters    = homeNodesDistancesMeters;
 
-            tIndexesByUuid[t->uuid] = ts.size();
-            ts.push_back(std::move(t));
+            // The households without data source are in the data source of their cache file
+            ts.emplace(uuidGenerator(uuid), T(uuidGenerator(uuid),
+                                              capnpT.getId(),
+                                              capnpT.getInternalId(),
+                                              dataSourceUuidStr.length() > 0 ? dataSources.at(uuidGenerator(dataSourceUuidStr)) : iter->second,
+                                              capnpT.getExpansionFactor(),
+                                              capnpT.getSize(),
+                                              capnpT.getCarNumber(),
+                                              capnpT.getIncomeLevel(),
+                                              incomeLevelGroup,
+                                              category,
+                                              homeNodes,
+                                              std::move(point)
+                                              ));
           }
         }
         catch (const kj::Exception& e)
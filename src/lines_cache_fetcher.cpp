@@ -8,7 +8,7 @@
 #include <fcntl.h>
 #include <kj/exception.h>
 #include <boost/uuid/string_generator.hpp>
-#include <capnp/serialize-packed.h>
+#include "cache_file_reader.hpp"
 #include "cache_fetcher.hpp"
 #include "line.hpp"
 #include "capnp/lineCollection.capnp.h"
@@ -59,7 +59,7 @@ namespace TrRouting
 
     try
     {
-      ::capnp::PackedFdMessageReader capnpTCollectionMessage(fd, {64 * 1024 * 1024});
+      CacheFileReader capnpTCollectionMessage(fd, {64 * 1024 * 1024});
       TCollection::Reader capnpTCollection = capnpTCollectionMessage.getRoot<TCollection>();
       for (cT::Reader capnpT : capnpTCollection.getLines())
       {
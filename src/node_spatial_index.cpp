@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+
+#include "node_spatial_index.hpp"
+#include "point.hpp"
+#include "node.hpp"
+#include "spdlog/spdlog.h"
+
+namespace TrRouting
+{
+
+  void NodeSpatialIndex::build(const std::map<boost::uuids::uuid, Node> &nodesMap)
+  {
+    buildId = ++lastBuildId;
+    nodes.clear();
+    cellStarts.clear();
+    cellNodeIndexes.clear();
+    columnsCount = 0;
+    rowsCount = 0;
+    if (nodesMap.empty()) {
+      return;
+    }
+
+    double maxLongitude = nodesMap.begin()->second.point.get()->longitude;
+    double maxLatitude  = nodesMap.begin()->second.point.get()->latitude;
+    minLongitude = maxLongitude;
+    minLatitude  = maxLatitude;
+    nodes.reserve(nodesMap.size());
+    for (auto &&[uuid, node] : nodesMap)
+    {
+      nodes.push_back(node);
+      minLongitude = std::min(minLongitude, node.point.get()->longitude);
+      maxLongitude = std::max(maxLongitude, node.point.get()->longitude);
+      minLatitude  = std::min(minLatitude, node.point.get()->latitude);
+      maxLatitude  = std::max(maxLatitude, node.point.get()->latitude);
+    }
+
+    // Approximate length of one degree at the middle latitude, it only needs to give reasonably square cells
+    double middleLatitude = (minLatitude + maxLatitude) / 2;
+    double lengthOfOneDegreeOfLongitude = std::max(111412.84 * cos(middleLatitude * M_PI / 180), 1.0);
+    cellLongitudeSize = std::max(CELL_SIZE_METERS / lengthOfOneDegreeOfLongitude, (maxLongitude - minLongitude) / MAX_CELLS_PER_DIMENSION);
+    cellLatitudeSize  = std::max(CELL_SIZE_METERS / 111132.92, (maxLatitude - minLatitude) / MAX_CELLS_PER_DIMENSION);
+    columnsCount = std::min((int)((maxLongitude - minLongitude) / cellLongitudeSize) + 1, MAX_CELLS_PER_DIMENSION);
+    rowsCount    = std::min((int)((maxLatitude - minLatitude) / cellLatitudeSize) + 1, MAX_CELLS_PER_DIMENSION);
+
+    // Counting sort of the nodes by cell, nodes of a cell stay in the map order
+    std::vector<size_t> nodesCells(nodes.size());
+    cellStarts.assign((size_t)columnsCount * rowsCount + 1, 0);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+      const Point & point = *nodes[i].get().point.get();
+      nodesCells[i] = (size_t)getRow(point.latitude) * columnsCount + getColumn(point.longitude);
+      cellStarts[nodesCells[i] + 1]++;
+    }
+    for (size_t cell = 1; cell < cellStarts.size(); cell++)
+    {
+      cellStarts[cell] += cellStarts[cell - 1];
+    }
+    cellNodeIndexes.resize(nodes.size());
+    std::vector<size_t> cellPositions(cellStarts.begin(), cellStarts.end() - 1);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+      cellNodeIndexes[cellPositions[nodesCells[i]]++] = i;
+    }
+
+    spdlog::debug("Built the nodes spatial index with {} nodes in {}x{} cells", nodes.size(), columnsCount, rowsCount);
+  }
+
+  int NodeSpatialIndex::getColumn(double longitude) const
+  {
+    double column = std::floor((longitude - minLongitude) / cellLongitudeSize);
+    return (int)std::clamp(column, 0.0, (double)(columnsCount - 1));
+  }
+
+  int NodeSpatialIndex::getRow(double latitude) const
+  {
+    double row = std::floor((latitude - minLatitude) / cellLatitudeSize);
+    return (int)std::clamp(row, 0.0, (double)(rowsCount - 1));
+  }
+
+  std::vector<std::reference_wrapper<const Node>> NodeSpatialIndex::getNodesInBoundingBox(const Point &point, double longitudeDelta, double latitudeDelta) const
+  {
+    std::vector<std::reference_wrapper<const Node>> nodesInBoundingBox;
+    if (nodes.empty()) {
+      return nodesInBoundingBox;
+    }
+
+    if ((point.longitude + longitudeDelta < minLongitude) || (point.longitude - longitudeDelta > minLongitude + columnsCount * cellLongitudeSize) ||
+        (point.latitude + latitudeDelta < minLatitude) || (point.latitude - latitudeDelta > minLatitude + rowsCount * cellLatitudeSize)) {
+      return nodesInBoundingBox;
+    }
+    int firstColumn = getColumn(point.longitude - longitudeDelta);
+    int lastColumn  = getColumn(point.longitude + longitudeDelta);
+    int firstRow    = getRow(point.latitude - latitudeDelta);
+    int lastRow     = getRow(point.latitude + latitudeDelta);
+
+    std::vector<size_t> indexes;
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+      size_t rowStart = (size_t)row * columnsCount;
+      indexes.insert(indexes.end(), cellNodeIndexes.begin() + cellStarts[rowStart + firstColumn], cellNodeIndexes.begin() + cellStarts[rowStart + lastColumn + 1]);
+    }
+    // Return the nodes in the map order, so the results do not depend on the grid
+    std::sort(indexes.begin(), indexes.end());
+
+    nodesInBoundingBox.reserve(indexes.size());
+    for (size_t index : indexes)
+    {
+      nodesInBoundingBox.push_back(nodes[index]);
+    }
+    return nodesInBoundingBox;
+  }
+
+}
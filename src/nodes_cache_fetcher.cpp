@@ -9,7 +9,7 @@
 #include <fcntl.h>
 #include <kj/exception.h>
 #include <boost/uuid/string_generator.hpp>
-#include <capnp/serialize-packed.h>
+#include "cache_file_reader.hpp"
 #include "cache_fetcher.hpp"
 #include "node.hpp"
 #include "point.hpp"
@@ -62,7 +62,7 @@ namespace TrRouting
 
     try
     {
-      ::capnp::PackedFdMessageReader capnpTCollectionMessage(cacheFd, {64 * 1024 * 1024});
+      CacheFileReader capnpTCollectionMessage(cacheFd, {64 * 1024 * 1024});
       TCollection::Reader capnpTCollection = capnpTCollectionMessage.getRoot<TCollection>();
       for (cT::Reader capnpT : capnpTCollection.getNodes())
       {
@@ -122,7 +122,7 @@ namespace TrRouting
 
       try
       {
-        ::capnp::PackedFdMessageReader capnpTMessage(fd, {32 * 1024 * 1024});
+        CacheFileReader capnpTMessage(fd, {32 * 1024 * 1024});
 
         cNode::Reader capnpT = capnpTMessage.getRoot<cNode>();
         const unsigned int transferableNodesCount {capnpT.getTransferableNodesUuids().size()};
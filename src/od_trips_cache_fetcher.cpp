@@ -6,7 +6,7 @@
 #include <vector>
 #include <fcntl.h>
 #include <boost/uuid/string_generator.hpp>
-#include <capnp/serialize-packed.h>
+#include "cache_file_reader.hpp"
 #include "cache_fetcher.hpp"
 #include "od_trip.hpp"
 #include "point.hpp"
@@ -133,7 +133,7 @@ namespace TrRouting
 
         try
         {   
-          ::capnp::PackedFdMessageReader capnpTCollectionMessage(fd, {512 * 1024 * 1024});
+          CacheFileReader capnpTCollectionMessage(fd, {512 * 1024 * 1024});
           TCollection::Reader capnpTCollection = capnpTCollectionMessage.getRoot<TCollection>();
           for (cT::Reader capnpT : capnpTCollection.getOdTrips())
           {
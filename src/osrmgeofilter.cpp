@@ -2,24 +2,33 @@
 #include <nlohmann/json.hpp>
 #include "point.hpp"
 #include "node.hpp"
+#include "node_spatial_index.hpp"
 #include "client_http.hpp"
 #include "spdlog/spdlog.h"
 
 namespace TrRouting {
 
-  OsrmGeoFilter::OsrmGeoFilter(const std::string &amode, const std::string &ahost, const std::string &aport) :
+  OsrmGeoFilter::OsrmGeoFilter(const std::string &amode, const std::string &ahost, const std::string &aport, size_t cacheSize) :
     mode(amode),
     host(ahost),
-    port(aport)
+    port(aport),
+    footpathCache(cacheSize)
   {
   }
 
   std::vector<NodeTimeDistance> OsrmGeoFilter::getAccessibleNodesFootpathsFromPoint(const Point &point,
-                                                                                    const std::map<boost::uuids::uuid, Node> &nodes,
+                                                                                    const NodeSpatialIndex &nodesIndex,
                                                                                     int maxWalkingTravelTime,
                                                                                     float walkingSpeedMetersPerSecond,
                                                                                     bool reversed)
   {
+    FootpathCacheKey cacheKey(mode, point, maxWalkingTravelTime, walkingSpeedMetersPerSecond, reversed);
+    std::optional<std::vector<NodeTimeDistance>> cachedFootpaths = footpathCache.get(cacheKey, nodesIndex.getBuildId());
+    if (cachedFootpaths.has_value()) {
+      spdlog::debug("osrm footpaths found in cache ({} footpaths, {} hits, {} misses)", cachedFootpaths.value().size(), footpathCache.getHits(), footpathCache.getMisses());
+      return cachedFootpaths.value();
+    }
+
     std::vector<std::reference_wrapper<const Node>> birdDistanceAccessibleNodeIndexes;
     std::vector<NodeTimeDistance> accessibleNodesFootpaths;
 
@@ -34,7 +43,7 @@ namespace TrRouting {
     // We first filter the nodes with euclidean distance using the common distance calculation
     // to only send a subset of nodes to OSRM. We do not reuse the EuclideanGeoFilter directly, since
     // we process the data differently here. (We directly compute the OSRM query.)
-    for (auto &&[uuid,node] : nodes)
+    for (const Node & node : getCandidateNodes(point, nodesIndex, maxDistanceMetersSquared, lengthOfOneDegree))
     {
       distanceMetersSquared = calculateNodeDistanceSquared(node.point.get(), point, lengthOfOneDegree);
 
@@ -110,6 +119,8 @@ namespace TrRouting {
     }
 
     spdlog::debug("fetched osrm footpaths ({} footpaths found)",  accessibleNodesFootpaths.size());
+    // Only successful responses are cached, errors will be retried with the next query
+    footpathCache.set(cacheKey, nodesIndex.getBuildId(), accessibleNodesFootpaths);
 
     return accessibleNodesFootpaths;
   }
@@ -6,7 +6,7 @@
 #include <vector>
 #include <fcntl.h>
 #include <boost/uuid/string_generator.hpp>
-#include <capnp/serialize-packed.h>
+#include "cache_file_reader.hpp"
 #include "cache_fetcher.hpp"
 #include "person.hpp"
 #include "point.hpp"
@@ -144,7 +144,7 @@ namespace TrRouting
 
         try
         {   
-          ::capnp::PackedFdMessageReader capnpTCollectionMessage(fd, {64 * 1024 * 1024});
+          CacheFileReader capnpTCollectionMessage(fd, {64 * 1024 * 1024});
           TCollection::Reader capnpTCollection = capnpTCollectionMessage.getRoot<TCollection>();
           for (cT::Reader capnpT : capnpTCollection.getPersons())
           {
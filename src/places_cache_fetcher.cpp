@@ -5,8 +5,9 @@
 #include <string>
 #include <vector>
 #include <fcntl.h>
+#include <kj/exception.h>
 #include <boost/uuid/string_generator.hpp>
-#include <capnp/serialize-packed.h>
+#include "cache_file_reader.hpp"
 #include "cache_fetcher.hpp"
 #include "place.hpp"
 #include "point.hpp"
@@ -18,10 +19,9 @@ namespace TrRouting
 {
 
   int CacheFetcher::getPlaces(
-    std::vector<std::unique_ptr<Place>>& ts,
-    std::map<boost::uuids::uuid, int>& tIndexesByUuid,
-    const std::map<boost::uuids::uuid, int>& dataSourceIndexesByUuid,
-    const std::map<boost::uuids::uuid, int>& nodeIndexesByUuid,
+    std::map<boost::uuids::uuid, Place>& ts,
+    const std::map<boost::uuids::uuid, DataSource>& dataSources,
+    const std::map<boost::uuids::uuid, Node>& nodes,
     std::string customPath
   )
   {
@@ -33,24 +33,26 @@ namespace TrRouting
     std::string tStr  = "places";
     std::string TStr  = "Places";
 
+    ts.clear();
+
     std::string cacheFileName{tStr};
     boost::uuids::string_generator uuidGenerator;
 
     spdlog::info("Fetching {} from cache... {}", tStr, customPath);
 
-    for(std::map<boost::uuids::uuid, int>::const_iterator iter = dataSourceIndexesByUuid.begin(); iter != dataSourceIndexesByUuid.end(); ++iter)
+    for(std::map<boost::uuids::uuid, DataSource>::const_iterator iter = dataSources.begin(); iter != dataSources.end(); ++iter)
     {
       boost::uuids::uuid dataSourceUuid = iter->first;
 
-      std::string cacheFilePath {"dataSources/" + boost::uuids::to_string(dataSourceUuid) + "/" + cacheFileName};
+      std::string dataSourceCacheFilePath {"dataSources/" + boost::uuids::to_string(dataSourceUuid) + "/" + cacheFileName};
 
-      int filesCount {CacheFetcher::getCacheFilesCount(getFilePath(cacheFilePath + ".capnpbin.count", customPath))};
+      int filesCount {CacheFetcher::getCacheFilesCount(getFilePath(dataSourceCacheFilePath + ".capnpbin.count", customPath))};
 
-      spdlog::info("files count places: {} path: {}", filesCount, cacheFilePath);
+      spdlog::info("files count places: {} path: {}", filesCount, dataSourceCacheFilePath);
 
       for (int i = 0; i < filesCount; i++)
       {
-        std::string filePath {cacheFilePath + ".capnpbin" + (filesCount > 1 ? "." + std::to_string(i) : "")};
+        std::string filePath {dataSourceCacheFilePath + ".capnpbin" + (filesCount > 1 ? "." + std::to_string(i) : "")};
         std::string cacheFilePath = getFilePath(filePath, customPath);
 
         int fd = open(cacheFilePath.c_str(), O_RDWR);
@@ -70,50 +72,49 @@ namespace TrRouting
 
         try
         {
-          ::capnp::PackedFdMessageReader capnpTCollectionMessage(fd, {64 * 1024 * 1024});
+          CacheFileReader capnpTCollectionMessage(fd, {64 * 1024 * 1024});
           TCollection::Reader capnpTCollection = capnpTCollectionMessage.getRoot<TCollection>();
           for (cT::Reader capnpT : capnpTCollection.getPlaces())
           {
-            std::string uuid           {capnpT.getUuid()};
-            std::string dataSourceUuid {capnpT.getDataSourceUuid()};
+            std::string uuid              {capnpT.getUuid()};
+            std::string dataSourceUuidStr {capnpT.getDataSourceUuid()};
 
-            std::unique_ptr<T> t         = std::make_unique<T>();
             std::unique_ptr<Point> point = std::make_unique<Point>();
-
-            t->uuid            = uuidGenerator(uuid);
-            t->id              = capnpT.getId();
-            t->shortname       = capnpT.getShortname();
-            t->name            = capnpT.getName();
-            t->internalId      = capnpT.getInternalId();
-            t->dataSourceIdx   = dataSourceUuid.length() > 0 ? dataSourceIndexesByUuid.at(uuidGenerator(dataSourceUuid)) : -1;
-
             point->latitude  = ((double)capnpT.getLatitude())  / 1000000.0;
             point->longitude = ((double)capnpT.getLongitude()) / 1000000.0;
-            t->point         = std::move(point);
 
             const unsigned int nodesCount {capnpT.getNodesUuids().size()};
-            std::vector<int> nodesIdx(nodesCount);
-            std::vector<int> nodesTravelTimesSeconds(nodesCount);
-            std::vector<int> nodesDistancesMeters(nodesCount);
-            for (int i = 0; i < nodesCount; i++)
+            std::vector<NodeTimeDistance> placeNodes;
+            for (unsigned int j = 0; j < nodesCount; j++)
             {
-              std::string nodeUuid {capnpT.getNodesUuids()[i]};
-              nodesIdx               [i] = nodeIndexesByUuid.at(uuidGenerator(nodeUuid));
-              nodesTravelTimesSeconds[i] = capnpT.getNodesTravelTimes()[i];
-              nodesDistancesMeters   [i] = capnpT.getNodesDistances()[i];
+              std::string nodeUuid {capnpT.getNodesUuids()[j]};
+              placeNodes.push_back(NodeTimeDistance(nodes.at(uuidGenerator(nodeUuid)),
+                                                    capnpT.getNodesTravelTimes()[j],
+                                                    capnpT.getNodesDistances()[j]));
             }
-            t->nodesIdx                = nodesIdx;
-            t->nodesTravelTimesSeconds = nodesTravelTimesSeconds;
-            t->nodesDistancesMeters    = nodesDistancesMeters;
 
-            tIndexesByUuid[t->uuid] = ts.size();
-            ts.push_back(std::move(t));
+            // The places without data source are in the data source of their cache file
+            ts.emplace(uuidGenerator(uuid), T(uuidGenerator(uuid),
+                                              capnpT.getId(),
+                                              capnpT.getInternalId(),
+                                              capnpT.getShortname(),
+                                              capnpT.getName(),
+                                              dataSourceUuidStr.length() > 0 ? dataSources.at(uuidGenerator(dataSourceUuidStr)) : iter->second,
+                                              placeNodes,
+                                              std::move(point)
+                                              ));
           }
+
+          spdlog::info("parsed {} places", ts.size());
         }
         catch (const kj::Exception& e)
         {
           spdlog::error("Error opening cache file {}: {}", filePath, e.getDescription().cStr());
         }
+        catch (const std::exception& e)
+        {
+          spdlog::error("Unknown error occurred {} {}", tStr, e.what());
+        }
         catch (...)
         {
           spdlog::error("Unknown error occurred {} ", filePath);
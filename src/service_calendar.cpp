@@ -0,0 +1,73 @@
+#include <algorithm>
+#include "service_calendar.hpp"
+#include "service.hpp"
+
+namespace TrRouting
+{
+
+  ServiceCalendar::ServiceCalendar(const std::map<boost::uuids::uuid, Service> &services)
+  {
+    auto extendRange = [this](const boost::gregorian::date &date) {
+      if (date.is_special()) {
+        return;
+      }
+      if (firstDate.is_special() || date < firstDate) {
+        firstDate = date;
+      }
+      if (lastDate.is_special() || date > lastDate) {
+        lastDate = date;
+      }
+    };
+    for (auto & [uuid, service] : services) {
+      extendRange(service.startDate);
+      extendRange(service.endDate);
+      for (auto & date : service.onlyDates) {
+        extendRange(date);
+      }
+    }
+    if (firstDate.is_special()) {
+      return;
+    }
+    if ((lastDate - firstDate).days() >= MAX_DAYS) {
+      lastDate = firstDate + boost::gregorian::days(MAX_DAYS - 1);
+    }
+
+    size_t daysCount = (lastDate - firstDate).days() + 1;
+    Service::uid_t maxUid = 0;
+    for (auto & [uuid, service] : services) {
+      maxUid = std::max(maxUid, service.uid);
+    }
+    activeDays.resize(maxUid + 1);
+    for (auto & [uuid, service] : services) {
+      std::vector<uint64_t> &serviceDays = activeDays[service.uid];
+      serviceDays.assign((daysCount + 63) / 64, 0);
+      boost::gregorian::date date = firstDate;
+      for (size_t day = 0; day < daysCount; day++, date += boost::gregorian::days(1)) {
+        if (service.isActiveOnDate(date)) {
+          serviceDays[day >> 6] |= (uint64_t)1 << (day & 63);
+        }
+      }
+    }
+  }
+
+  bool ServiceCalendar::isServiceActive(const Service &service, const boost::gregorian::date &date) const
+  {
+    if (firstDate.is_special() || date < firstDate || date > lastDate || (size_t)service.uid >= activeDays.size() || activeDays[service.uid].empty()) {
+      return service.isActiveOnDate(date);
+    }
+    size_t day = (date - firstDate).days();
+    return (activeDays[service.uid][day >> 6] >> (day & 63)) & 1;
+  }
+
+  std::vector<std::reference_wrapper<const Service>> ServiceCalendar::getActiveServices(const std::vector<std::reference_wrapper<const Service>> &services, const boost::gregorian::date &date) const
+  {
+    std::vector<std::reference_wrapper<const Service>> activeServices;
+    for (auto & service : services) {
+      if (isServiceActive(service.get(), date)) {
+        activeServices.push_back(service);
+      }
+    }
+    return activeServices;
+  }
+
+}
@@ -0,0 +1,938 @@
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <boost/uuid/uuid_io.hpp>
+#include "spdlog/spdlog.h"
+
+#include "snapshot_data_fetcher.hpp"
+#include "transit_data.hpp"
+#include "mode.hpp"
+#include "data_source.hpp"
+#include "household.hpp"
+#include "person.hpp"
+#include "od_trip.hpp"
+#include "place.hpp"
+#include "agency.hpp"
+#include "service.hpp"
+#include "node.hpp"
+#include "line.hpp"
+#include "path.hpp"
+#include "scenario.hpp"
+#include "trip.hpp"
+#include "point.hpp"
+#include "connection.hpp"
+
+namespace TrRouting
+{
+  static const char SNAPSHOT_FILE_HEADER[8] = {'T', 'R', 'S', 'N', 'A', 'P', 'S', 'H'};
+  // Increment when the content of the snapshot changes, older snapshots will need to be written again
+  static const uint32_t SNAPSHOT_VERSION = 2;
+
+  // Appends values to a section of the snapshot, in the native byte order
+  class SnapshotWriter {
+  public:
+    std::string buffer;
+
+    template <typename T>
+    void write(T value) {
+      buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    void writeString(const std::string &value) {
+      write<uint32_t>(value.size());
+      buffer.append(value);
+    }
+    void writeUuid(const boost::uuids::uuid &uuid) {
+      buffer.append(reinterpret_cast<const char *>(uuid.data), uuid.size());
+    }
+    void writeDate(const boost::gregorian::date &date) {
+      write<uint8_t>(date.is_special() ? 1 : 0);
+      if (!date.is_special()) {
+        write<uint16_t>(date.year());
+        write<uint8_t>(date.month());
+        write<uint8_t>(date.day());
+      }
+    }
+    void writePoint(const Point *point) {
+      write<uint8_t>(point != nullptr ? 1 : 0);
+      if (point != nullptr) {
+        write<double>(point->latitude);
+        write<double>(point->longitude);
+      }
+    }
+    template <typename T>
+    void writeUuids(const std::vector<std::reference_wrapper<const T>> &objects) {
+      write<uint32_t>(objects.size());
+      for (const T &object : objects) {
+        writeUuid(object.uuid);
+      }
+    }
+  };
+
+  // Reads the values of a section, throws if reading past the end of the section
+  class SnapshotReader {
+  public:
+    SnapshotReader(const char *_current, const char *_end) : current(_current), end(_end) {}
+
+    template <typename T>
+    T read() {
+      check(sizeof(T));
+      T value;
+      memcpy(&value, current, sizeof(T));
+      current += sizeof(T);
+      return value;
+    }
+    std::string readString() {
+      uint32_t size = read<uint32_t>();
+      check(size);
+      std::string value(current, size);
+      current += size;
+      return value;
+    }
+    boost::uuids::uuid readUuid() {
+      boost::uuids::uuid uuid;
+      check(uuid.size());
+      memcpy(uuid.data, current, uuid.size());
+      current += uuid.size();
+      return uuid;
+    }
+    boost::gregorian::date readDate() {
+      if (read<uint8_t>() == 1) {
+        return boost::gregorian::date();
+      }
+      uint16_t year = read<uint16_t>();
+      uint8_t month = read<uint8_t>();
+      uint8_t day   = read<uint8_t>();
+      return boost::gregorian::date(year, month, day);
+    }
+    std::unique_ptr<Point> readPoint() {
+      if (read<uint8_t>() == 0) {
+        return nullptr;
+      }
+      double latitude  = read<double>();
+      double longitude = read<double>();
+      return std::make_unique<Point>(latitude, longitude);
+    }
+    template <typename T>
+    void readUuids(std::vector<std::reference_wrapper<const T>> &objects, const std::map<boost::uuids::uuid, T> &objectsByUuid) {
+      uint32_t count = read<uint32_t>();
+      objects.clear();
+      for (uint32_t i = 0; i < count; i++) {
+        objects.push_back(objectsByUuid.at(readUuid()));
+      }
+    }
+
+  private:
+    const char *current;
+    const char *end;
+
+    void check(size_t size) {
+      if ((size_t)(end - current) < size) {
+        throw std::out_of_range("Reading past the end of the snapshot section");
+      }
+    }
+  };
+
+  // Write a node list to the snapshot, with the nodes index in the nodes map order
+  static void writeNodesTimeDistance(SnapshotWriter &writer, const std::vector<NodeTimeDistance> &nodesTimeDistance, const std::vector<uint32_t> &nodeIndexesByUid)
+  {
+    writer.write<uint32_t>(nodesTimeDistance.size());
+    for (const NodeTimeDistance &nodeTimeDistance : nodesTimeDistance) {
+      writer.write<uint32_t>(nodeIndexesByUid[nodeTimeDistance.node.uid]);
+      writer.write<int32_t>(nodeTimeDistance.time);
+      writer.write<int32_t>(nodeTimeDistance.distance);
+    }
+  }
+
+  static std::vector<NodeTimeDistance> readNodesTimeDistance(SnapshotReader &reader, const std::vector<std::reference_wrapper<const Node>> &nodesByIndex)
+  {
+    std::vector<NodeTimeDistance> nodesTimeDistance;
+    uint32_t count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < count; i++) {
+      const Node &node = nodesByIndex.at(reader.read<uint32_t>());
+      int time = reader.read<int32_t>();
+      int distance = reader.read<int32_t>();
+      nodesTimeDistance.push_back(NodeTimeDistance(node, time, distance));
+    }
+    return nodesTimeDistance;
+  }
+
+  static std::vector<std::reference_wrapper<const Node>> getNodesByIndex(const std::map<boost::uuids::uuid, Node> &nodes)
+  {
+    std::vector<std::reference_wrapper<const Node>> nodesByIndex;
+    nodesByIndex.reserve(nodes.size());
+    for (auto & nodeIter : nodes) {
+      nodesByIndex.push_back(nodeIter.second);
+    }
+    return nodesByIndex;
+  }
+
+  int SnapshotDataFetcher::writeSnapshot(const TransitData &transitData, const std::string &snapshotFilePath)
+  {
+    std::vector<SnapshotWriter> writers((size_t)Section::SECTIONS_COUNT);
+
+    // Nodes are referenced by their index in the nodes map
+    std::vector<uint32_t> nodeIndexesByUid(transitData.getNodesMaxUid() + 1, 0);
+    uint32_t nodeIndex {0};
+    for (auto & nodeIter : transitData.getNodes()) {
+      nodeIndexesByUid[nodeIter.second.uid] = nodeIndex++;
+    }
+
+    SnapshotWriter &modesWriter = writers[(size_t)Section::MODES];
+    modesWriter.write<uint32_t>(transitData.getModes().size());
+    for (auto & [shortname, mode] : transitData.getModes()) {
+      modesWriter.writeString(mode.shortname);
+      modesWriter.writeString(mode.name);
+      modesWriter.write<int32_t>(mode.gtfsId);
+      modesWriter.write<int32_t>(mode.extendedGtfsId);
+    }
+
+    SnapshotWriter &dataSourcesWriter = writers[(size_t)Section::DATA_SOURCES];
+    dataSourcesWriter.write<uint32_t>(transitData.getDataSources().size());
+    for (auto & [uuid, dataSource] : transitData.getDataSources()) {
+      dataSourcesWriter.writeUuid(dataSource.uuid);
+      dataSourcesWriter.writeString(dataSource.shortname);
+      dataSourcesWriter.writeString(dataSource.name);
+      dataSourcesWriter.writeString(dataSource.type);
+    }
+
+    SnapshotWriter &householdsWriter = writers[(size_t)Section::HOUSEHOLDS];
+    householdsWriter.write<uint32_t>(transitData.getHouseholds().size());
+    for (auto & [uuid, household] : transitData.getHouseholds()) {
+      householdsWriter.writeUuid(household.uuid);
+      householdsWriter.write<uint64_t>(household.id);
+      householdsWriter.writeString(household.internalId);
+      householdsWriter.writeUuid(household.dataSource.uuid);
+      householdsWriter.write<float>(household.expansionFactor);
+      householdsWriter.write<int32_t>(household.size);
+      householdsWriter.write<int32_t>(household.carNumber);
+      householdsWriter.write<int32_t>(household.incomeLevel);
+      householdsWriter.writeString(household.incomeLevelGroup);
+      householdsWriter.writeString(household.category);
+      writeNodesTimeDistance(householdsWriter, household.homeNodes, nodeIndexesByUid);
+      householdsWriter.writePoint(household.point.get());
+    }
+
+    SnapshotWriter &personsWriter = writers[(size_t)Section::PERSONS];
+    personsWriter.write<uint32_t>(transitData.getPersons().size());
+    for (auto & [uuid, person] : transitData.getPersons()) {
+      personsWriter.writeUuid(person.uuid);
+      personsWriter.write<uint64_t>(person.id);
+      personsWriter.writeUuid(person.dataSource.uuid);
+      personsWriter.write<float>(person.expansionFactor);
+      personsWriter.write<int32_t>(person.age);
+      personsWriter.write<int16_t>(person.drivingLicenseOwner);
+      personsWriter.write<int16_t>(person.transitPassOwner);
+      personsWriter.writeString(person.ageGroup);
+      personsWriter.writeString(person.gender);
+      personsWriter.writeString(person.occupation);
+      personsWriter.writeString(person.internalId);
+    }
+
+    SnapshotWriter &odTripsWriter = writers[(size_t)Section::OD_TRIPS];
+    odTripsWriter.write<uint32_t>(transitData.getOdTrips().size());
+    for (auto & [uuid, odTrip] : transitData.getOdTrips()) {
+      odTripsWriter.writeUuid(odTrip.uuid);
+      odTripsWriter.write<uint64_t>(odTrip.id);
+      odTripsWriter.writeString(odTrip.internalId);
+      odTripsWriter.writeUuid(odTrip.dataSource.uuid);
+      odTripsWriter.write<uint8_t>(odTrip.person.has_value() ? 1 : 0);
+      if (odTrip.person.has_value()) {
+        odTripsWriter.writeUuid(odTrip.person.value().get().uuid);
+      }
+      odTripsWriter.write<int32_t>(odTrip.departureTimeSeconds);
+      odTripsWriter.write<int32_t>(odTrip.arrivalTimeSeconds);
+      odTripsWriter.write<int32_t>(odTrip.walkingTravelTimeSeconds);
+      odTripsWriter.write<int32_t>(odTrip.cyclingTravelTimeSeconds);
+      odTripsWriter.write<int32_t>(odTrip.drivingTravelTimeSeconds);
+      odTripsWriter.write<float>(odTrip.expansionFactor);
+      odTripsWriter.writeString(odTrip.mode);
+      odTripsWriter.writeString(odTrip.originActivity);
+      odTripsWriter.writeString(odTrip.destinationActivity);
+      writeNodesTimeDistance(odTripsWriter, odTrip.originNodes, nodeIndexesByUid);
+      writeNodesTimeDistance(odTripsWriter, odTrip.destinationNodes, nodeIndexesByUid);
+      odTripsWriter.writePoint(odTrip.origin.get());
+      odTripsWriter.writePoint(odTrip.destination.get());
+    }
+
+    SnapshotWriter &placesWriter = writers[(size_t)Section::PLACES];
+    placesWriter.write<uint32_t>(transitData.getPlaces().size());
+    for (auto & [uuid, place] : transitData.getPlaces()) {
+      placesWriter.writeUuid(place.uuid);
+      placesWriter.write<uint64_t>(place.id);
+      placesWriter.writeString(place.internalId);
+      placesWriter.writeString(place.shortname);
+      placesWriter.writeString(place.name);
+      placesWriter.writeUuid(place.dataSource.uuid);
+      writeNodesTimeDistance(placesWriter, place.nodes, nodeIndexesByUid);
+      placesWriter.writePoint(place.point.get());
+    }
+
+    SnapshotWriter &agenciesWriter = writers[(size_t)Section::AGENCIES];
+    agenciesWriter.write<uint32_t>(transitData.getAgencies().size());
+    for (auto & [uuid, agency] : transitData.getAgencies()) {
+      agenciesWriter.writeUuid(agency.uuid);
+      agenciesWriter.writeString(agency.acronym);
+      agenciesWriter.writeString(agency.name);
+      agenciesWriter.writeString(agency.internalId);
+      agenciesWriter.writeUuid(agency.simulationUuid);
+    }
+
+    SnapshotWriter &servicesWriter = writers[(size_t)Section::SERVICES];
+    servicesWriter.write<uint32_t>(transitData.getServices().size());
+    for (auto & [uuid, service] : transitData.getServices()) {
+      servicesWriter.writeUuid(service.uuid);
+      servicesWriter.writeString(service.name);
+      servicesWriter.writeString(service.internalId);
+      servicesWriter.writeUuid(service.simulationUuid);
+      for (short day : {service.monday, service.tuesday, service.wednesday, service.thursday, service.friday, service.saturday, service.sunday}) {
+        servicesWriter.write<int16_t>(day);
+      }
+      servicesWriter.write<uint32_t>(service.onlyDates.size());
+      for (auto & date : service.onlyDates) {
+        servicesWriter.writeDate(date);
+      }
+      servicesWriter.write<uint32_t>(service.exceptDates.size());
+      for (auto & date : service.exceptDates) {
+        servicesWriter.writeDate(date);
+      }
+      servicesWriter.writeDate(service.startDate);
+      servicesWriter.writeDate(service.endDate);
+    }
+
+    // The transferable nodes are written after all nodes, they reference other nodes
+    SnapshotWriter &nodesWriter = writers[(size_t)Section::NODES];
+    nodesWriter.write<uint32_t>(transitData.getNodes().size());
+    for (auto & [uuid, node] : transitData.getNodes()) {
+      nodesWriter.writeUuid(node.uuid);
+      nodesWriter.write<uint64_t>(node.id);
+      nodesWriter.writeString(node.code);
+      nodesWriter.writeString(node.name);
+      nodesWriter.writeString(node.internalId);
+      nodesWriter.writePoint(node.point.get());
+    }
+    for (auto & [uuid, node] : transitData.getNodes()) {
+      writeNodesTimeDistance(nodesWriter, node.transferableNodes, nodeIndexesByUid);
+      writeNodesTimeDistance(nodesWriter, node.reverseTransferableNodes, nodeIndexesByUid);
+    }
+
+    SnapshotWriter &linesWriter = writers[(size_t)Section::LINES];
+    linesWriter.write<uint32_t>(transitData.getLines().size());
+    for (auto & [uuid, line] : transitData.getLines()) {
+      linesWriter.writeUuid(line.uuid);
+      linesWriter.writeUuid(line.agency.uuid);
+      linesWriter.writeString(line.mode.shortname);
+      linesWriter.writeString(line.shortname);
+      linesWriter.writeString(line.longname);
+      linesWriter.writeString(line.internalId);
+      linesWriter.write<int16_t>(line.allowSameLineTransfers);
+    }
+
+    SnapshotWriter &pathsWriter = writers[(size_t)Section::PATHS];
+    pathsWriter.write<uint32_t>(transitData.getPaths().size());
+    for (auto & [uuid, path] : transitData.getPaths()) {
+      pathsWriter.writeUuid(path.uuid);
+      pathsWriter.writeUuid(path.line.uuid);
+      pathsWriter.writeString(path.direction);
+      pathsWriter.writeString(path.internalId);
+      pathsWriter.write<uint32_t>(path.nodesRef.size());
+      for (const Node &node : path.nodesRef) {
+        pathsWriter.write<uint32_t>(nodeIndexesByUid[node.uid]);
+      }
+      pathsWriter.write<uint32_t>(path.segmentsTravelTimeSeconds.size());
+      for (int travelTime : path.segmentsTravelTimeSeconds) {
+        pathsWriter.write<int32_t>(travelTime);
+      }
+      pathsWriter.write<uint32_t>(path.segmentsDistanceMeters.size());
+      for (int distance : path.segmentsDistanceMeters) {
+        pathsWriter.write<int32_t>(distance);
+      }
+    }
+
+    SnapshotWriter &scenariosWriter = writers[(size_t)Section::SCENARIOS];
+    scenariosWriter.write<uint32_t>(transitData.getScenarios().size());
+    for (auto & [uuid, scenario] : transitData.getScenarios()) {
+      scenariosWriter.writeUuid(scenario.uuid);
+      scenariosWriter.writeString(scenario.name);
+      scenariosWriter.writeUuid(scenario.simulationUuid);
+      scenariosWriter.writeUuids(scenario.servicesList);
+      for (auto modes : {&scenario.onlyModes, &scenario.exceptModes}) {
+        scenariosWriter.write<uint32_t>(modes->size());
+        for (const Mode &mode : *modes) {
+          scenariosWriter.writeString(mode.shortname);
+        }
+      }
+      scenariosWriter.writeUuids(scenario.onlyLines);
+      scenariosWriter.writeUuids(scenario.exceptLines);
+      scenariosWriter.writeUuids(scenario.onlyAgencies);
+      scenariosWriter.writeUuids(scenario.exceptAgencies);
+      scenariosWriter.writeUuids(scenario.onlyNodes);
+      scenariosWriter.writeUuids(scenario.exceptNodes);
+    }
+
+    // Trips are written in the uid order, the order they were created in, and are referenced by this index
+    std::vector<std::reference_wrapper<const Trip>> tripsByUid;
+    for (auto & tripIter : transitData.getTrips()) {
+      tripsByUid.push_back(tripIter.second);
+    }
+    std::sort(tripsByUid.begin(), tripsByUid.end(), [](const Trip &tripA, const Trip &tripB) { return tripA.uid < tripB.uid; });
+    std::vector<uint32_t> tripIndexesByUid(transitData.getTripsMaxUid() + 1, 0);
+    SnapshotWriter &schedulesWriter = writers[(size_t)Section::SCHEDULES];
+    schedulesWriter.write<uint32_t>(tripsByUid.size());
+    for (size_t tripIndex = 0; tripIndex < tripsByUid.size(); tripIndex++) {
+      const Trip &trip = tripsByUid[tripIndex];
+      tripIndexesByUid[trip.uid] = tripIndex;
+      schedulesWriter.writeUuid(trip.uuid);
+      schedulesWriter.writeUuid(trip.path.uuid);
+      schedulesWriter.writeUuid(trip.service.uuid);
+      schedulesWriter.write<int16_t>(trip.allowSameLineTransfers);
+      schedulesWriter.write<int32_t>(trip.totalCapacity);
+      schedulesWriter.write<int32_t>(trip.seatedCapacity);
+      schedulesWriter.write<uint32_t>(trip.connectionDepartureTimes.size());
+      for (int departureTime : trip.connectionDepartureTimes) {
+        schedulesWriter.write<int32_t>(departureTime);
+      }
+    }
+    // The schedules are read without the nodes map, so this section has its own table of the nodes uuids
+    schedulesWriter.write<uint32_t>(transitData.getNodes().size());
+    for (auto & nodeIter : transitData.getNodes()) {
+      schedulesWriter.writeUuid(nodeIter.first);
+    }
+    const std::vector<Connection> &connections = transitData.getConnections();
+    schedulesWriter.write<uint64_t>(connections.size());
+    for (const Connection &connection : connections) {
+      schedulesWriter.write<uint32_t>(nodeIndexesByUid[connection.getDepartureNode().uid]);
+      schedulesWriter.write<uint32_t>(nodeIndexesByUid[connection.getArrivalNode().uid]);
+      schedulesWriter.write<int32_t>(connection.getDepartureTime());
+      schedulesWriter.write<int32_t>(connection.getArrivalTime());
+      schedulesWriter.write<uint32_t>(tripIndexesByUid[connection.getTrip().uid]);
+      schedulesWriter.write<uint8_t>(connection.canBoard());
+      schedulesWriter.write<uint8_t>(connection.canUnboard());
+      schedulesWriter.write<int32_t>(connection.getSequenceInTrip());
+      schedulesWriter.write<uint8_t>(connection.canTransferSameLine());
+      schedulesWriter.write<int16_t>(connection.getMinWaitingTime());
+    }
+
+    // Sorted orders as indexes in the connections vector
+    SnapshotWriter &ordersWriter = writers[(size_t)Section::CONNECTIONS_ORDERS];
+    for (auto orderedConnections : {&transitData.getForwardConnections(), &transitData.getReverseConnections()}) {
+      ordersWriter.write<uint64_t>(orderedConnections->size());
+      for (const Connection &connection : *orderedConnections) {
+        ordersWriter.write<uint64_t>(&connection - connections.data());
+      }
+    }
+
+    std::ofstream snapshotFile(snapshotFilePath, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!snapshotFile.is_open()) {
+      int err = errno;
+      spdlog::error("Error opening snapshot file {} for writing: {}", snapshotFilePath, err);
+      return -err;
+    }
+    SnapshotWriter headerWriter;
+    headerWriter.buffer.append(SNAPSHOT_FILE_HEADER, sizeof(SNAPSHOT_FILE_HEADER));
+    headerWriter.write<uint32_t>(SNAPSHOT_VERSION);
+    headerWriter.write<uint32_t>(writers.size());
+    uint64_t offset = headerWriter.buffer.size() + writers.size() * 2 * sizeof(uint64_t);
+    for (auto & writer : writers) {
+      headerWriter.write<uint64_t>(offset);
+      headerWriter.write<uint64_t>(writer.buffer.size());
+      offset += writer.buffer.size();
+    }
+    snapshotFile.write(headerWriter.buffer.data(), headerWriter.buffer.size());
+    for (auto & writer : writers) {
+      snapshotFile.write(writer.buffer.data(), writer.buffer.size());
+    }
+    snapshotFile.close();
+    if (!snapshotFile) {
+      spdlog::error("Error writing snapshot file {}", snapshotFilePath);
+      return -EIO;
+    }
+
+    spdlog::info("Wrote transit data snapshot {} ({} bytes)", snapshotFilePath, offset);
+    return 0;
+  }
+
+  SnapshotDataFetcher::SnapshotDataFetcher(const std::string &_snapshotFilePath) : snapshotFilePath(_snapshotFilePath)
+  {
+    int fd = open(snapshotFilePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+      mapError = errno;
+      spdlog::error("Error opening snapshot file {}: {}", snapshotFilePath, mapError);
+      return;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+      mapError = EBADMSG;
+      close(fd);
+      spdlog::error("Empty snapshot file {}", snapshotFilePath);
+      return;
+    }
+    void *data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after closing the file
+    close(fd);
+    if (data == MAP_FAILED) {
+      mapError = errno;
+      spdlog::error("Error mapping snapshot file {}: {}", snapshotFilePath, mapError);
+      return;
+    }
+    mappedData = static_cast<const char *>(data);
+    mappedSize = fileStat.st_size;
+
+    try {
+      SnapshotReader reader(mappedData, mappedData + mappedSize);
+      char header[sizeof(SNAPSHOT_FILE_HEADER)];
+      for (size_t i = 0; i < sizeof(header); i++) {
+        header[i] = reader.read<char>();
+      }
+      uint32_t version = reader.read<uint32_t>();
+      uint32_t sectionsCount = reader.read<uint32_t>();
+      if (memcmp(header, SNAPSHOT_FILE_HEADER, sizeof(header)) != 0 || version != SNAPSHOT_VERSION || sectionsCount != (uint32_t)Section::SECTIONS_COUNT) {
+        throw std::runtime_error("invalid header or version");
+      }
+      for (uint32_t i = 0; i < sectionsCount; i++) {
+        uint64_t offset = reader.read<uint64_t>();
+        uint64_t size = reader.read<uint64_t>();
+        if (offset > mappedSize || size > mappedSize - offset) {
+          throw std::runtime_error("section out of the file");
+        }
+        sections.push_back(std::make_pair(offset, size));
+      }
+    } catch (const std::exception &e) {
+      spdlog::error("Invalid snapshot file {}: {}", snapshotFilePath, e.what());
+      mapError = EBADMSG;
+      sections.clear();
+    }
+    spdlog::info("Mapped transit data snapshot {} ({} bytes)", snapshotFilePath, mappedSize);
+  }
+
+  SnapshotDataFetcher::~SnapshotDataFetcher()
+  {
+    if (mappedData != nullptr) {
+      munmap(const_cast<char *>(mappedData), mappedSize);
+    }
+  }
+
+  bool SnapshotDataFetcher::getSection(Section section, const char *&begin, const char *&end) const
+  {
+    if (sections.size() != (size_t)Section::SECTIONS_COUNT) {
+      return false;
+    }
+    begin = mappedData + sections[(size_t)section].first;
+    end = begin + sections[(size_t)section].second;
+    return true;
+  }
+
+  const std::map<std::string, Mode> SnapshotDataFetcher::getModes()
+  {
+    std::map<std::string, Mode> modes;
+    const char *begin, *end;
+    if (!getSection(Section::MODES, begin, end)) {
+      return modes;
+    }
+    try {
+      SnapshotReader reader(begin, end);
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        std::string shortname = reader.readString();
+        std::string name = reader.readString();
+        int gtfsId = reader.read<int32_t>();
+        int extendedGtfsId = reader.read<int32_t>();
+        modes.emplace(shortname, Mode(shortname, name, gtfsId, extendedGtfsId));
+      }
+    } catch (const std::exception &e) {
+      spdlog::error("Error reading modes from snapshot: {}", e.what());
+    }
+    return modes;
+  }
+
+  // Read a section with the readSection function, returning the error code the fetchers return
+  template <typename F>
+  static int readSnapshotSection(bool hasSection, int mapError, const char *begin, const char *end, const std::string &name, F readSection)
+  {
+    if (!hasSection) {
+      return mapError != 0 ? -mapError : -EBADMSG;
+    }
+    try {
+      SnapshotReader reader(begin, end);
+      readSection(reader);
+    } catch (const std::exception &e) {
+      spdlog::error("Error reading {} from snapshot: {}", name, e.what());
+      return -EBADMSG;
+    }
+    return 0;
+  }
+
+  int SnapshotDataFetcher::getDataSources(std::map<boost::uuids::uuid, DataSource>& ts, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::DATA_SOURCES, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "data sources", [&ts](SnapshotReader &reader) {
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        DataSource dataSource;
+        dataSource.uuid      = reader.readUuid();
+        dataSource.shortname = reader.readString();
+        dataSource.name      = reader.readString();
+        dataSource.type      = reader.readString();
+        ts.emplace(dataSource.uuid, dataSource);
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getHouseholds(std::map<boost::uuids::uuid, Household>& ts, const std::map<boost::uuids::uuid, DataSource>& dataSources, const std::map<boost::uuids::uuid, Node>& nodes, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::HOUSEHOLDS, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "households", [&](SnapshotReader &reader) {
+      std::vector<std::reference_wrapper<const Node>> nodesByIndex = getNodesByIndex(nodes);
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        boost::uuids::uuid uuid = reader.readUuid();
+        unsigned long long id = reader.read<uint64_t>();
+        std::string internalId = reader.readString();
+        const DataSource &dataSource = dataSources.at(reader.readUuid());
+        float expansionFactor = reader.read<float>();
+        int size = reader.read<int32_t>();
+        int carNumber = reader.read<int32_t>();
+        int incomeLevel = reader.read<int32_t>();
+        std::string incomeLevelGroup = reader.readString();
+        std::string category = reader.readString();
+        std::vector<NodeTimeDistance> homeNodes = readNodesTimeDistance(reader, nodesByIndex);
+        std::unique_ptr<Point> point = reader.readPoint();
+        ts.emplace(uuid, Household(uuid, id, internalId, dataSource, expansionFactor, size, carNumber, incomeLevel, incomeLevelGroup, category, homeNodes, std::move(point)));
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getPersons(std::map<boost::uuids::uuid, Person>& ts, const std::map<boost::uuids::uuid, DataSource>& dataSources, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::PERSONS, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "persons", [&ts, &dataSources](SnapshotReader &reader) {
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        boost::uuids::uuid uuid = reader.readUuid();
+        unsigned long long id = reader.read<uint64_t>();
+        const DataSource &dataSource = dataSources.at(reader.readUuid());
+        float expansionFactor = reader.read<float>();
+        int age = reader.read<int32_t>();
+        short drivingLicenseOwner = reader.read<int16_t>();
+        short transitPassOwner = reader.read<int16_t>();
+        std::string ageGroup = reader.readString();
+        std::string gender = reader.readString();
+        std::string occupation = reader.readString();
+        std::string internalId = reader.readString();
+        ts.emplace(uuid, Person(uuid, id, dataSource, expansionFactor, age, drivingLicenseOwner, transitPassOwner, ageGroup, gender, occupation, internalId));
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getOdTrips(std::map<boost::uuids::uuid, OdTrip>& ts, const std::map<boost::uuids::uuid, DataSource>& dataSources, const std::map<boost::uuids::uuid, Person>& persons, const std::map<boost::uuids::uuid, Node>& nodes, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::OD_TRIPS, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "od trips", [&](SnapshotReader &reader) {
+      std::vector<std::reference_wrapper<const Node>> nodesByIndex = getNodesByIndex(nodes);
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        boost::uuids::uuid uuid = reader.readUuid();
+        unsigned long long id = reader.read<uint64_t>();
+        std::string internalId = reader.readString();
+        const DataSource &dataSource = dataSources.at(reader.readUuid());
+        std::optional<std::reference_wrapper<const Person>> person;
+        if (reader.read<uint8_t>() == 1) {
+          person = persons.at(reader.readUuid());
+        }
+        int departureTimeSeconds = reader.read<int32_t>();
+        int arrivalTimeSeconds = reader.read<int32_t>();
+        int walkingTravelTimeSeconds = reader.read<int32_t>();
+        int cyclingTravelTimeSeconds = reader.read<int32_t>();
+        int drivingTravelTimeSeconds = reader.read<int32_t>();
+        float expansionFactor = reader.read<float>();
+        std::string mode = reader.readString();
+        std::string originActivity = reader.readString();
+        std::string destinationActivity = reader.readString();
+        std::vector<NodeTimeDistance> originNodes = readNodesTimeDistance(reader, nodesByIndex);
+        std::vector<NodeTimeDistance> destinationNodes = readNodesTimeDistance(reader, nodesByIndex);
+        std::unique_ptr<Point> origin = reader.readPoint();
+        std::unique_ptr<Point> destination = reader.readPoint();
+        ts.emplace(uuid, OdTrip(uuid, id, internalId, dataSource, person, departureTimeSeconds, arrivalTimeSeconds, walkingTravelTimeSeconds, cyclingTravelTimeSeconds, drivingTravelTimeSeconds, expansionFactor, mode, originActivity, destinationActivity, originNodes, destinationNodes, std::move(origin), std::move(destination)));
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getPlaces(std::map<boost::uuids::uuid, Place>& ts, const std::map<boost::uuids::uuid, DataSource>& dataSources, const std::map<boost::uuids::uuid, Node>& nodes, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::PLACES, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "places", [&](SnapshotReader &reader) {
+      std::vector<std::reference_wrapper<const Node>> nodesByIndex = getNodesByIndex(nodes);
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        boost::uuids::uuid uuid = reader.readUuid();
+        unsigned long long id = reader.read<uint64_t>();
+        std::string internalId = reader.readString();
+        std::string shortname = reader.readString();
+        std::string name = reader.readString();
+        const DataSource &dataSource = dataSources.at(reader.readUuid());
+        std::vector<NodeTimeDistance> placeNodes = readNodesTimeDistance(reader, nodesByIndex);
+        std::unique_ptr<Point> point = reader.readPoint();
+        ts.emplace(uuid, Place(uuid, id, internalId, shortname, name, dataSource, placeNodes, std::move(point)));
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getAgencies(std::map<boost::uuids::uuid, Agency>& ts, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::AGENCIES, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "agencies", [&ts](SnapshotReader &reader) {
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        Agency agency;
+        agency.uuid           = reader.readUuid();
+        agency.acronym        = reader.readString();
+        agency.name           = reader.readString();
+        agency.internalId     = reader.readString();
+        agency.simulationUuid = reader.readUuid();
+        ts.emplace(agency.uuid, agency);
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getServices(std::map<boost::uuids::uuid, Service>& ts, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::SERVICES, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "services", [&ts](SnapshotReader &reader) {
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        Service service;
+        service.uuid           = reader.readUuid();
+        service.name           = reader.readString();
+        service.internalId     = reader.readString();
+        service.simulationUuid = reader.readUuid();
+        service.monday         = reader.read<int16_t>();
+        service.tuesday        = reader.read<int16_t>();
+        service.wednesday      = reader.read<int16_t>();
+        service.thursday       = reader.read<int16_t>();
+        service.friday         = reader.read<int16_t>();
+        service.saturday       = reader.read<int16_t>();
+        service.sunday         = reader.read<int16_t>();
+        uint32_t onlyDatesCount = reader.read<uint32_t>();
+        for (uint32_t j = 0; j < onlyDatesCount; j++) {
+          service.onlyDates.push_back(reader.readDate());
+        }
+        uint32_t exceptDatesCount = reader.read<uint32_t>();
+        for (uint32_t j = 0; j < exceptDatesCount; j++) {
+          service.exceptDates.push_back(reader.readDate());
+        }
+        service.startDate = reader.readDate();
+        service.endDate   = reader.readDate();
+        ts.emplace(service.uuid, service);
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getNodes(std::map<boost::uuids::uuid, Node>& ts, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::NODES, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "nodes", [&ts](SnapshotReader &reader) {
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        boost::uuids::uuid uuid = reader.readUuid();
+        unsigned long long id = reader.read<uint64_t>();
+        std::string code = reader.readString();
+        std::string name = reader.readString();
+        std::string internalId = reader.readString();
+        std::unique_ptr<Point> point = reader.readPoint();
+        ts.emplace(uuid, Node(uuid, id, code, name, internalId, std::move(point)));
+      }
+      std::vector<std::reference_wrapper<const Node>> nodesByIndex = getNodesByIndex(ts);
+      for (auto & nodeIter : ts) {
+        nodeIter.second.transferableNodes = readNodesTimeDistance(reader, nodesByIndex);
+        nodeIter.second.reverseTransferableNodes = readNodesTimeDistance(reader, nodesByIndex);
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getLines(std::map<boost::uuids::uuid, Line>& ts, const std::map<boost::uuids::uuid, Agency>& agencies, const std::map<std::string, Mode>& modes, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::LINES, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "lines", [&](SnapshotReader &reader) {
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        boost::uuids::uuid uuid = reader.readUuid();
+        const Agency &agency = agencies.at(reader.readUuid());
+        const Mode &mode = modes.at(reader.readString());
+        std::string shortname = reader.readString();
+        std::string longname = reader.readString();
+        std::string internalId = reader.readString();
+        short allowSameLineTransfers = reader.read<int16_t>();
+        ts.emplace(uuid, Line(uuid, agency, mode, shortname, longname, internalId, allowSameLineTransfers));
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getPaths(std::map<boost::uuids::uuid, Path>& ts, const std::map<boost::uuids::uuid, Line>& lines, const std::map<boost::uuids::uuid, Node>& nodes, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::PATHS, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "paths", [&](SnapshotReader &reader) {
+      std::vector<std::reference_wrapper<const Node>> nodesByIndex = getNodesByIndex(nodes);
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        boost::uuids::uuid uuid = reader.readUuid();
+        const Line &line = lines.at(reader.readUuid());
+        std::string direction = reader.readString();
+        std::string internalId = reader.readString();
+        std::vector<std::reference_wrapper<const Node>> nodesRef;
+        uint32_t nodesCount = reader.read<uint32_t>();
+        for (uint32_t j = 0; j < nodesCount; j++) {
+          nodesRef.push_back(nodesByIndex.at(reader.read<uint32_t>()));
+        }
+        std::vector<int> segmentsTravelTimeSeconds(reader.read<uint32_t>());
+        for (auto & travelTime : segmentsTravelTimeSeconds) {
+          travelTime = reader.read<int32_t>();
+        }
+        std::vector<int> segmentsDistanceMeters(reader.read<uint32_t>());
+        for (auto & distance : segmentsDistanceMeters) {
+          distance = reader.read<int32_t>();
+        }
+        ts.emplace(uuid, Path(uuid, line, direction, internalId, nodesRef, {}, segmentsTravelTimeSeconds, segmentsDistanceMeters));
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getScenarios(std::map<boost::uuids::uuid, Scenario>& ts, const std::map<boost::uuids::uuid, Service>& services, const std::map<boost::uuids::uuid, Line>& lines, const std::map<boost::uuids::uuid, Agency>& agencies, const std::map<boost::uuids::uuid, Node>& nodes, const std::map<std::string, Mode>& modes, std::string)
+  {
+    ts.clear();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::SCENARIOS, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "scenarios", [&](SnapshotReader &reader) {
+      uint32_t count = reader.read<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        boost::uuids::uuid uuid = reader.readUuid();
+        Scenario &scenario = ts[uuid];
+        scenario.uuid = uuid;
+        scenario.name = reader.readString();
+        scenario.simulationUuid = reader.readUuid();
+        reader.readUuids(scenario.servicesList, services);
+        for (auto scenarioModes : {&scenario.onlyModes, &scenario.exceptModes}) {
+          uint32_t modesCount = reader.read<uint32_t>();
+          for (uint32_t j = 0; j < modesCount; j++) {
+            scenarioModes->push_back(modes.at(reader.readString()));
+          }
+        }
+        reader.readUuids(scenario.onlyLines, lines);
+        reader.readUuids(scenario.exceptLines, lines);
+        reader.readUuids(scenario.onlyAgencies, agencies);
+        reader.readUuids(scenario.exceptAgencies, agencies);
+        reader.readUuids(scenario.onlyNodes, nodes);
+        reader.readUuids(scenario.exceptNodes, nodes);
+      }
+    });
+  }
+
+  int SnapshotDataFetcher::getSchedules(std::map<boost::uuids::uuid, Trip>& trips, const std::map<boost::uuids::uuid, Line>&, std::map<boost::uuids::uuid, Path>& paths, const std::map<boost::uuids::uuid, Service>& services, std::vector<Connection>& connections, std::string)
+  {
+    trips.clear();
+    connections.clear();
+    connections.shrink_to_fit();
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::SCHEDULES, begin, end);
+    return readSnapshotSection(hasSection, mapError, begin, end, "schedules", [&](SnapshotReader &reader) {
+      // The nodes are only reachable through the paths here
+      std::map<boost::uuids::uuid, std::reference_wrapper<const Node>> nodesByUuid;
+      for (auto & pathIter : paths) {
+        pathIter.second.tripsRef.clear();
+        for (const Node &node : pathIter.second.nodesRef) {
+          nodesByUuid.emplace(node.uuid, node);
+        }
+      }
+
+      uint32_t tripsCount = reader.read<uint32_t>();
+      std::vector<std::reference_wrapper<Trip>> tripsByIndex;
+      tripsByIndex.reserve(tripsCount);
+      for (uint32_t i = 0; i < tripsCount; i++) {
+        boost::uuids::uuid uuid = reader.readUuid();
+        Path &path = paths.at(reader.readUuid());
+        const Service &service = services.at(reader.readUuid());
+        short allowSameLineTransfers = reader.read<int16_t>();
+        int totalCapacity = reader.read<int32_t>();
+        int seatedCapacity = reader.read<int32_t>();
+        auto tripIter = trips.emplace(uuid, Trip(uuid, path.line.agency, path.line, path, path.line.mode, service, allowSameLineTransfers, totalCapacity, seatedCapacity)).first;
+        Trip &trip = tripIter->second;
+        trip.connectionDepartureTimes.resize(reader.read<uint32_t>());
+        for (auto & departureTime : trip.connectionDepartureTimes) {
+          departureTime = reader.read<int32_t>();
+        }
+        path.tripsRef.push_back(trip);
+        tripsByIndex.push_back(trip);
+      }
+
+      // Connections reference the nodes by their index in the nodes table, nodes that are not in any path are never referenced
+      std::vector<const Node *> nodesByIndex(reader.read<uint32_t>(), nullptr);
+      for (auto & node : nodesByIndex) {
+        auto nodeIter = nodesByUuid.find(reader.readUuid());
+        if (nodeIter != nodesByUuid.end()) {
+          node = &nodeIter->second.get();
+        }
+      }
+      auto getNode = [&nodesByIndex](uint32_t nodeIndex) -> const Node & {
+        if (nodesByIndex.at(nodeIndex) == nullptr) {
+          throw std::out_of_range("Connection node is not in the paths");
+        }
+        return *nodesByIndex[nodeIndex];
+      };
+      uint64_t connectionsCount = reader.read<uint64_t>();
+      connections.reserve(connectionsCount);
+      for (uint64_t i = 0; i < connectionsCount; i++) {
+        uint32_t departureNodeIndex = reader.read<uint32_t>();
+        uint32_t arrivalNodeIndex = reader.read<uint32_t>();
+        int departureTime = reader.read<int32_t>();
+        int arrivalTime = reader.read<int32_t>();
+        Trip &trip = tripsByIndex.at(reader.read<uint32_t>());
+        bool canBoard = reader.read<uint8_t>() == 1;
+        bool canUnboard = reader.read<uint8_t>() == 1;
+        int sequenceInTrip = reader.read<int32_t>();
+        bool canTransferSameLine = reader.read<uint8_t>() == 1;
+        short minWaitingTime = reader.read<int16_t>();
+        connections.push_back(Connection(getNode(departureNodeIndex), getNode(arrivalNodeIndex), departureTime, arrivalTime, trip, canBoard, canUnboard, sequenceInTrip, canTransferSameLine, minWaitingTime));
+      }
+    });
+  }
+
+  bool SnapshotDataFetcher::getSortedConnectionsOrders(std::vector<size_t>& forwardOrder, std::vector<size_t>& reverseOrder)
+  {
+    const char *begin = nullptr, *end = nullptr;
+    bool hasSection = getSection(Section::CONNECTIONS_ORDERS, begin, end);
+    int ret = readSnapshotSection(hasSection, mapError, begin, end, "connections orders", [&](SnapshotReader &reader) {
+      for (auto order : {&forwardOrder, &reverseOrder}) {
+        order->resize(reader.read<uint64_t>());
+        for (auto & index : *order) {
+          index = reader.read<uint64_t>();
+        }
+      }
+    });
+    return ret == 0;
+  }
+
+}
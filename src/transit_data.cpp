@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <thread>
+#include <boost/uuid/name_generator_sha1.hpp>
+
 #include "transit_data.hpp"
 #include "spdlog/spdlog.h"
 
@@ -5,10 +9,13 @@
 #include "calculation_time.hpp"
 #include "mode.hpp"
 #include "data_source.hpp"
+#include "household.hpp"
 #include "person.hpp"
 #include "od_trip.hpp"
+#include "place.hpp"
 #include "agency.hpp"
 #include "service.hpp"
+#include "node.hpp"
 #include "line.hpp"
 #include "path.hpp"
 #include "scenario.hpp"
@@ -16,14 +23,29 @@
 #include "connection.hpp"
 #include "connection_cache.hpp"
 #include "connection_set.hpp"
+#include "trip_filter.hpp"
 
 
 namespace TrRouting {
 
-  TransitData::TransitData(DataFetcher& fetcher, bool cacheAllScenarios) :
-    dataFetcher(fetcher)
+  template <class T>
+  static int getMapMaxUid(const std::map<boost::uuids::uuid, T> &objects)
+  {
+    int maxUid = 0;
+    for (auto & objectIte : objects) {
+      maxUid = std::max(maxUid, (int)objectIte.second.uid);
+    }
+    return maxUid;
+  }
+
+  TransitData::TransitData(DataFetcher& fetcher, bool cacheAllScenarios, size_t connectionCacheMaxBytes, const std::map<std::string, std::string> &customCachePaths) :
+    dataFetcher(fetcher),
+    dataVersion(0),
+    instanceId(++lastInstanceId),
+    allConnections(std::make_shared<const ConnectionSet>(std::vector<std::reference_wrapper<const Trip>>(), std::vector<std::reference_wrapper<const Connection>>(), std::vector<std::reference_wrapper<const Connection>>()))
   {
-    DataStatus loadStatus = loadAllData();
+    DataStatus loadStatus = loadAllData(customCachePaths);
+    dataReadError = loadStatus == DataStatus::DATA_READ_ERROR;
     if (loadStatus != DataStatus::READY) {
       //TODO For now, don't throw on error because Transit server expect to get the dataStatus
       //throw std::exception("Incomplete transit data");
@@ -32,6 +54,9 @@ namespace TrRouting {
     if (cacheAllScenarios) {
       scenarioConnectionCache = new ScenarioConnectionCacheAll();
       spdlog::info("Will cache all connectionSets");
+    } else if (connectionCacheMaxBytes > 0) {
+      scenarioConnectionCache = new ScenarioConnectionCacheLru(connectionCacheMaxBytes);
+      spdlog::info("Will cache the most recently used connectionSets, up to {} bytes", connectionCacheMaxBytes);
     } else {
       scenarioConnectionCache = new ScenarioConnectionCacheOne();
       spdlog::info("Will cache one connectionSet");
@@ -42,8 +67,25 @@ namespace TrRouting {
     delete scenarioConnectionCache;
   }
 
+  const std::vector<std::reference_wrapper<const Connection>> & TransitData::getForwardConnections() const {
+    return allConnections->getForwardConnections();
+  }
+
+  const std::vector<std::reference_wrapper<const Connection>> & TransitData::getReverseConnections() const {
+    return allConnections->getReverseConnections();
+  }
+
+  const std::vector<std::string> & TransitData::getCacheNames() {
+    static const std::vector<std::string> cacheNames {"nodes", "data_sources", "households", "persons", "od_trips", "places", "agencies", "services", "lines", "paths", "scenarios", "schedules"};
+    return cacheNames;
+  }
+
   DataStatus TransitData::getDataStatus() const {
-    if (agencies.size() == 0)
+    if (dataReadError)
+    {
+      return DataStatus::DATA_READ_ERROR;
+    }
+    else if (agencies.size() == 0)
     {
       return DataStatus::NO_AGENCIES;
     }
@@ -77,61 +119,83 @@ namespace TrRouting {
 
   int TransitData::updateNodes(std::string customPath)
   {
-    return dataFetcher.getNodes(nodes, customPath);
+    dataVersion++;
+    int ret = dataFetcher.getNodes(nodes, customPath);
+    nodesMaxUid = getMapMaxUid(nodes);
+    // Rebuild the index even on error, it must not reference nodes of a previous map content
+    nodesSpatialIndex.build(nodes);
+    return ret;
   }
 
   int TransitData::updateDataSources(std::string customPath)
   {
+    dataVersion++;
     return dataFetcher.getDataSources(dataSources, customPath);
   }
-  /* TODO #167
+
   int TransitData::updateHouseholds(std::string customPath)
   {
-    return dataFetcher.getHouseholds(households, householdIndexesByUuid, dataSourceIndexesByUuid, nodeIndexesByUuid, customPath);
+    dataVersion++;
+    return dataFetcher.getHouseholds(households, dataSources, getNodes(), customPath);
   }
-  */
+
   int TransitData::updatePersons(std::string customPath)
   {
+    dataVersion++;
     return dataFetcher.getPersons(persons, getDataSources(), customPath);
   }
   
   int TransitData::updateOdTrips(std::string customPath)
   {
+    dataVersion++;
     return dataFetcher.getOdTrips(odTrips, dataSources, getPersons(), getNodes(), customPath);
   }
-  /* TODO #167
+
   int TransitData::updatePlaces(std::string customPath)
   {
-    return dataFetcher.getPlaces(places, placeIndexesByUuid, dataSourceIndexesByUuid, nodeIndexesByUuid, customPath);
+    dataVersion++;
+    return dataFetcher.getPlaces(places, dataSources, getNodes(), customPath);
   }
-  */ 
+
   int TransitData::updateAgencies(std::string customPath)
   {
+    dataVersion++;
     return dataFetcher.getAgencies(agencies, customPath);
   }
 
   int TransitData::updateServices(std::string customPath)
   {
-    return dataFetcher.getServices(services, customPath);
+    dataVersion++;
+    int ret = dataFetcher.getServices(services, customPath);
+    serviceCalendar = ServiceCalendar(services);
+    return ret;
   }
 
   int TransitData::updateLines(std::string customPath)
   {
-    return dataFetcher.getLines(lines, getAgencies(), getModes(), customPath);
+    dataVersion++;
+    int ret = dataFetcher.getLines(lines, getAgencies(), getModes(), customPath);
+    linesMaxUid = getMapMaxUid(lines);
+    return ret;
   }
 
   int TransitData::updatePaths(std::string customPath)
   {
-    return dataFetcher.getPaths(paths, getLines(), getNodes(), customPath);
+    dataVersion++;
+    int ret = dataFetcher.getPaths(paths, getLines(), getNodes(), customPath);
+    pathsMaxUid = getMapMaxUid(paths);
+    return ret;
   }
 
   int TransitData::updateScenarios(std::string customPath)
   {
+    dataVersion++;
     return dataFetcher.getScenarios(scenarios, getServices(), getLines(), getAgencies(), getNodes(), getModes(), customPath);
   }
 
   int TransitData::updateSchedules(std::string customPath)
   {
+    dataVersion++;
     int ret =  dataFetcher.getSchedules(
       trips,
       getLines(),
@@ -140,6 +204,7 @@ namespace TrRouting {
       connections,
       customPath
     );
+    tripsMaxUid = getMapMaxUid(trips);
     if (ret < 0)
     {
       return ret;
@@ -153,80 +218,106 @@ namespace TrRouting {
   int TransitData::generateForwardAndReverseConnections()
   {
 
-    // Copy the connections to both forward and reverse vectors
-    forwardConnections.clear();
-    reverseConnections.clear();
-    for (size_t i=0; i<connections.size(); i++)
+    std::vector<std::reference_wrapper<const Connection>> forwardConnections;
+    std::vector<std::reference_wrapper<const Connection>> reverseConnections;
+
+    // Use the orders from the data source when it has them, instead of sorting
+    std::vector<size_t> forwardOrder;
+    std::vector<size_t> reverseOrder;
+    bool isSorted = dataFetcher.getSortedConnectionsOrders(forwardOrder, reverseOrder) &&
+      forwardOrder.size() == connections.size() &&
+      reverseOrder.size() == connections.size() &&
+      std::all_of(forwardOrder.begin(), forwardOrder.end(), [this](size_t i) { return i < connections.size(); }) &&
+      std::all_of(reverseOrder.begin(), reverseOrder.end(), [this](size_t i) { return i < connections.size(); });
+    if (isSorted)
     {
-      forwardConnections.push_back(connections[i]);
-      reverseConnections.push_back(connections[i]);
+      spdlog::info("Using the sorted connections from the data source");
+      forwardConnections.reserve(connections.size());
+      reverseConnections.reserve(connections.size());
+      for (size_t i=0; i<connections.size(); i++)
+      {
+        forwardConnections.push_back(connections[forwardOrder[i]]);
+        reverseConnections.push_back(connections[reverseOrder[i]]);
+      }
+    }
+    else
+    {
+      // Copy the connections to both forward and reverse vectors
+      for (size_t i=0; i<connections.size(); i++)
+      {
+        forwardConnections.push_back(connections[i]);
+        reverseConnections.push_back(connections[i]);
+      }
     }
     forwardConnections.shrink_to_fit();
     reverseConnections.shrink_to_fit();
 
     try
     {
-      spdlog::info("Sorting connections...");
-      // Sort forward connections by departure time, trip id, sequence
-      //TODO Maybe this could be handled by an operator in the connection class or at least some function that we could bind
-      std::stable_sort(forwardConnections.begin(), forwardConnections.end(), [](const std::reference_wrapper<const Connection>& connectionA, const std::reference_wrapper<const Connection>& connectionB)
+      if (!isSorted)
       {
-        if (connectionA.get().getDepartureTime() < connectionB.get().getDepartureTime())
-        {
-          return true;
-        }
-        else if (connectionA.get().getDepartureTime() > connectionB.get().getDepartureTime())
-        {
-          return false;
-        }
-        //TODO We could do something  better than comparing uuud for trip. We just need something to have a stable sort
-        if (connectionA.get().getTrip().uuid < connectionB.get().getTrip().uuid)
-        {
-          return true;
-        }
-        else if (connectionA.get().getTrip().uuid > connectionB.get().getTrip().uuid)
-        {
-          return false;
-        }
-        if (connectionA.get().getSequenceInTrip() < connectionB.get().getSequenceInTrip())
-        {
-          return true;
-        }
-        else if (connectionA.get().getSequenceInTrip() > connectionB.get().getSequenceInTrip())
-        {
-          return false;
-        }
-        return false;
-      });
-      // Sort reverse connection by arrival time, trip and sequence
-      std::stable_sort(reverseConnections.begin(), reverseConnections.end(), [](const std::reference_wrapper<const Connection>& connectionA, const std::reference_wrapper<const Connection>& connectionB)
-      {
-        if (connectionA.get().getArrivalTime() > connectionB.get().getArrivalTime())
-        {
-          return true;
-        }
-        else if (connectionA.get().getArrivalTime() < connectionB.get().getArrivalTime())
-        {
-          return false;
-        }
-        if (connectionA.get().getTrip().uuid > connectionB.get().getTrip().uuid) // here we need to reverse sequence!
-        {
-          return true;
-        }
-        else if (connectionA.get().getTrip().uuid < connectionB.get().getTrip().uuid)
+        spdlog::info("Sorting connections...");
+        // Sort forward connections by departure time, trip id, sequence
+        //TODO Maybe this could be handled by an operator in the connection class or at least some function that we could bind
+        std::stable_sort(forwardConnections.begin(), forwardConnections.end(), [](const std::reference_wrapper<const Connection>& connectionA, const std::reference_wrapper<const Connection>& connectionB)
         {
+          if (connectionA.get().getDepartureTime() < connectionB.get().getDepartureTime())
+          {
+            return true;
+          }
+          else if (connectionA.get().getDepartureTime() > connectionB.get().getDepartureTime())
+          {
+            return false;
+          }
+          //TODO We could do something  better than comparing uuud for trip. We just need something to have a stable sort
+          if (connectionA.get().getTrip().uuid < connectionB.get().getTrip().uuid)
+          {
+            return true;
+          }
+          else if (connectionA.get().getTrip().uuid > connectionB.get().getTrip().uuid)
+          {
+            return false;
+          }
+          if (connectionA.get().getSequenceInTrip() < connectionB.get().getSequenceInTrip())
+          {
+            return true;
+          }
+          else if (connectionA.get().getSequenceInTrip() > connectionB.get().getSequenceInTrip())
+          {
+            return false;
+          }
           return false;
-        }
-        if (connectionA.get().getSequenceInTrip() > connectionB.get().getSequenceInTrip()) // here we need to reverse sequence!
-        {
-          return true;
-        }
-        else if (connectionA.get().getSequenceInTrip() < connectionB.get().getSequenceInTrip())
+        });
+        // Sort reverse connection by arrival time, trip and sequence
+        std::stable_sort(reverseConnections.begin(), reverseConnections.end(), [](const std::reference_wrapper<const Connection>& connectionA, const std::reference_wrapper<const Connection>& connectionB)
         {
+          if (connectionA.get().getArrivalTime() > connectionB.get().getArrivalTime())
+          {
+            return true;
+          }
+          else if (connectionA.get().getArrivalTime() < connectionB.get().getArrivalTime())
+          {
+            return false;
+          }
+          if (connectionA.get().getTrip().uuid > connectionB.get().getTrip().uuid) // here we need to reverse sequence!
+          {
+            return true;
+          }
+          else if (connectionA.get().getTrip().uuid < connectionB.get().getTrip().uuid)
+          {
+            return false;
+          }
+          if (connectionA.get().getSequenceInTrip() > connectionB.get().getSequenceInTrip()) // here we need to reverse sequence!
+          {
+            return true;
+          }
+          else if (connectionA.get().getSequenceInTrip() < connectionB.get().getSequenceInTrip())
+          {
+            return false;
+          }
           return false;
-        }
-        return false;
-      });
+        });
+      }
 
       CalculationTime algorithmCalculationTime = CalculationTime();
       algorithmCalculationTime.start();
@@ -250,6 +341,14 @@ namespace TrRouting {
 
       spdlog::debug("-- assign connections to trips -- {} microseconds", algorithmCalculationTime.getDurationMicrosecondsNoStop() - calculationTime);
 
+      std::vector<std::reference_wrapper<const Trip>> allTrips;
+      allTrips.reserve(trips.size());
+      for (auto & tripIte : trips)
+      {
+        allTrips.push_back(tripIte.second);
+      }
+      allConnections = std::make_shared<const ConnectionSet>(std::move(allTrips), std::move(forwardConnections), std::move(reverseConnections));
+
       return 0;
     }
     catch (const std::exception& ex)
@@ -259,80 +358,97 @@ namespace TrRouting {
     }
   }
   
-  DataStatus TransitData::loadAllData() {
+  DataStatus TransitData::loadAllData(const std::map<std::string, std::string> &customCachePaths) {
     int ret = 0;
+    // All the caches are read once, in this order, so the data they reference is already loaded
+    auto cachePath = [&customCachePaths](const std::string &cacheName) {
+      auto customPathIte = customCachePaths.find(cacheName);
+      if (customPathIte == customCachePaths.end()) {
+        return std::string();
+      }
+      spdlog::info("Reading the {} cache from the custom path {}", cacheName, customPathIte->second);
+      return customPathIte->second;
+    };
 
     spdlog::debug("preparing nodes, routes, trips, connections and footpaths...");
-    
+
+    // The uids only need to be unique within this data, the vectors indexed by
+    // uid are sized with the max uids of the data they are used with
+    Agency::resetUids();
+    Service::resetUids();
+    Node::resetUids();
+    Line::resetUids();
+    Path::resetUids();
+    Mode::resetUids();
+    Trip::resetUids();
+
     modes = dataFetcher.getModes();
 
-    ret = updateNodes();
+    ret = updateNodes(cachePath("nodes"));
     // Ignore missing nodes file
     if (ret < 0 && ret != -ENOENT)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    ret = updateDataSources();
+    ret = updateDataSources(cachePath("data_sources"));
     // Ignore missing data sources file
     if (ret < 0 && ret != -ENOENT)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    /* TODO #167
-    ret = updateHouseholds();
-    if (ret < 0)
+    ret = updateHouseholds(cachePath("households"));
+    // Ignore missing households file
+    if (ret < 0 && ret != -ENOENT)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    */
-    ret = updatePersons();
+    ret = updatePersons(cachePath("persons"));
     if (ret < 0)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    ret = updateOdTrips();
+    ret = updateOdTrips(cachePath("od_trips"));
     if (ret < 0)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    /* TODO #167
-    ret = updatePlaces();
-    if (ret < 0)
+    ret = updatePlaces(cachePath("places"));
+    // Ignore missing places file
+    if (ret < 0 && ret != -ENOENT)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    */
-    ret = updateAgencies();
+    ret = updateAgencies(cachePath("agencies"));
     // Ignore missing file
     if (ret < 0 && ret != -ENOENT)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    ret = updateServices();
+    ret = updateServices(cachePath("services"));
     // Ignore missing file
     if (ret < 0 && ret != -ENOENT)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    ret = updateLines();
+    ret = updateLines(cachePath("lines"));
     // Ignore missing file
     if (ret < 0 && ret != -ENOENT)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    ret = updatePaths();
+    ret = updatePaths(cachePath("paths"));
     // Ignore missing file
     if (ret < 0 && ret != -ENOENT)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    ret = updateScenarios();
+    ret = updateScenarios(cachePath("scenarios"));
     // Ignore missing file
     if (ret < 0 && ret != -ENOENT)
     {
       return DataStatus::DATA_READ_ERROR;
     }
-    ret = updateSchedules();
+    ret = updateSchedules(cachePath("schedules"));
     // Ignore missing file
     if (ret < 0 && ret != -ENOENT)
     {
@@ -342,132 +458,129 @@ namespace TrRouting {
     return getDataStatus();
   }
   
-  std::shared_ptr<ConnectionSet> TransitData::getConnectionsForScenario(const Scenario & scenario) const {
-    std::optional<std::shared_ptr<ConnectionSet>> optCurrentCache = scenarioConnectionCache->get(scenario.uuid);
+  std::shared_ptr<ConnectionSet> TransitData::getConnectionsForScenario(const Scenario & scenario, const std::optional<boost::gregorian::date> & date) const {
+    // The connection sets for a date are cached with a key derived from the scenario and the date
+    boost::uuids::uuid cacheKey = scenario.uuid;
+    if (date.has_value()) {
+      cacheKey = boost::uuids::name_generator_sha1(scenario.uuid)(boost::gregorian::to_iso_extended_string(date.value()));
+    }
+
+    std::optional<std::shared_ptr<ConnectionSet>> optCurrentCache = scenarioConnectionCache->get(cacheKey);
     if (optCurrentCache.has_value()) {
       return optCurrentCache.value();
     }
 
-    spdlog::debug("Computing connection cache for scenario {}...", boost::uuids::to_string(scenario.uuid));
-    // Create the cache for scenario
-    // Get the list of enabled trips
-    std::unordered_map<Trip::uid_t, bool> tripsEnabled;
-    std::vector<std::reference_wrapper<const Trip>> cachedTrips; 
-    for (auto & tripIte : getTrips())
+    std::promise<std::shared_ptr<ConnectionSet>> connectionSetPromise;
     {
-      const Trip & trip = tripIte.second;
-      bool enabled = true;
-
-      if (enabled && scenario.servicesList.size() > 0)
-      {
-        if (std::find(scenario.servicesList.begin(), scenario.servicesList.end(), trip.service) == scenario.servicesList.end())
-        {
-          enabled = false;
-        }
+      std::unique_lock<std::mutex> lock(pendingConnectionSetsMutex);
+      auto pendingIte = pendingConnectionSets.find(cacheKey);
+      if (pendingIte != pendingConnectionSets.end()) {
+        // Another thread is building it, wait for its result
+        std::shared_future<std::shared_ptr<ConnectionSet>> pendingConnectionSet = pendingIte->second;
+        lock.unlock();
+        return pendingConnectionSet.get();
       }
-
-      if (enabled && scenario.onlyLines.size() > 0)
-      {
-        if (std::find(scenario.onlyLines.begin(), scenario.onlyLines.end(), trip.line) == scenario.onlyLines.end())
-        {
-          enabled = false;
-        }
-      }
-
-      if (enabled && scenario.onlyModes.size() > 0)
-      {
-        if (std::find(scenario.onlyModes.begin(), scenario.onlyModes.end(), trip.mode) == scenario.onlyModes.end())
-        {
-          enabled = false;
-        }
-      }
-
-      if (enabled  && scenario.onlyNodes.size() > 0)
-      {
-        // FIXME: This is not right, it should look for a node, not the mode
-        // FIXME2: Commented out, since mode is now typed, it won't match
-        /*if (std::find(scenario.onlyNodesIdx()->begin(), scenario.onlyNodesIdx()->end(), trip->modeIdx) == scenario.onlyNodesIdx()->end())
-          {
-          enabled = -1;
-          }(*/
-      }
-
-      if (enabled && scenario.onlyAgencies.size() > 0)
-      {
-        if (std::find(scenario.onlyAgencies.begin(), scenario.onlyAgencies.end(), trip.agency) == scenario.onlyAgencies.end())
-        {
-          enabled = false;
-        }
+      // The build may have completed between the cache lookup and the lock
+      optCurrentCache = scenarioConnectionCache->get(cacheKey);
+      if (optCurrentCache.has_value()) {
+        return optCurrentCache.value();
       }
+      pendingConnectionSets.emplace(cacheKey, connectionSetPromise.get_future().share());
+    }
 
-      if (enabled && scenario.exceptLines.size() > 0)
-      {
-        if (std::find(scenario.exceptLines.begin(), scenario.exceptLines.end(), trip.line) != scenario.exceptLines.end())
-        {
-          enabled = false;
-        }
-      }
+    std::shared_ptr<ConnectionSet> currentCache;
+    try {
+      currentCache = buildConnectionsForScenario(scenario, date);
+      scenarioConnectionCache->set(cacheKey, currentCache);
+      connectionSetPromise.set_value(currentCache);
+    } catch (...) {
+      connectionSetPromise.set_exception(std::current_exception());
+      std::lock_guard<std::mutex> lock(pendingConnectionSetsMutex);
+      pendingConnectionSets.erase(cacheKey);
+      throw;
+    }
+    // It is in the cache now, following requests do not need to wait
+    std::lock_guard<std::mutex> lock(pendingConnectionSetsMutex);
+    pendingConnectionSets.erase(cacheKey);
+    return currentCache;
+  }
 
-      if (enabled && scenario.exceptNodes.size() > 0)
-      {
-        // FIXME: This is not right, it should look for a node, not the mode
-        // FIXME2: Commented out, since mode is now typed, it won't match
-        /*
-          if (std::find(scenario.exceptNodesIdx()->begin(), scenario.exceptNodesIdx()->end(), trip.modeIdx) != scenario.exceptNodesIdx()->end())
-          {
-          enabled = false;
-          }*/
+  void TransitData::warmupConnectionsForScenarios(const std::vector<std::reference_wrapper<const Scenario>> & scenariosToWarmup, unsigned int threadsCount) const {
+    std::atomic<size_t> nextScenarioIndex {0};
+    auto warmupScenarios = [this, &scenariosToWarmup, &nextScenarioIndex]() {
+      for (size_t i = nextScenarioIndex++; i < scenariosToWarmup.size(); i = nextScenarioIndex++) {
+        getConnectionsForScenario(scenariosToWarmup[i]);
       }
+    };
+    threadsCount = std::max(1u, std::min(threadsCount, (unsigned int)scenariosToWarmup.size()));
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < threadsCount; i++) {
+      threads.push_back(std::thread(warmupScenarios));
+    }
+    warmupScenarios();
+    for (auto & thread : threads) {
+      thread.join();
+    }
+  }
 
-      if (enabled && scenario.exceptModes.size() > 0)
-      {
-        if (std::find(scenario.exceptModes.begin(), scenario.exceptModes.end(), trip.mode) != scenario.exceptModes.end())
-        {
-          enabled = false;
+  std::shared_ptr<ConnectionSet> TransitData::buildConnectionsForScenario(const Scenario & scenario, const std::optional<boost::gregorian::date> & date) const {
+    connectionSetBuildCount++;
+    spdlog::debug("Computing connection cache for scenario {}...", boost::uuids::to_string(scenario.uuid));
+    // Create the cache for scenario
+    // For a specific date, only the scenario's services running that day are kept
+    std::vector<std::reference_wrapper<const Service>> services = scenario.servicesList;
+    if (date.has_value()) {
+      // A scenario without services list runs all the services, they also have to be active that day
+      if (scenario.servicesList.empty()) {
+        for (auto & serviceIte : getServices()) {
+          services.push_back(serviceIte.second);
         }
       }
+      services = serviceCalendar.getActiveServices(services, date.value());
+    }
+    // An empty services list would not filter anything, but for a date it means no service runs
+    bool hasServices = !services.empty() || (!date.has_value() && scenario.servicesList.empty());
 
-      if (enabled && scenario.exceptAgencies.size() > 0)
-      {
-        if (std::find(scenario.exceptAgencies.begin(), scenario.exceptAgencies.end(), trip.agency) != scenario.exceptAgencies.end())
-        {
-          enabled = false;
-        }
-      }
-      tripsEnabled[trip.uid] = enabled;
-      if (enabled) {
+    // Get the list of enabled trips
+    // FIXME: The only/except nodes of the scenario are not supported, they were never applied
+    TripFilter tripFilter(services,
+                          {},
+                          scenario.onlyLines,
+                          scenario.exceptLines,
+                          scenario.onlyModes,
+                          scenario.exceptModes,
+                          scenario.onlyAgencies,
+                          scenario.exceptAgencies);
+    std::vector<bool> tripsEnabled(tripsMaxUid + 1, false);
+    std::vector<std::reference_wrapper<const Trip>> cachedTrips; 
+    for (auto & tripIte : getTrips())
+    {
+      const Trip & trip = tripIte.second;
+      if (hasServices && tripFilter.isTripEnabled(trip)) {
+        tripsEnabled[trip.uid] = true;
         cachedTrips.push_back(trip);
       }
     }
 
     // Keep only the connections that are active for enabled trips
-    std::vector<std::reference_wrapper<const Connection>> scenarioForwardConnections;
-    std::vector<std::reference_wrapper<const Connection>> scenarioReverseConnections; 
-    auto forwardLastConnection = forwardConnections.end(); // cache last connection for loop
-    for(auto connection = forwardConnections.begin(); connection != forwardLastConnection; ++connection)
+    const PackedConnections & forwardPackedConnections = allConnections->getForwardPackedConnections();
+    ConnectionMask forwardMask(forwardPackedConnections.size());
+    for (size_t i = 0; i < forwardPackedConnections.size(); i++)
     {
-      const Trip & trip = (*connection).get().getTrip();
-
-      // enabled trips only here:
-      if (tripsEnabled[trip.uid]) {
-        scenarioForwardConnections.push_back(*connection);
+      if (tripsEnabled[forwardPackedConnections.tripUids[i]]) {
+        forwardMask.set(i);
       }
     }
 
-    auto reverseLastConnection = reverseConnections.end(); // cache last connection for loop
-    for(auto connection = reverseConnections.begin(); connection != reverseLastConnection; ++connection)
+    const PackedConnections & reversePackedConnections = allConnections->getReversePackedConnections();
+    ConnectionMask reverseMask(reversePackedConnections.size());
+    for (size_t i = 0; i < reversePackedConnections.size(); i++)
     {
-      const Trip & trip = (*connection).get().getTrip();
-
-      // enabled trips only here:
-      if (tripsEnabled[trip.uid]) {
-        scenarioReverseConnections.push_back(*connection);
+      if (tripsEnabled[reversePackedConnections.tripUids[i]]) {
+        reverseMask.set(i);
       }
     }
 
-    std::shared_ptr<ConnectionSet> currentCache = std::make_shared<ConnectionSet>(cachedTrips, scenarioForwardConnections, scenarioReverseConnections);
-    scenarioConnectionCache->set(scenario.uuid, currentCache);
-    return currentCache;
-    
+    return std::make_shared<ConnectionSet>(allConnections, std::move(cachedTrips), std::move(forwardMask), std::move(reverseMask));
   }
 }
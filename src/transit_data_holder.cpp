@@ -0,0 +1,100 @@
+#include <chrono>
+#include <algorithm>
+#include "spdlog/spdlog.h"
+
+#include "transit_data_holder.hpp"
+#include "data_fetcher.hpp"
+
+namespace TrRouting
+{
+
+  TransitDataHolder::TransitDataHolder(DataFetcher &_dataFetcher, bool _cacheAllScenarios, size_t _connectionCacheMaxBytes) :
+    dataFetcher(_dataFetcher),
+    cacheAllScenarios(_cacheAllScenarios),
+    connectionCacheMaxBytes(_connectionCacheMaxBytes),
+    transitData(std::make_shared<const TransitData>(_dataFetcher, _cacheAllScenarios, _connectionCacheMaxBytes))
+  {
+
+  }
+
+  bool TransitDataHolder::isCacheName(const std::string &cacheName)
+  {
+    const std::vector<std::string> &cacheNames = TransitData::getCacheNames();
+    return cacheName == "all" || std::find(cacheNames.begin(), cacheNames.end(), cacheName) != cacheNames.end();
+  }
+
+  std::map<std::string, std::string> TransitDataHolder::getCustomCachePaths()
+  {
+    std::lock_guard<std::mutex> lock(reloadMutex);
+    return customCachePaths;
+  }
+
+  DataStatus TransitDataHolder::reload(const std::function<void(TransitData &)> &updateNewData)
+  {
+    // The data fetcher is not meant to be used concurrently
+    std::lock_guard<std::mutex> lock(reloadMutex);
+    return reloadLocked(customCachePaths, [&updateNewData](TransitData &newData) {
+      if (updateNewData) {
+        updateNewData(newData);
+      }
+      return newData.getDataStatus();
+    });
+  }
+
+  DataStatus TransitDataHolder::reloadCaches(const std::vector<std::string> &cacheNames, const std::string &customPath)
+  {
+    std::lock_guard<std::mutex> lock(reloadMutex);
+
+    // The caches from a custom path of the previous reloads are read again, with the paths of this reload
+    std::map<std::string, std::string> newCustomCachePaths = customCachePaths;
+    for (auto & cacheName : TransitData::getCacheNames())
+    {
+      if (std::find(cacheNames.begin(), cacheNames.end(), cacheName) == cacheNames.end() &&
+          std::find(cacheNames.begin(), cacheNames.end(), "all") == cacheNames.end())
+      {
+        continue;
+      }
+      if (customPath.empty()) {
+        newCustomCachePaths.erase(cacheName);
+      } else {
+        newCustomCachePaths[cacheName] = customPath;
+      }
+    }
+
+    DataStatus newStatus = reloadLocked(newCustomCachePaths, [](TransitData &newData) {
+      return newData.getDataStatus();
+    });
+    if (newStatus == DataStatus::READY) {
+      customCachePaths = newCustomCachePaths;
+    }
+    return newStatus;
+  }
+
+  DataStatus TransitDataHolder::reloadLocked(const std::map<std::string, std::string> &cachePaths, const std::function<DataStatus(TransitData &)> &buildNewData)
+  {
+    auto buildStart = std::chrono::steady_clock::now();
+    // All the caches are read in a single load, so that the data references each other in the new data only
+    std::shared_ptr<TransitData> newData = std::make_shared<TransitData>(dataFetcher, cacheAllScenarios, connectionCacheMaxBytes, cachePaths);
+    // The new data is not published yet, it can be modified in place
+    DataStatus newStatus = buildNewData(*newData);
+    auto buildEnd = std::chrono::steady_clock::now();
+    lastBuildDuration = std::chrono::duration_cast<std::chrono::microseconds>(buildEnd - buildStart).count();
+
+    std::shared_ptr<const TransitData> currentData = get();
+    if (newStatus != DataStatus::READY && currentData->getDataStatus() == DataStatus::READY) {
+      spdlog::error("The reloaded transit data is not valid ({}), keeping the current data", (int)newStatus);
+      return newStatus;
+    }
+
+    std::shared_ptr<const TransitData> publishedData = std::move(newData);
+    std::atomic_store(&transitData, publishedData);
+    auto publishEnd = std::chrono::steady_clock::now();
+    lastPublishDuration = std::chrono::duration_cast<std::chrono::microseconds>(publishEnd - buildEnd).count();
+    publishedCount++;
+
+    // The previous data is deleted when the last request using it ends
+    spdlog::info("Published new transit data, built in {} ms, published in {} us, {} other users of the previous data", lastBuildDuration / 1000, lastPublishDuration.load(), currentData.use_count() - 1);
+    return newStatus;
+  }
+
+}
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include "trip_filter.hpp"
+#include "trip.hpp"
+#include "service.hpp"
+#include "line.hpp"
+#include "mode.hpp"
+#include "agency.hpp"
+
+namespace TrRouting
+{
+
+  TripFilter::TripFilter(const std::vector<std::reference_wrapper<const Service>> &_onlyServices,
+                         const std::vector<std::reference_wrapper<const Service>> &_exceptServices,
+                         const std::vector<std::reference_wrapper<const Line>> &_onlyLines,
+                         const std::vector<std::reference_wrapper<const Line>> &_exceptLines,
+                         const std::vector<std::reference_wrapper<const Mode>> &_onlyModes,
+                         const std::vector<std::reference_wrapper<const Mode>> &_exceptModes,
+                         const std::vector<std::reference_wrapper<const Agency>> &_onlyAgencies,
+                         const std::vector<std::reference_wrapper<const Agency>> &_exceptAgencies) :
+    onlyServices(toBitset(_onlyServices)),
+    exceptServices(toBitset(_exceptServices)),
+    onlyLines(toBitset(_onlyLines)),
+    exceptLines(toBitset(_exceptLines)),
+    onlyModes(toBitset(_onlyModes)),
+    exceptModes(toBitset(_exceptModes)),
+    onlyAgencies(toBitset(_onlyAgencies)),
+    exceptAgencies(toBitset(_exceptAgencies))
+  {
+
+  }
+
+  template <class T>
+  TripFilter::UidBitset TripFilter::toBitset(const std::vector<std::reference_wrapper<const T>> &objects)
+  {
+    UidBitset bitset;
+    if (objects.empty()) {
+      return bitset;
+    }
+    typename T::uid_t maxUid = 0;
+    for (auto & object : objects) {
+      maxUid = std::max(maxUid, object.get().uid);
+    }
+    bitset.assign(maxUid + 1, false);
+    for (auto & object : objects) {
+      bitset[object.get().uid] = true;
+    }
+    return bitset;
+  }
+
+  bool TripFilter::isTripEnabled(const Trip &trip) const
+  {
+    return passesOnly(onlyServices, trip.service.uid)
+      && passesOnly(onlyLines, trip.line.uid)
+      && passesOnly(onlyModes, trip.mode.uid)
+      && passesOnly(onlyAgencies, trip.agency.uid)
+      && !contains(exceptServices, trip.service.uid)
+      && !contains(exceptLines, trip.line.uid)
+      && !contains(exceptModes, trip.mode.uid)
+      && !contains(exceptAgencies, trip.agency.uid);
+  }
+
+  std::vector<bool> TripFilter::getDisabledTrips(const std::vector<std::reference_wrapper<const Trip>> &trips) const
+  {
+    Trip::uid_t maxUid = 0;
+    for (auto & trip : trips) {
+      maxUid = std::max(maxUid, trip.get().uid);
+    }
+    std::vector<bool> disabledTrips(maxUid + 1, false);
+    for (auto & trip : trips) {
+      if (!isTripEnabled(trip.get())) {
+        disabledTrips[trip.get().uid] = true;
+      }
+    }
+    return disabledTrips;
+  }
+
+}
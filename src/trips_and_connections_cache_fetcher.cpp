@@ -4,11 +4,14 @@
 
 #include <string>
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 #include <errno.h>
 #include <fcntl.h>
 #include <kj/exception.h>
 #include <boost/uuid/string_generator.hpp>
-#include <capnp/serialize-packed.h>
+#include "cache_file_reader.hpp"
 #include "spdlog/spdlog.h"
 
 #include "cache_fetcher.hpp"
@@ -20,6 +23,104 @@
 
 namespace TrRouting
 {
+  // Trip data read from a line cache file, before the trips and connections are created
+  class CachedTripSchedule {
+  public:
+    boost::uuids::uuid uuid;
+    boost::uuids::uuid pathUuid;
+    boost::uuids::uuid serviceUuid;
+    int totalCapacity;
+    int seatedCapacity;
+    std::vector<int> arrivalTimesSeconds;
+    std::vector<int> departureTimesSeconds;
+    std::vector<short> canBoards;
+    std::vector<short> canUnboards;
+  };
+
+  // Schedules of one line, read independently of the other lines
+  class CachedLineSchedules {
+  public:
+    bool fileFound {false};
+    bool readError {false};
+    std::vector<CachedTripSchedule> trips;
+  };
+
+  // Read and decode a line cache file. This does not access any shared data, so lines can be read in parallel
+  static void readLineSchedules(const std::string &cacheFilePath, CachedLineSchedules &lineSchedules)
+  {
+    int fd = open(cacheFilePath.c_str(), O_RDWR);
+    if (fd < 0)
+    {
+      return;
+    }
+    lineSchedules.fileFound = true;
+
+    try
+    {
+      boost::uuids::string_generator uuidGenerator;
+      CacheFileReader capnpLineMessage(fd, {32 * 1024 * 1024});
+      line::Line::Reader capnpLine = capnpLineMessage.getRoot<line::Line>();
+
+      const auto schedules {capnpLine.getSchedules()};
+      for (const auto & schedule : schedules)
+      {
+        std::string serviceUuidStr = schedule.getServiceUuid();
+        boost::uuids::uuid serviceUuid = uuidGenerator(serviceUuidStr);
+
+        const auto periods {schedule.getPeriods()};
+        for (const auto & period : periods)
+        {
+          const auto capnpTrips {period.getTrips()};
+          for (const auto & capnpTrip : capnpTrips)
+          {
+            CachedTripSchedule & trip = lineSchedules.trips.emplace_back();
+            std::string tripUuidStr = capnpTrip.getUuid();
+            std::string pathUuidStr = capnpTrip.getPathUuid();
+            trip.uuid           = uuidGenerator(tripUuidStr);
+            trip.pathUuid       = uuidGenerator(pathUuidStr);
+            trip.serviceUuid    = serviceUuid;
+            trip.totalCapacity  = capnpTrip.getTotalCapacity();
+            trip.seatedCapacity = capnpTrip.getSeatedCapacity();
+
+            auto arrivalTimesSeconds   = capnpTrip.getNodeArrivalTimesSeconds();
+            auto departureTimesSeconds = capnpTrip.getNodeDepartureTimesSeconds();
+            auto canBoards             = capnpTrip.getNodesCanBoard();
+            auto canUnboards           = capnpTrip.getNodesCanUnboard();
+            trip.arrivalTimesSeconds.resize(arrivalTimesSeconds.size());
+            trip.departureTimesSeconds.resize(departureTimesSeconds.size());
+            trip.canBoards.resize(canBoards.size());
+            trip.canUnboards.resize(canUnboards.size());
+            for (unsigned int i = 0; i < arrivalTimesSeconds.size(); i++)
+            {
+              trip.arrivalTimesSeconds[i] = arrivalTimesSeconds[i];
+            }
+            for (unsigned int i = 0; i < departureTimesSeconds.size(); i++)
+            {
+              trip.departureTimesSeconds[i] = departureTimesSeconds[i];
+            }
+            for (unsigned int i = 0; i < canBoards.size(); i++)
+            {
+              trip.canBoards[i] = canBoards[i];
+            }
+            for (unsigned int i = 0; i < canUnboards.size(); i++)
+            {
+              trip.canUnboards[i] = canUnboards[i];
+            }
+          }
+        }
+      }
+    }
+    catch (const kj::Exception& e)
+    {
+      // TODO Do something about faulty cache files?
+      spdlog::error("-- Error reading line cache file -- {}: {}", cacheFilePath, e.getDescription().cStr());
+      lineSchedules.readError = true;
+      lineSchedules.trips.clear();
+    }
+
+    close(fd);
+  }
+
   int CacheFetcher::getSchedules(
     std::map<boost::uuids::uuid, Trip>& trips,
     const std::map<boost::uuids::uuid, Line>& lines,
@@ -33,112 +134,109 @@ namespace TrRouting
     connections.clear();
     connections.shrink_to_fit();
 
-    boost::uuids::string_generator uuidGenerator;
-    boost::uuids::uuid tripUuid, pathUuid;
-    std::string tripUuidStr, pathUuidStr, cacheFileName;
-    unsigned long nodeTimesCount;
     unsigned long linesCount {lines.size()};
-    int lineI {0};
-    
-    spdlog::info("Fetching trips and connections from cache... ({} lines)", linesCount);
-
+    std::vector<std::reference_wrapper<const Line>> linesToRead;
+    std::vector<std::string> cacheFilePaths;
     for (auto & lineIter : lines)
     {
-      const Line &line = lineIter.second;
-      cacheFileName = "lines/line_" + boost::uuids::to_string(line.uuid);
-      std::string cacheFilePath = getFilePath(cacheFileName, customPath) + ".capnpbin";
-      int fd = open(cacheFilePath.c_str(), O_RDWR);
-      if (fd < 0)
+      linesToRead.push_back(lineIter.second);
+      cacheFilePaths.push_back(getFilePath("lines/line_" + boost::uuids::to_string(lineIter.second.uuid), customPath) + ".capnpbin");
+    }
+
+    unsigned int threadsCount = loadingThreadsCount > 0 ? loadingThreadsCount : std::max(std::thread::hardware_concurrency(), 1u);
+    threadsCount = std::min<unsigned long>(threadsCount, std::max(linesCount, 1ul));
+    spdlog::info("Fetching trips and connections from cache... ({} lines, {} threads)", linesCount, threadsCount);
+    CalculationTime loadingTime;
+    loadingTime.start();
+
+    // Decode the line files on all threads, each line in its own buffer
+    std::vector<CachedLineSchedules> linesSchedules(linesCount);
+    std::atomic<unsigned long> nextLineI {0};
+    std::atomic<unsigned long> readLinesCount {0};
+    auto readLines = [&]() {
+      for (unsigned long lineI = nextLineI++; lineI < linesCount; lineI = nextLineI++)
+      {
+        readLineSchedules(cacheFilePaths[lineI], linesSchedules[lineI]);
+        unsigned long readCount = ++readLinesCount;
+        if (readCount % 100 == 0) {
+          spdlog::info("Fetching trips and connections from cache...({:.2}%)", ((((double) readCount) / linesCount) * 100));
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned int threadI = 1; threadI < threadsCount; threadI++)
+    {
+      threads.push_back(std::thread(readLines));
+    }
+    readLines();
+    for (auto & thread : threads)
+    {
+      thread.join();
+    }
+    spdlog::debug("Read {} line files in {} ms", linesCount, loadingTime.getDurationMicrosecondsNoStop() / 1000);
+
+    // Create the trips and connections in the lines order, so the result does not depend on the number of threads
+    for (unsigned long lineI = 0; lineI < linesCount; lineI++)
+    {
+      const Line &line = linesToRead[lineI].get();
+      CachedLineSchedules &lineSchedules = linesSchedules[lineI];
+      if (!lineSchedules.fileFound)
       {
         spdlog::error("no schedules found for line {} ({} {})", boost::uuids::to_string(line.uuid), line.shortname, line.longname);
         continue;
       }
 
-      try
+      for (const CachedTripSchedule & tripSchedule : lineSchedules.trips)
       {
-        ::capnp::PackedFdMessageReader capnpLineMessage(fd, {32 * 1024 * 1024});
-        line::Line::Reader capnpLine = capnpLineMessage.getRoot<line::Line>();
-        
-        const auto schedules {capnpLine.getSchedules()};
-        for (const auto & schedule : schedules)
+        auto & service = services.at(tripSchedule.serviceUuid);
+        Path &path = paths.at(tripSchedule.pathUuid);
+
+        trips.emplace(tripSchedule.uuid, Trip(tripSchedule.uuid,
+                                              line.agency,
+                                              line,
+                                              path,
+                                              line.mode,
+                                              service,
+                                              line.allowSameLineTransfers,
+                                              tripSchedule.totalCapacity,
+                                              tripSchedule.seatedCapacity));
+        //Current trip
+        Trip & trip = trips.at(tripSchedule.uuid);
+
+        // TODO This should probably be done in the Trip constructor (setting the back reference)
+        path.tripsRef.push_back(trip);
+
+        unsigned long nodeTimesCount = tripSchedule.arrivalTimesSeconds.size();
+        trip.connectionDepartureTimes.resize(nodeTimesCount);
+        // nodeTimesCount - 1, since we process node pairs, we have to stop and the second from last
+        for (unsigned long nodeTimeI = 0; nodeTimeI < nodeTimesCount - 1; nodeTimeI++)
         {
-          std::string serviceUuidStr = schedule.getServiceUuid();
-          auto & service  = services.at(uuidGenerator(serviceUuidStr));
-
-          const auto periods {schedule.getPeriods()};
-          for (const auto & period : periods)
-          {
-            const auto capnpTrips {period.getTrips()};
-            for (const auto & capnpTrip : capnpTrips)
-            {
-              tripUuidStr  = capnpTrip.getUuid();
-              pathUuidStr  = capnpTrip.getPathUuid();
-              tripUuid     = uuidGenerator(tripUuidStr);
-              pathUuid     = uuidGenerator(pathUuidStr);
-              Path &path = paths.at(pathUuid);
-              
-              trips.emplace(tripUuid, Trip(tripUuid,
-                                           line.agency,
-                                           line,
-                                           path,
-                                           line.mode,
-                                           service,
-                                           line.allowSameLineTransfers,
-                                           capnpTrip.getTotalCapacity(),
-                                           capnpTrip.getSeatedCapacity()));
-              //Current trip
-              Trip & trip = trips.at(tripUuid);
-              
-              // TODO This should probably be done in the Trip constructor (setting the back reference)
-              path.tripsRef.push_back(trip);
-
-              nodeTimesCount             = capnpTrip.getNodeArrivalTimesSeconds().size();
-              auto arrivalTimesSeconds   = capnpTrip.getNodeArrivalTimesSeconds();
-              auto departureTimesSeconds = capnpTrip.getNodeDepartureTimesSeconds();
-              auto canBoards             = capnpTrip.getNodesCanBoard();
-              auto canUnboards           = capnpTrip.getNodesCanUnboard();
-              trip.connectionDepartureTimes.resize(nodeTimesCount);
-              // nodeTimesCount - 1, since we process node pairs, we have to stop and the second from last
-              for (unsigned long nodeTimeI = 0; nodeTimeI < nodeTimesCount - 1; nodeTimeI++)
-              {
-
-                try {
-                  connections.push_back(Connection(
-                    path.nodesRef.at(nodeTimeI).get(),
-                    path.nodesRef.at(nodeTimeI + 1).get(),
-                    departureTimesSeconds[nodeTimeI],
-                    arrivalTimesSeconds[nodeTimeI + 1],
-                    trip,
-                    canBoards[nodeTimeI] == 1,
-                    canUnboards[nodeTimeI + 1] == 1,
-                    nodeTimeI + 1,
-                    trip.allowSameLineTransfers,
-                    line.mode.isTransferable() ? 0 : -1
-                  ));
-
-                  trip.connectionDepartureTimes[nodeTimeI] = departureTimesSeconds[nodeTimeI];
-                } catch (std::out_of_range const& exc) {
-                  spdlog::error("Index out of range while parsing connection for trip on line ({})", path.line.longname);
-                  return -1;
-                }
-              }
-            }
+          try {
+            connections.push_back(Connection(
+              path.nodesRef.at(nodeTimeI).get(),
+              path.nodesRef.at(nodeTimeI + 1).get(),
+              tripSchedule.departureTimesSeconds.at(nodeTimeI),
+              tripSchedule.arrivalTimesSeconds.at(nodeTimeI + 1),
+              trip,
+              tripSchedule.canBoards.at(nodeTimeI) == 1,
+              tripSchedule.canUnboards.at(nodeTimeI + 1) == 1,
+              nodeTimeI + 1,
+              trip.allowSameLineTransfers,
+              line.mode.isTransferable() ? 0 : -1
+            ));
+
+            trip.connectionDepartureTimes[nodeTimeI] = tripSchedule.departureTimesSeconds[nodeTimeI];
+          } catch (std::out_of_range const& exc) {
+            spdlog::error("Index out of range while parsing connection for trip on line ({})", path.line.longname);
+            return -1;
           }
         }
-        lineI++;
-        if (lineI % 100 == 0) {
-          spdlog::info("Fetching trips and connections from cache...({:.2}%)", ((((double) lineI) / linesCount) * 100));
-        }
       }
-      catch (const kj::Exception& e)
-      {
-        // TODO Do something about faulty cache files?
-        spdlog::error("-- Error reading line cache file -- {}: {}", cacheFilePath, e.getDescription().cStr());
-      }
-
-      close(fd);
+      // Release the decoded line as soon as its connections are created
+      lineSchedules.trips.clear();
+      lineSchedules.trips.shrink_to_fit();
     }
-    spdlog::info("Fetching trips and connections from cache DONE");
+    spdlog::info("Fetching trips and connections from cache DONE ({} ms)", loadingTime.getDurationMicrosecondsNoStop() / 1000);
 
     return 0;
 
@@ -4,6 +4,10 @@
 #define BOOST_SPIRIT_THREADSAFE
 
 #include <fstream>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+#include <new>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/string_generator.hpp>
 #include "spdlog/spdlog.h"
@@ -13,10 +17,11 @@
 #include "parameters.hpp"
 #include "routing_result.hpp"
 #include "scenario.hpp"
-#include "calculator.hpp"
+#include "calculator_pool.hpp"
 #include "benchmark_CSA_test.hpp"
 #include "transit_data.hpp"
 #include "euclideangeofilter.hpp"
+#include "od_trips_writer.hpp"
 
 using namespace TrRouting;
 
@@ -27,6 +32,29 @@ TransitData* transitData; //TODO Required only to get the scenario, we might wan
 EuclideanGeoFilter* geoFilter;
 std::ofstream benchmarkResultsFile;
 std::ofstream benchmarkDetailedResultsFile;
+std::ofstream benchmarkPoolResultsFile;
+
+// Count the heap allocations of the benchmark program, to compare the number of allocations per request
+std::atomic<unsigned long> allocationCount(0);
+
+void* operator new(std::size_t size)
+{
+  allocationCount++;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
 
 /**
  * The benchmarks require cache data to be available in the
@@ -79,16 +107,20 @@ public:
     struct tm * timeinfo;
     char resultFilename[80];
     char detailedResultFilename[80];
+    char poolResultFilename[80];
 
     time(&rawtime);
     timeinfo = localtime(&rawtime);
 
     strftime (resultFilename, 80, "benchmarkResults_%Y%m%d_%H%M.csv", timeinfo);
     strftime (detailedResultFilename, 80, "benchmarkResultsDetailed_%Y%m%d_%H%M.csv", timeinfo);
+    strftime (poolResultFilename, 80, "benchmarkPoolResults_%Y%m%d_%H%M.csv", timeinfo);
     benchmarkResultsFile.open (resultFilename, std::ofstream::out);
     benchmarkDetailedResultsFile.open (detailedResultFilename, std::ofstream::out);
+    benchmarkPoolResultsFile.open (poolResultFilename, std::ofstream::out);
 
-    benchmarkResultsFile << ",Forward - no alternatives,Arrival time - no alternatives,Forward - alternatives,Arrival time - alternatives"  << std::endl;
+    benchmarkResultsFile << ",Forward - no alternatives,Arrival time - no alternatives,Forward - alternatives,Arrival time - alternatives,Forward - multi-criteria alternatives"  << std::endl;
+    benchmarkPoolResultsFile << ",New calculator - seconds per request,New calculator - allocations per request,Pooled calculator - seconds per request,Pooled calculator - allocations per request"  << std::endl;
 
   }
 
@@ -97,6 +129,40 @@ public:
   {
     benchmarkResultsFile.close();
     benchmarkDetailedResultsFile.close();
+    benchmarkPoolResultsFile.close();
+  }
+
+  // Run the query nbIter times, either with a new calculator for each request, like the server used to do, or with a pooled calculator
+  void benchmarkCalculatorAllocations(TrRouting::RouteParameters &routeParams, bool usePool, int nbIter)
+  {
+    CalculatorPool calculatorPool(*geoFilter);
+    // Warm up the pool and the scenario's connection cache, so that only steady-state requests are measured
+    try {
+      calculatorPool.getCalculator(*transitData).calculateSingle(routeParams);
+    } catch (TrRouting::NoRoutingFoundException& e) {
+      // Nothing to do, only the timing matters here
+    }
+
+    unsigned long allocationsBefore = allocationCount;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < nbIter; i++)
+    {
+      try {
+        if (usePool) {
+          calculatorPool.getCalculator(*transitData).calculateSingle(routeParams);
+        } else {
+          Calculator calculator(*transitData, *geoFilter);
+          calculator.calculateSingle(routeParams);
+        }
+      } catch (TrRouting::NoRoutingFoundException& e) {
+        // Nothing to do, only the timing matters here
+      }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    unsigned long allocations = allocationCount - allocationsBefore;
+
+    double secondsPerRequest = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / (double)nbIter;
+    benchmarkPoolResultsFile << "," << std::fixed << secondsPerRequest << std::setprecision(9) << "," << allocations / (double)nbIter;
   }
 
   void benchmarkCurrentParams(TrRouting::RouteParameters &routeParams, bool expectResult, int nbIter)
@@ -138,7 +204,7 @@ public:
     benchmarkResultsFile << "," << std::fixed << resultSum / (double)nbIter << std::setprecision(9);
   }
 
-  void benchmarkCurrentData(std::string testType, BenchmarkDataTuple paramTuple, bool alternatives, bool forward, int nbIter)
+  TrRouting::RouteParameters createRouteParameters(BenchmarkDataTuple paramTuple, bool alternatives, bool forward, std::optional<int> maxTransfers = std::nullopt)
   {
     const Scenario & scenario = transitData->getScenarios().at(scenarioUuid);
 
@@ -156,6 +222,21 @@ public:
       alternatives,
       forward
     );
+    if (!maxTransfers.has_value()) {
+      return routeParams;
+    }
+    return TrRouting::RouteParameters(
+      std::make_unique<TrRouting::Point>(std::get<parameterIndexes::LAT_ORIG>(paramTuple), std::get<parameterIndexes::LON_ORIG>(paramTuple)),
+      std::make_unique<TrRouting::Point>(std::get<parameterIndexes::LAT_DEST>(paramTuple), std::get<parameterIndexes::LON_DEST>(paramTuple)),
+      alternatives,
+      routeParams,
+      maxTransfers
+    );
+  }
+
+  void benchmarkCurrentData(std::string testType, BenchmarkDataTuple paramTuple, bool alternatives, bool forward, int nbIter, std::optional<int> maxTransfers = std::nullopt)
+  {
+    TrRouting::RouteParameters routeParams = createRouteParameters(paramTuple, alternatives, forward, maxTransfers);
 
     try
     {
@@ -212,5 +293,99 @@ TEST_P(BenchmarkCSATests, BenchmarkOriginDestinationQuery)
   benchmarkCurrentData("Forward - alternatives", param, true, true, NB_ITER);
   // Alternatives, arrival time
   benchmarkCurrentData("Arrival time - alternatives", param, true, false, NB_ITER);
+  // Alternatives as the arrival time/transfers Pareto front, forward
+  benchmarkCurrentData("Forward - multi-criteria alternatives", param, true, true, NB_ITER, 4);
   benchmarkResultsFile << std::endl;
 }
+
+TEST_P(BenchmarkCSATests, BenchmarkPooledCalculator)
+{
+  BenchmarkDataTuple param = GetParam();
+  TrRouting::RouteParameters routeParams = createRouteParameters(param, false, true);
+
+  // One line in pool results file per test data
+  benchmarkPoolResultsFile << std::get<parameterIndexes::TEST_DESCRIPTION>(param);
+  benchmarkCalculatorAllocations(routeParams, false, NB_ITER);
+  benchmarkCalculatorAllocations(routeParams, true, NB_ITER);
+  benchmarkPoolResultsFile << std::endl;
+}
+
+// Compare the data loading time at startup when reading the line schedules on one thread or on all cores
+TEST(BenchmarkCSALoadingTests, BenchmarkSchedulesLoading)
+{
+  time_t rawtime;
+  struct tm * timeinfo;
+  char loadingResultFilename[80];
+  time(&rawtime);
+  timeinfo = localtime(&rawtime);
+  strftime (loadingResultFilename, 80, "benchmarkLoadingResults_%Y%m%d_%H%M.csv", timeinfo);
+  std::ofstream benchmarkLoadingResultsFile;
+  benchmarkLoadingResultsFile.open (loadingResultFilename, std::ofstream::out);
+  benchmarkLoadingResultsFile << "Threads,Loading time - seconds" << std::endl;
+
+  std::vector<unsigned int> threadsCounts { 1, std::max(std::thread::hardware_concurrency(), 1u) };
+  for (unsigned int threadsCount : threadsCounts)
+  {
+    CacheFetcher cacheFetcher = TrRouting::CacheFetcher("cache/demo_transition", threadsCount);
+    auto start = std::chrono::high_resolution_clock::now();
+    TrRouting::TransitData loadedTransitData(cacheFetcher);
+    auto end = std::chrono::high_resolution_clock::now();
+    ASSERT_EQ(DataStatus::READY, loadedTransitData.getDataStatus());
+
+    benchmarkLoadingResultsFile << threadsCount << "," << std::fixed << std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 << std::endl;
+  }
+  benchmarkLoadingResultsFile.close();
+}
+
+// Compare the od trips routing with and without grouping the od trips sharing their origin and departure time
+TEST(BenchmarkCSAOdTripsTests, BenchmarkOdTripsGrouping)
+{
+  CacheFetcher cacheFetcher = TrRouting::CacheFetcher("cache/demo_transition");
+  TrRouting::TransitData loadedTransitData(cacheFetcher);
+  ASSERT_EQ(DataStatus::READY, loadedTransitData.getDataStatus());
+  if (loadedTransitData.getOdTrips().size() == 0) {
+    GTEST_SKIP() << "No od trips in the cache data";
+  }
+  EuclideanGeoFilter odTripsGeoFilter;
+  TrRouting::Calculator calculator(loadedTransitData, odTripsGeoFilter);
+  boost::uuids::string_generator uuidGenerator;
+  TrRouting::RouteParameters routeParams(std::make_unique<TrRouting::Point>(45.5242, -73.5817),
+    std::make_unique<TrRouting::Point>(45.5466, -73.6405),
+    loadedTransitData.getScenarios().at(uuidGenerator("ed42d920-0349-4f64-8590-4698056c2734")),
+    8 * 3600,
+    DEFAULT_MIN_WAITING_TIME,
+    DEFAULT_MAX_TOTAL_TIME,
+    DEFAULT_MAX_ACCESS_TRAVEL_TIME,
+    DEFAULT_MAX_EGRESS_TRAVEL_TIME,
+    DEFAULT_MAX_TRANSFER_TRAVEL_TIME,
+    DEFAULT_FIRST_WAITING_TIME,
+    false,
+    true);
+
+  time_t rawtime;
+  struct tm * timeinfo;
+  char odTripsResultFilename[80];
+  time(&rawtime);
+  timeinfo = localtime(&rawtime);
+  strftime (odTripsResultFilename, 80, "benchmarkOdTripsResults_%Y%m%d_%H%M.csv", timeinfo);
+  std::ofstream benchmarkOdTripsResultsFile;
+  benchmarkOdTripsResultsFile.open (odTripsResultFilename, std::ofstream::out);
+  benchmarkOdTripsResultsFile << "Grouped,Od trips,Forward calculations,Scanned connections per od trip,Seconds per od trip" << std::endl;
+
+  for (bool groupOdTrips : { false, true })
+  {
+    TrRouting::OdTripLegacyParameters odTripParameters;
+    odTripParameters.groupOdTrips = groupOdTrips;
+    TrRouting::OdTripsJsonWriter writer;
+    auto start = std::chrono::high_resolution_clock::now();
+    calculator.odTripsRouting(routeParams, writer, odTripParameters);
+    auto end = std::chrono::high_resolution_clock::now();
+    nlohmann::json json = nlohmann::json::parse(writer.getJsonString());
+    size_t odTripsCount = std::max((size_t)1, json["odTrips"].size());
+
+    benchmarkOdTripsResultsFile << groupOdTrips << "," << json["odTrips"].size() << "," << json["forwardCalculationsCount"].get<int>() << ","
+      << json["scannedConnectionsCount"].get<long long>() / (double)odTripsCount << ","
+      << std::fixed << std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1e-9 / odTripsCount << std::endl;
+  }
+  benchmarkOdTripsResultsFile.close();
+}
@@ -1,9 +1,13 @@
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <filesystem>
+#include <capnp/message.h>
 
 #include "gtest/gtest.h" // we will add the path to C preprocessor later
 #include "cache_fetcher.hpp"
 #include "cache_fetcher_test.hpp"
+#include "cache_file_reader.hpp"
 #include "agency.hpp"
 #include "capnp/agencyCollection.capnp.h"
 
@@ -51,3 +55,43 @@ TEST_F(AgencyCacheFetcherFixtureTests, TestGetAgenciesFileNotExists)
     ASSERT_EQ(0u, agencies.size());
 }
 
+
+// Write the valid agencies in the mappable format, they should be read the same as the packed file
+TEST_F(AgencyCacheFetcherFixtureTests, TestGetAgenciesMappable)
+{
+    const std::string MAPPABLE_CUSTOM_PATH = "mappableCacheFiles";
+    fs::create_directory(BASE_CACHE_DIRECTORY_NAME + "/" + MAPPABLE_CUSTOM_PATH);
+
+    int fd = open(cacheFetcher.getFilePath("agencies.capnpbin", VALID_CUSTOM_PATH).c_str(), O_RDONLY);
+    ASSERT_LE(0, fd);
+    {
+        TrRouting::CacheFileReader packedReader(fd, {16 * 1024 * 1024});
+        ASSERT_FALSE(packedReader.isMapped());
+        ::capnp::MallocMessageBuilder message;
+        message.setRoot(packedReader.getRoot<agencyCollection::AgencyCollection>());
+        TrRouting::CacheFetcher::saveToCapnpCacheFile(message, cacheFetcher.getFilePath("agencies.capnpbin", MAPPABLE_CUSTOM_PATH));
+    }
+    close(fd);
+
+    fd = open(cacheFetcher.getFilePath("agencies.capnpbin", MAPPABLE_CUSTOM_PATH).c_str(), O_RDONLY);
+    ASSERT_LE(0, fd);
+    {
+        TrRouting::CacheFileReader mappedReader(fd, {16 * 1024 * 1024});
+        ASSERT_TRUE(mappedReader.isMapped());
+        ASSERT_EQ(2u, mappedReader.getRoot<agencyCollection::AgencyCollection>().getAgencies().size());
+    }
+    close(fd);
+
+    std::map<boost::uuids::uuid, TrRouting::Agency> validAgencies;
+    cacheFetcher.getAgencies(validAgencies, VALID_CUSTOM_PATH);
+    int retVal = cacheFetcher.getAgencies(agencies, MAPPABLE_CUSTOM_PATH);
+    fs::remove_all(BASE_CACHE_DIRECTORY_NAME + "/" + MAPPABLE_CUSTOM_PATH);
+
+    ASSERT_EQ(0, retVal);
+    ASSERT_EQ(validAgencies.size(), agencies.size());
+    for (auto & [uuid, agency] : validAgencies)
+    {
+        ASSERT_EQ(agency.acronym, agencies.at(uuid).acronym);
+        ASSERT_EQ(agency.name, agencies.at(uuid).name);
+    }
+}
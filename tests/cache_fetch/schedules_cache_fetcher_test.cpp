@@ -95,3 +95,33 @@ TEST_F(ScheduleCacheFetcherFixtureTests, TestGetSchedulesValid)
     ASSERT_EQ(50u, trips.size());
     ASSERT_EQ(275u, connections.size());
 }
+
+// Lines are read in parallel, the connections should be the same as when read on a single thread
+TEST_F(ScheduleCacheFetcherFixtureTests, TestGetSchedulesSameWithThreads)
+{
+    TrRouting::CacheFetcher singleThreadFetcher = TrRouting::CacheFetcher(BASE_CACHE_DIRECTORY_NAME, 1);
+    int retVal = singleThreadFetcher.getSchedules(trips, lines, paths, services, connections, VALID_CUSTOM_PATH);
+    ASSERT_EQ(0, retVal);
+    std::vector<std::tuple<boost::uuids::uuid, int, int>> singleThreadConnections;
+    for (auto & connection : connections)
+    {
+        singleThreadConnections.push_back(std::make_tuple(connection.getTrip().uuid, connection.getDepartureTime(), connection.getArrivalTime()));
+    }
+
+    // Paths keep a reference to their trips, start from a fresh copy of the data
+    for (auto & pathIter : paths)
+    {
+        pathIter.second.tripsRef.clear();
+    }
+    TrRouting::CacheFetcher multiThreadFetcher = TrRouting::CacheFetcher(BASE_CACHE_DIRECTORY_NAME, 4);
+    retVal = multiThreadFetcher.getSchedules(trips, lines, paths, services, connections, VALID_CUSTOM_PATH);
+    ASSERT_EQ(0, retVal);
+    ASSERT_EQ(50u, trips.size());
+    ASSERT_EQ(singleThreadConnections.size(), connections.size());
+    for (size_t i = 0; i < connections.size(); i++)
+    {
+        ASSERT_EQ(std::get<0>(singleThreadConnections[i]), connections[i].getTrip().uuid);
+        ASSERT_EQ(std::get<1>(singleThreadConnections[i]), connections[i].getDepartureTime());
+        ASSERT_EQ(std::get<2>(singleThreadConnections[i]), connections[i].getArrivalTime());
+    }
+}
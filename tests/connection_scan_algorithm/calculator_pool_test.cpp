@@ -0,0 +1,88 @@
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "calculator.hpp"
+#include "calculator_pool.hpp"
+#include "connection_set_test.hpp"
+#include "euclideangeofilter.hpp"
+
+// Test that each thread gets its own calculator, which is reused for the following requests
+TEST_F(ConnectionSetFixtureTests, TestCalculatorPerThread)
+{
+    TrRouting::EuclideanGeoFilter geoFilter;
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+
+    TrRouting::Calculator * mainCalculator = &calculatorPool.getCalculator(transitData);
+    ASSERT_EQ(mainCalculator, &calculatorPool.getCalculator(transitData));
+    ASSERT_EQ(1u, calculatorPool.getCreatedCount());
+
+    TrRouting::Calculator * threadCalculator = nullptr;
+    std::thread thread([this, &calculatorPool, &threadCalculator]() {
+        threadCalculator = &calculatorPool.getCalculator(transitData);
+    });
+    thread.join();
+
+    ASSERT_NE(nullptr, threadCalculator);
+    ASSERT_NE(mainCalculator, threadCalculator);
+    ASSERT_EQ(2u, calculatorPool.getCreatedCount());
+}
+
+// Test that the calculator is re-created when the transit data is updated
+TEST_F(ConnectionSetFixtureTests, TestCalculatorDataUpdate)
+{
+    TrRouting::EuclideanGeoFilter geoFilter;
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+
+    calculatorPool.getCalculator(transitData);
+    unsigned int dataVersion = transitData.getDataVersion();
+    transitData.updateAgencies();
+    ASSERT_NE(dataVersion, transitData.getDataVersion());
+
+    calculatorPool.getCalculator(transitData);
+    ASSERT_EQ(2u, calculatorPool.getCreatedCount());
+}
+
+// Test that the calculator is re-created for another transit data
+TEST_F(ConnectionSetFixtureTests, TestCalculatorOtherData)
+{
+    TrRouting::EuclideanGeoFilter geoFilter;
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+    TrRouting::TransitData otherTransitData(dataFetcher);
+    ASSERT_NE(transitData.getInstanceId(), otherTransitData.getInstanceId());
+
+    calculatorPool.getCalculator(transitData);
+    calculatorPool.getCalculator(otherTransitData);
+    ASSERT_EQ(2u, calculatorPool.getCreatedCount());
+    calculatorPool.getCalculator(otherTransitData);
+    ASSERT_EQ(2u, calculatorPool.getCreatedCount());
+}
+
+// Test that the calculators of a previous data are deleted once released, so they do not keep its memory
+TEST_F(ConnectionSetFixtureTests, TestCalculatorReleaseStaleData)
+{
+    TrRouting::EuclideanGeoFilter geoFilter;
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+    TrRouting::TransitData newTransitData(dataFetcher);
+
+    // Another thread's calculator, idle once its request is done
+    std::thread thread([this, &calculatorPool]() {
+        calculatorPool.getCalculator(transitData);
+        calculatorPool.releaseCalculator();
+    });
+    thread.join();
+    ASSERT_EQ(1u, calculatorPool.getCalculatorsCount());
+
+    // Publishing the new data deletes the idle calculator, the one in use is only deleted when it is released
+    {
+        calculatorPool.getCalculator(transitData);
+        TrRouting::CalculatorRelease calculatorRelease(calculatorPool);
+        calculatorPool.releaseStaleCalculators(newTransitData.getInstanceId());
+        ASSERT_EQ(1u, calculatorPool.getCalculatorsCount());
+    }
+    ASSERT_EQ(0u, calculatorPool.getCalculatorsCount());
+
+    // The calculators of the current data are kept
+    calculatorPool.getCalculator(newTransitData);
+    calculatorPool.releaseCalculator();
+    ASSERT_EQ(1u, calculatorPool.getCalculatorsCount());
+}
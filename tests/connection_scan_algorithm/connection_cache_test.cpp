@@ -1,4 +1,6 @@
 #include <errno.h>
+#include <thread>
+#include <set>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
@@ -9,6 +11,7 @@
 #include "connection_cache.hpp"
 #include "spdlog/spdlog.h"
 #include "scenario.hpp"
+#include "trip.hpp"
 
 // Test that the TransitData gets and create the connection cache correctly for various scenarios
 TEST_F(ConnectionSetFixtureTests, TestCacheAssignation)
@@ -19,25 +22,230 @@ TEST_F(ConnectionSetFixtureTests, TestCacheAssignation)
     // Get the cache a first time for a given scenario
     std::shared_ptr<TrRouting::ConnectionSet> cache = transitData.getConnectionsForScenario(scenario);
 
-    ASSERT_EQ(17, cache->getForwardConnections().size());
-    ASSERT_EQ(17, cache->getReverseConnections().size());
+    ASSERT_EQ(17, cache->getForwardConnectionsCount());
+    ASSERT_EQ(17, cache->getReverseConnectionsCount());
 
     // Get the cache a second time for the same scenario
     cache = transitData.getConnectionsForScenario(scenario);
 
-    ASSERT_EQ(17, cache->getForwardConnections().size());
-    ASSERT_EQ(17, cache->getReverseConnections().size());
+    ASSERT_EQ(17, cache->getForwardConnectionsCount());
+    ASSERT_EQ(17, cache->getReverseConnectionsCount());
 
     // Get the cache for a second scenario
     cache = transitData.getConnectionsForScenario(scenario2);
 
-    ASSERT_EQ(9, cache->getForwardConnections().size());
-    ASSERT_EQ(9, cache->getReverseConnections().size());
+    ASSERT_EQ(9, cache->getForwardConnectionsCount());
+    ASSERT_EQ(9, cache->getReverseConnectionsCount());
 
     // Get the cache for a first scenario again
     cache = transitData.getConnectionsForScenario(scenario);
 
-    ASSERT_EQ(17, cache->getForwardConnections().size());
-    ASSERT_EQ(17, cache->getReverseConnections().size());
+    ASSERT_EQ(17, cache->getForwardConnectionsCount());
+    ASSERT_EQ(17, cache->getReverseConnectionsCount());
 
 }
+
+// Test that the packed columns of the connection set match the connections they were built from
+TEST_F(ConnectionSetFixtureTests, TestPackedConnections)
+{
+    const TrRouting::Scenario & scenario = transitData.getScenarios().at(TestDataFetcher::scenarioUuid);
+    std::shared_ptr<TrRouting::ConnectionSet> cache = transitData.getConnectionsForScenario(scenario);
+
+    const TrRouting::PackedConnections & forwardPacked = cache->getForwardPackedConnections();
+    ASSERT_EQ(cache->getForwardConnections().size(), forwardPacked.size());
+    for (size_t i = 0; i < forwardPacked.size(); i++) {
+        const TrRouting::Connection & connection = cache->getForwardConnections()[i];
+        ASSERT_EQ(connection.getDepartureNode().uid, forwardPacked.departureNodeUids[i]);
+        ASSERT_EQ(connection.getArrivalNode().uid, forwardPacked.arrivalNodeUids[i]);
+        ASSERT_EQ(connection.getDepartureTime(), forwardPacked.departureTimes[i]);
+        ASSERT_EQ(connection.getArrivalTime(), forwardPacked.arrivalTimes[i]);
+        ASSERT_EQ(connection.getTrip().uid, forwardPacked.tripUids[i]);
+        ASSERT_EQ(connection.canBoard(), forwardPacked.canBoard(i));
+        ASSERT_EQ(connection.canUnboard(), forwardPacked.canUnboard(i));
+        ASSERT_EQ(connection.getMinWaitingTimeOrDefault(180), forwardPacked.getMinWaitingTimeOrDefault(i, 180));
+    }
+
+    const TrRouting::PackedConnections & reversePacked = cache->getReversePackedConnections();
+    ASSERT_EQ(cache->getReverseConnections().size(), reversePacked.size());
+    for (size_t i = 0; i < reversePacked.size(); i++) {
+        const TrRouting::Connection & connection = cache->getReverseConnections()[i];
+        ASSERT_EQ(connection.getArrivalTime(), reversePacked.arrivalTimes[i]);
+        ASSERT_EQ(connection.getTrip().uid, reversePacked.tripUids[i]);
+    }
+
+    // Index and iterator hour caches should point to the same connection
+    for (int hour = 0; hour < 32; hour++) {
+        ASSERT_EQ(cache->getForwardConnectionsBeginAtDepartureHour(hour) - cache->getForwardConnections().cbegin(), cache->getForwardConnectionsBeginIndexAtDepartureHour(hour));
+        ASSERT_EQ(cache->getReverseConnectionsBeginAtArrivalHour(hour) - cache->getReverseConnections().cbegin(), cache->getReverseConnectionsBeginIndexAtArrivalHour(hour));
+    }
+}
+
+// Test that the scenarios share the connections of the transit data and only differ by their masks
+TEST_F(ConnectionSetFixtureTests, TestConnectionSetMasks)
+{
+    std::shared_ptr<TrRouting::ConnectionSet> set1 = transitData.getConnectionsForScenario(transitData.getScenarios().at(TestDataFetcher::scenarioUuid));
+    std::shared_ptr<TrRouting::ConnectionSet> set2 = transitData.getConnectionsForScenario(transitData.getScenarios().at(TestDataFetcher::scenario2Uuid));
+
+    ASSERT_EQ(&transitData.getForwardConnections(), &set1->getForwardConnections());
+    ASSERT_EQ(&transitData.getForwardConnections(), &set2->getForwardConnections());
+    ASSERT_EQ(&set1->getReversePackedConnections(), &set2->getReversePackedConnections());
+    ASSERT_EQ(set1->getForwardConnectionsBeginIndexAtDepartureHour(10), set2->getForwardConnectionsBeginIndexAtDepartureHour(10));
+
+    // The enabled connections are those of the scenario's trips
+    std::set<int> set2TripUids;
+    for (const TrRouting::Trip & trip : set2->getTrips()) {
+        set2TripUids.insert(trip.uid);
+    }
+    const TrRouting::PackedConnections & forwardPacked = set2->getForwardPackedConnections();
+    size_t enabledCount = 0;
+    for (size_t i = set2->getForwardMask().next(0); i != forwardPacked.size(); i = set2->getForwardMask().next(i + 1)) {
+        ASSERT_TRUE(set2TripUids.count(forwardPacked.tripUids[i]) > 0);
+        enabledCount++;
+    }
+    ASSERT_EQ(set2->getForwardConnectionsCount(), enabledCount);
+    for (size_t i = 0; i < forwardPacked.size(); i++) {
+        ASSERT_EQ(set2TripUids.count(forwardPacked.tripUids[i]) > 0, set2->getForwardMask().isSet(i));
+    }
+}
+
+// Test the scans of the connection mask, across words
+TEST(ConnectionMaskTests, NextAndPrevious)
+{
+    TrRouting::ConnectionMask mask(200);
+    ASSERT_EQ(200u, mask.next(0));
+    ASSERT_EQ(200u, mask.previous(200));
+
+    mask.set(3);
+    mask.set(64);
+    mask.set(130);
+    mask.set(199);
+    mask.set(199);
+    ASSERT_EQ(4u, mask.count());
+    ASSERT_EQ(3u, mask.next(0));
+    ASSERT_EQ(3u, mask.next(3));
+    ASSERT_EQ(64u, mask.next(4));
+    ASSERT_EQ(130u, mask.next(65));
+    ASSERT_EQ(199u, mask.next(131));
+    ASSERT_EQ(200u, mask.next(200));
+    ASSERT_EQ(199u, mask.previous(200));
+    ASSERT_EQ(130u, mask.previous(199));
+    ASSERT_EQ(64u, mask.previous(130));
+    ASSERT_EQ(3u, mask.previous(64));
+    ASSERT_EQ(200u, mask.previous(3));
+
+    TrRouting::ConnectionMask fullMask(70, true);
+    ASSERT_EQ(70u, fullMask.count());
+    ASSERT_EQ(69u, fullMask.next(69));
+    ASSERT_EQ(70u, fullMask.next(70));
+    ASSERT_EQ(69u, fullMask.previous(70));
+}
+
+// Test that the lru cache evicts the least recently used connection sets when over its size
+TEST_F(ConnectionSetFixtureTests, TestLruCacheEviction)
+{
+    std::shared_ptr<TrRouting::ConnectionSet> set1 = transitData.getConnectionsForScenario(transitData.getScenarios().at(TestDataFetcher::scenarioUuid));
+    std::shared_ptr<TrRouting::ConnectionSet> set2 = transitData.getConnectionsForScenario(transitData.getScenarios().at(TestDataFetcher::scenario2Uuid));
+    ASSERT_GT(set1->getMemorySize(), set2->getMemorySize());
+
+    boost::uuids::string_generator uuidGenerator;
+    boost::uuids::uuid uuid1 = uuidGenerator("00000000-0000-0000-0000-000000000001");
+    boost::uuids::uuid uuid2 = uuidGenerator("00000000-0000-0000-0000-000000000002");
+    boost::uuids::uuid uuid3 = uuidGenerator("00000000-0000-0000-0000-000000000003");
+
+    // Room for the large set and one small one
+    TrRouting::ScenarioConnectionCacheLru cache(set1->getMemorySize() + set2->getMemorySize());
+    ASSERT_FALSE(cache.get(uuid1).has_value());
+    cache.set(uuid1, set1);
+    cache.set(uuid2, set2);
+    ASSERT_EQ(2u, cache.getCount());
+    ASSERT_EQ(set1->getMemorySize() + set2->getMemorySize(), cache.getSizeBytes());
+
+    // Use the first set, the second one is now the least recently used
+    ASSERT_EQ(set1, cache.get(uuid1).value());
+    cache.set(uuid3, set2);
+    ASSERT_EQ(1u, cache.getEvictions());
+    ASSERT_TRUE(cache.get(uuid1).has_value());
+    ASSERT_FALSE(cache.get(uuid2).has_value());
+    ASSERT_TRUE(cache.get(uuid3).has_value());
+    ASSERT_EQ(3u, cache.getHits());
+    ASSERT_EQ(2u, cache.getMisses());
+    TrRouting::ScenarioConnectionCacheStats stats = cache.getStats();
+    ASSERT_EQ(2u, stats.count);
+    ASSERT_EQ(cache.getSizeBytes(), stats.sizeBytes);
+    ASSERT_EQ(3u, stats.hits);
+    ASSERT_EQ(2u, stats.misses);
+    ASSERT_EQ(1u, stats.evictions);
+
+    // Replacing an entry does not count its previous size
+    cache.set(uuid3, set2);
+    ASSERT_EQ(set1->getMemorySize() + set2->getMemorySize(), cache.getSizeBytes());
+    ASSERT_EQ(1u, cache.getEvictions());
+}
+
+// Test that the lru cache keeps the last set even if it is larger than the budget
+TEST_F(ConnectionSetFixtureTests, TestLruCacheKeepsLastSet)
+{
+    std::shared_ptr<TrRouting::ConnectionSet> set1 = transitData.getConnectionsForScenario(transitData.getScenarios().at(TestDataFetcher::scenarioUuid));
+    std::shared_ptr<TrRouting::ConnectionSet> set2 = transitData.getConnectionsForScenario(transitData.getScenarios().at(TestDataFetcher::scenario2Uuid));
+
+    TrRouting::ScenarioConnectionCacheLru cache(1);
+    cache.set(TestDataFetcher::scenarioUuid, set1);
+    ASSERT_EQ(set1, cache.get(TestDataFetcher::scenarioUuid).value());
+    cache.set(TestDataFetcher::scenario2Uuid, set2);
+    ASSERT_EQ(1u, cache.getCount());
+    ASSERT_FALSE(cache.get(TestDataFetcher::scenarioUuid).has_value());
+    ASSERT_EQ(set2, cache.get(TestDataFetcher::scenario2Uuid).value());
+}
+
+// Test that the transit data uses the lru cache when configured with a size
+TEST_F(ConnectionSetFixtureTests, TestTransitDataLruCache)
+{
+    TrRouting::TransitData lruTransitData(dataFetcher, false, 1024 * 1024);
+    const TrRouting::Scenario & scenario = lruTransitData.getScenarios().at(TestDataFetcher::scenarioUuid);
+    const TrRouting::Scenario & scenario2 = lruTransitData.getScenarios().at(TestDataFetcher::scenario2Uuid);
+
+    std::shared_ptr<TrRouting::ConnectionSet> cache = lruTransitData.getConnectionsForScenario(scenario);
+    lruTransitData.getConnectionsForScenario(scenario2);
+    // Both are still cached, the same object is returned
+    ASSERT_EQ(cache, lruTransitData.getConnectionsForScenario(scenario));
+    TrRouting::ScenarioConnectionCacheStats stats = lruTransitData.getConnectionCacheStats();
+    ASSERT_EQ(2u, stats.count);
+    ASSERT_EQ(1u, stats.hits);
+    ASSERT_EQ(0u, stats.evictions);
+}
+
+// Test that concurrent requests for a scenario that is not cached build its connection set only once
+TEST_F(ConnectionSetFixtureTests, TestConcurrentRequestsBuildOnce)
+{
+    const TrRouting::Scenario & scenario = transitData.getScenarios().at(TestDataFetcher::scenarioUuid);
+    std::vector<std::shared_ptr<TrRouting::ConnectionSet>> connectionSets(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < connectionSets.size(); i++) {
+        threads.push_back(std::thread([this, &scenario, &connectionSets, i]() {
+            connectionSets[i] = transitData.getConnectionsForScenario(scenario);
+        }));
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(1u, transitData.getConnectionSetBuildCount());
+    for (auto & connectionSet : connectionSets) {
+        ASSERT_EQ(connectionSets[0], connectionSet);
+    }
+}
+
+// Test that the warmup builds the connection sets of the scenarios, which are then taken from the cache
+TEST_F(ConnectionSetFixtureTests, TestWarmupScenarios)
+{
+    TrRouting::TransitData lruTransitData(dataFetcher, false, 1024 * 1024);
+    const TrRouting::Scenario & scenario = lruTransitData.getScenarios().at(TestDataFetcher::scenarioUuid);
+    const TrRouting::Scenario & scenario2 = lruTransitData.getScenarios().at(TestDataFetcher::scenario2Uuid);
+
+    lruTransitData.warmupConnectionsForScenarios({scenario, scenario2}, 4);
+    ASSERT_EQ(2u, lruTransitData.getConnectionSetBuildCount());
+
+    ASSERT_EQ(17u, lruTransitData.getConnectionsForScenario(scenario)->getForwardConnectionsCount());
+    ASSERT_EQ(9u, lruTransitData.getConnectionsForScenario(scenario2)->getForwardConnectionsCount());
+    ASSERT_EQ(2u, lruTransitData.getConnectionSetBuildCount());
+}
@@ -5,6 +5,9 @@
 #include "parameters.hpp"
 #include "csa_test_base.hpp"
 #include "scenario.hpp"
+#include "place.hpp"
+#include "household.hpp"
+#include "node.hpp"
 #include "toolbox.hpp" //MAX_INT
 
 // This fixture tests the calculations for the accessibility map from/to a point
@@ -25,6 +28,33 @@ public:
     void SetUp();
 };
 
+// Geofilter counting its calls, the places and households with precomputed nodes should not call it
+class CountingGeoFilter : public TrRouting::GeoFilter
+{
+public:
+    TrRouting::EuclideanGeoFilter geoFilter;
+    int callsCount {0};
+
+    std::vector<TrRouting::NodeTimeDistance> getAccessibleNodesFootpathsFromPoint(const TrRouting::Point &point, const TrRouting::NodeSpatialIndex &nodesIndex, int maxWalkingTravelTime, float walkingSpeedMetersPerSecond, bool reversed = false) override
+    {
+        callsCount++;
+        return geoFilter.getAccessibleNodesFootpathsFromPoint(point, nodesIndex, maxWalkingTravelTime, walkingSpeedMetersPerSecond, reversed);
+    }
+};
+
+void assertSameAllNodesResult(TrRouting::AllNodesResult &expected, TrRouting::AllNodesResult &result)
+{
+    ASSERT_EQ(expected.numberOfReachableNodes, result.numberOfReachableNodes);
+    ASSERT_EQ(expected.totalNodeCount, result.totalNodeCount);
+    ASSERT_EQ(expected.nodes.size(), result.nodes.size());
+    for (size_t i = 0; i < expected.nodes.size(); i++) {
+        ASSERT_EQ(expected.nodes[i].node.uid, result.nodes[i].node.uid);
+        ASSERT_EQ(expected.nodes[i].arrivalTime, result.nodes[i].arrivalTime);
+        ASSERT_EQ(expected.nodes[i].totalTravelTime, result.nodes[i].totalTravelTime);
+        ASSERT_EQ(expected.nodes[i].numberOfTransfers, result.nodes[i].numberOfTransfers);
+    }
+}
+
 void AccessMapFixtureTests::SetUp()
 {
     BaseCsaFixtureTests::SetUp();
@@ -224,3 +254,188 @@ TEST_F(AccessMapFixtureTests, SimpleAllNodesQueryBackward)
     }   
 
 }*/
+
+// Test the batch calculation of many places, including places without access
+// and without service, it should give the same result as each place alone.
+// There are more places than lanes, to calculate more than one batch
+TEST_F(AccessMapFixtureTests, AllNodesBatchQuery)
+{
+    int departureTime = getTimeInSeconds(9, 45);
+    int totalTravelTime = 45 * 60;
+    std::vector<std::pair<double, double>> placesCoordinates {
+        {45.5242, -73.5817}, {44.5242, -73.5817}, {45.54, -73.6146}, {45.5485, -73.6416}, {45.5295, -73.624}
+    };
+
+    const TrRouting::Scenario & scenario = transitData.getScenarios().at(TestDataFetcher::scenarioUuid);
+    TrRouting::CommonParameters commonParameters(scenario, departureTime, DEFAULT_MIN_WAITING_TIME, totalTravelTime, DEFAULT_MAX_ACCESS_TRAVEL_TIME, DEFAULT_MAX_EGRESS_TRAVEL_TIME, DEFAULT_MAX_TRANSFER_TRAVEL_TIME, DEFAULT_FIRST_WAITING_TIME, true);
+    std::vector<std::unique_ptr<TrRouting::Point>> places;
+    for (size_t i = 0; i < TrRouting::ACCESSIBILITY_BATCH_LANES + 3; i++) {
+        auto & coordinates = placesCoordinates[i % placesCoordinates.size()];
+        places.push_back(std::make_unique<TrRouting::Point>(coordinates.first, coordinates.second));
+    }
+    TrRouting::AccessibilityBatchParameters batchParameters(std::move(places), commonParameters);
+
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    std::vector<TrRouting::PlaceAllNodesResult> results = calculator.calculateAllNodesBatch(batchParameters);
+    ASSERT_EQ(TrRouting::ACCESSIBILITY_BATCH_LANES + 3, results.size());
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        auto & coordinates = placesCoordinates[i % placesCoordinates.size()];
+        TrRouting::AccessibilityParameters placeParameters(std::make_unique<TrRouting::Point>(coordinates.first, coordinates.second), commonParameters);
+        try {
+            std::unique_ptr<TrRouting::AllNodesResult> expected = calculateOd(placeParameters);
+            ASSERT_NE(nullptr, results[i].result.get()) << "Place " << i;
+            ASSERT_EQ(expected->numberOfReachableNodes, results[i].result->numberOfReachableNodes);
+            ASSERT_EQ(expected->totalNodeCount, results[i].result->totalNodeCount);
+            ASSERT_EQ(expected->nodes.size(), results[i].result->nodes.size());
+            for (size_t j = 0; j < expected->nodes.size(); j++) {
+                ASSERT_EQ(expected->nodes[j].node.uid, results[i].result->nodes[j].node.uid);
+                ASSERT_EQ(expected->nodes[j].arrivalTime, results[i].result->nodes[j].arrivalTime);
+                ASSERT_EQ(expected->nodes[j].totalTravelTime, results[i].result->nodes[j].totalTravelTime);
+                ASSERT_EQ(expected->nodes[j].numberOfTransfers, results[i].result->nodes[j].numberOfTransfers);
+            }
+        } catch (TrRouting::NoRoutingFoundException const & e) {
+            ASSERT_EQ(nullptr, results[i].result.get()) << "Place " << i;
+            ASSERT_EQ(e.getReason(), results[i].noRoutingReason);
+        }
+    }
+}
+
+// Test the calculation of a time window, the travel times at each time of
+// trip should be the same as the single time of trip calculation. There are
+// more times than lanes, to calculate more than one batch
+TEST_F(AccessMapFixtureTests, AllNodesTimeWindowQuery)
+{
+    int windowStart = getTimeInSeconds(9, 30);
+    int windowEnd = getTimeInSeconds(10, 10);
+    int stepSeconds = 2 * 60;
+
+    const TrRouting::Scenario & scenario = transitData.getScenarios().at(TestDataFetcher::scenarioUuid);
+    TrRouting::CommonParameters commonParameters(scenario, windowStart, DEFAULT_MIN_WAITING_TIME, 45 * 60, DEFAULT_MAX_ACCESS_TRAVEL_TIME, DEFAULT_MAX_EGRESS_TRAVEL_TIME, DEFAULT_MAX_TRANSFER_TRAVEL_TIME, DEFAULT_FIRST_WAITING_TIME, true);
+    TrRouting::AccessibilityParameters windowParameters(std::make_unique<TrRouting::Point>(45.5242, -73.5817), windowEnd, stepSeconds, commonParameters);
+
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    std::unique_ptr<TrRouting::AllNodesRangeResult> result = calculator.calculateAllNodesRange(windowParameters);
+    ASSERT_EQ(21u, result->timesOfTrip.size());
+    ASSERT_GT(result->timesOfTrip.size(), TrRouting::ACCESSIBILITY_BATCH_LANES);
+    ASSERT_FALSE(result->nodes.empty());
+
+    bool hasUnreachedTime = false;
+    for (size_t timeIndex = 0; timeIndex < result->timesOfTrip.size(); timeIndex++)
+    {
+        TrRouting::CommonParameters timeParameters(scenario, result->timesOfTrip[timeIndex], DEFAULT_MIN_WAITING_TIME, 45 * 60, DEFAULT_MAX_ACCESS_TRAVEL_TIME, DEFAULT_MAX_EGRESS_TRAVEL_TIME, DEFAULT_MAX_TRANSFER_TRAVEL_TIME, DEFAULT_FIRST_WAITING_TIME, true);
+        TrRouting::AccessibilityParameters placeParameters(std::make_unique<TrRouting::Point>(45.5242, -73.5817), timeParameters);
+        std::map<TrRouting::Node::uid_t, int> expectedTravelTimes;
+        try {
+            std::unique_ptr<TrRouting::AllNodesResult> expected = calculateOd(placeParameters);
+            for (auto & node : expected->nodes) {
+                expectedTravelTimes[node.node.uid] = node.totalTravelTime;
+            }
+        } catch (TrRouting::NoRoutingFoundException const & e) {
+            // No node reached at this time
+        }
+        ASSERT_EQ(result->totalNodeCount, (int)transitData.getNodes().size());
+        for (auto & node : result->nodes) {
+            ASSERT_EQ(result->timesOfTrip.size(), node.travelTimes.size());
+            auto expectedTravelTime = expectedTravelTimes.find(node.node.uid);
+            int travelTime = node.travelTimes[timeIndex];
+            hasUnreachedTime = hasUnreachedTime || travelTime == -1;
+            ASSERT_EQ(expectedTravelTime == expectedTravelTimes.end() ? -1 : expectedTravelTime->second, travelTime) << "Time " << result->timesOfTrip[timeIndex];
+            expectedTravelTimes.erase(node.node.uid);
+        }
+        // All the nodes reached at this time are in the result
+        ASSERT_TRUE(expectedTravelTimes.empty());
+    }
+    ASSERT_TRUE(hasUnreachedTime);
+}
+
+// Test the accessibility from a place given by uuid, its precomputed nodes are
+// used as access nodes instead of the geofilter
+TEST_F(AccessMapFixtureTests, AllNodesQueryFromPlaceUuid)
+{
+    const TrRouting::Place & place = transitData.getPlaces().at(TestDataFetcher::placeUuid);
+    std::vector<std::pair<std::string, std::string>> parametersWithValues;
+    parametersWithValues.push_back(std::make_pair("place_uuid", boost::uuids::to_string(TestDataFetcher::placeUuid)));
+    parametersWithValues.push_back(std::make_pair("scenario_id", boost::uuids::to_string(TestDataFetcher::scenarioUuid)));
+    parametersWithValues.push_back(std::make_pair("time_of_trip", std::to_string(getTimeInSeconds(9, 45))));
+    parametersWithValues.push_back(std::make_pair("max_travel_time", std::to_string(45 * 60)));
+    TrRouting::AccessibilityParameters placeParameters = TrRouting::AccessibilityParameters::createAccessibilityParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
+    ASSERT_EQ(place.point->latitude, placeParameters.getPlace()->latitude);
+    ASSERT_EQ(place.point->longitude, placeParameters.getPlace()->longitude);
+    ASSERT_TRUE(placeParameters.getOriginNodes().has_value());
+
+    CountingGeoFilter countingGeoFilter;
+    TrRouting::Calculator calculator(transitData, countingGeoFilter);
+    std::unique_ptr<TrRouting::AllNodesResult> result = calculator.calculateAllNodes(placeParameters);
+    ASSERT_EQ(0, countingGeoFilter.callsCount);
+
+    // Same result as the coordinates of the place, whose footpath to South2 is the same as the precomputed one
+    TrRouting::AccessibilityParameters pointParameters(std::make_unique<TrRouting::Point>(place.point->latitude, place.point->longitude), placeParameters);
+    std::unique_ptr<TrRouting::AllNodesResult> expected = calculator.calculateAllNodes(pointParameters);
+    ASSERT_EQ(1, countingGeoFilter.callsCount);
+    assertSameAllNodesResult(*expected.get(), *result.get());
+
+    // The precomputed nodes further than the max access time are ignored
+    parametersWithValues.push_back(std::make_pair("max_access_travel_time", "400"));
+    TrRouting::AccessibilityParameters shortAccessParameters = TrRouting::AccessibilityParameters::createAccessibilityParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
+    try {
+        calculator.calculateAllNodes(shortAccessParameters);
+        FAIL() << "Expected TrRouting::NoRoutingFoundException, no exception thrown";
+    } catch (TrRouting::NoRoutingFoundException const & e) {
+        assertNoRouting(e, TrRouting::NoRoutingReason::NO_ACCESS_AT_ORIGIN);
+    }
+    ASSERT_EQ(1, countingGeoFilter.callsCount);
+
+    // Unknown places and households are invalid
+    for (std::string uuidParameter : {"place_uuid", "household_uuid"}) {
+        std::vector<std::pair<std::string, std::string>> invalidParameters(parametersWithValues.begin() + 1, parametersWithValues.end());
+        invalidParameters.push_back(std::make_pair(uuidParameter, boost::uuids::to_string(TestDataFetcher::scenarioUuid)));
+        try {
+            TrRouting::AccessibilityParameters::createAccessibilityParameter(invalidParameters, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
+            FAIL() << "Expected TrRouting::ParameterException, no exception thrown";
+        } catch (TrRouting::ParameterException const & e) {
+            ASSERT_EQ(TrRouting::ParameterException::Type::INVALID_PLACE, e.getType());
+        }
+    }
+}
+
+// Test the batch accessibility of all the places of a data source and of a
+// household, with their precomputed nodes
+TEST_F(AccessMapFixtureTests, AllNodesBatchQueryFromPlaces)
+{
+    std::vector<std::pair<std::string, std::string>> parametersWithValues;
+    parametersWithValues.push_back(std::make_pair("places_data_source_uuid", boost::uuids::to_string(TestDataFetcher::dataSourceUuid)));
+    parametersWithValues.push_back(std::make_pair("places", "-73.6146,45.54"));
+    parametersWithValues.push_back(std::make_pair("scenario_id", boost::uuids::to_string(TestDataFetcher::scenarioUuid)));
+    parametersWithValues.push_back(std::make_pair("time_of_trip", std::to_string(getTimeInSeconds(9, 45))));
+    parametersWithValues.push_back(std::make_pair("max_travel_time", std::to_string(45 * 60)));
+    TrRouting::AccessibilityBatchParameters batchParameters = TrRouting::AccessibilityBatchParameters::createAccessibilityBatchParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces());
+    ASSERT_EQ(transitData.getPlaces().size() + 1, batchParameters.getPlaces().size());
+    ASSERT_EQ(TestDataFetcher::placeUuid, batchParameters.getPlacesUuids()[0].value());
+    ASSERT_FALSE(batchParameters.getPlacesUuids()[1].has_value());
+
+    CountingGeoFilter countingGeoFilter;
+    TrRouting::Calculator calculator(transitData, countingGeoFilter);
+    std::vector<TrRouting::PlaceAllNodesResult> results = calculator.calculateAllNodesBatch(batchParameters);
+    ASSERT_EQ(batchParameters.getPlaces().size(), results.size());
+    // Only the place given by coordinates uses the geofilter
+    ASSERT_EQ(1, countingGeoFilter.callsCount);
+
+    TrRouting::AccessibilityParameters placeParameters(std::make_unique<TrRouting::Point>(*batchParameters.getPlaces()[0].get()), batchParameters, transitData.getPlaces().at(TestDataFetcher::placeUuid).nodes);
+    std::unique_ptr<TrRouting::AllNodesResult> expected = calculator.calculateAllNodes(placeParameters);
+    ASSERT_NE(nullptr, results[0].result.get());
+    assertSameAllNodesResult(*expected.get(), *results[0].result.get());
+
+    // The household uses its home nodes
+    std::vector<std::pair<std::string, std::string>> householdParametersWithValues(parametersWithValues.begin() + 2, parametersWithValues.end());
+    householdParametersWithValues.push_back(std::make_pair("household_uuid", boost::uuids::to_string(TestDataFetcher::householdUuid)));
+    TrRouting::AccessibilityParameters householdParameters = TrRouting::AccessibilityParameters::createAccessibilityParameter(householdParametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
+    ASSERT_EQ(&transitData.getHouseholds().at(TestDataFetcher::householdUuid).homeNodes, &householdParameters.getOriginNodes().value().get());
+    try {
+        calculator.calculateAllNodes(householdParameters);
+    } catch (TrRouting::NoRoutingFoundException const & e) {
+        ASSERT_NE(TrRouting::NoRoutingReason::NO_ACCESS_AT_ORIGIN, e.getReason());
+    }
+    ASSERT_EQ(1, countingGeoFilter.callsCount);
+}
@@ -0,0 +1,133 @@
+#include <boost/uuid/uuid_io.hpp>
+
+#include "gtest/gtest.h"
+#include "calculator.hpp"
+#include "csa_test_base.hpp"
+#include "parameters.hpp"
+#include "scenario.hpp"
+#include "point.hpp"
+#include "routing_result.hpp"
+#include "place.hpp"
+#include "household.hpp"
+#include "toolbox.hpp" //MAX_INT
+
+/**
+ * This file covers the profile calculation, which returns all the best
+ * journeys in a departure time window
+ * */
+class ProfileCalculationFixtureTests : public BaseCsaFixtureTests
+{
+public:
+    // Same origin and destination as the simple OD route calculation, served by both South/North trips
+    TrRouting::ProfileParameters createProfileParameters(int windowStart, int windowEnd)
+    {
+        TrRouting::RouteParameters routeParameters = TrRouting::RouteParameters(
+            std::make_unique<TrRouting::Point>(45.5242, -73.5817),
+            std::make_unique<TrRouting::Point>(45.54, -73.6146),
+            transitData.getScenarios().at(TestDataFetcher::scenarioUuid),
+            windowStart,
+            TrRouting::DEFAULT_MIN_WAITING_TIME,
+            TrRouting::DEFAULT_MAX_TOTAL_TIME,
+            TrRouting::DEFAULT_MAX_ACCESS_TRAVEL_TIME,
+            TrRouting::DEFAULT_MAX_EGRESS_TRAVEL_TIME,
+            TrRouting::DEFAULT_MAX_TRANSFER_TRAVEL_TIME,
+            TrRouting::DEFAULT_FIRST_WAITING_TIME,
+            false,
+            true
+        );
+        return TrRouting::ProfileParameters(
+            std::make_unique<TrRouting::Point>(45.5242, -73.5817),
+            std::make_unique<TrRouting::Point>(45.54, -73.6146),
+            windowEnd,
+            routeParameters
+        );
+    }
+};
+
+// Both trips of the South/North line depart in the window, each gives one journey
+TEST_F(ProfileCalculationFixtureTests, ProfileWithTwoDepartures)
+{
+    int travelTimeInVehicle = 420;
+    // Same as the single route calculation test
+    int accessTime = 469;
+    int egressTime = 138;
+
+    TrRouting::ProfileParameters testParameters = createProfileParameters(getTimeInSeconds(9, 45), getTimeInSeconds(11, 15));
+
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    std::unique_ptr<TrRouting::ProfileResult> result = calculator.calculateProfile(testParameters);
+
+    ASSERT_EQ(TrRouting::result_type::PROFILE, result.get()->resType);
+    ASSERT_EQ(2u, result.get()->journeys.size());
+    assertSuccessResults(*result.get()->journeys[0].get(),
+        getTimeInSeconds(9, 45),
+        getTimeInSeconds(10),
+        travelTimeInVehicle,
+        accessTime,
+        egressTime);
+    assertSuccessResults(*result.get()->journeys[1].get(),
+        getTimeInSeconds(9, 45),
+        getTimeInSeconds(11),
+        travelTimeInVehicle,
+        accessTime,
+        egressTime);
+}
+
+// The window only contains the departure for the second trip
+TEST_F(ProfileCalculationFixtureTests, ProfileWithOneDeparture)
+{
+    TrRouting::ProfileParameters testParameters = createProfileParameters(getTimeInSeconds(10), getTimeInSeconds(11, 15));
+
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    std::unique_ptr<TrRouting::ProfileResult> result = calculator.calculateProfile(testParameters);
+
+    ASSERT_EQ(1u, result.get()->journeys.size());
+    assertSuccessResults(*result.get()->journeys[0].get(),
+        getTimeInSeconds(10),
+        getTimeInSeconds(11),
+        420,
+        469,
+        138);
+}
+
+// No trip departs in the window
+TEST_F(ProfileCalculationFixtureTests, ProfileNoDepartureInWindow)
+{
+    TrRouting::ProfileParameters testParameters = createProfileParameters(getTimeInSeconds(11, 15), getTimeInSeconds(12));
+
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    try {
+        calculator.calculateProfile(testParameters);
+        FAIL() << "Expected TrRouting::NoRoutingFoundException, no exception thrown";
+    } catch (TrRouting::NoRoutingFoundException const & e) {
+        assertNoRouting(e, TrRouting::NoRoutingReason::NO_ROUTING_FOUND);
+    } catch(...) {
+        FAIL() << "Expected TrRouting::NoRoutingFoundException, another type was thrown";
+    }
+}
+
+// The origin and destination can be a place and a household given by uuid, their precomputed nodes are the access and egress nodes
+TEST_F(ProfileCalculationFixtureTests, ProfileFromPlaceToHousehold)
+{
+    const TrRouting::Place & place = transitData.getPlaces().at(TestDataFetcher::placeUuid);
+    const TrRouting::Household & household = transitData.getHouseholds().at(TestDataFetcher::householdUuid);
+    std::vector<std::pair<std::string, std::string>> parametersWithValues;
+    parametersWithValues.push_back(std::make_pair("origin_place_uuid", boost::uuids::to_string(TestDataFetcher::placeUuid)));
+    parametersWithValues.push_back(std::make_pair("destination_household_uuid", boost::uuids::to_string(TestDataFetcher::householdUuid)));
+    parametersWithValues.push_back(std::make_pair("scenario_id", boost::uuids::to_string(TestDataFetcher::scenarioUuid)));
+    parametersWithValues.push_back(std::make_pair("time_of_trip", std::to_string(getTimeInSeconds(10))));
+    parametersWithValues.push_back(std::make_pair("time_window_end", std::to_string(getTimeInSeconds(11, 15))));
+    TrRouting::ProfileParameters testParameters = TrRouting::ProfileParameters::createProfileParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
+    ASSERT_EQ(&place.nodes, &testParameters.getOriginNodes().value().get());
+    ASSERT_EQ(&household.homeNodes, &testParameters.getDestinationNodes().value().get());
+
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    std::unique_ptr<TrRouting::ProfileResult> result = calculator.calculateProfile(testParameters);
+
+    // Same access and egress as the route from the place to the household
+    ASSERT_EQ(1u, result.get()->journeys.size());
+    ASSERT_EQ(469, result.get()->journeys[0]->accessTravelTime);
+    ASSERT_EQ(500, result.get()->journeys[0]->accessDistance);
+    ASSERT_EQ(138, result.get()->journeys[0]->egressTravelTime);
+    ASSERT_EQ(150, result.get()->journeys[0]->egressDistance);
+}
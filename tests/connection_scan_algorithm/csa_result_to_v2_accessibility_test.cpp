@@ -177,6 +177,54 @@ TEST_F(ResultToV2AccessFixtureTest, TestAllNodesBackwardV2Access)
 
 }
 
+TEST_F(ResultToV2AccessFixtureTest, TestAllNodesTimeWindowV2Access)
+{
+    TrRouting::AccessibilityParameters windowParams(std::make_unique<TrRouting::Point>(45.5269, -73.58912), DEFAULT_TIME + 180, 60, *accessParameters.get());
+
+    // Prepare a result object, with the second node not reached at all times
+    TrRouting::AllNodesRangeResult result;
+    result.totalNodeCount = 50;
+    result.timesOfTrip = windowParams.getTimesOfTrip();
+    result.nodes.push_back(TrRouting::AccessibleNodeTravelTimes(*boardingNode, {900, 1200, 1000, 600}));
+    result.nodes.push_back(TrRouting::AccessibleNodeTravelTimes(*unboardingNode, {900, 1200, -1, 600}));
+
+    // Validate response
+    nlohmann::json jsonResponse = TrRouting::ResultToV2AccessibilityResponse::resultToJsonString(result, windowParams);
+
+    ASSERT_EQ(STATUS_SUCCESS, jsonResponse["status"]);
+    assertQueryConversion(jsonResponse);
+    ASSERT_EQ(DEFAULT_TIME + 180, jsonResponse["query"]["timeWindowEnd"]);
+    ASSERT_EQ(60, jsonResponse["query"]["stepSeconds"]);
+
+    // Validate result
+    ASSERT_EQ(result.totalNodeCount, jsonResponse["result"]["totalNodeCount"]);
+    ASSERT_EQ(4, jsonResponse["result"]["timesOfTripCount"]);
+    ASSERT_EQ(2u, jsonResponse["result"]["nodes"].size());
+
+    // Validate first node
+    nlohmann::json nodeJson = jsonResponse["result"]["nodes"][0];
+    ASSERT_EQ(boardingNodeUuid, nodeJson["nodeUuid"]);
+    ASSERT_EQ(4, nodeJson["reachableCount"]);
+    ASSERT_EQ(600, nodeJson["minTravelTime"]);
+    ASSERT_EQ(925, nodeJson["averageTravelTime"]);
+    ASSERT_EQ(900, nodeJson["medianTravelTime"]);
+    ASSERT_EQ(600, nodeJson["travelTimePercentiles"]["p10"]);
+    ASSERT_EQ(600, nodeJson["travelTimePercentiles"]["p25"]);
+    ASSERT_EQ(900, nodeJson["travelTimePercentiles"]["p50"]);
+    ASSERT_EQ(1000, nodeJson["travelTimePercentiles"]["p75"]);
+    ASSERT_EQ(1200, nodeJson["travelTimePercentiles"]["p90"]);
+
+    // Validate second node, the time at which it is not reached counts as an infinite travel time
+    nodeJson = jsonResponse["result"]["nodes"][1];
+    ASSERT_EQ(unboardingNodeUuid, nodeJson["nodeUuid"]);
+    ASSERT_EQ(3, nodeJson["reachableCount"]);
+    ASSERT_EQ(600, nodeJson["minTravelTime"]);
+    ASSERT_EQ(900, nodeJson["averageTravelTime"]);
+    ASSERT_EQ(900, nodeJson["medianTravelTime"]);
+    ASSERT_EQ(1200, nodeJson["travelTimePercentiles"]["p75"]);
+    ASSERT_TRUE(nodeJson["travelTimePercentiles"]["p90"].is_null());
+}
+
 void ResultToV2AccessFixtureTest::assertQueryConversion(nlohmann::json jsonResponse, bool isForward) {
     TrRouting::Point* place = accessParameters.get()->getPlace();
 
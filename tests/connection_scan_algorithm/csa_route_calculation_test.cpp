@@ -535,6 +535,41 @@ TEST_F(SingleRouteCalculationFixtureTests, NoRoutingTravelTimeLongerTrip)
     }
 }
 
+// Test a route from a place to a household given by uuid, their precomputed nodes are the access and egress nodes
+TEST_F(SingleRouteCalculationFixtureTests, RouteFromPlaceToHousehold)
+{
+    const TrRouting::Place & place = transitData.getPlaces().at(TestDataFetcher::placeUuid);
+    const TrRouting::Household & household = transitData.getHouseholds().at(TestDataFetcher::householdUuid);
+    std::vector<std::pair<std::string, std::string>> parametersWithValues;
+    parametersWithValues.push_back(std::make_pair("origin_place_uuid", boost::uuids::to_string(TestDataFetcher::placeUuid)));
+    parametersWithValues.push_back(std::make_pair("destination_household_uuid", boost::uuids::to_string(TestDataFetcher::householdUuid)));
+    parametersWithValues.push_back(std::make_pair("scenario_id", boost::uuids::to_string(TestDataFetcher::scenarioUuid)));
+    parametersWithValues.push_back(std::make_pair("time_of_trip", std::to_string(getTimeInSeconds(9, 45))));
+    TrRouting::RouteParameters testParameters = TrRouting::RouteParameters::createRouteODParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
+    ASSERT_EQ(place.point->latitude, testParameters.getOrigin()->latitude);
+    ASSERT_EQ(household.point->longitude, testParameters.getDestination()->longitude);
+    ASSERT_EQ(&place.nodes, &testParameters.getOriginNodes().value().get());
+    ASSERT_EQ(&household.homeNodes, &testParameters.getDestinationNodes().value().get());
+
+    std::unique_ptr<TrRouting::RoutingResult> result = calculateOd(testParameters);
+    TrRouting::SingleCalculationResult & singleResult = dynamic_cast<TrRouting::SingleCalculationResult&>(*result.get());
+    // Walk 469 seconds to South2, then ride to MidNode and walk 138 seconds to home
+    ASSERT_EQ(469, singleResult.accessTravelTime);
+    ASSERT_EQ(500, singleResult.accessDistance);
+    ASSERT_EQ(138, singleResult.egressTravelTime);
+    ASSERT_EQ(150, singleResult.egressDistance);
+
+    // The precomputed nodes further than the max egress time are ignored
+    parametersWithValues.push_back(std::make_pair("max_egress_travel_time", "100"));
+    TrRouting::RouteParameters shortEgressParameters = TrRouting::RouteParameters::createRouteODParameter(parametersWithValues, transitData.getScenarios(), transitData.getPlaces(), transitData.getHouseholds());
+    try {
+        calculateOd(shortEgressParameters);
+        FAIL() << "Expected TrRouting::NoRoutingFoundException, no exception thrown";
+    } catch (TrRouting::NoRoutingFoundException const & e) {
+        assertNoRouting(e, TrRouting::NoRoutingReason::NO_ACCESS_AT_DESTINATION);
+    }
+}
+
 std::unique_ptr<TrRouting::RoutingResult> SingleRouteCalculationFixtureTests::calculateOd(TrRouting::RouteParameters& parameters)
 {
     TrRouting::Calculator calculator(transitData, geoFilter);
@@ -320,6 +320,94 @@ TEST_F(SingleTAndACalculationFixtureTests, TripWithAlternativesTooLong)
 
 }
 
+// Same as TripWithAlternatives, but with a maximum number of transfers, the
+// alternatives are the arrival time/transfers Pareto front, calculated in a
+// single pass
+TEST_F(SingleTAndACalculationFixtureTests, TripWithMultiCriteriaAlternatives)
+{
+    int departureTime = getTimeInSeconds(9, 45);
+    int accessTime = 469;
+    int expectedTransitDepartureTime = getTimeInSeconds(10);
+
+    TrRouting::RouteParameters commonParameters = TrRouting::RouteParameters(
+        std::make_unique<TrRouting::Point>(45.5242, -73.5817),
+        std::make_unique<TrRouting::Point>(45.5541, -73.6186),
+        transitData.getScenarios().at(TestDataFetcher::scenarioUuid),
+        departureTime,
+        DEFAULT_MIN_WAITING_TIME,
+        DEFAULT_MAX_TOTAL_TIME,
+        DEFAULT_MAX_ACCESS_TRAVEL_TIME,
+        DEFAULT_MAX_EGRESS_TRAVEL_TIME,
+        DEFAULT_MAX_TRANSFER_TRAVEL_TIME,
+        DEFAULT_FIRST_WAITING_TIME,
+        true,
+        true
+    );
+    TrRouting::RouteParameters testParameters = TrRouting::RouteParameters(
+        std::make_unique<TrRouting::Point>(45.5242, -73.5817),
+        std::make_unique<TrRouting::Point>(45.5541, -73.6186),
+        true,
+        commonParameters,
+        1
+    );
+
+    TrRouting::AlternativesResult routingResult = calculateWithAlternatives(testParameters);
+    ASSERT_EQ(2u, routingResult.alternatives.size());
+    ASSERT_EQ(1, routingResult.totalAlternativesCalculated);
+
+    // The fastest with one transfer, same as the first alternative
+    int expTransferWaitingTime1 = 300;
+    assertSuccessResults(*routingResult.alternatives[0].get(),
+        departureTime,
+        expectedTransitDepartureTime,
+        12 * 60,
+        accessTime,
+        77,
+        1,
+        MIN_WAITING_TIME,
+        MIN_WAITING_TIME + expTransferWaitingTime1,
+        expTransferWaitingTime1,
+        480
+    );
+
+    // Then the SN line to North1 without transfer
+    assertSuccessResults(*routingResult.alternatives[1].get(),
+        departureTime,
+        expectedTransitDepartureTime,
+        13 * 60,
+        accessTime,
+        1080,
+        0,
+        MIN_WAITING_TIME,
+        MIN_WAITING_TIME,
+        0,
+        0
+    );
+
+    // Without transfers, only the SN line journey is possible
+    TrRouting::RouteParameters noTransferParameters = TrRouting::RouteParameters(
+        std::make_unique<TrRouting::Point>(45.5242, -73.5817),
+        std::make_unique<TrRouting::Point>(45.5541, -73.6186),
+        true,
+        commonParameters,
+        0
+    );
+    routingResult = calculateWithAlternatives(noTransferParameters);
+    ASSERT_EQ(1u, routingResult.alternatives.size());
+    assertSuccessResults(*routingResult.alternatives[0].get(),
+        departureTime,
+        expectedTransitDepartureTime,
+        13 * 60,
+        accessTime,
+        1080,
+        0,
+        MIN_WAITING_TIME,
+        MIN_WAITING_TIME,
+        0,
+        0
+    );
+}
+
 // Test a query with alternatives, for a trip with no routing found because too far from network
 TEST_F(SingleTAndACalculationFixtureTests, TripWithNoRoutingAlternatives)
 {
@@ -73,6 +73,54 @@ int TestDataFetcher::getOdTrips(
   return 0;
 }
 
+int TestDataFetcher::getHouseholds(
+                                   std::map<boost::uuids::uuid, TrRouting::Household>& ts,
+                                   const std::map<boost::uuids::uuid, TrRouting::DataSource>& dataSources,
+                                   const std::map<boost::uuids::uuid, TrRouting::Node>& nodes,
+                                   std::string
+                                   ) {
+  // The household is at the destination of the od trip, with the same accessible nodes
+  std::vector<TrRouting::NodeTimeDistance> homeNodes;
+  homeNodes.push_back(TrRouting::NodeTimeDistance(nodes.at(nodeMidNodeUuid), 138, 150));
+
+  ts.emplace(householdUuid, TrRouting::Household(householdUuid,
+                                                 23456,
+                                                 "23456",
+                                                 dataSources.at(dataSourceUuid),
+                                                 1.0,
+                                                 2,
+                                                 1,
+                                                 -1,
+                                                 "unknown",
+                                                 "couple",
+                                                 homeNodes,
+                                                 std::make_unique<TrRouting::Point>(45.54, -73.6146)));
+
+  return 0;
+}
+
+int TestDataFetcher::getPlaces(
+                               std::map<boost::uuids::uuid, TrRouting::Place>& ts,
+                               const std::map<boost::uuids::uuid, TrRouting::DataSource>& dataSources,
+                               const std::map<boost::uuids::uuid, TrRouting::Node>& nodes,
+                               std::string
+                               ) {
+  // The place is at the origin of the od trip, with the same accessible nodes
+  std::vector<TrRouting::NodeTimeDistance> placeNodes;
+  placeNodes.push_back(TrRouting::NodeTimeDistance(nodes.at(nodeSouth2Uuid), 469, 500));
+
+  ts.emplace(placeUuid, TrRouting::Place(placeUuid,
+                                         34567,
+                                         "34567",
+                                         "testPlace",
+                                         "Test place",
+                                         dataSources.at(dataSourceUuid),
+                                         placeNodes,
+                                         std::make_unique<TrRouting::Point>(45.5242, -73.5817)));
+
+  return 0;
+}
+
 int TestDataFetcher::getAgencies(
                                  std::map<boost::uuids::uuid, TrRouting::Agency>& ts,
                                  std::string
@@ -71,6 +71,8 @@ class TestDataFetcher : public TrRouting::DataFetcher
     inline static const boost::uuids::uuid trip1ExtraUuid = uuidGenerator("4aff9220-e72e-4b41-9cbf-0d86565d5128");
     inline static const boost::uuids::uuid dataSourceUuid = uuidGenerator("12121212-3434-5656-7878-5f008b95c7b8");
     inline static const boost::uuids::uuid odTripUuid = uuidGenerator("21212121-4343-6565-8787-5422d6a36f46");
+    inline static const boost::uuids::uuid placeUuid = uuidGenerator("31313131-5353-7575-9797-5422d6a36f46");
+    inline static const boost::uuids::uuid householdUuid = uuidGenerator("41414141-6363-8585-a7a7-5422d6a36f46");
     
  
     virtual const std::map<std::string, TrRouting::Mode> getModes();
@@ -81,6 +83,13 @@ class TestDataFetcher : public TrRouting::DataFetcher
       std::string customPath = ""
     );
 
+    virtual int getHouseholds(
+      std::map<boost::uuids::uuid, TrRouting::Household>& ts,
+      const std::map<boost::uuids::uuid, TrRouting::DataSource>& dataSources,
+      const std::map<boost::uuids::uuid, TrRouting::Node>& nodes,
+      std::string customPath = ""
+    );
+
     virtual int getPersons(
       std::map<boost::uuids::uuid, TrRouting::Person>& ts,
       const std::map<boost::uuids::uuid, TrRouting::DataSource>& dataSources,
@@ -95,6 +104,13 @@ class TestDataFetcher : public TrRouting::DataFetcher
       std::string customPath = ""
     );
 
+    virtual int getPlaces(
+      std::map<boost::uuids::uuid, TrRouting::Place>& ts,
+      const std::map<boost::uuids::uuid, TrRouting::DataSource>& dataSources,
+      const std::map<boost::uuids::uuid, TrRouting::Node>& nodes,
+      std::string customPath = ""
+    );
+
     virtual int getAgencies(
       std::map<boost::uuids::uuid, TrRouting::Agency>& ts,
       std::string customPath = ""
@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+#include "epoch_vector.hpp"
+
+using TrRouting::EpochVector;
+
+TEST(EpochVectorTest, defaultValues) {
+    EpochVector<int> vector;
+    vector.reset(3, -1);
+
+    EXPECT_EQ(3u, vector.size());
+    EXPECT_EQ(-1, vector.get(0));
+    EXPECT_EQ(-1, vector[2]);
+}
+
+TEST(EpochVectorTest, resetInvalidatesValues) {
+    EpochVector<int> vector;
+    vector.reset(3, -1);
+    vector[0] = 10;
+    vector.at(1) = 20;
+
+    EXPECT_EQ(10, vector.get(0));
+    EXPECT_EQ(20, vector.get(1));
+    EXPECT_EQ(-1, vector.get(2));
+
+    // Reset with the same size and another default value
+    vector.reset(3, 5);
+    EXPECT_EQ(5, vector.get(0));
+    EXPECT_EQ(5, vector[1]);
+    vector[1]++;
+    EXPECT_EQ(6, vector.get(1));
+
+    // Clear keeps the default value
+    vector.clear();
+    EXPECT_EQ(5, vector.get(1));
+}
+
+TEST(EpochVectorTest, resize) {
+    EpochVector<int> vector;
+    vector.reset(2, 0);
+    vector[1] = 3;
+    vector.reset(4, 1);
+
+    EXPECT_EQ(4u, vector.size());
+    EXPECT_EQ(1, vector.get(1));
+    EXPECT_EQ(1, vector.get(3));
+    EXPECT_THROW(vector.at(4), std::out_of_range);
+}
@@ -0,0 +1,103 @@
+#include <boost/uuid/uuid_generators.hpp>
+
+#include "gtest/gtest.h"
+#include "footpath_cache.hpp"
+#include "node.hpp"
+#include "point.hpp"
+
+using TrRouting::FootpathCache;
+using TrRouting::FootpathCacheKey;
+using TrRouting::Point;
+
+class FootpathCacheFixtureTests : public ::testing::Test
+{
+protected:
+    boost::uuids::uuid nodeUuid = boost::uuids::random_generator()();
+    TrRouting::Node node = TrRouting::Node(nodeUuid, 1, "", "", "", std::make_unique<Point>(45.5, -73.6));
+    std::vector<TrRouting::NodeTimeDistance> footpaths { TrRouting::NodeTimeDistance(node, 120, 150) };
+};
+
+TEST_F(FootpathCacheFixtureTests, HitsAndMisses)
+{
+    FootpathCache cache(10);
+    FootpathCacheKey key("walking", Point(45.5, -73.6), 900, 1.38, false);
+
+    ASSERT_FALSE(cache.get(key, 1).has_value());
+    cache.set(key, 1, footpaths);
+    auto cached = cache.get(key, 1);
+    ASSERT_TRUE(cached.has_value());
+    ASSERT_EQ(1u, cached.value().size());
+    ASSERT_EQ(node, cached.value()[0].node);
+    ASSERT_EQ(120, cached.value()[0].time);
+    ASSERT_EQ(1u, cache.getHits());
+    ASSERT_EQ(1u, cache.getMisses());
+}
+
+TEST_F(FootpathCacheFixtureTests, QuantizedKey)
+{
+    FootpathCache cache(10);
+    cache.set(FootpathCacheKey("walking", Point(45.5, -73.6), 900, 1.38, false), 1, footpaths);
+
+    // Less than one meter away is the same key
+    ASSERT_TRUE(cache.get(FootpathCacheKey("walking", Point(45.500001, -73.600002), 900, 1.38, false), 1).has_value());
+    // Other points and parameters are different keys
+    ASSERT_FALSE(cache.get(FootpathCacheKey("walking", Point(45.5001, -73.6), 900, 1.38, false), 1).has_value());
+    ASSERT_FALSE(cache.get(FootpathCacheKey("walking", Point(45.5, -73.6), 600, 1.38, false), 1).has_value());
+    ASSERT_FALSE(cache.get(FootpathCacheKey("walking", Point(45.5, -73.6), 900, 1.0, false), 1).has_value());
+    ASSERT_FALSE(cache.get(FootpathCacheKey("walking", Point(45.5, -73.6), 900, 1.38, true), 1).has_value());
+    ASSERT_FALSE(cache.get(FootpathCacheKey("cycling", Point(45.5, -73.6), 900, 1.38, false), 1).has_value());
+}
+
+TEST_F(FootpathCacheFixtureTests, LeastRecentlyUsedEvicted)
+{
+    FootpathCache cache(2);
+    FootpathCacheKey key1("walking", Point(45.1, -73.6), 900, 1.38, false);
+    FootpathCacheKey key2("walking", Point(45.2, -73.6), 900, 1.38, false);
+    FootpathCacheKey key3("walking", Point(45.3, -73.6), 900, 1.38, false);
+
+    cache.set(key1, 1, footpaths);
+    cache.set(key2, 1, footpaths);
+    // Use key1, so key2 is the least recently used
+    ASSERT_TRUE(cache.get(key1, 1).has_value());
+    cache.set(key3, 1, footpaths);
+
+    ASSERT_EQ(2u, cache.size());
+    ASSERT_TRUE(cache.get(key1, 1).has_value());
+    ASSERT_FALSE(cache.get(key2, 1).has_value());
+    ASSERT_TRUE(cache.get(key3, 1).has_value());
+}
+
+TEST_F(FootpathCacheFixtureTests, ClearedWithNewNodes)
+{
+    FootpathCache cache(10);
+    FootpathCacheKey key("walking", Point(45.5, -73.6), 900, 1.38, false);
+    cache.set(key, 1, footpaths);
+
+    // The nodes were rebuilt, the footpaths reference old nodes
+    ASSERT_FALSE(cache.get(key, 2).has_value());
+    ASSERT_EQ(0u, cache.size());
+}
+
+TEST_F(FootpathCacheFixtureTests, OlderNodesBypassCache)
+{
+    FootpathCache cache(10);
+    FootpathCacheKey key("walking", Point(45.5, -73.6), 900, 1.38, false);
+    FootpathCacheKey oldKey("walking", Point(45.1, -73.6), 900, 1.38, false);
+    cache.set(key, 2, footpaths);
+
+    // Requests still on the previous data neither clear the cache nor add their footpaths to it
+    ASSERT_FALSE(cache.get(key, 1).has_value());
+    cache.set(oldKey, 1, footpaths);
+    ASSERT_EQ(1u, cache.size());
+    ASSERT_TRUE(cache.get(key, 2).has_value());
+    ASSERT_FALSE(cache.get(oldKey, 2).has_value());
+}
+
+TEST_F(FootpathCacheFixtureTests, DisabledCache)
+{
+    FootpathCache cache(0);
+    FootpathCacheKey key("walking", Point(45.5, -73.6), 900, 1.38, false);
+    cache.set(key, 1, footpaths);
+    ASSERT_FALSE(cache.get(key, 1).has_value());
+    ASSERT_EQ(0u, cache.size());
+}
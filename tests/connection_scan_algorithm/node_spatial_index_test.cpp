@@ -0,0 +1,119 @@
+#include <random>
+#include <boost/uuid/uuid_generators.hpp>
+
+#include "gtest/gtest.h"
+#include "node_spatial_index.hpp"
+#include "euclideangeofilter.hpp"
+#include "node.hpp"
+#include "point.hpp"
+
+// Expose the common distance calculation, to compare the geofilter with a search through all nodes
+class AllNodesEuclideanGeoFilter : public TrRouting::EuclideanGeoFilter
+{
+public:
+    std::vector<std::pair<TrRouting::Node::uid_t, int>> getAccessibleNodes(const TrRouting::Point &point, const std::map<boost::uuids::uuid, TrRouting::Node> &nodes, int maxWalkingTravelTime, float walkingSpeedMetersPerSecond)
+    {
+        std::vector<std::pair<TrRouting::Node::uid_t, int>> accessibleNodes;
+        auto lengthOfOneDegree = calculateLengthOfOneDegree(point);
+        float maxDistanceMetersSquared = calculateMaxDistanceSquared(maxWalkingTravelTime, walkingSpeedMetersPerSecond);
+        for (auto &&[uuid, node] : nodes)
+        {
+            float distanceMetersSquared = calculateNodeDistanceSquared(node.point.get(), point, lengthOfOneDegree);
+            if (distanceMetersSquared <= maxDistanceMetersSquared)
+            {
+                accessibleNodes.push_back(std::make_pair(node.uid, (int)((int)sqrt(distanceMetersSquared) / walkingSpeedMetersPerSecond)));
+            }
+        }
+        return accessibleNodes;
+    }
+};
+
+class NodeSpatialIndexFixtureTests : public ::testing::Test
+{
+protected:
+    std::map<boost::uuids::uuid, TrRouting::Node> nodes;
+    TrRouting::NodeSpatialIndex nodesIndex;
+    std::mt19937 generator {42};
+
+public:
+    void SetUp() override
+    {
+        boost::uuids::random_generator uuidGenerator;
+        // Random nodes in a 20km x 20km area
+        std::uniform_real_distribution<double> latitudes(45.45, 45.63);
+        std::uniform_real_distribution<double> longitudes(-73.75, -73.50);
+        for (int i = 0; i < 2000; i++)
+        {
+            boost::uuids::uuid uuid = uuidGenerator();
+            nodes.emplace(uuid, TrRouting::Node(uuid, i, "", "", "", std::make_unique<TrRouting::Point>(latitudes(generator), longitudes(generator))));
+        }
+        nodesIndex.build(nodes);
+    }
+};
+
+TEST_F(NodeSpatialIndexFixtureTests, BoundingBoxContainsAllNodes)
+{
+    std::uniform_real_distribution<double> latitudes(45.40, 45.68);
+    std::uniform_real_distribution<double> longitudes(-73.80, -73.45);
+    for (int i = 0; i < 100; i++)
+    {
+        TrRouting::Point point(latitudes(generator), longitudes(generator));
+        double delta = 0.002 * (i % 10);
+        std::vector<std::reference_wrapper<const TrRouting::Node>> candidates = nodesIndex.getNodesInBoundingBox(point, delta, delta);
+
+        size_t expectedInBox = 0;
+        auto candidateIte = candidates.begin();
+        for (auto &&[uuid, node] : nodes)
+        {
+            bool isCandidate = candidateIte != candidates.end() && candidateIte->get() == node;
+            if (isCandidate)
+            {
+                candidateIte++;
+            }
+            if (std::abs(node.point.get()->latitude - point.latitude) <= delta && std::abs(node.point.get()->longitude - point.longitude) <= delta)
+            {
+                expectedInBox++;
+                ASSERT_TRUE(isCandidate) << "Node in the bounding box was not returned";
+            }
+        }
+        // All candidates were matched in the map order
+        ASSERT_EQ(candidates.end(), candidateIte);
+        ASSERT_LE(expectedInBox, candidates.size());
+    }
+}
+
+TEST_F(NodeSpatialIndexFixtureTests, PointOutsideOfGrid)
+{
+    TrRouting::Point point(46.5, -73.6);
+    ASSERT_EQ(0u, nodesIndex.getNodesInBoundingBox(point, 0.01, 0.01).size());
+    // A large bounding box around the point contains all nodes
+    ASSERT_EQ(nodes.size(), nodesIndex.getNodesInBoundingBox(point, 2.0, 2.0).size());
+}
+
+TEST_F(NodeSpatialIndexFixtureTests, EmptyIndex)
+{
+    TrRouting::NodeSpatialIndex emptyIndex;
+    emptyIndex.build(std::map<boost::uuids::uuid, TrRouting::Node>());
+    ASSERT_EQ(0u, emptyIndex.getNodesInBoundingBox(TrRouting::Point(45.5, -73.6), 1.0, 1.0).size());
+}
+
+TEST_F(NodeSpatialIndexFixtureTests, GeoFilterSameAsAllNodes)
+{
+    AllNodesEuclideanGeoFilter geoFilter;
+    std::uniform_real_distribution<double> latitudes(45.45, 45.63);
+    std::uniform_real_distribution<double> longitudes(-73.75, -73.50);
+    for (int i = 0; i < 100; i++)
+    {
+        TrRouting::Point point(latitudes(generator), longitudes(generator));
+        int maxWalkingTravelTime = 300 + 60 * (i % 20);
+        std::vector<TrRouting::NodeTimeDistance> footpaths = geoFilter.getAccessibleNodesFootpathsFromPoint(point, nodesIndex, maxWalkingTravelTime, 1.3888);
+        std::vector<std::pair<TrRouting::Node::uid_t, int>> expected = geoFilter.getAccessibleNodes(point, nodes, maxWalkingTravelTime, 1.3888);
+
+        ASSERT_EQ(expected.size(), footpaths.size());
+        for (size_t j = 0; j < expected.size(); j++)
+        {
+            ASSERT_EQ(expected[j].first, footpaths[j].node.uid);
+            ASSERT_EQ(expected[j].second, footpaths[j].time);
+        }
+    }
+}
@@ -0,0 +1,250 @@
+#include <sstream>
+#include <filesystem>
+#include <stdexcept>
+#include <boost/uuid/name_generator.hpp>
+#include <nlohmann/json.hpp>
+
+#include "gtest/gtest.h"
+#include "csa_test_data_fetcher.hpp"
+#include "calculator.hpp"
+#include "calculator_pool.hpp"
+#include "worker_pool.hpp"
+#include "od_trips_writer.hpp"
+#include "transit_data.hpp"
+#include "euclideangeofilter.hpp"
+#include "constants.hpp"
+#include "od_trip.hpp"
+#include "node.hpp"
+#include "data_source.hpp"
+#include "parameters.hpp"
+
+// Data fetcher with many od trips between the nodes of the test network, at a few times, so many of them share their origin and departure time
+class ManyOdTripsDataFetcher : public TestDataFetcher
+{
+public:
+    int getOdTrips(std::map<boost::uuids::uuid, TrRouting::OdTrip>& ts,
+        const std::map<boost::uuids::uuid, TrRouting::DataSource>& dataSources,
+        const std::map<boost::uuids::uuid, TrRouting::Person>&,
+        const std::map<boost::uuids::uuid, TrRouting::Node>& nodes,
+        std::string) override
+    {
+        std::vector<boost::uuids::uuid> nodeUuids = {nodeSouth2Uuid, nodeSouth1Uuid, nodeMidNodeUuid, nodeNorth1Uuid, nodeNorth2Uuid, nodeEast2Uuid, nodeWest2Uuid};
+        boost::uuids::name_generator_sha1 odTripUuidGenerator(odTripUuid);
+        for (int i = 0; i < 150; i++) {
+            const TrRouting::Node &originNode = nodes.at(nodeUuids[i % nodeUuids.size()]);
+            const TrRouting::Node &destinationNode = nodes.at(nodeUuids[(i * 3 + 1) % nodeUuids.size()]);
+            boost::uuids::uuid uuid = odTripUuidGenerator(std::to_string(i));
+            ts.emplace(uuid, TrRouting::OdTrip(uuid,
+                i,
+                std::to_string(i),
+                dataSources.at(dataSourceUuid),
+                std::nullopt,
+                getTimeInSeconds(9, 30 + (i % 3) * 5),
+                -1,
+                0,
+                0,
+                0,
+                0.3 + 0.1 * (i % 7),
+                "",
+                "",
+                "",
+                {TrRouting::NodeTimeDistance(originNode, 60, 70)},
+                {TrRouting::NodeTimeDistance(destinationNode, 60, 70)},
+                std::make_unique<TrRouting::Point>(originNode.point.get()->latitude, originNode.point.get()->longitude),
+                std::make_unique<TrRouting::Point>(destinationNode.point.get()->latitude, destinationNode.point.get()->longitude)));
+        }
+        return 0;
+    }
+};
+
+TrRouting::RouteParameters getOdTripsParameters(const TrRouting::TransitData &transitData)
+{
+    return TrRouting::RouteParameters(
+        std::make_unique<TrRouting::Point>(45.5242, -73.5817),
+        std::make_unique<TrRouting::Point>(45.5466, -73.6405),
+        transitData.getScenarios().at(TestDataFetcher::scenarioUuid),
+        getTimeInSeconds(9, 30),
+        TrRouting::DEFAULT_MIN_WAITING_TIME,
+        TrRouting::DEFAULT_MAX_TOTAL_TIME,
+        TrRouting::DEFAULT_MAX_ACCESS_TRAVEL_TIME,
+        TrRouting::DEFAULT_MAX_EGRESS_TRAVEL_TIME,
+        TrRouting::DEFAULT_MAX_TRANSFER_TRAVEL_TIME,
+        TrRouting::DEFAULT_FIRST_WAITING_TIME,
+        false,
+        true
+    );
+}
+
+// Test that the parallel od trips routing gives exactly the same result as the sequential one
+TEST(OdTripsRoutingTests, ParallelSameAsSequential)
+{
+    ManyOdTripsDataFetcher dataFetcher;
+    TrRouting::TransitData transitData(dataFetcher);
+    TrRouting::EuclideanGeoFilter geoFilter;
+    ASSERT_EQ(150u, transitData.getOdTrips().size());
+
+    TrRouting::RouteParameters parameters = getOdTripsParameters(transitData);
+
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    std::string sequentialResult = calculator.odTripsRouting(parameters);
+
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+    TrRouting::WorkerPool workerPool(4);
+    std::string parallelResult = TrRouting::Calculator::odTripsRouting(parameters, transitData, calculatorPool, workerPool);
+    ASSERT_EQ(sequentialResult, parallelResult);
+
+    nlohmann::json json = nlohmann::json::parse(parallelResult);
+    ASSERT_EQ(150u, json["odTrips"].size());
+    ASSERT_GT(json["totalTravelTimeSeconds"].get<int>(), 0);
+    ASSERT_GT(json["maxSegmentTotalDemand"].get<float>(), 0.0);
+    // The profiles of the used paths have the demand of each segment by hour, the line profiles have all the lines
+    ASSERT_EQ(transitData.getLines().size(), json["lineProfiles"].size());
+    ASSERT_GT(json["pathProfiles"].size(), 0u);
+    for (auto & [pathUuid, segmentsProfiles] : json["pathProfiles"].items()) {
+        ASSERT_GT(segmentsProfiles.size(), 0u);
+        for (auto & segmentProfile : segmentsProfiles) {
+            ASSERT_EQ(29u, segmentProfile.size());
+        }
+    }
+
+    // The calculator can be used again for another run
+    ASSERT_EQ(sequentialResult, calculator.odTripsRouting(parameters));
+}
+
+// Test that the ndjson writer writes one line per od trip, then the summary, with the same content as the json result
+TEST(OdTripsRoutingTests, NdjsonWriter)
+{
+    ManyOdTripsDataFetcher dataFetcher;
+    TrRouting::TransitData transitData(dataFetcher);
+    TrRouting::EuclideanGeoFilter geoFilter;
+    TrRouting::RouteParameters parameters = getOdTripsParameters(transitData);
+
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    nlohmann::json expectedJson = nlohmann::json::parse(calculator.odTripsRouting(parameters));
+
+    std::stringstream output;
+    TrRouting::OdTripsNdjsonWriter writer(output);
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+    TrRouting::WorkerPool workerPool(3);
+    TrRouting::Calculator::odTripsRouting(parameters, transitData, calculatorPool, workerPool, writer);
+
+    std::vector<nlohmann::json> lines;
+    std::string line;
+    while (std::getline(output, line)) {
+        lines.push_back(nlohmann::json::parse(line));
+    }
+    ASSERT_EQ(151u, lines.size());
+    for (size_t i = 0; i < 150; i++) {
+        ASSERT_EQ(expectedJson["odTrips"][i], lines[i]);
+    }
+    nlohmann::json summary = lines[150];
+    ASSERT_FALSE(summary.contains("odTrips"));
+    expectedJson.erase("odTrips");
+    ASSERT_EQ(expectedJson, summary);
+    ASSERT_EQ("success", summary["status"]);
+    ASSERT_TRUE(summary.contains("lineProfiles"));
+    ASSERT_TRUE(summary.contains("pathProfiles"));
+}
+
+// Test that routing the od trips by groups sharing their forward calculation gives the same od trip results as routing them one by one, while scanning less connections
+TEST(OdTripsRoutingTests, GroupedSameAsUngrouped)
+{
+    ManyOdTripsDataFetcher dataFetcher;
+    TrRouting::TransitData transitData(dataFetcher);
+    TrRouting::EuclideanGeoFilter geoFilter;
+    TrRouting::RouteParameters parameters = getOdTripsParameters(transitData);
+    TrRouting::Calculator calculator(transitData, geoFilter);
+
+    TrRouting::OdTripLegacyParameters ungroupedParameters;
+    ungroupedParameters.groupOdTrips = false;
+    TrRouting::OdTripsJsonWriter ungroupedWriter;
+    calculator.odTripsRouting(parameters, ungroupedWriter, ungroupedParameters);
+    nlohmann::json ungroupedJson = nlohmann::json::parse(ungroupedWriter.getJsonString());
+
+    TrRouting::OdTripsJsonWriter groupedWriter;
+    calculator.odTripsRouting(parameters, groupedWriter);
+    nlohmann::json groupedJson = nlohmann::json::parse(groupedWriter.getJsonString());
+
+    // Without grouping, the od trips are in the same order as the map of od trips
+    ASSERT_EQ(150u, ungroupedJson["odTrips"].size());
+    size_t index = 0;
+    for (auto & odTripPair : transitData.getOdTrips()) {
+        ASSERT_EQ(boost::uuids::to_string(odTripPair.first), ungroupedJson["odTrips"][index++]["uuid"]);
+    }
+    ASSERT_EQ(150, ungroupedJson["forwardCalculationsCount"]);
+
+    // With grouping, the od trips are ordered by group, each result is the same
+    std::map<std::string, nlohmann::json> ungroupedOdTrips;
+    for (auto & odTripJson : ungroupedJson["odTrips"]) {
+        ungroupedOdTrips[odTripJson["uuid"]] = odTripJson;
+    }
+    ASSERT_EQ(150u, groupedJson["odTrips"].size());
+    for (auto & odTripJson : groupedJson["odTrips"]) {
+        ASSERT_EQ(ungroupedOdTrips.at(odTripJson["uuid"]), odTripJson);
+    }
+    // 7 origins at 3 departure times
+    ASSERT_EQ(21, groupedJson["forwardCalculationsCount"]);
+    ASSERT_LT(groupedJson["scannedConnectionsCount"].get<long long>(), ungroupedJson["scannedConnectionsCount"].get<long long>());
+
+    // The demand is the same, up to the order of the floating point sums
+    ASSERT_EQ(ungroupedJson["totalTravelTimeSeconds"], groupedJson["totalTravelTimeSeconds"]);
+    ASSERT_NEAR(ungroupedJson["maxSegmentTotalDemand"].get<float>(), groupedJson["maxSegmentTotalDemand"].get<float>(), 0.001);
+    for (auto & [lineUuid, demand] : ungroupedJson["lineProfiles"].items()) {
+        ASSERT_NEAR(demand.get<float>(), groupedJson["lineProfiles"][lineUuid].get<float>(), 0.001);
+    }
+    ASSERT_EQ(ungroupedJson["pathProfiles"].size(), groupedJson["pathProfiles"].size());
+}
+
+// Writer that stops the run after a number of od trips, like an interrupted process
+class InterruptedOdTripsWriter : public TrRouting::OdTripsJsonWriter
+{
+public:
+    InterruptedOdTripsWriter(size_t _interruptAfter) : interruptAfter(_interruptAfter) {}
+    void writeOdTrip(const nlohmann::json &odTripJson) override
+    {
+        if (writtenCount++ == interruptAfter) {
+            throw std::runtime_error("interrupted");
+        }
+        TrRouting::OdTripsJsonWriter::writeOdTrip(odTripJson);
+    }
+
+private:
+    size_t interruptAfter;
+    size_t writtenCount = 0;
+};
+
+// Test that an interrupted run resumed from its checkpoint gives the same output as an uninterrupted run
+TEST(OdTripsRoutingTests, ResumeFromCheckpoint)
+{
+    ManyOdTripsDataFetcher dataFetcher;
+    TrRouting::TransitData transitData(dataFetcher);
+    TrRouting::EuclideanGeoFilter geoFilter;
+    TrRouting::RouteParameters parameters = getOdTripsParameters(transitData);
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    std::string checkpointFilePath = (std::filesystem::temp_directory_path() / "trrouting_od_trips_checkpoint_test.json").string();
+    std::filesystem::remove(checkpointFilePath);
+
+    // Sampled od trips, so the result depends on the seed
+    TrRouting::OdTripLegacyParameters odTripParameters;
+    odTripParameters.odTripsSampleRatio = 0.8;
+    odTripParameters.seed = 1234;
+    TrRouting::OdTripsJsonWriter expectedWriter;
+    calculator.odTripsRouting(parameters, expectedWriter, odTripParameters);
+
+    odTripParameters.checkpointFilePath = checkpointFilePath;
+    odTripParameters.checkpointInterval = 40;
+    InterruptedOdTripsWriter interruptedWriter(100);
+    ASSERT_THROW(calculator.odTripsRouting(parameters, interruptedWriter, odTripParameters), std::runtime_error);
+    ASSERT_TRUE(std::filesystem::exists(checkpointFilePath));
+
+    // Resume with another seed and in parallel, the seed of the checkpoint is used
+    odTripParameters.seed = 5678;
+    TrRouting::OdTripsJsonWriter resumedWriter;
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+    TrRouting::WorkerPool workerPool(3);
+    TrRouting::Calculator::odTripsRouting(parameters, transitData, calculatorPool, workerPool, resumedWriter, odTripParameters);
+    ASSERT_EQ(expectedWriter.getJsonString(), resumedWriter.getJsonString());
+
+    // The checkpoint is removed once the run is complete
+    ASSERT_FALSE(std::filesystem::exists(checkpointFilePath));
+}
@@ -66,7 +66,12 @@ INSTANTIATE_TEST_SUITE_P(
         std::make_tuple("max_egress_travel_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
         std::make_tuple("max_transfer_travel_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
         std::make_tuple("max_travel_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
-        std::make_tuple("max_first_waiting_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA)
+        std::make_tuple("max_first_waiting_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
+        std::make_tuple("time_window_end", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
+        std::make_tuple("time_window_end", "10799", TrRouting::ParameterException::Type::INVALID_TIME_WINDOW),
+        std::make_tuple("time_window_end", "100000", TrRouting::ParameterException::Type::INVALID_TIME_WINDOW),
+        std::make_tuple("time_window_end", "2147483647", TrRouting::ParameterException::Type::INVALID_TIME_WINDOW),
+        std::make_tuple("step_seconds", "0", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA)
     )
 );
 
@@ -127,6 +132,33 @@ TEST_F(AccessibilityParametersFixtureTests, DefaultParameters)
     EXPECT_EQ(queryParams.getMaxEgressWalkingTravelTimeSeconds(), 20 * 60);
     EXPECT_EQ(queryParams.getMaxTransferWalkingTravelTimeSeconds(), 20 * 60);
     EXPECT_EQ(queryParams.getMaxFirstWaitingTimeSeconds(), 30 * 60);
+    EXPECT_FALSE(queryParams.hasTimeWindow());
+    EXPECT_EQ(std::vector<int>({10800}), queryParams.getTimesOfTrip());
+}
+
+TEST_F(AccessibilityParametersFixtureTests, TimeWindowParameters)
+{
+    std::vector<std::pair<std::string, std::string>> parametersWithValues;
+    parametersWithValues.push_back(std::make_pair("scenario_id",  TEST_SCENARIO_UUID));
+    parametersWithValues.push_back(std::make_pair("place", "-73.5,45.5544"));
+    parametersWithValues.push_back(std::make_pair("time_of_trip", "10800"));
+    parametersWithValues.push_back(std::make_pair("time_window_end", "11100"));
+    parametersWithValues.push_back(std::make_pair("step_seconds", "120"));
+
+    TrRouting::AccessibilityParameters queryParams = TrRouting::AccessibilityParameters::createAccessibilityParameter(parametersWithValues, scenarios);
+    EXPECT_TRUE(queryParams.hasTimeWindow());
+    EXPECT_EQ(queryParams.getTimeWindowEnd(), 11100);
+    EXPECT_EQ(queryParams.getStepSeconds(), 120);
+    EXPECT_EQ(std::vector<int>({10800, 10920, 11040}), queryParams.getTimesOfTrip());
+
+    // The step cannot be longer than the window
+    std::vector<std::pair<std::string, std::string>> longStepParameters(parametersWithValues);
+    longStepParameters.push_back(std::make_pair("step_seconds", "301"));
+    EXPECT_THROW(TrRouting::AccessibilityParameters::createAccessibilityParameter(longStepParameters, scenarios), TrRouting::ParameterException);
+
+    // The time window is only for departure times
+    parametersWithValues.push_back(std::make_pair("time_type", "1"));
+    EXPECT_THROW(TrRouting::AccessibilityParameters::createAccessibilityParameter(parametersWithValues, scenarios), TrRouting::ParameterException);
 }
 
 TEST_F(AccessibilityParametersFixtureTests, SetAllParameters)
@@ -0,0 +1,84 @@
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/string_generator.hpp>
+
+#include "gtest/gtest.h"
+#include "parameters.hpp"
+#include "parameters_test.hpp"
+#include "scenario.hpp"
+#include "point.hpp"
+#include "service.hpp"
+
+const std::string TEST_SCENARIO_UUID = "12345678-9999-0000-1111-ababbabaabab";
+
+class ProfileParametersFixtureTests : public BaseParametersFixtureTests
+{
+protected:
+    std::map<boost::uuids::uuid, TrRouting::Scenario> scenarios;
+    TrRouting::Service service; //Empty service, as the param parser expect at least one
+    std::vector<std::pair<std::string, std::string>> parametersWithValues;
+public:
+    void SetUp( ) override
+    {
+        const boost::uuids::string_generator uuidGenerator;
+
+        // Create a valid scenario, services and other data don't have to exist, we are creating parameters, not using them
+        auto uuid = uuidGenerator(TEST_SCENARIO_UUID);
+        scenarios[uuid].uuid = uuid;
+        scenarios[uuid].name = "Test valid scenario";
+        scenarios[uuid].servicesList.push_back(service);
+
+        // Valid route parameters
+        parametersWithValues.push_back(std::make_pair("scenario_id",  TEST_SCENARIO_UUID));
+        parametersWithValues.push_back(std::make_pair("origin", "-73.5,45.5544"));
+        parametersWithValues.push_back(std::make_pair("destination", "-73.57786713522127,45.55239801892435"));
+        parametersWithValues.push_back(std::make_pair("time_of_trip", "10800"));
+    }
+
+    void TearDown( ) override
+    {
+        scenarios.clear();
+    }
+
+    void assertInvalidTimeWindow()
+    {
+        try {
+            TrRouting::ProfileParameters queryParams = TrRouting::ProfileParameters::createProfileParameter(parametersWithValues, scenarios);
+            FAIL() << "Expected TrRouting::ParameterException, no exception was thrown";
+        }
+        catch(TrRouting::ParameterException const & err) {
+            EXPECT_EQ(err.getType(), TrRouting::ParameterException::Type::INVALID_TIME_WINDOW);
+        }
+        catch(...) {
+            FAIL() << "Expected TrRouting::ParameterException, another type was thrown";
+        }
+    }
+};
+
+TEST_F(ProfileParametersFixtureTests, DefaultTimeWindow)
+{
+    TrRouting::ProfileParameters queryParams = TrRouting::ProfileParameters::createProfileParameter(parametersWithValues, scenarios);
+    EXPECT_DOUBLE_EQ(queryParams.getOrigin()->latitude, 45.5544);
+    EXPECT_DOUBLE_EQ(queryParams.getDestination()->longitude, -73.57786713522127);
+    EXPECT_EQ(queryParams.getTimeWindowStart(), 10800);
+    EXPECT_EQ(queryParams.getTimeWindowEnd(), 10800 + TrRouting::DEFAULT_PROFILE_TIME_WINDOW);
+}
+
+TEST_F(ProfileParametersFixtureTests, SetTimeWindow)
+{
+    parametersWithValues.push_back(std::make_pair("time_window_end", "12600"));
+    TrRouting::ProfileParameters queryParams = TrRouting::ProfileParameters::createProfileParameter(parametersWithValues, scenarios);
+    EXPECT_EQ(queryParams.getTimeWindowStart(), 10800);
+    EXPECT_EQ(queryParams.getTimeWindowEnd(), 12600);
+}
+
+TEST_F(ProfileParametersFixtureTests, WindowEndBeforeStart)
+{
+    parametersWithValues.push_back(std::make_pair("time_window_end", "9000"));
+    assertInvalidTimeWindow();
+}
+
+TEST_F(ProfileParametersFixtureTests, ArrivalTimeWindow)
+{
+    parametersWithValues.push_back(std::make_pair("time_type", "1"));
+    assertInvalidTimeWindow();
+}
@@ -69,7 +69,13 @@ INSTANTIATE_TEST_SUITE_P(
         std::make_tuple("max_egress_travel_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
         std::make_tuple("max_transfer_travel_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
         std::make_tuple("max_travel_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
-        std::make_tuple("max_first_waiting_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA)
+        std::make_tuple("max_first_waiting_time", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
+        std::make_tuple("max_transfers", "nan", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
+        std::make_tuple("max_transfers", "-1", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
+        std::make_tuple("max_transfers", "11", TrRouting::ParameterException::Type::INVALID_NUMERICAL_DATA),
+        std::make_tuple("max_transfers", "2", TrRouting::ParameterException::Type::INVALID_MAX_TRANSFERS),
+        std::make_tuple("date", "2023-02-30", TrRouting::ParameterException::Type::INVALID_DATE),
+        std::make_tuple("date", "tomorrow", TrRouting::ParameterException::Type::INVALID_DATE)
     )
 );
 
@@ -138,6 +144,8 @@ TEST_F(RouteParametersFixtureTests, DefaultParameters)
     EXPECT_EQ(queryParams.getMaxEgressWalkingTravelTimeSeconds(), 20 * 60);
     EXPECT_EQ(queryParams.getMaxTransferWalkingTravelTimeSeconds(), 20 * 60);
     EXPECT_EQ(queryParams.getMaxFirstWaitingTimeSeconds(), 30 * 60);
+    EXPECT_FALSE(queryParams.getMaxTransfers().has_value());
+    EXPECT_FALSE(queryParams.getDate().has_value());
 }
 
 TEST_F(RouteParametersFixtureTests, SetAllParameters)
@@ -159,6 +167,7 @@ TEST_F(RouteParametersFixtureTests, SetAllParameters)
     parametersWithValues.push_back(std::make_pair("max_transfer_travel_time", std::to_string(maxTransfer)));
     parametersWithValues.push_back(std::make_pair("max_travel_time", std::to_string(maxTotalTime)));
     parametersWithValues.push_back(std::make_pair("max_first_waiting_time", std::to_string(maxFirst)));
+    parametersWithValues.push_back(std::make_pair("date", "2023-05-17"));
 
     TrRouting::RouteParameters queryParams = TrRouting::RouteParameters::createRouteODParameter(parametersWithValues, scenarios);
     EXPECT_DOUBLE_EQ(queryParams.getOrigin()->latitude, 45.5544);
@@ -176,4 +185,32 @@ TEST_F(RouteParametersFixtureTests, SetAllParameters)
     EXPECT_EQ(queryParams.getMaxEgressWalkingTravelTimeSeconds(), maxEgress);
     EXPECT_EQ(queryParams.getMaxTransferWalkingTravelTimeSeconds(), maxTransfer);
     EXPECT_EQ(queryParams.getMaxFirstWaitingTimeSeconds(), maxFirst);
+    EXPECT_EQ(queryParams.getDate(), boost::gregorian::date(2023, 5, 17));
+}
+
+TEST_F(RouteParametersFixtureTests, MaxTransfersParameters)
+{
+    std::vector<std::pair<std::string, std::string>> parametersWithValues;
+    parametersWithValues.push_back(std::make_pair("scenario_id",  TEST_SCENARIO_UUID));
+    parametersWithValues.push_back(std::make_pair("origin", "-73.5,45.5544"));
+    parametersWithValues.push_back(std::make_pair("destination", "-73.57786713522127, 45.55239801892435"));
+    parametersWithValues.push_back(std::make_pair("time_of_trip", "10800"));
+    parametersWithValues.push_back(std::make_pair("alternatives", "1"));
+    parametersWithValues.push_back(std::make_pair("max_transfers", "2"));
+
+    // With alternatives and a departure time, the max transfers are used by the multi-criteria calculation
+    TrRouting::RouteParameters queryParams = TrRouting::RouteParameters::createRouteODParameter(parametersWithValues, scenarios);
+    EXPECT_EQ(queryParams.isWithAlternatives(), true);
+    EXPECT_EQ(queryParams.isForwardCalculation(), true);
+    EXPECT_EQ(queryParams.getMaxTransfers(), 2);
+
+    // With an arrival time, they are not supported
+    parametersWithValues.push_back(std::make_pair("time_type", "1"));
+    try {
+        TrRouting::RouteParameters::createRouteODParameter(parametersWithValues, scenarios);
+        FAIL() << "Expected TrRouting::ParameterException, no exception was thrown";
+    }
+    catch(TrRouting::ParameterException const & err) {
+        EXPECT_EQ(err.getType(), TrRouting::ParameterException::Type::INVALID_MAX_TRANSFERS);
+    }
 }
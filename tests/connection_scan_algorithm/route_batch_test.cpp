@@ -0,0 +1,115 @@
+#include <atomic>
+#include <stdexcept>
+#include <boost/uuid/uuid_io.hpp>
+
+#include "gtest/gtest.h"
+#include "csa_test_base.hpp"
+#include "route_batch.hpp"
+#include "worker_pool.hpp"
+#include "calculator.hpp"
+#include "calculator_pool.hpp"
+#include "toolbox.hpp"
+
+class RouteBatchFixtureTests : public BaseCsaFixtureTests
+{
+protected:
+    // Route from South2 to North2, which has results at this time
+    nlohmann::json getQuery(int timeOfTrip)
+    {
+        nlohmann::json query;
+        query["origin"] = "-73.5817,45.5242";
+        query["destination"] = nlohmann::json::array({-73.6405, 45.5466});
+        query["scenario_id"] = boost::uuids::to_string(TestDataFetcher::scenarioUuid);
+        query["time_of_trip"] = timeOfTrip;
+        query["min_waiting_time"] = "180";
+        return query;
+    }
+};
+
+// Test that the worker pool runs all the tasks on its threads and rethrows their exceptions
+TEST(WorkerPoolTests, RunAllTasks)
+{
+    TrRouting::WorkerPool workerPool(3);
+    ASSERT_EQ(3u, workerPool.getThreadsCount());
+
+    std::vector<std::atomic<int>> calls(100);
+    workerPool.run(calls.size(), [&calls](size_t index) { calls[index]++; });
+    for (auto & call : calls) {
+        ASSERT_EQ(1, call);
+    }
+
+    std::atomic<int> doneCount {0};
+    ASSERT_THROW(workerPool.run(10, [&doneCount](size_t index) {
+        doneCount++;
+        if (index == 5) {
+            throw std::runtime_error("task error");
+        }
+    }), std::runtime_error);
+    ASSERT_EQ(10, doneCount);
+}
+
+// Test that the batch results are in the order of the queries, with their ids, and match the single route results
+TEST_F(RouteBatchFixtureTests, ResultsInOrder)
+{
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+    TrRouting::WorkerPool workerPool(4);
+    TrRouting::RouteBatch routeBatch(calculatorPool, workerPool);
+
+    nlohmann::json queries = nlohmann::json::array();
+    for (int i = 0; i < 20; i++) {
+        nlohmann::json query = getQuery(getTimeInSeconds(9, 30 + i));
+        query["id"] = "query" + std::to_string(i);
+        queries.push_back(query);
+    }
+    // An invalid query, without destination, and one without id
+    nlohmann::json invalidQuery = getQuery(getTimeInSeconds(9, 45));
+    invalidQuery.erase("destination");
+    invalidQuery["id"] = 20;
+    queries.push_back(invalidQuery);
+    queries.push_back(getQuery(getTimeInSeconds(9, 45)));
+
+    std::vector<nlohmann::json> results;
+    routeBatch.calculate(transitData, queries, [&results](size_t index, const nlohmann::json &result) {
+        ASSERT_EQ(results.size(), index);
+        results.push_back(result);
+    });
+
+    ASSERT_EQ(queries.size(), results.size());
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    for (size_t i = 0; i < 20; i++) {
+        ASSERT_EQ("query" + std::to_string(i), results[i]["id"]);
+        ASSERT_EQ(TrRouting::RouteBatch::calculateQuery(calculator, transitData, queries[i]), results[i]);
+    }
+    ASSERT_EQ("success", results[0]["status"]);
+    ASSERT_EQ(20, results[20]["id"]);
+    ASSERT_EQ("query_error", results[20]["status"]);
+    ASSERT_EQ("MISSING_PARAM_DESTINATION", results[20]["errorCode"]);
+    ASSERT_FALSE(results[21].contains("id"));
+    ASSERT_EQ("success", results[21]["status"]);
+
+    // The calculators of the worker threads are kept for the next batch, a
+    // thread which had no query in the first batch may create its own
+    ASSERT_LE(calculatorPool.getCreatedCount(), 4u);
+    routeBatch.calculate(transitData, queries, [](size_t, const nlohmann::json &) {});
+    ASSERT_LE(calculatorPool.getCreatedCount(), 4u);
+}
+
+// Test the conversion of the query fields to query string parameters
+TEST(RouteBatchTests, QueryToParameters)
+{
+    nlohmann::json query;
+    query["id"] = 3;
+    query["origin"] = nlohmann::json::array({-73.5, 45.5});
+    query["time_of_trip"] = 36000;
+    query["alternatives"] = true;
+    query["scenario_id"] = "abc";
+
+    std::vector<std::pair<std::string, std::string>> parameters = TrRouting::RouteBatch::queryToParameters(query);
+    std::map<std::string, std::string> parametersMap(parameters.begin(), parameters.end());
+    ASSERT_EQ(4u, parametersMap.size());
+    ASSERT_EQ("-73.5,45.5", parametersMap["origin"]);
+    ASSERT_EQ("36000", parametersMap["time_of_trip"]);
+    ASSERT_EQ("true", parametersMap["alternatives"]);
+    ASSERT_EQ("abc", parametersMap["scenario_id"]);
+    ASSERT_TRUE(TrRouting::RouteBatch::queryToParameters(nlohmann::json::array()).empty());
+}
@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+#include "csa_test_data_fetcher.hpp"
+#include "transit_data.hpp"
+#include "service_calendar.hpp"
+#include "service.hpp"
+#include "scenario.hpp"
+#include "connection_set.hpp"
+
+using boost::gregorian::date;
+
+// Data fetcher giving a weekday calendar to the test service
+class CalendarDataFetcher : public TestDataFetcher
+{
+public:
+    int getServices(std::map<boost::uuids::uuid, TrRouting::Service>& ts, std::string customPath = "") override
+    {
+        int ret = TestDataFetcher::getServices(ts, customPath);
+        TrRouting::Service &service = ts.at(serviceUuid);
+        service.monday = service.tuesday = service.wednesday = service.thursday = service.friday = 1;
+        service.startDate = date(2024, 1, 1);
+        service.endDate = date(2024, 12, 31);
+        service.exceptDates.push_back(date(2024, 7, 1)); // A monday
+        service.onlyDates.push_back(date(2024, 6, 2)); // A sunday
+        return ret;
+    }
+};
+
+TEST(ServiceCalendarTests, ActiveDays)
+{
+    std::map<boost::uuids::uuid, TrRouting::Service> services;
+    CalendarDataFetcher dataFetcher;
+    dataFetcher.getServices(services);
+    const TrRouting::Service &service = services.begin()->second;
+
+    // Another service without dates, active on the weekends
+    boost::uuids::uuid weekendUuid = TestDataFetcher::uuidGenerator("11111111-2222-3333-4444-555555777777");
+    TrRouting::Service &weekendService = services[weekendUuid];
+    weekendService.saturday = weekendService.sunday = 1;
+
+    TrRouting::ServiceCalendar calendar(services);
+    ASSERT_EQ(date(2024, 1, 1), calendar.getFirstDate());
+    ASSERT_EQ(date(2024, 12, 31), calendar.getLastDate());
+
+    std::vector<date> dates = {
+        date(2023, 12, 29), date(2024, 1, 1), date(2024, 1, 6), date(2024, 6, 2),
+        date(2024, 7, 1), date(2024, 7, 2), date(2024, 12, 31), date(2025, 1, 4)
+    };
+    for (auto & testDate : dates) {
+        EXPECT_EQ(service.isActiveOnDate(testDate), calendar.isServiceActive(service, testDate)) << testDate;
+        EXPECT_EQ(weekendService.isActiveOnDate(testDate), calendar.isServiceActive(weekendService, testDate)) << testDate;
+    }
+    EXPECT_FALSE(calendar.isServiceActive(service, date(2023, 12, 29)));
+    EXPECT_TRUE(calendar.isServiceActive(service, date(2024, 1, 1)));
+    EXPECT_FALSE(calendar.isServiceActive(service, date(2024, 1, 6)));
+    EXPECT_TRUE(calendar.isServiceActive(service, date(2024, 6, 2)));
+    EXPECT_FALSE(calendar.isServiceActive(service, date(2024, 7, 1)));
+    EXPECT_TRUE(calendar.isServiceActive(weekendService, date(2024, 1, 6)));
+    EXPECT_TRUE(calendar.isServiceActive(weekendService, date(2025, 1, 4)));
+
+    std::vector<std::reference_wrapper<const TrRouting::Service>> scenarioServices = {service, weekendService};
+    auto activeServices = calendar.getActiveServices(scenarioServices, date(2024, 1, 6));
+    ASSERT_EQ(1u, activeServices.size());
+    ASSERT_EQ(weekendService.uuid, activeServices[0].get().uuid);
+}
+
+// Test that the connection sets for a date only keep the trips of the services active that day, and are cached per date
+TEST(ServiceCalendarTests, ConnectionsForDate)
+{
+    CalendarDataFetcher dataFetcher;
+    TrRouting::TransitData transitData(dataFetcher, true);
+    const TrRouting::Scenario &scenario = transitData.getScenarios().at(TestDataFetcher::scenarioUuid);
+
+    ASSERT_EQ(17u, transitData.getConnectionsForScenario(scenario)->getForwardConnectionsCount());
+    ASSERT_EQ(17u, transitData.getConnectionsForScenario(scenario, date(2024, 1, 8))->getForwardConnectionsCount());
+    ASSERT_EQ(0u, transitData.getConnectionsForScenario(scenario, date(2024, 1, 6))->getForwardConnectionsCount());
+    ASSERT_EQ(0u, transitData.getConnectionsForScenario(scenario, date(2024, 7, 1))->getReverseConnectionsCount());
+    ASSERT_EQ(17u, transitData.getConnectionsForScenario(scenario, date(2024, 6, 2))->getReverseConnectionsCount());
+    ASSERT_EQ(5u, transitData.getConnectionSetBuildCount());
+
+    // Each date has its own cached set
+    auto mondaySet = transitData.getConnectionsForScenario(scenario, date(2024, 1, 8));
+    ASSERT_EQ(mondaySet, transitData.getConnectionsForScenario(scenario, date(2024, 1, 8)));
+    ASSERT_NE(mondaySet, transitData.getConnectionsForScenario(scenario));
+    ASSERT_EQ(5u, transitData.getConnectionSetBuildCount());
+}
+
+// Test that the services of a scenario without services list, which runs all of them, are also filtered by date
+TEST(ServiceCalendarTests, ConnectionsForDateAllServices)
+{
+    CalendarDataFetcher dataFetcher;
+    TrRouting::TransitData transitData(dataFetcher, true);
+    TrRouting::Scenario allServicesScenario;
+    allServicesScenario.uuid = TestDataFetcher::uuidGenerator("11111111-2222-3333-4444-555555888888");
+    allServicesScenario.name = "All services";
+
+    ASSERT_EQ(17u, transitData.getConnectionsForScenario(allServicesScenario)->getForwardConnectionsCount());
+    ASSERT_EQ(17u, transitData.getConnectionsForScenario(allServicesScenario, date(2024, 1, 8))->getForwardConnectionsCount());
+    ASSERT_EQ(0u, transitData.getConnectionsForScenario(allServicesScenario, date(2024, 1, 6))->getForwardConnectionsCount());
+    ASSERT_EQ(0u, transitData.getConnectionsForScenario(allServicesScenario, date(2024, 7, 1))->getReverseConnectionsCount());
+}
@@ -0,0 +1,162 @@
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "csa_test_base.hpp"
+#include "snapshot_data_fetcher.hpp"
+#include "calculator.hpp"
+#include "parameters.hpp"
+#include "constants.hpp"
+#include "toolbox.hpp"
+#include "agency.hpp"
+#include "node.hpp"
+#include "trip.hpp"
+#include "path.hpp"
+#include "connection.hpp"
+#include "scenario.hpp"
+#include "place.hpp"
+#include "household.hpp"
+#include "point.hpp"
+
+class SnapshotDataFetcherFixtureTests : public BaseCsaFixtureTests
+{
+protected:
+    std::string snapshotFilePath;
+
+public:
+    void SetUp() override
+    {
+        BaseCsaFixtureTests::SetUp();
+        snapshotFilePath = "/tmp/trRouting_snapshot_test_" + std::to_string(getpid()) + ".snapshot";
+    }
+    void TearDown() override
+    {
+        std::remove(snapshotFilePath.c_str());
+    }
+};
+
+TEST_F(SnapshotDataFetcherFixtureTests, SameDataFromSnapshot)
+{
+    ASSERT_EQ(0, TrRouting::SnapshotDataFetcher::writeSnapshot(transitData, snapshotFilePath));
+
+    TrRouting::SnapshotDataFetcher snapshotFetcher(snapshotFilePath);
+    TrRouting::TransitData snapshotData(snapshotFetcher);
+    ASSERT_EQ(TrRouting::DataStatus::READY, snapshotData.getDataStatus());
+
+    ASSERT_EQ(transitData.getModes().size(), snapshotData.getModes().size());
+    ASSERT_EQ(transitData.getAgencies().size(), snapshotData.getAgencies().size());
+    ASSERT_EQ(transitData.getServices().size(), snapshotData.getServices().size());
+    ASSERT_EQ(transitData.getLines().size(), snapshotData.getLines().size());
+    ASSERT_EQ(transitData.getScenarios().size(), snapshotData.getScenarios().size());
+    ASSERT_EQ(transitData.getOdTrips().size(), snapshotData.getOdTrips().size());
+    ASSERT_EQ(transitData.getTrips().size(), snapshotData.getTrips().size());
+
+    // The precomputed nodes of the places and households are kept
+    ASSERT_FALSE(transitData.getPlaces().empty());
+    ASSERT_EQ(transitData.getPlaces().size(), snapshotData.getPlaces().size());
+    for (auto & [uuid, place] : transitData.getPlaces()) {
+        const TrRouting::Place &snapshotPlace = snapshotData.getPlaces().at(uuid);
+        EXPECT_EQ(place.name, snapshotPlace.name);
+        EXPECT_DOUBLE_EQ(place.point->latitude, snapshotPlace.point->latitude);
+        ASSERT_EQ(place.nodes.size(), snapshotPlace.nodes.size());
+        for (size_t i = 0; i < place.nodes.size(); i++) {
+            EXPECT_EQ(place.nodes[i].node.uuid, snapshotPlace.nodes[i].node.uuid);
+            EXPECT_EQ(place.nodes[i].time, snapshotPlace.nodes[i].time);
+            EXPECT_EQ(place.nodes[i].distance, snapshotPlace.nodes[i].distance);
+        }
+    }
+    ASSERT_FALSE(transitData.getHouseholds().empty());
+    ASSERT_EQ(transitData.getHouseholds().size(), snapshotData.getHouseholds().size());
+    for (auto & [uuid, household] : transitData.getHouseholds()) {
+        const TrRouting::Household &snapshotHousehold = snapshotData.getHouseholds().at(uuid);
+        EXPECT_EQ(household.category, snapshotHousehold.category);
+        EXPECT_EQ(household.homeNodes.size(), snapshotHousehold.homeNodes.size());
+    }
+
+    ASSERT_EQ(transitData.getNodes().size(), snapshotData.getNodes().size());
+    for (auto & [uuid, node] : transitData.getNodes()) {
+        const TrRouting::Node &snapshotNode = snapshotData.getNodes().at(uuid);
+        EXPECT_EQ(node.code, snapshotNode.code);
+        EXPECT_DOUBLE_EQ(node.point->latitude, snapshotNode.point->latitude);
+        EXPECT_DOUBLE_EQ(node.point->longitude, snapshotNode.point->longitude);
+        ASSERT_EQ(node.transferableNodes.size(), snapshotNode.transferableNodes.size());
+        for (size_t i = 0; i < node.transferableNodes.size(); i++) {
+            EXPECT_EQ(node.transferableNodes[i].node.uuid, snapshotNode.transferableNodes[i].node.uuid);
+            EXPECT_EQ(node.transferableNodes[i].time, snapshotNode.transferableNodes[i].time);
+            EXPECT_EQ(node.transferableNodes[i].distance, snapshotNode.transferableNodes[i].distance);
+        }
+    }
+
+    ASSERT_EQ(transitData.getPaths().size(), snapshotData.getPaths().size());
+    for (auto & [uuid, path] : transitData.getPaths()) {
+        const TrRouting::Path &snapshotPath = snapshotData.getPaths().at(uuid);
+        ASSERT_EQ(path.nodesRef.size(), snapshotPath.nodesRef.size());
+        EXPECT_EQ(path.tripsRef.size(), snapshotPath.tripsRef.size());
+        EXPECT_EQ(path.segmentsTravelTimeSeconds, snapshotPath.segmentsTravelTimeSeconds);
+    }
+
+    // The sorted connections are read from the snapshot in the same order
+    ASSERT_EQ(transitData.getForwardConnections().size(), snapshotData.getForwardConnections().size());
+    ASSERT_EQ(transitData.getReverseConnections().size(), snapshotData.getReverseConnections().size());
+    for (size_t i = 0; i < transitData.getForwardConnections().size(); i++) {
+        const TrRouting::Connection &connection = transitData.getForwardConnections()[i];
+        const TrRouting::Connection &snapshotConnection = snapshotData.getForwardConnections()[i];
+        EXPECT_EQ(connection.getTrip().uuid, snapshotConnection.getTrip().uuid);
+        EXPECT_EQ(connection.getDepartureNode().uuid, snapshotConnection.getDepartureNode().uuid);
+        EXPECT_EQ(connection.getArrivalNode().uuid, snapshotConnection.getArrivalNode().uuid);
+        EXPECT_EQ(connection.getDepartureTime(), snapshotConnection.getDepartureTime());
+        EXPECT_EQ(connection.getSequenceInTrip(), snapshotConnection.getSequenceInTrip());
+    }
+    for (size_t i = 0; i < transitData.getReverseConnections().size(); i++) {
+        const TrRouting::Connection &connection = transitData.getReverseConnections()[i];
+        const TrRouting::Connection &snapshotConnection = snapshotData.getReverseConnections()[i];
+        EXPECT_EQ(connection.getTrip().uuid, snapshotConnection.getTrip().uuid);
+        EXPECT_EQ(connection.getSequenceInTrip(), snapshotConnection.getSequenceInTrip());
+    }
+
+    // Both data give the same route
+    auto getParameters = [](const TrRouting::TransitData &data) {
+        return TrRouting::RouteParameters(
+            std::make_unique<TrRouting::Point>(45.5242, -73.5817),
+            std::make_unique<TrRouting::Point>(45.5466, -73.6405),
+            data.getScenarios().at(TestDataFetcher::scenarioUuid),
+            getTimeInSeconds(9, 45),
+            180,
+            TrRouting::MAX_INT,
+            20 * 60,
+            20 * 60,
+            20 * 60,
+            30 * 60,
+            false,
+            true
+        );
+    };
+    TrRouting::RouteParameters parameters = getParameters(transitData);
+    TrRouting::RouteParameters snapshotParameters = getParameters(snapshotData);
+    TrRouting::Calculator calculator(transitData, geoFilter);
+    TrRouting::Calculator snapshotCalculator(snapshotData, geoFilter);
+    std::unique_ptr<TrRouting::RoutingResult> result = calculator.calculateSingle(parameters);
+    std::unique_ptr<TrRouting::RoutingResult> snapshotResult = snapshotCalculator.calculateSingle(snapshotParameters);
+    TrRouting::SingleCalculationResult &singleResult = dynamic_cast<TrRouting::SingleCalculationResult&>(*result.get());
+    TrRouting::SingleCalculationResult &snapshotSingleResult = dynamic_cast<TrRouting::SingleCalculationResult&>(*snapshotResult.get());
+    EXPECT_EQ(singleResult.arrivalTime, snapshotSingleResult.arrivalTime);
+    EXPECT_EQ(singleResult.totalTravelTime, snapshotSingleResult.totalTravelTime);
+    EXPECT_EQ(singleResult.numberOfTransfers, snapshotSingleResult.numberOfTransfers);
+    EXPECT_EQ(singleResult.steps.size(), snapshotSingleResult.steps.size());
+}
+
+TEST_F(SnapshotDataFetcherFixtureTests, InvalidSnapshot)
+{
+    // Missing file
+    TrRouting::SnapshotDataFetcher missingFetcher(snapshotFilePath);
+    std::map<boost::uuids::uuid, TrRouting::Agency> agencies;
+    ASSERT_EQ(-ENOENT, missingFetcher.getAgencies(agencies));
+
+    // Truncated file
+    ASSERT_EQ(0, TrRouting::SnapshotDataFetcher::writeSnapshot(transitData, snapshotFilePath));
+    ASSERT_EQ(0, truncate(snapshotFilePath.c_str(), 20));
+    TrRouting::SnapshotDataFetcher truncatedFetcher(snapshotFilePath);
+    ASSERT_EQ(-EBADMSG, truncatedFetcher.getAgencies(agencies));
+    ASSERT_EQ(0u, agencies.size());
+}
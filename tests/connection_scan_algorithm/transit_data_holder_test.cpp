@@ -0,0 +1,229 @@
+#include <thread>
+#include <atomic>
+#include <errno.h>
+
+#include "gtest/gtest.h"
+#include "csa_test_data_fetcher.hpp"
+#include "transit_data_holder.hpp"
+#include "calculator.hpp"
+#include "calculator_pool.hpp"
+#include "routing_result.hpp"
+#include "parameters.hpp"
+#include "euclideangeofilter.hpp"
+#include "toolbox.hpp"
+#include "scenario.hpp"
+#include "point.hpp"
+#include "agency.hpp"
+#include "node.hpp"
+#include "path.hpp"
+
+// Data fetcher that can return no scenarios, to get data that is not ready
+class NoScenariosDataFetcher : public TestDataFetcher
+{
+public:
+    bool noScenarios {false};
+
+    int getScenarios(std::map<boost::uuids::uuid, TrRouting::Scenario>& ts,
+                     const std::map<boost::uuids::uuid, TrRouting::Service>& services,
+                     const std::map<boost::uuids::uuid, TrRouting::Line>& lines,
+                     const std::map<boost::uuids::uuid, TrRouting::Agency>& agencies,
+                     const std::map<boost::uuids::uuid, TrRouting::Node>& nodes,
+                     const std::map<std::string, TrRouting::Mode>& modes,
+                     std::string customPath = "") override
+    {
+        if (noScenarios) {
+            ts.clear();
+            return 0;
+        }
+        return TestDataFetcher::getScenarios(ts, services, lines, agencies, nodes, modes, customPath);
+    }
+
+    // Custom paths from which the agencies were read, the "bad" path cannot be read
+    std::vector<std::string> agenciesCustomPaths;
+
+    int getAgencies(std::map<boost::uuids::uuid, TrRouting::Agency>& ts,
+                    std::string customPath = "") override
+    {
+        if (!customPath.empty()) {
+            agenciesCustomPaths.push_back(customPath);
+        }
+        if (customPath == "bad") {
+            return -EBADMSG;
+        }
+        return TestDataFetcher::getAgencies(ts, customPath);
+    }
+};
+
+class TransitDataHolderFixtureTests : public ::testing::Test
+{
+protected:
+    NoScenariosDataFetcher dataFetcher;
+    TrRouting::EuclideanGeoFilter geoFilter;
+
+    // Route from South2 to North2, which has results at this time
+    int calculateArrivalTime(TrRouting::Calculator &calculator, const TrRouting::TransitData &transitData)
+    {
+        TrRouting::RouteParameters parameters(
+            std::make_unique<TrRouting::Point>(45.5242, -73.5817),
+            std::make_unique<TrRouting::Point>(45.5466, -73.6405),
+            transitData.getScenarios().at(TestDataFetcher::scenarioUuid),
+            getTimeInSeconds(9, 45),
+            180,
+            TrRouting::MAX_INT,
+            20 * 60,
+            20 * 60,
+            20 * 60,
+            30 * 60,
+            false,
+            true
+        );
+        return calculator.calculateSingle(parameters)->arrivalTime;
+    }
+};
+
+// Test that a reload publishes a new data, while the previous one stays valid for its current users
+TEST_F(TransitDataHolderFixtureTests, ReloadKeepsPreviousData)
+{
+    TrRouting::TransitDataHolder transitDataHolder(dataFetcher);
+    std::shared_ptr<const TrRouting::TransitData> previousData = transitDataHolder.get();
+    ASSERT_EQ(TrRouting::DataStatus::READY, previousData->getDataStatus());
+    std::weak_ptr<const TrRouting::TransitData> previousDataRef = previousData;
+
+    ASSERT_EQ(TrRouting::DataStatus::READY, transitDataHolder.reload());
+    std::shared_ptr<const TrRouting::TransitData> currentData = transitDataHolder.get();
+    ASSERT_NE(previousData.get(), currentData.get());
+    ASSERT_EQ(1u, transitDataHolder.getPublishedCount());
+    ASSERT_GE(transitDataHolder.getLastPublishDurationMicroseconds(), 0);
+
+    // Both data can still be queried and give the same result
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+    int previousArrivalTime = calculateArrivalTime(calculatorPool.getCalculator(*previousData), *previousData);
+    int currentArrivalTime = calculateArrivalTime(calculatorPool.getCalculator(*currentData), *currentData);
+    ASSERT_EQ(previousArrivalTime, currentArrivalTime);
+    ASSERT_EQ(2u, calculatorPool.getCreatedCount());
+
+    // The previous data is deleted with its last user
+    previousData.reset();
+    ASSERT_TRUE(previousDataRef.expired());
+}
+
+// Test that the function updating the new data is called before it is published
+TEST_F(TransitDataHolderFixtureTests, ReloadUpdatesNewData)
+{
+    TrRouting::TransitDataHolder transitDataHolder(dataFetcher);
+    std::shared_ptr<const TrRouting::TransitData> previousData = transitDataHolder.get();
+
+    const TrRouting::TransitData * updatedData = nullptr;
+    transitDataHolder.reload([&updatedData](TrRouting::TransitData &newData) {
+        newData.updateAgencies();
+        updatedData = &newData;
+    });
+    ASSERT_EQ(updatedData, transitDataHolder.get().get());
+    ASSERT_NE(previousData->getDataVersion(), transitDataHolder.get()->getDataVersion());
+}
+
+// Test that data which is not ready does not replace valid data
+TEST_F(TransitDataHolderFixtureTests, InvalidDataNotPublished)
+{
+    TrRouting::TransitDataHolder transitDataHolder(dataFetcher);
+    std::shared_ptr<const TrRouting::TransitData> previousData = transitDataHolder.get();
+
+    dataFetcher.noScenarios = true;
+    ASSERT_EQ(TrRouting::DataStatus::NO_SCENARIOS, transitDataHolder.reload());
+    ASSERT_EQ(previousData.get(), transitDataHolder.get().get());
+    ASSERT_EQ(0u, transitDataHolder.getPublishedCount());
+}
+
+// Test that the caches from a custom path are read again by the next reloads
+TEST_F(TransitDataHolderFixtureTests, ReloadKeepsCustomCachePaths)
+{
+    TrRouting::TransitDataHolder transitDataHolder(dataFetcher);
+
+    ASSERT_EQ(TrRouting::DataStatus::READY, transitDataHolder.reloadCaches({"agencies"}, "custom"));
+    ASSERT_EQ(std::vector<std::string>({"custom"}), dataFetcher.agenciesCustomPaths);
+
+    // Reloading another cache reads the agencies from their custom path again
+    ASSERT_EQ(TrRouting::DataStatus::READY, transitDataHolder.reloadCaches({"nodes"}, "other"));
+    ASSERT_EQ(std::vector<std::string>({"custom", "custom"}), dataFetcher.agenciesCustomPaths);
+    std::map<std::string, std::string> expectedPaths {{"agencies", "custom"}, {"nodes", "other"}};
+    ASSERT_EQ(expectedPaths, transitDataHolder.getCustomCachePaths());
+
+    // Without path, the agencies are read from the data fetcher again
+    ASSERT_EQ(TrRouting::DataStatus::READY, transitDataHolder.reloadCaches({"agencies"}, ""));
+    ASSERT_EQ(2u, dataFetcher.agenciesCustomPaths.size());
+    expectedPaths.erase("agencies");
+    ASSERT_EQ(expectedPaths, transitDataHolder.getCustomCachePaths());
+    ASSERT_EQ(3u, transitDataHolder.getPublishedCount());
+}
+
+// Test that the data reloaded with nodes from a custom path only references these nodes and can be queried
+TEST_F(TransitDataHolderFixtureTests, ReloadCustomNodesThenRoute)
+{
+    TrRouting::TransitDataHolder transitDataHolder(dataFetcher);
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+    int expectedArrivalTime;
+    {
+        std::shared_ptr<const TrRouting::TransitData> transitData = transitDataHolder.get();
+        expectedArrivalTime = calculateArrivalTime(calculatorPool.getCalculator(*transitData), *transitData);
+    }
+
+    ASSERT_EQ(TrRouting::DataStatus::READY, transitDataHolder.reloadCaches({"nodes"}, "custom"));
+    // Reloading another cache keeps the nodes from their custom path
+    ASSERT_EQ(TrRouting::DataStatus::READY, transitDataHolder.reloadCaches({"scenarios"}, ""));
+    std::shared_ptr<const TrRouting::TransitData> transitData = transitDataHolder.get();
+    for (auto & [pathUuid, path] : transitData->getPaths()) {
+        for (const TrRouting::Node & node : path.nodesRef) {
+            ASSERT_EQ(&transitData->getNodes().at(node.uuid), &node);
+        }
+    }
+    ASSERT_EQ(expectedArrivalTime, calculateArrivalTime(calculatorPool.getCalculator(*transitData), *transitData));
+}
+
+// Test that a custom cache that cannot be read does not replace the current data
+TEST_F(TransitDataHolderFixtureTests, ReloadCustomCacheError)
+{
+    TrRouting::TransitDataHolder transitDataHolder(dataFetcher);
+    std::shared_ptr<const TrRouting::TransitData> previousData = transitDataHolder.get();
+
+    ASSERT_EQ(TrRouting::DataStatus::DATA_READ_ERROR, transitDataHolder.reloadCaches({"all"}, "bad"));
+    ASSERT_EQ(previousData.get(), transitDataHolder.get().get());
+    ASSERT_EQ(0u, transitDataHolder.getPublishedCount());
+    ASSERT_TRUE(transitDataHolder.getCustomCachePaths().empty());
+}
+
+// Test that queries can run in other threads while the data is reloaded
+TEST_F(TransitDataHolderFixtureTests, ConcurrentReadersDuringReload)
+{
+    TrRouting::TransitDataHolder transitDataHolder(dataFetcher);
+    TrRouting::CalculatorPool calculatorPool(geoFilter);
+    int expectedArrivalTime;
+    {
+        std::shared_ptr<const TrRouting::TransitData> transitData = transitDataHolder.get();
+        expectedArrivalTime = calculateArrivalTime(calculatorPool.getCalculator(*transitData), *transitData);
+    }
+
+    std::atomic<bool> reloading {true};
+    std::atomic<int> wrongResults {0};
+    std::atomic<int> queries {0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.push_back(std::thread([&]() {
+            while (reloading || queries < 4) {
+                std::shared_ptr<const TrRouting::TransitData> transitData = transitDataHolder.get();
+                if (calculateArrivalTime(calculatorPool.getCalculator(*transitData), *transitData) != expectedArrivalTime) {
+                    wrongResults++;
+                }
+                queries++;
+            }
+        }));
+    }
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(TrRouting::DataStatus::READY, transitDataHolder.reload());
+    }
+    reloading = false;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQ(0, wrongResults);
+    ASSERT_EQ(5u, transitDataHolder.getPublishedCount());
+}
@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+#include "trip_filter.hpp"
+#include "trip.hpp"
+#include "line.hpp"
+#include "mode.hpp"
+#include "agency.hpp"
+#include "service.hpp"
+#include "connection_set_test.hpp"
+
+// Test the only/except filters on lines, with the same trips as the rest of the test data
+TEST_F(ConnectionSetFixtureTests, TestTripFilterLines)
+{
+    const TrRouting::Trip & tripSN = transitData.getTrips().at(TestDataFetcher::trip1SNUuid);
+    const TrRouting::Trip & tripEW = transitData.getTrips().at(TestDataFetcher::trip1EWUuid);
+    std::vector<std::reference_wrapper<const TrRouting::Line>> lines;
+    lines.push_back(transitData.getLines().at(TestDataFetcher::lineSNUuid));
+
+    TrRouting::TripFilter onlyFilter({}, {}, lines, {}, {}, {}, {}, {});
+    ASSERT_TRUE(onlyFilter.isTripEnabled(tripSN));
+    ASSERT_FALSE(onlyFilter.isTripEnabled(tripEW));
+
+    TrRouting::TripFilter exceptFilter({}, {}, {}, lines, {}, {}, {}, {});
+    ASSERT_FALSE(exceptFilter.isTripEnabled(tripSN));
+    ASSERT_TRUE(exceptFilter.isTripEnabled(tripEW));
+
+    std::vector<std::reference_wrapper<const TrRouting::Trip>> trips {tripSN, tripEW};
+    std::vector<bool> disabledTrips = exceptFilter.getDisabledTrips(trips);
+    ASSERT_EQ((size_t)std::max(tripSN.uid, tripEW.uid) + 1, disabledTrips.size());
+    ASSERT_TRUE(disabledTrips[tripSN.uid]);
+    ASSERT_FALSE(disabledTrips[tripEW.uid]);
+}
+
+// Test that the filters on the other trip attributes are combined with the line filter
+TEST_F(ConnectionSetFixtureTests, TestTripFilterAttributes)
+{
+    const TrRouting::Trip & tripSN = transitData.getTrips().at(TestDataFetcher::trip1SNUuid);
+    std::vector<std::reference_wrapper<const TrRouting::Service>> services {transitData.getServices().at(TestDataFetcher::serviceUuid)};
+    std::vector<std::reference_wrapper<const TrRouting::Agency>> agencies {transitData.getAgencies().at(TestDataFetcher::agencyUuid)};
+    std::vector<std::reference_wrapper<const TrRouting::Mode>> modes {transitData.getModes().at("bus")};
+
+    // No filter enables all trips
+    ASSERT_TRUE(TrRouting::TripFilter({}, {}, {}, {}, {}, {}, {}, {}).isTripEnabled(tripSN));
+    ASSERT_TRUE(TrRouting::TripFilter(services, {}, {}, {}, modes, {}, agencies, {}).isTripEnabled(tripSN));
+    ASSERT_FALSE(TrRouting::TripFilter({}, services, {}, {}, {}, {}, {}, {}).isTripEnabled(tripSN));
+    ASSERT_FALSE(TrRouting::TripFilter({}, {}, {}, {}, {}, modes, {}, {}).isTripEnabled(tripSN));
+    ASSERT_FALSE(TrRouting::TripFilter({}, {}, {}, {}, {}, {}, {}, agencies).isTripEnabled(tripSN));
+}